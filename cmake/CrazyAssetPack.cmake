@@ -0,0 +1,38 @@
+# crazy_add_asset_pack(<target> INPUT <dir> OUTPUT <file> [COMPRESS] [KEEP_PNG])
+#
+# Adds a target that packs every file under <dir> into <file> with
+# tools/asset-pack/pack.js, for loading through crazy::AssetPack. The pack
+# is rebuilt when a file under <dir> changes. COMPRESS stores entries as
+# LZ4 blocks where that pays off; KEEP_PNG stores PNG images as they are
+# instead of decoding them to textures. Requires Node.js.
+function(crazy_add_asset_pack target)
+    cmake_parse_arguments(PACK "COMPRESS;KEEP_PNG" "INPUT;OUTPUT" "" ${ARGN})
+    if(NOT PACK_INPUT OR NOT PACK_OUTPUT)
+        message(FATAL_ERROR "crazy_add_asset_pack: INPUT and OUTPUT are required")
+    endif()
+
+    find_program(NODE_EXECUTABLE node)
+    if(NOT NODE_EXECUTABLE)
+        message(WARNING "crazy_add_asset_pack: Node.js not found, ${target} is not available")
+        return()
+    endif()
+
+    set(options)
+    if(PACK_COMPRESS)
+        list(APPEND options --compress)
+    endif()
+    if(PACK_KEEP_PNG)
+        list(APPEND options --keep-png)
+    endif()
+
+    set(script ${CMAKE_SOURCE_DIR}/tools/asset-pack/pack.js)
+    file(GLOB_RECURSE inputs CONFIGURE_DEPENDS ${PACK_INPUT}/*)
+    add_custom_command(
+        OUTPUT ${PACK_OUTPUT}
+        COMMAND ${NODE_EXECUTABLE} ${script} ${PACK_INPUT} ${PACK_OUTPUT} ${options}
+        DEPENDS ${inputs} ${script}
+        COMMENT "Packing assets into ${PACK_OUTPUT}"
+        VERBATIM
+    )
+    add_custom_target(${target} DEPENDS ${PACK_OUTPUT})
+endfunction()
@@ -3,49 +3,175 @@
 #include <string>
 
 #ifdef NODE_EMBED_ENABLED
-#include <node.h>
-#include <uv.h>
+#include <crazy/NodeRuntime.hpp>
+#include <chrono>
 
 // Node.js embedding mode - in-process execution
+//
+//   bridge_node_embed [--bundle <file>] [--snapshot <file>] [--code-cache <dir>]
+//   bridge_node_embed [--bundle <file>] --build-snapshot <file>
+//
+// --build-snapshot evaluates the bundle and writes a startup snapshot, then
+// exits; --snapshot starts from it. The startup time printed compares both.
 int main(int argc, char* argv[]) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point launch = Clock::now();
+    
+    std::string bundle = "script.js";
+    std::string snapshot;
+    std::string buildSnapshot;
+    std::string codeCache;
+    std::vector<std::string> args = {argv[0]};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && arg == "--bundle") {
+            bundle = argv[++i];
+        } else if (i + 1 < argc && arg == "--snapshot") {
+            snapshot = argv[++i];
+        } else if (i + 1 < argc && arg == "--build-snapshot") {
+            buildSnapshot = argv[++i];
+        } else if (i + 1 < argc && arg == "--code-cache") {
+            codeCache = argv[++i];
+        } else {
+            args.push_back(arg);
+        }
+    }
+    
+    crazy::NodeRuntime& node = crazy::NodeRuntime::instance();
+    
+    // Build step: the bundle runs here, not at launch
+    if (!buildSnapshot.empty()) {
+        return node.buildSnapshot(bundle, buildSnapshot, args) ? 0 : 1;
+    }
+    
     std::cout << "Running in Node.js EMBEDDED mode (in-process)" << std::endl;
     
-    // Initialize Node.js
-    // Note: This is a skeleton - real implementation would:
-    // 1. Initialize libuv event loop
-    // 2. Create Node.js platform and isolate
-    // 3. Load and execute script.js in the embedded context
-    // 4. Handle bidirectional C++ <-> JS communication
+    // C++ functions callable from JS as crazy.<name>()
+    node.registerFunction("hostName", [](const std::vector<crazy::NodeValue>&) {
+        return crazy::NodeValue("bridge_node_embed");
+    });
+    node.registerFunction("multiply", [](const std::vector<crazy::NodeValue>& args) {
+        if (args.size() < 2) {
+            return crazy::NodeValue();
+        }
+        return crazy::NodeValue(args[0].asNumber() * args[1].asNumber());
+    });
     
-    std::cout << "TODO: Implement actual Node.js embedding using libnode API" << std::endl;
-    std::cout << "This would allow direct C++ <-> JS function calls without subprocess overhead" << std::endl;
+    // One platform, isolate and environment for the life of the process
+    node.setStartupSnapshot(snapshot);
+    node.setCodeCacheDirectory(codeCache);
+    if (!node.start(args)) {
+        std::cerr << "Failed to start Node.js: " << node.getLastError() << std::endl;
+        return 1;
+    }
+    const Clock::time_point started = Clock::now();
     
+    // Already evaluated (and silent) when the snapshot contains the bundle
+    std::cout << "--- Output from " << bundle << " ---" << std::endl;
+    if (!node.loadScript(bundle)) {
+        std::cerr << "Failed to load " << bundle << ": " << node.getLastError() << std::endl;
+        node.shutdown();
+        return 1;
+    }
+    std::cout << "--- End of " << bundle << " output ---" << std::endl;
+    const Clock::time_point loaded = Clock::now();
+    std::cout << "Startup" << (node.isSnapshotLoaded() ? " (snapshot)" : "") << ": "
+              << std::chrono::duration<double, std::milli>(loaded - launch).count() << " ms (start "
+              << std::chrono::duration<double, std::milli>(started - launch).count() << " ms, load "
+              << std::chrono::duration<double, std::milli>(loaded - started).count() << " ms)" << std::endl;
+    
+    // C++ -> JS calls into the loaded module
+    crazy::NodeValue result;
+    if (node.call("add", {2, 3}, &result)) {
+        std::cout << "add(2, 3) = " << result.asNumber() << std::endl;
+    }
+    if (node.call("describeHost", {}, &result)) {
+        std::cout << "describeHost() = " << result.asString() << std::endl;
+    }
+    
+    // Bridge call cost, without any process boundary
+    const int iterations = 100000;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        node.call("add", {i, 1});
+    }
+    auto elapsed = Clock::now() - start;
+    std::cout << "Average call: "
+              << std::chrono::duration<double, std::micro>(elapsed).count() / iterations
+              << " us" << std::endl;
+    
+    // Run callbacks that are already due (an application does this every frame)
+    node.runPendingEvents();
+    
+    node.shutdown();
     return 0;
 }
 
 #else
-// Subprocess fallback mode - spawn Node.js as external process
-int main(int argc, char* argv[]) {
-    std::cout << "Running in SUBPROCESS FALLBACK mode" << std::endl;
+#include <crazy/NodeWorker.hpp>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Subprocess fallback mode - one persistent Node.js worker process
+int main() {
+    std::cout << "Running in SUBPROCESS FALLBACK mode (persistent worker)" << std::endl;
     std::cout << "To enable real embedding, rebuild with NODE_INCLUDE_DIR and NODE_LIBRARY" << std::endl;
     std::cout << std::endl;
     
-    // Execute script.js using system Node.js installation
-    std::string command = "node script.js";
+    // Spawned once; script.js is loaded by nodeWorker.js and its exports are
+    // called over a Unix socket pair
+    crazy::NodeWorkerOptions options;
+    options.workerScript = "nodeWorker.js";
+    options.script = "script.js";
+    options.healthCheckInterval = 1.0;
     
-    std::cout << "Executing: " << command << std::endl;
-    std::cout << "--- Output from script.js ---" << std::endl;
+    crazy::NodeWorker worker;
+    if (!worker.start(options)) {
+        std::cerr << "Failed to start Node.js: " << worker.getLastError() << std::endl;
+        return 1;
+    }
     
-    int result = system(command.c_str());
+    crazy::NodeValue result;
+    if (!worker.call("add", {2, 3}, &result, 10.0)) {
+        std::cerr << "add() failed: " << worker.getLastError() << std::endl;
+        return 1;
+    }
+    std::cout << "add(2, 3) = " << result.asNumber() << std::endl;
+    if (worker.call("describeHost", {}, &result, 10.0)) {
+        std::cout << "describeHost() = " << result.asString() << std::endl;
+    }
     
-    std::cout << "--- End of script.js output ---" << std::endl;
+    // Round trip with one call in flight
+    const int iterations = 10000;
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        worker.call("add", {i, 1});
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    std::cout << "Call latency: p50 " << samples[iterations / 2]
+              << " us, p99 " << samples[iterations * 99 / 100]
+              << " us, max " << samples.back() << " us" << std::endl;
     
-    if (result == 0) {
-        std::cout << "Script executed successfully" << std::endl;
-        return 0;
-    } else {
-        std::cerr << "Script execution failed with code: " << result << std::endl;
-        return 1;
+    // Pipelined: all requests in flight, responses dispatched by poll()
+    int completed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        worker.callAsync("add", {i, 1}, [&](bool, const crazy::NodeValue&, const std::string&) {
+            ++completed;
+        });
     }
+    while (completed < iterations && worker.isRunning()) {
+        worker.poll(0.1);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Pipelined: " << std::chrono::duration<double, std::micro>(elapsed).count() / iterations
+              << " us per call" << std::endl;
+    
+    worker.stop();
+    return 0;
 }
 #endif
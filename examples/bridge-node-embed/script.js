@@ -1,18 +1,22 @@
-// Example JavaScript file for Node.js embedding prototype
+// Example JavaScript file for the Node.js embedding example.
+// Runs standalone (`node script.js`) or loaded in-process by crazy::NodeRuntime.
 console.log("Hello from script.js!");
 console.log("Node.js version:", process.version);
 console.log("Platform:", process.platform);
 console.log("Architecture:", process.arch);
 
-// Example of what could be done with real embedding:
-// - Expose C++ functions to JavaScript
-// - Call JavaScript functions from C++
-// - Share data structures between C++ and JS
-// - Handle async operations across the boundary
+// Native functions registered by the C++ host live on the global `crazy`
+// object; it does not exist when running under the node executable.
+const host = globalThis.crazy;
 
-console.log("\nThis is a simple demonstration script.");
-console.log("With real embedding, you could:");
-console.log("  1. Call C++ functions directly from JS");
-console.log("  2. Invoke JS functions from C++ code");
-console.log("  3. Share data with zero-copy semantics");
-console.log("  4. Build native addons using N-API");
+// Functions exported here can be called from C++ with NodeRuntime::call()
+exports.add = (a, b) => a + b;
+
+exports.describeHost = () => {
+    if (!host) {
+        return "no native host";
+    }
+    return `${host.hostName()} (6 * 7 = ${host.multiply(6, 7)})`;
+};
+
+console.log("Embedded in native host:", host ? "yes" : "no");
@@ -0,0 +1,81 @@
+'use strict';
+
+// JavaScript end of crazy::CommandBatch (include/crazy/CommandBatch.hpp).
+//
+// Commands are encoded straight into the shared ring but not published:
+// the batch stands in for the ring in the generated post() helpers, and its
+// commit() only counts. flush() publishes everything with one commit and
+// makes one native call. It runs at the end of the React commit (the
+// reconciler calls it) or, failing that, at the next microtask checkpoint,
+// so a burst of thousands of operations costs a single crossing.
+//
+//   const batch = new CommandBatch(crazy.shared.commands, { flush: crazy.flushCommands });
+//   M.AppendChild.post(batch, parent, child);
+
+const { RingChannel } = require('./ringChannel');
+
+class CommandBatch {
+  /**
+   * @param {SharedArrayBuffer} buffer Ring exposed by CommandBatch::attach()
+   * @param {object} [options]
+   * @param {function} [options.flush] Native flush function (crazy.flush<Name>)
+   * @param {number} [options.byteOffset=0] Start of the ring in the buffer
+   */
+  constructor(buffer, { flush = null, byteOffset = 0 } = {}) {
+    this.ring = new RingChannel(buffer, { byteOffset });
+    /** DataView the generated encoders write through */
+    this.view = this.ring.view;
+    this.nativeFlush = flush;
+
+    /** Commands appended since the last flush */
+    this.pending = 0;
+    this.firstPendingTime = 0;
+    this.scheduled = false;
+    this.flushTask = () => {
+      this.scheduled = false;
+      this.flush();
+    };
+  }
+
+  /**
+   * Reserve space for a command. When the ring is full, the batch so far is
+   * flushed and applied at once, then the reservation is retried.
+   * @returns {number} Byte offset in `view`, or -1 if the command cannot fit
+   */
+  reserve(size) {
+    let offset = this.ring.reserve(size);
+    if (offset < 0 && this.pending > 0) {
+      this.flush(true);
+      offset = this.ring.reserve(size);
+    }
+    return offset;
+  }
+
+  /** Append the reserved command to the batch; called by post() helpers. */
+  commit() {
+    if (this.pending++ === 0) {
+      this.firstPendingTime = performance.now();
+      if (!this.scheduled) {
+        this.scheduled = true;
+        queueMicrotask(this.flushTask);
+      }
+    }
+  }
+
+  /**
+   * Hand the batch to C++ with a single native call.
+   * @param {boolean} [overflow=false] The ring is full; C++ applies at once
+   */
+  flush(overflow = false) {
+    if (this.pending === 0) {
+      return;
+    }
+    this.ring.commit();
+    this.pending = 0;
+    if (this.nativeFlush) {
+      this.nativeFlush(performance.now() - this.firstPendingTime, overflow);
+    }
+  }
+}
+
+module.exports = { CommandBatch };
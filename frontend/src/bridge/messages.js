@@ -0,0 +1,989 @@
+'use strict';
+
+// Generated by tools/bridge-codegen/generate.js from schema/bridge-messages.json.
+// Do not edit: change the schema and rebuild the bridge_messages target.
+//
+// Accessors take the DataView of the buffer holding the message and the
+// byte offset of the message, as returned by RingChannel.peek()/reserve(),
+// and read or write the field at its fixed offset.
+
+const SCHEMA_VERSION = 1;
+
+const MessageType = Object.freeze({
+  Invalid: 0,
+  KeyEvent: 1,
+  MouseButtonEvent: 2,
+  MouseMoveEvent: 3,
+  WindowResizeEvent: 4,
+  PointerEvent: 5,
+  CreateElement: 32,
+  CreateText: 33,
+  AppendChild: 34,
+  InsertBefore: 35,
+  RemoveChild: 36,
+  DestroyNode: 37,
+  SetNumberProperty: 38,
+  SetStringProperty: 39,
+  RemoveProperty: 40,
+  SetText: 41,
+  SetTransition: 42,
+  SetEventMask: 43,
+});
+
+const encoder = new TextEncoder();
+
+// Messages are almost always written through the same view (a ring's)
+let lastView = null;
+let lastBytes = null;
+
+function bytesOf(view) {
+  if (view !== lastView) {
+    lastBytes = new Uint8Array(view.buffer, view.byteOffset, view.byteLength);
+    lastView = view;
+  }
+  return lastBytes;
+}
+
+/** Number of bytes `text` takes in UTF-8 */
+function utf8Length(text) {
+  let length = 0;
+  for (let i = 0; i < text.length; i++) {
+    const c = text.charCodeAt(i);
+    if (c < 0x80) {
+      length += 1;
+    } else if (c < 0x800) {
+      length += 2;
+    } else if ((c & 0xfc00) === 0xd800 && i + 1 < text.length && (text.charCodeAt(i + 1) & 0xfc00) === 0xdc00) {
+      length += 4;
+      i++;
+    } else {
+      length += 3;
+    }
+  }
+  return length;
+}
+
+function encodeUtf8(view, offset, text) {
+  const bytes = bytesOf(view);
+  let i = 0;
+  // Short ASCII strings (element types, property names) are the common case
+  for (; i < text.length; i++) {
+    const c = text.charCodeAt(i);
+    if (c >= 0x80) {
+      break;
+    }
+    bytes[offset + i] = c;
+  }
+  if (i === text.length) {
+    return i;
+  }
+  return i + encoder.encodeInto(text.slice(i), bytes.subarray(offset + i)).written;
+}
+
+function decodeUtf8(view, offset, length) {
+  return Buffer.from(view.buffer, view.byteOffset + offset, length).toString('utf8');
+}
+
+/** Type of the message at `offset`, or MessageType.Invalid if `size` is too small */
+function getMessageType(view, offset, size) {
+  return size < 2 ? MessageType.Invalid : view.getUint16(offset, true);
+}
+
+/** Keyboard key pressed, released or repeated (GLFW key codes) */
+const KeyEvent = Object.freeze({
+  type: 1,
+  fixedSize: 17,
+
+  /** Encoded size of a message */
+  size() {
+    return 17;
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, key, scancode, mods, action) {
+    view.setUint16(offset, 1, true);
+    view.setInt32(offset + 4, key, true);
+    view.setInt32(offset + 8, scancode, true);
+    view.setInt32(offset + 12, mods, true);
+    view.setUint8(offset + 16, action);
+    return 17;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, key, scancode, mods, action) {
+    const offset = ring.reserve(this.size());
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, key, scancode, mods, action);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 17 &&
+      view.getUint16(offset, true) === 1;
+  },
+
+  key(view, offset) {
+    return view.getInt32(offset + 4, true);
+  },
+
+  scancode(view, offset) {
+    return view.getInt32(offset + 8, true);
+  },
+
+  mods(view, offset) {
+    return view.getInt32(offset + 12, true);
+  },
+
+  action(view, offset) {
+    return view.getUint8(offset + 16);
+  },
+});
+
+/** Mouse button pressed or released */
+const MouseButtonEvent = Object.freeze({
+  type: 2,
+  fixedSize: 13,
+
+  /** Encoded size of a message */
+  size() {
+    return 13;
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, button, mods, action) {
+    view.setUint16(offset, 2, true);
+    view.setInt32(offset + 4, button, true);
+    view.setInt32(offset + 8, mods, true);
+    view.setUint8(offset + 12, action);
+    return 13;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, button, mods, action) {
+    const offset = ring.reserve(this.size());
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, button, mods, action);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 13 &&
+      view.getUint16(offset, true) === 2;
+  },
+
+  button(view, offset) {
+    return view.getInt32(offset + 4, true);
+  },
+
+  mods(view, offset) {
+    return view.getInt32(offset + 8, true);
+  },
+
+  action(view, offset) {
+    return view.getUint8(offset + 12);
+  },
+});
+
+/** Cursor moved, in window coordinates */
+const MouseMoveEvent = Object.freeze({
+  type: 3,
+  fixedSize: 24,
+
+  /** Encoded size of a message */
+  size() {
+    return 24;
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, x, y) {
+    view.setUint16(offset, 3, true);
+    view.setFloat64(offset + 8, x, true);
+    view.setFloat64(offset + 16, y, true);
+    return 24;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, x, y) {
+    const offset = ring.reserve(this.size());
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, x, y);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 24 &&
+      view.getUint16(offset, true) === 3;
+  },
+
+  x(view, offset) {
+    return view.getFloat64(offset + 8, true);
+  },
+
+  y(view, offset) {
+    return view.getFloat64(offset + 16, true);
+  },
+});
+
+/** Framebuffer resized, in pixels */
+const WindowResizeEvent = Object.freeze({
+  type: 4,
+  fixedSize: 12,
+
+  /** Encoded size of a message */
+  size() {
+    return 12;
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, width, height) {
+    view.setUint16(offset, 4, true);
+    view.setInt32(offset + 4, width, true);
+    view.setInt32(offset + 8, height, true);
+    return 12;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, width, height) {
+    const offset = ring.reserve(this.size());
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, width, height);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 12 &&
+      view.getUint16(offset, true) === 4;
+  },
+
+  width(view, offset) {
+    return view.getInt32(offset + 4, true);
+  },
+
+  height(view, offset) {
+    return view.getInt32(offset + 8, true);
+  },
+});
+
+/** UI: pointer event hit-tested by UiTree; kind is a UiEventKind, coordinates are in window and target space */
+const PointerEvent = Object.freeze({
+  type: 5,
+  fixedSize: 56,
+
+  /** Encoded size of a message */
+  size() {
+    return 56;
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, target, button, mods, kind, x, y, localX, localY) {
+    view.setUint16(offset, 5, true);
+    view.setUint32(offset + 4, target, true);
+    view.setInt32(offset + 8, button, true);
+    view.setInt32(offset + 12, mods, true);
+    view.setUint8(offset + 16, kind);
+    view.setFloat64(offset + 24, x, true);
+    view.setFloat64(offset + 32, y, true);
+    view.setFloat64(offset + 40, localX, true);
+    view.setFloat64(offset + 48, localY, true);
+    return 56;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, target, button, mods, kind, x, y, localX, localY) {
+    const offset = ring.reserve(this.size());
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, target, button, mods, kind, x, y, localX, localY);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 56 &&
+      view.getUint16(offset, true) === 5;
+  },
+
+  target(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  button(view, offset) {
+    return view.getInt32(offset + 8, true);
+  },
+
+  mods(view, offset) {
+    return view.getInt32(offset + 12, true);
+  },
+
+  kind(view, offset) {
+    return view.getUint8(offset + 16);
+  },
+
+  x(view, offset) {
+    return view.getFloat64(offset + 24, true);
+  },
+
+  y(view, offset) {
+    return view.getFloat64(offset + 32, true);
+  },
+
+  localX(view, offset) {
+    return view.getFloat64(offset + 40, true);
+  },
+
+  localY(view, offset) {
+    return view.getFloat64(offset + 48, true);
+  },
+});
+
+/** UI: create an element node of the given type */
+const CreateElement = Object.freeze({
+  type: 32,
+  fixedSize: 12,
+
+  /** Encoded size of a message */
+  size(elementType) {
+    return 12 + utf8Length(elementType);
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, id, elementType) {
+    view.setUint16(offset, 32, true);
+    let tail = offset + 12;
+    view.setUint32(offset + 4, id, true);
+    const elementTypeLength = encodeUtf8(view, tail, elementType);
+    view.setUint32(offset + 8, elementTypeLength, true);
+    tail += elementTypeLength;
+    return tail - offset;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, id, elementType) {
+    const offset = ring.reserve(this.size(elementType));
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, id, elementType);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 12 &&
+      view.getUint16(offset, true) === 32 &&
+      12 + view.getUint32(offset + 8, true) <= size;
+  },
+
+  id(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  elementTypeLength(view, offset) {
+    return view.getUint32(offset + 8, true);
+  },
+
+  elementType(view, offset) {
+    return decodeUtf8(view, offset + 12, view.getUint32(offset + 8, true));
+  },
+});
+
+/** UI: create a text node */
+const CreateText = Object.freeze({
+  type: 33,
+  fixedSize: 12,
+
+  /** Encoded size of a message */
+  size(text) {
+    return 12 + utf8Length(text);
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, id, text) {
+    view.setUint16(offset, 33, true);
+    let tail = offset + 12;
+    view.setUint32(offset + 4, id, true);
+    const textLength = encodeUtf8(view, tail, text);
+    view.setUint32(offset + 8, textLength, true);
+    tail += textLength;
+    return tail - offset;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, id, text) {
+    const offset = ring.reserve(this.size(text));
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, id, text);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 12 &&
+      view.getUint16(offset, true) === 33 &&
+      12 + view.getUint32(offset + 8, true) <= size;
+  },
+
+  id(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  textLength(view, offset) {
+    return view.getUint32(offset + 8, true);
+  },
+
+  text(view, offset) {
+    return decodeUtf8(view, offset + 12, view.getUint32(offset + 8, true));
+  },
+});
+
+/** UI: append a node to a parent (0 is the root container) */
+const AppendChild = Object.freeze({
+  type: 34,
+  fixedSize: 12,
+
+  /** Encoded size of a message */
+  size() {
+    return 12;
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, parent, child) {
+    view.setUint16(offset, 34, true);
+    view.setUint32(offset + 4, parent, true);
+    view.setUint32(offset + 8, child, true);
+    return 12;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, parent, child) {
+    const offset = ring.reserve(this.size());
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, parent, child);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 12 &&
+      view.getUint16(offset, true) === 34;
+  },
+
+  parent(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  child(view, offset) {
+    return view.getUint32(offset + 8, true);
+  },
+});
+
+/** UI: insert a node before a sibling */
+const InsertBefore = Object.freeze({
+  type: 35,
+  fixedSize: 16,
+
+  /** Encoded size of a message */
+  size() {
+    return 16;
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, parent, child, before) {
+    view.setUint16(offset, 35, true);
+    view.setUint32(offset + 4, parent, true);
+    view.setUint32(offset + 8, child, true);
+    view.setUint32(offset + 12, before, true);
+    return 16;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, parent, child, before) {
+    const offset = ring.reserve(this.size());
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, parent, child, before);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 16 &&
+      view.getUint16(offset, true) === 35;
+  },
+
+  parent(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  child(view, offset) {
+    return view.getUint32(offset + 8, true);
+  },
+
+  before(view, offset) {
+    return view.getUint32(offset + 12, true);
+  },
+});
+
+/** UI: detach a node from its parent */
+const RemoveChild = Object.freeze({
+  type: 36,
+  fixedSize: 12,
+
+  /** Encoded size of a message */
+  size() {
+    return 12;
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, parent, child) {
+    view.setUint16(offset, 36, true);
+    view.setUint32(offset + 4, parent, true);
+    view.setUint32(offset + 8, child, true);
+    return 12;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, parent, child) {
+    const offset = ring.reserve(this.size());
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, parent, child);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 12 &&
+      view.getUint16(offset, true) === 36;
+  },
+
+  parent(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  child(view, offset) {
+    return view.getUint32(offset + 8, true);
+  },
+});
+
+/** UI: release a detached node */
+const DestroyNode = Object.freeze({
+  type: 37,
+  fixedSize: 8,
+
+  /** Encoded size of a message */
+  size() {
+    return 8;
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, id) {
+    view.setUint16(offset, 37, true);
+    view.setUint32(offset + 4, id, true);
+    return 8;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, id) {
+    const offset = ring.reserve(this.size());
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, id);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 8 &&
+      view.getUint16(offset, true) === 37;
+  },
+
+  id(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+});
+
+/** UI: set a numeric property */
+const SetNumberProperty = Object.freeze({
+  type: 38,
+  fixedSize: 20,
+
+  /** Encoded size of a message */
+  size(property) {
+    return 20 + utf8Length(property);
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, id, value, property) {
+    view.setUint16(offset, 38, true);
+    let tail = offset + 20;
+    view.setUint32(offset + 4, id, true);
+    view.setFloat64(offset + 8, value, true);
+    const propertyLength = encodeUtf8(view, tail, property);
+    view.setUint32(offset + 16, propertyLength, true);
+    tail += propertyLength;
+    return tail - offset;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, id, value, property) {
+    const offset = ring.reserve(this.size(property));
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, id, value, property);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 20 &&
+      view.getUint16(offset, true) === 38 &&
+      20 + view.getUint32(offset + 16, true) <= size;
+  },
+
+  id(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  value(view, offset) {
+    return view.getFloat64(offset + 8, true);
+  },
+
+  propertyLength(view, offset) {
+    return view.getUint32(offset + 16, true);
+  },
+
+  property(view, offset) {
+    return decodeUtf8(view, offset + 20, view.getUint32(offset + 16, true));
+  },
+});
+
+/** UI: set a string property */
+const SetStringProperty = Object.freeze({
+  type: 39,
+  fixedSize: 16,
+
+  /** Encoded size of a message */
+  size(property, value) {
+    return 16 + utf8Length(property) + utf8Length(value);
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, id, property, value) {
+    view.setUint16(offset, 39, true);
+    let tail = offset + 16;
+    view.setUint32(offset + 4, id, true);
+    const propertyLength = encodeUtf8(view, tail, property);
+    view.setUint32(offset + 8, propertyLength, true);
+    tail += propertyLength;
+    const valueLength = encodeUtf8(view, tail, value);
+    view.setUint32(offset + 12, valueLength, true);
+    tail += valueLength;
+    return tail - offset;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, id, property, value) {
+    const offset = ring.reserve(this.size(property, value));
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, id, property, value);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 16 &&
+      view.getUint16(offset, true) === 39 &&
+      16 + view.getUint32(offset + 8, true) + view.getUint32(offset + 12, true) <= size;
+  },
+
+  id(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  propertyLength(view, offset) {
+    return view.getUint32(offset + 8, true);
+  },
+
+  property(view, offset) {
+    return decodeUtf8(view, offset + 16, view.getUint32(offset + 8, true));
+  },
+
+  valueLength(view, offset) {
+    return view.getUint32(offset + 12, true);
+  },
+
+  value(view, offset) {
+    return decodeUtf8(view, offset + 16 + view.getUint32(offset + 8, true), view.getUint32(offset + 12, true));
+  },
+});
+
+/** UI: remove a property */
+const RemoveProperty = Object.freeze({
+  type: 40,
+  fixedSize: 12,
+
+  /** Encoded size of a message */
+  size(property) {
+    return 12 + utf8Length(property);
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, id, property) {
+    view.setUint16(offset, 40, true);
+    let tail = offset + 12;
+    view.setUint32(offset + 4, id, true);
+    const propertyLength = encodeUtf8(view, tail, property);
+    view.setUint32(offset + 8, propertyLength, true);
+    tail += propertyLength;
+    return tail - offset;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, id, property) {
+    const offset = ring.reserve(this.size(property));
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, id, property);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 12 &&
+      view.getUint16(offset, true) === 40 &&
+      12 + view.getUint32(offset + 8, true) <= size;
+  },
+
+  id(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  propertyLength(view, offset) {
+    return view.getUint32(offset + 8, true);
+  },
+
+  property(view, offset) {
+    return decodeUtf8(view, offset + 12, view.getUint32(offset + 8, true));
+  },
+});
+
+/** UI: replace the content of a text node */
+const SetText = Object.freeze({
+  type: 41,
+  fixedSize: 12,
+
+  /** Encoded size of a message */
+  size(text) {
+    return 12 + utf8Length(text);
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, id, text) {
+    view.setUint16(offset, 41, true);
+    let tail = offset + 12;
+    view.setUint32(offset + 4, id, true);
+    const textLength = encodeUtf8(view, tail, text);
+    view.setUint32(offset + 8, textLength, true);
+    tail += textLength;
+    return tail - offset;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, id, text) {
+    const offset = ring.reserve(this.size(text));
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, id, text);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 12 &&
+      view.getUint16(offset, true) === 41 &&
+      12 + view.getUint32(offset + 8, true) <= size;
+  },
+
+  id(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  textLength(view, offset) {
+    return view.getUint32(offset + 8, true);
+  },
+
+  text(view, offset) {
+    return decodeUtf8(view, offset + 12, view.getUint32(offset + 8, true));
+  },
+});
+
+/** UI: animate later changes of a numeric property natively (duration in seconds, 0 disables; easing is a UiEasing) */
+const SetTransition = Object.freeze({
+  type: 42,
+  fixedSize: 24,
+
+  /** Encoded size of a message */
+  size(property) {
+    return 24 + utf8Length(property);
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, id, duration, easing, property) {
+    view.setUint16(offset, 42, true);
+    let tail = offset + 24;
+    view.setUint32(offset + 4, id, true);
+    view.setFloat64(offset + 8, duration, true);
+    view.setUint8(offset + 16, easing);
+    const propertyLength = encodeUtf8(view, tail, property);
+    view.setUint32(offset + 20, propertyLength, true);
+    tail += propertyLength;
+    return tail - offset;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, id, duration, easing, property) {
+    const offset = ring.reserve(this.size(property));
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, id, duration, easing, property);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 24 &&
+      view.getUint16(offset, true) === 42 &&
+      24 + view.getUint32(offset + 20, true) <= size;
+  },
+
+  id(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  duration(view, offset) {
+    return view.getFloat64(offset + 8, true);
+  },
+
+  easing(view, offset) {
+    return view.getUint8(offset + 16);
+  },
+
+  propertyLength(view, offset) {
+    return view.getUint32(offset + 20, true);
+  },
+
+  property(view, offset) {
+    return decodeUtf8(view, offset + 24, view.getUint32(offset + 20, true));
+  },
+});
+
+/** UI: pointer events the node listens to (bit 1 << UiEventKind) */
+const SetEventMask = Object.freeze({
+  type: 43,
+  fixedSize: 12,
+
+  /** Encoded size of a message */
+  size() {
+    return 12;
+  },
+
+  /** Encode at `offset` in `view`; returns the encoded size */
+  encode(view, offset, id, mask) {
+    view.setUint16(offset, 43, true);
+    view.setUint32(offset + 4, id, true);
+    view.setUint32(offset + 8, mask, true);
+    return 12;
+  },
+
+  /** Encode directly into a RingChannel; returns false if it is full */
+  post(ring, id, mask) {
+    const offset = ring.reserve(this.size());
+    if (offset < 0) {
+      return false;
+    }
+    this.encode(ring.view, offset, id, mask);
+    ring.commit();
+    return true;
+  },
+
+  /** Check the type and that every field lies within `size` bytes */
+  isValid(view, offset, size) {
+    return size >= 12 &&
+      view.getUint16(offset, true) === 43;
+  },
+
+  id(view, offset) {
+    return view.getUint32(offset + 4, true);
+  },
+
+  mask(view, offset) {
+    return view.getUint32(offset + 8, true);
+  },
+});
+
+module.exports = {
+  SCHEMA_VERSION,
+  MessageType,
+  getMessageType,
+  utf8Length,
+  KeyEvent,
+  MouseButtonEvent,
+  MouseMoveEvent,
+  WindowResizeEvent,
+  PointerEvent,
+  CreateElement,
+  CreateText,
+  AppendChild,
+  InsertBefore,
+  RemoveChild,
+  DestroyNode,
+  SetNumberProperty,
+  SetStringProperty,
+  RemoveProperty,
+  SetText,
+  SetTransition,
+  SetEventMask,
+};
@@ -0,0 +1,202 @@
+'use strict';
+
+// Child side of crazy::NodeWorker (include/crazy/NodeWorker.hpp).
+//
+//   node nodeWorker.js <script>
+//
+// Loads <script> and serves calls to its exports (or globals) by name over
+// the socket inherited as fd 3. Frames are a u32 payload length followed by
+// the payload, all integers little-endian:
+//
+//   request   u32 id, u8 kind (1 call, 2 ping), u32 name length, name,
+//             u32 argument count, values
+//   response  u32 id, u8 status (0 ok, 1 error), value or u32-length error
+//   value     u8 tag (0 undefined, 1 null, 2 false, 3 true, 4 f64, 5 string
+//             with u32 length)
+//
+// Requests are handled as they arrive; a function returning a promise is
+// answered when it settles, so responses may be out of order. The worker
+// exits when the host closes the socket.
+
+const net = require('net');
+const path = require('path');
+
+const REQUEST_CALL = 1;
+const REQUEST_PING = 2;
+const STATUS_OK = 0;
+const STATUS_ERROR = 1;
+
+let target = {};
+let loadError = null;
+if (process.argv[2]) {
+  try {
+    target = require(path.resolve(process.argv[2]));
+  } catch (error) {
+    loadError = error;
+    console.error(error);
+  }
+}
+
+function resolveFunction(name) {
+  for (const root of [target, globalThis]) {
+    let value = root;
+    for (const part of name.split('.')) {
+      value = value == null ? undefined : value[part];
+    }
+    if (typeof value === 'function') {
+      return value;
+    }
+  }
+  return null;
+}
+
+// Decoding
+
+function readValue(buffer, state) {
+  const tag = buffer[state.offset++];
+  switch (tag) {
+    case 0: return undefined;
+    case 1: return null;
+    case 2: return false;
+    case 3: return true;
+    case 4: {
+      const value = buffer.readDoubleLE(state.offset);
+      state.offset += 8;
+      return value;
+    }
+    case 5: {
+      const length = buffer.readUInt32LE(state.offset);
+      const value = buffer.toString('utf8', state.offset + 4, state.offset + 4 + length);
+      state.offset += 4 + length;
+      return value;
+    }
+    default:
+      throw new Error(`Invalid value tag ${tag}`);
+  }
+}
+
+// Encoding
+
+function valueSize(value) {
+  switch (typeof value) {
+    case 'number': return 9;
+    case 'string': return 5 + Buffer.byteLength(value);
+    default: return 1;
+  }
+}
+
+function writeValue(buffer, offset, value) {
+  switch (typeof value) {
+    case 'boolean':
+      buffer[offset] = value ? 3 : 2;
+      return offset + 1;
+    case 'number':
+      buffer[offset] = 4;
+      buffer.writeDoubleLE(value, offset + 1);
+      return offset + 9;
+    case 'string': {
+      buffer[offset] = 5;
+      const length = buffer.write(value, offset + 5);
+      buffer.writeUInt32LE(length, offset + 1);
+      return offset + 5 + length;
+    }
+    default:
+      // Objects, functions and symbols cross as undefined, as in NodeRuntime
+      buffer[offset] = value === null ? 1 : 0;
+      return offset + 1;
+  }
+}
+
+const socket = new net.Socket({ fd: 3, readable: true, writable: true });
+
+function respond(id, status, value) {
+  const payload = status === STATUS_OK ? valueSize(value) : 4 + Buffer.byteLength(value);
+  const frame = Buffer.allocUnsafe(4 + 5 + payload);
+  frame.writeUInt32LE(5 + payload, 0);
+  frame.writeUInt32LE(id, 4);
+  frame[8] = status;
+  if (status === STATUS_OK) {
+    writeValue(frame, 9, value);
+  } else {
+    const length = frame.write(value, 13);
+    frame.writeUInt32LE(length, 9);
+  }
+  socket.write(frame);
+}
+
+function respondError(id, error) {
+  respond(id, STATUS_ERROR, error instanceof Error ? (error.stack || error.message) : String(error));
+}
+
+function handleRequest(buffer, start, length) {
+  const state = { offset: start };
+  const id = buffer.readUInt32LE(state.offset);
+  const kind = buffer[state.offset + 4];
+  state.offset += 5;
+
+  if (kind === REQUEST_PING) {
+    respond(id, STATUS_OK, undefined);
+    return;
+  }
+  if (kind !== REQUEST_CALL) {
+    respondError(id, `Unknown request kind ${kind}`);
+    return;
+  }
+
+  let name;
+  const args = [];
+  try {
+    const nameLength = buffer.readUInt32LE(state.offset);
+    name = buffer.toString('utf8', state.offset + 4, state.offset + 4 + nameLength);
+    state.offset += 4 + nameLength;
+    const count = buffer.readUInt32LE(state.offset);
+    state.offset += 4;
+    for (let i = 0; i < count && state.offset < start + length; i++) {
+      args.push(readValue(buffer, state));
+    }
+  } catch (error) {
+    respondError(id, error);
+    return;
+  }
+
+  const fn = resolveFunction(name);
+  if (!fn) {
+    respondError(id, loadError ? `Script failed to load: ${loadError.message}` : `Function not found: ${name}`);
+    return;
+  }
+
+  let result;
+  try {
+    result = fn(...args);
+  } catch (error) {
+    respondError(id, error);
+    return;
+  }
+  if (result && typeof result.then === 'function') {
+    result.then((value) => respond(id, STATUS_OK, value), (error) => respondError(id, error));
+  } else {
+    respond(id, STATUS_OK, result);
+  }
+}
+
+let pending = null;
+
+socket.on('data', (chunk) => {
+  const buffer = pending ? Buffer.concat([pending, chunk]) : chunk;
+  let offset = 0;
+  // Responses to a burst of pipelined requests go out in one write
+  socket.cork();
+  while (buffer.length - offset >= 4) {
+    const length = buffer.readUInt32LE(offset);
+    if (buffer.length - offset - 4 < length) {
+      break;
+    }
+    handleRequest(buffer, offset + 4, length);
+    offset += 4 + length;
+  }
+  process.nextTick(() => socket.uncork());
+  pending = offset < buffer.length ? buffer.subarray(offset) : null;
+});
+
+socket.on('end', () => process.exit(0));
+socket.on('error', () => process.exit(1));
@@ -0,0 +1,235 @@
+'use strict';
+
+// JavaScript end of crazy::RingChannel (include/crazy/RingChannel.hpp).
+//
+// A single-producer/single-consumer message ring in a SharedArrayBuffer
+// shared with C++ (crazy.shared.<name> when embedded). Messages are read and
+// written in place through `view`/`bytes` at the offsets returned by
+// reserve() and peek(), so steady-state traffic allocates nothing and copies
+// nothing. Both ends must agree on the layout below.
+
+const MAGIC = 0x5a52524b;
+const VERSION = 1;
+const HEADER_SIZE = 256;
+const WRAP_MARKER = 0xffffffff;
+
+// Int32Array indices of the header fields
+const MAGIC_SLOT = 0;
+const VERSION_SLOT = 1;
+const CAPACITY_SLOT = 2;
+const WRITE_SLOT = 64 / 4;
+const READ_SLOT = 128 / 4;
+const PARKED_SLOT = 192 / 4;
+
+function recordSize(payload) {
+  return (4 + payload + 7) & ~7;
+}
+
+class RingChannel {
+  /**
+   * @param {SharedArrayBuffer|ArrayBuffer} buffer Region holding the ring
+   * @param {object} [options]
+   * @param {number} [options.byteOffset=0] Start of the ring in the buffer
+   * @param {boolean} [options.initialize=false] Write a fresh header
+   * @param {function} [options.wakeup] Called by commit() when the consumer
+   *   is parked (e.g. a native function that wakes the C++ side)
+   */
+  constructor(buffer, { byteOffset = 0, initialize = false, wakeup = null } = {}) {
+    this.header = new Int32Array(buffer, byteOffset, HEADER_SIZE / 4);
+
+    if (initialize) {
+      let capacity = 64;
+      while (capacity * 2 <= buffer.byteLength - byteOffset - HEADER_SIZE && capacity < 2 ** 30) {
+        capacity *= 2;
+      }
+      this.header.fill(0);
+      this.header[MAGIC_SLOT] = MAGIC;
+      this.header[VERSION_SLOT] = VERSION;
+      this.header[CAPACITY_SLOT] = capacity;
+    }
+
+    if (this.header[MAGIC_SLOT] !== MAGIC || this.header[VERSION_SLOT] !== VERSION) {
+      throw new Error('RingChannel: buffer does not contain a valid ring');
+    }
+
+    this.capacity = this.header[CAPACITY_SLOT] >>> 0;
+    this.mask = this.capacity - 1;
+    this.dataOffset = byteOffset + HEADER_SIZE;
+
+    /** DataView over the whole buffer; message offsets index into it */
+    this.view = new DataView(buffer);
+    /** Uint8Array over the whole buffer */
+    this.bytes = new Uint8Array(buffer);
+
+    this.wakeup = wakeup;
+    this.dropped = 0;
+
+    // Atomics on shared memory are not free, so each end keeps its own index
+    // locally and only re-reads the other end's index when the ring looks
+    // full (producer) or empty (consumer).
+    // Producer-local state
+    this._write = Atomics.load(this.header, WRITE_SLOT) >>> 0;
+    this._readCache = Atomics.load(this.header, READ_SLOT) >>> 0;
+    this._reservedEnd = -1;
+    // Consumer-local state
+    this._read = Atomics.load(this.header, READ_SLOT) >>> 0;
+    this._writeCache = Atomics.load(this.header, WRITE_SLOT) >>> 0;
+    this._peekedEnd = -1;
+    /** Payload size of the message returned by the last peek() */
+    this.size = 0;
+  }
+
+  get maxMessageSize() {
+    return this.capacity / 2 - 4;
+  }
+
+  // Producer
+
+  /**
+   * Reserve space for a message of `size` bytes. Further reserve() calls
+   * before commit() add messages after it; commit() publishes them all.
+   * @returns {number} Byte offset of the payload in `view`/`bytes`, or -1 if full
+   */
+  reserve(size) {
+    if (size > this.maxMessageSize) {
+      this.dropped++;
+      return -1;
+    }
+
+    const record = recordSize(size);
+    const write = this._reservedEnd >= 0 ? this._reservedEnd : this._write;
+    const tail = this.capacity - (write & this.mask);
+    const skip = record <= tail ? 0 : tail;
+    if (skip + record > this.capacity - ((write - this._readCache) >>> 0)) {
+      this._readCache = Atomics.load(this.header, READ_SLOT) >>> 0;
+      if (skip + record > this.capacity - ((write - this._readCache) >>> 0)) {
+        this.dropped++;
+        return -1;
+      }
+    }
+
+    if (skip > 0) {
+      this.view.setUint32(this.dataOffset + (write & this.mask), WRAP_MARKER, true);
+    }
+    const start = (write + skip) >>> 0;
+    const offset = this.dataOffset + (start & this.mask);
+    this.view.setUint32(offset, size, true);
+
+    this._reservedEnd = (start + record) >>> 0;
+    return offset + 4;
+  }
+
+  /** Publish the reserved messages, waking a parked consumer. */
+  commit() {
+    if (this._reservedEnd < 0) {
+      return;
+    }
+    this._write = this._reservedEnd;
+    this._reservedEnd = -1;
+    Atomics.store(this.header, WRITE_SLOT, this._write | 0);
+
+    if (Atomics.load(this.header, PARKED_SLOT) !== 0 &&
+        Atomics.exchange(this.header, PARKED_SLOT, 0) !== 0 &&
+        this.wakeup) {
+      this.wakeup();
+    }
+  }
+
+  /** Copy `data` (a Uint8Array) into the ring. Returns false if full. */
+  write(data) {
+    const offset = this.reserve(data.byteLength);
+    if (offset < 0) {
+      return false;
+    }
+    this.bytes.set(data, offset);
+    this.commit();
+    return true;
+  }
+
+  // Consumer
+
+  /**
+   * Look at the oldest message without removing it; its size is in `size`.
+   * @returns {number} Byte offset of the payload in `view`/`bytes`, or -1 if empty
+   */
+  peek() {
+    this._peekedEnd = -1;
+    let read = this._read;
+    if (read === this._writeCache) {
+      this._writeCache = Atomics.load(this.header, WRITE_SLOT) >>> 0;
+      if (read === this._writeCache) {
+        return -1;
+      }
+    }
+
+    let length = this.view.getUint32(this.dataOffset + (read & this.mask), true);
+    if (length === WRAP_MARKER) {
+      read = (read + this.capacity - (read & this.mask)) >>> 0;
+      length = this.view.getUint32(this.dataOffset + (read & this.mask), true);
+    }
+
+    this.size = length;
+    this._peekedEnd = (read + recordSize(length)) >>> 0;
+    return this.dataOffset + (read & this.mask) + 4;
+  }
+
+  /** Remove the message returned by the last peek(). */
+  release() {
+    if (this._peekedEnd < 0) {
+      return;
+    }
+    this._read = this._peekedEnd;
+    this._peekedEnd = -1;
+    Atomics.store(this.header, READ_SLOT, this._read | 0);
+  }
+
+  /**
+   * Call `handler(offset, size)` for each available message, in place.
+   * The space is handed back to the producer once, after the last message.
+   * @returns {number} Number of messages handled
+   */
+  drain(handler, maxMessages = Infinity) {
+    let count = 0;
+    try {
+      while (count < maxMessages) {
+        const offset = this.peek();
+        if (offset < 0) {
+          break;
+        }
+        handler(offset, this.size);
+        this._read = this._peekedEnd;
+        this._peekedEnd = -1;
+        count++;
+      }
+    } finally {
+      if (count > 0) {
+        Atomics.store(this.header, READ_SLOT, this._read | 0);
+      }
+    }
+    return count;
+  }
+
+  /**
+   * Announce that the consumer is going idle. Returns true if the ring is
+   * still empty: the producer will then call its wakeup once a message
+   * arrives. Returns false if a message arrived meanwhile.
+   */
+  park() {
+    Atomics.store(this.header, PARKED_SLOT, 1);
+    if ((Atomics.load(this.header, WRITE_SLOT) >>> 0) !== this._read) {
+      Atomics.store(this.header, PARKED_SLOT, 0);
+      return false;
+    }
+    return true;
+  }
+
+  unpark() {
+    Atomics.store(this.header, PARKED_SLOT, 0);
+  }
+
+  isEmpty() {
+    return Atomics.load(this.header, WRITE_SLOT) === Atomics.load(this.header, READ_SLOT);
+  }
+}
+
+module.exports = { RingChannel, HEADER_SIZE };
@@ -0,0 +1,405 @@
+'use strict';
+
+// react-reconciler host config targeting crazy::UiTree (include/crazy/UiTree.hpp).
+//
+// Every host operation React performs during a commit becomes a UI bridge
+// message appended to a CommandBatch; resetAfterCommit() flushes the batch,
+// so a commit costs one native call however many nodes it touches. There is
+// no DOM: instances are small records holding the node id, the props last
+// sent and the event handlers.
+//
+// Props are flattened with `style` and sent by name. Colors are converted to
+// packed 0xRRGGBBAA numbers here, so the core never parses strings. The
+// `transition` prop marks properties the core animates by itself:
+//
+//   <view style={{ x, opacity }} transition={{ x: 200, opacity: { duration: 150, easing: 'easeOut' } }} />
+//
+// Durations are in milliseconds. Event props (onClick, onPointerDown, ...)
+// set the node's event mask: C++ only reports pointer events that some node
+// on the path listens for.
+
+const M = require('../bridge/messages');
+
+/** Bit index per event prop; matches crazy::UiEventKind */
+const EVENT_KINDS = Object.freeze({
+  onPointerDown: 0,
+  onPointerUp: 1,
+  onPointerMove: 2,
+  onPointerEnter: 3,
+  onPointerLeave: 4,
+  onClick: 5,
+});
+
+/** Values of crazy::UiEasing */
+const EASINGS = Object.freeze({
+  linear: 0,
+  easeIn: 1,
+  easeOut: 2,
+  easeInOut: 3,
+});
+
+const NAMED_COLORS = Object.freeze({
+  transparent: 0x00000000,
+  black: 0x000000ff,
+  white: 0xffffffff,
+  red: 0xff0000ff,
+  green: 0x008000ff,
+  blue: 0x0000ffff,
+});
+
+const ROOT_ID = 0;
+const RESERVED_PROPS = new Set(['children', 'style', 'transition', 'key', 'ref']);
+
+function isColorProperty(name) {
+  return name === 'color' || name.endsWith('Color');
+}
+
+/**
+ * Convert a CSS-like color to a packed 0xRRGGBBAA number.
+ * Accepts numbers, #rgb, #rgba, #rrggbb, #rrggbbaa, rgb(), rgba() and a few names.
+ * @returns {number|undefined} undefined if the value is not a color
+ */
+function parseColor(value) {
+  if (typeof value === 'number') {
+    return value >>> 0;
+  }
+  if (typeof value !== 'string') {
+    return undefined;
+  }
+  const text = value.trim().toLowerCase();
+  if (text in NAMED_COLORS) {
+    return NAMED_COLORS[text];
+  }
+  if (text[0] === '#') {
+    let hex = text.slice(1);
+    if (!/^[0-9a-f]+$/.test(hex)) {
+      return undefined;
+    }
+    if (hex.length === 3 || hex.length === 4) {
+      hex = hex.replace(/./g, '$&$&');
+    }
+    if (hex.length === 6) {
+      hex += 'ff';
+    }
+    return hex.length === 8 ? parseInt(hex, 16) >>> 0 : undefined;
+  }
+  const match = /^rgba?\(([^)]*)\)$/.exec(text);
+  if (match) {
+    const parts = match[1].split(/[\s,/]+/).filter(Boolean).map(Number);
+    if ((parts.length !== 3 && parts.length !== 4) || parts.some(Number.isNaN)) {
+      return undefined;
+    }
+    const alpha = parts.length === 4 ? parts[3] : 1;
+    const channel = (v) => Math.max(0, Math.min(255, Math.round(v)));
+    return ((channel(parts[0]) << 24) | (channel(parts[1]) << 16) |
+            (channel(parts[2]) << 8) | channel(alpha * 255)) >>> 0;
+  }
+  return undefined;
+}
+
+/**
+ * Flatten props into the values sent to C++: name -> number or string.
+ * Booleans become 0/1; functions, objects and null are not sent.
+ */
+function computeAttributes(props) {
+  const attributes = new Map();
+  const add = (name, value) => {
+    if (isColorProperty(name)) {
+      const color = parseColor(value);
+      if (color !== undefined) {
+        attributes.set(name, color);
+        return;
+      }
+    }
+    if (typeof value === 'boolean') {
+      attributes.set(name, value ? 1 : 0);
+    } else if (typeof value === 'number' || typeof value === 'string') {
+      attributes.set(name, value);
+    }
+  };
+  for (const name in props) {
+    if (!RESERVED_PROPS.has(name) && !(name in EVENT_KINDS)) {
+      add(name, props[name]);
+    }
+  }
+  const style = props.style;
+  if (style) {
+    for (const name in style) {
+      add(name, style[name]);
+    }
+  }
+  return attributes;
+}
+
+/** Normalize the transition prop to name -> { duration (s), easing } */
+function computeTransitions(transition) {
+  const transitions = new Map();
+  for (const name in transition || {}) {
+    let spec = transition[name];
+    if (typeof spec === 'number') {
+      spec = { duration: spec };
+    }
+    if (!spec || !(spec.duration > 0)) {
+      continue;
+    }
+    transitions.set(name, {
+      duration: spec.duration / 1000,
+      easing: EASINGS[spec.easing] !== undefined ? EASINGS[spec.easing] : EASINGS.easeInOut,
+    });
+  }
+  return transitions;
+}
+
+function computeHandlers(props) {
+  const handlers = {};
+  let mask = 0;
+  for (const name in EVENT_KINDS) {
+    if (typeof props[name] === 'function') {
+      handlers[name] = props[name];
+      mask |= 1 << EVENT_KINDS[name];
+    }
+  }
+  return { handlers, mask };
+}
+
+/**
+ * @param {object} options
+ * @param {CommandBatch} options.batch Batch attached to the UiTree's CommandBatch
+ * @param {Map<number, object>} [options.instances] Receives id -> element instance,
+ *   used to route events
+ * @param {function} [options.getCurrentEventPriority] Priority of the update being
+ *   scheduled; defaults to DefaultEventPriority (16 in react-reconciler 0.29)
+ * @returns {object} Host config for react-reconciler 0.29
+ */
+function createHostConfig({ batch, instances = new Map(), getCurrentEventPriority = () => 16 }) {
+  let nextId = ROOT_ID + 1;
+  const allocateId = () => {
+    const id = nextId;
+    nextId = nextId === 0xffffffff ? ROOT_ID + 1 : nextId + 1;
+    return id;
+  };
+
+  function sendAttributes(instance, previous, next) {
+    const id = instance.id;
+    for (const [name, value] of next) {
+      if (previous.get(name) === value) {
+        continue;
+      }
+      if (typeof value === 'number') {
+        M.SetNumberProperty.post(batch, id, value, name);
+      } else {
+        M.SetStringProperty.post(batch, id, name, value);
+      }
+    }
+    for (const name of previous.keys()) {
+      if (!next.has(name)) {
+        M.RemoveProperty.post(batch, id, name);
+      }
+    }
+  }
+
+  function sendTransitions(instance, previous, next) {
+    for (const [name, spec] of next) {
+      const old = previous.get(name);
+      if (!old || old.duration !== spec.duration || old.easing !== spec.easing) {
+        M.SetTransition.post(batch, instance.id, spec.duration, spec.easing, name);
+      }
+    }
+    for (const name of previous.keys()) {
+      if (!next.has(name)) {
+        M.SetTransition.post(batch, instance.id, 0, 0, name);
+      }
+    }
+  }
+
+  function attach(parentId, parent, child) {
+    child.parent = parent;
+    M.AppendChild.post(batch, parentId, child.id);
+  }
+
+  function insert(parentId, parent, child, before) {
+    child.parent = parent;
+    M.InsertBefore.post(batch, parentId, child.id, before.id);
+  }
+
+  function remove(parentId, child) {
+    // DestroyNode frees the whole subtree in C++
+    child.parent = null;
+    M.RemoveChild.post(batch, parentId, child.id);
+    M.DestroyNode.post(batch, child.id);
+  }
+
+  function setHidden(instance, hidden) {
+    if (hidden) {
+      M.SetNumberProperty.post(batch, instance.id, 0, 'visible');
+    } else if (instance.attributes && instance.attributes.has('visible')) {
+      M.SetNumberProperty.post(batch, instance.id, instance.attributes.get('visible'), 'visible');
+    } else {
+      M.RemoveProperty.post(batch, instance.id, 'visible');
+    }
+  }
+
+  return {
+    supportsMutation: true,
+    supportsPersistence: false,
+    supportsHydration: false,
+    supportsMicrotasks: true,
+    isPrimaryRenderer: true,
+    noTimeout: -1,
+    scheduleTimeout: setTimeout,
+    cancelTimeout: clearTimeout,
+    scheduleMicrotask: queueMicrotask,
+
+    getRootHostContext: () => null,
+    getChildHostContext: (parentContext) => parentContext,
+    getPublicInstance: (instance) => instance,
+    getCurrentEventPriority,
+    getInstanceFromNode: () => null,
+    getInstanceFromScope: () => null,
+    beforeActiveInstanceBlur() {},
+    afterActiveInstanceBlur() {},
+    prepareScopeUpdate() {},
+    preparePortalMount() {},
+    shouldSetTextContent: () => false,
+
+    prepareForCommit: () => null,
+    resetAfterCommit() {
+      batch.flush();
+    },
+
+    createInstance(type, props) {
+      const instance = {
+        id: allocateId(),
+        type,
+        parent: null,
+        attributes: computeAttributes(props),
+        transitions: computeTransitions(props.transition),
+        handlers: null,
+        mask: 0,
+      };
+      Object.assign(instance, computeHandlers(props));
+      M.CreateElement.post(batch, instance.id, type);
+      // Initial values do not animate, so transitions can follow them
+      sendAttributes(instance, new Map(), instance.attributes);
+      sendTransitions(instance, new Map(), instance.transitions);
+      if (instance.mask !== 0) {
+        M.SetEventMask.post(batch, instance.id, instance.mask);
+      }
+      instances.set(instance.id, instance);
+      return instance;
+    },
+
+    createTextInstance(text) {
+      const instance = { id: allocateId(), text, parent: null, isText: true };
+      M.CreateText.post(batch, instance.id, text);
+      return instance;
+    },
+
+    appendInitialChild(parent, child) {
+      attach(parent.id, parent, child);
+    },
+
+    finalizeInitialChildren: () => false,
+
+    prepareUpdate(instance, type, oldProps, newProps) {
+      const attributes = computeAttributes(newProps);
+      const transitions = computeTransitions(newProps.transition);
+      const { handlers, mask } = computeHandlers(newProps);
+      let changed = attributes.size !== instance.attributes.size ||
+        transitions.size !== instance.transitions.size || mask !== instance.mask;
+      for (const [name, value] of attributes) {
+        changed = changed || instance.attributes.get(name) !== value;
+      }
+      for (const [name, spec] of transitions) {
+        const old = instance.transitions.get(name);
+        changed = changed || !old || old.duration !== spec.duration || old.easing !== spec.easing;
+      }
+      for (const name in handlers) {
+        changed = changed || handlers[name] !== instance.handlers[name];
+      }
+      return changed ? { attributes, transitions, handlers, mask } : null;
+    },
+
+    commitUpdate(instance, payload) {
+      // Transitions first so the new values animate
+      sendTransitions(instance, instance.transitions, payload.transitions);
+      sendAttributes(instance, instance.attributes, payload.attributes);
+      if (payload.mask !== instance.mask) {
+        M.SetEventMask.post(batch, instance.id, payload.mask);
+      }
+      instance.attributes = payload.attributes;
+      instance.transitions = payload.transitions;
+      instance.handlers = payload.handlers;
+      instance.mask = payload.mask;
+    },
+
+    commitTextUpdate(textInstance, oldText, newText) {
+      textInstance.text = newText;
+      M.SetText.post(batch, textInstance.id, newText);
+    },
+
+    commitMount() {},
+    resetTextContent() {},
+
+    appendChild(parent, child) {
+      attach(parent.id, parent, child);
+    },
+
+    appendChildToContainer(container, child) {
+      container.children.add(child);
+      attach(ROOT_ID, null, child);
+    },
+
+    insertBefore(parent, child, before) {
+      insert(parent.id, parent, child, before);
+    },
+
+    insertInContainerBefore(container, child, before) {
+      container.children.add(child);
+      insert(ROOT_ID, null, child, before);
+    },
+
+    removeChild(parent, child) {
+      remove(parent.id, child);
+    },
+
+    removeChildFromContainer(container, child) {
+      container.children.delete(child);
+      remove(ROOT_ID, child);
+    },
+
+    clearContainer(container) {
+      for (const child of container.children) {
+        remove(ROOT_ID, child);
+      }
+      container.children.clear();
+    },
+
+    hideInstance(instance) {
+      setHidden(instance, true);
+    },
+
+    unhideInstance(instance) {
+      setHidden(instance, false);
+    },
+
+    hideTextInstance(textInstance) {
+      setHidden(textInstance, true);
+    },
+
+    unhideTextInstance(textInstance) {
+      setHidden(textInstance, false);
+    },
+
+    detachDeletedInstance(instance) {
+      instances.delete(instance.id);
+    },
+  };
+}
+
+/** Container object passed to createContainer(); stands for the UiTree root */
+function createContainer() {
+  return { id: ROOT_ID, children: new Set() };
+}
+
+module.exports = { createHostConfig, createContainer, parseColor, EVENT_KINDS, EASINGS };
@@ -0,0 +1,158 @@
+'use strict';
+
+// React renderer for the C++ core.
+//
+//   const { CommandBatch } = require('../bridge/commandBatch');
+//   const { createRoot } = require('./renderer');
+//
+//   const batch = new CommandBatch(crazy.shared.commands, { flush: crazy.flushCommands });
+//   const root = createRoot({ batch, events: crazy.shared.uiEvents });
+//   root.render(<view style={{ width: 200, height: 80, backgroundColor: '#3478f6' }}
+//                     onClick={() => console.log('clicked')} />);
+//
+// Pointer events arrive from crazy::UiTree on the uiEvents ring, already
+// hit-tested. dispatchEvents() drains the ring and calls the handlers;
+// createRoot() registers it as crazy.dispatchUiEvents, which C++ calls
+// whenever events arrive while JavaScript is idle.
+
+const Reconciler = require('react-reconciler');
+const {
+  LegacyRoot,
+  DefaultEventPriority,
+  DiscreteEventPriority,
+  ContinuousEventPriority,
+} = require('react-reconciler/constants');
+const M = require('../bridge/messages');
+const { RingChannel } = require('../bridge/ringChannel');
+const { createHostConfig, createContainer, EVENT_KINDS } = require('./hostConfig');
+
+const HANDLER_NAMES = Object.keys(EVENT_KINDS);
+const ENTER = EVENT_KINDS.onPointerEnter;
+const LEAVE = EVENT_KINDS.onPointerLeave;
+const MOVE = EVENT_KINDS.onPointerMove;
+
+/**
+ * @param {object} options
+ * @param {CommandBatch} options.batch Batch attached to the UiTree's CommandBatch
+ * @param {SharedArrayBuffer} [options.events] Event ring (crazy.shared.uiEvents)
+ * @param {function} [options.onKey] Called with { key, scancode, mods, action }
+ * @returns {{render: function, unmount: function, dispatchEvents: function}}
+ */
+function createRoot({ batch, events = null, onKey = null }) {
+  const instances = new Map();
+  let eventPriority = DefaultEventPriority;
+  const reconciler = Reconciler(createHostConfig({
+    batch,
+    instances,
+    getCurrentEventPriority: () => eventPriority,
+  }));
+  const container = createContainer();
+  const root = reconciler.createContainer(container, LegacyRoot, null, false, null, '', console.error, null);
+  const ring = events ? new RingChannel(events) : null;
+
+  function dispatchPointer(view, offset) {
+    const kind = M.PointerEvent.kind(view, offset);
+    const target = instances.get(M.PointerEvent.target(view, offset));
+    if (!target || kind >= HANDLER_NAMES.length) {
+      return;
+    }
+    const handlerName = HANDLER_NAMES[kind];
+    let stopped = false;
+    const event = {
+      type: handlerName.slice(2, 3).toLowerCase() + handlerName.slice(3),
+      target,
+      currentTarget: target,
+      x: M.PointerEvent.x(view, offset),
+      y: M.PointerEvent.y(view, offset),
+      localX: M.PointerEvent.localX(view, offset),   // relative to target
+      localY: M.PointerEvent.localY(view, offset),
+      button: M.PointerEvent.button(view, offset),
+      mods: M.PointerEvent.mods(view, offset),
+      stopPropagation() {
+        stopped = true;
+      },
+    };
+    const bubbles = kind !== ENTER && kind !== LEAVE;
+    eventPriority = kind === MOVE || !bubbles ? ContinuousEventPriority : DiscreteEventPriority;
+    try {
+      reconciler.batchedUpdates(() => {
+        for (let node = target; node && !stopped; node = bubbles ? node.parent : null) {
+          const handler = node.handlers && node.handlers[handlerName];
+          if (handler) {
+            event.currentTarget = node;
+            handler(event);
+          }
+        }
+      });
+    } finally {
+      eventPriority = DefaultEventPriority;
+    }
+  }
+
+  function dispatch(offset, size) {
+    const view = ring.view;
+    switch (M.getMessageType(view, offset, size)) {
+      case M.MessageType.PointerEvent:
+        if (M.PointerEvent.isValid(view, offset, size)) {
+          dispatchPointer(view, offset);
+        }
+        break;
+      case M.MessageType.KeyEvent:
+        if (onKey && M.KeyEvent.isValid(view, offset, size)) {
+          const key = {
+            key: M.KeyEvent.key(view, offset),
+            scancode: M.KeyEvent.scancode(view, offset),
+            mods: M.KeyEvent.mods(view, offset),
+            action: M.KeyEvent.action(view, offset),
+          };
+          eventPriority = DiscreteEventPriority;
+          try {
+            reconciler.batchedUpdates(() => onKey(key));
+          } finally {
+            eventPriority = DefaultEventPriority;
+          }
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  /**
+   * Handle every queued event, then park the ring so C++ calls back when
+   * more arrive.
+   * @returns {number} Number of events handled
+   */
+  function dispatchEvents() {
+    if (!ring) {
+      return 0;
+    }
+    let count = 0;
+    ring.unpark();
+    do {
+      count += ring.drain(dispatch);
+    } while (!ring.park());
+    return count;
+  }
+
+  if (ring && globalThis.crazy) {
+    globalThis.crazy.dispatchUiEvents = dispatchEvents;
+    // Catch up with anything queued before the renderer existed
+    queueMicrotask(dispatchEvents);
+  }
+
+  return {
+    render(element, callback = null) {
+      reconciler.updateContainer(element, root, null, callback);
+    },
+    unmount() {
+      reconciler.updateContainer(null, root, null, null);
+      if (ring && globalThis.crazy && globalThis.crazy.dispatchUiEvents === dispatchEvents) {
+        delete globalThis.crazy.dispatchUiEvents;
+      }
+    },
+    dispatchEvents,
+  };
+}
+
+module.exports = { createRoot };
@@ -1,14 +1,14 @@
 #ifndef CRAZY_APPLICATION_HPP
 #define CRAZY_APPLICATION_HPP
 
-#include "Window.hpp"
-#include "EventHandler.hpp"
-#include "Renderer.hpp"
+#include "BasicApplication.hpp"
 #include <functional>
-#include <memory>
+#include <string>
 
 namespace crazy {
 
+class CommandBatch;
+
 /**
  * @brief Application class for coordinating the main render loop
  * 
@@ -29,8 +29,16 @@ namespace crazy {
  * 
  * return app.run();
  * @endcode
+ * 
+ * Application is the type-erased specialisation of BasicApplication: its
+ * hooks forward to callbacks that can be set at runtime. Embedders who know
+ * their callbacks at compile time can derive from BasicApplication directly
+ * to get static dispatch and policies of their choice.
+ * 
+ * If NodeRuntime is running, its event loop is run once per frame (see
+ * policy::NodePollEvents).
  */
-class Application {
+class Application : public BasicApplication<Application, policy::NodePollEvents> {
 public:
     using UpdateCallback = std::function<void(float deltaTime)>;
     using RenderCallback = std::function<void()>;
@@ -43,34 +51,15 @@ public:
      * @param width Window width in pixels
      * @param height Window height in pixels
      * @param title Window title
+     * @param startup Startup pipeline run alongside window creation (not owned), or nullptr
      */
-    Application(int width, int height, const std::string& title);
+    Application(int width, int height, const std::string& title, StartupPipeline* startup = nullptr);
     
     /**
      * @brief Destroy the Application object
      */
     ~Application();
     
-    /**
-     * @brief Initialize GLFW and the application
-     * 
-     * @return true if initialization succeeded
-     * @return false if initialization failed
-     */
-    bool initialize();
-    
-    /**
-     * @brief Run the main application loop
-     * 
-     * @return int Exit code (0 for success)
-     */
-    int run();
-    
-    /**
-     * @brief Shutdown the application
-     */
-    void shutdown();
-    
     /**
      * @brief Set the initialization callback
      * 
@@ -99,52 +88,50 @@ public:
     void setRenderCallback(RenderCallback callback);
     
     /**
-     * @brief Set the shutdown callback
+     * @brief Set the UI render callback
      * 
-     * Called once during shutdown, before cleanup.
+     * Called once per frame after the render callback, for text and UI
+     * chrome. With dynamic resolution enabled and
+     * DynamicResolutionSettings::nativeResolutionUI set, it runs after the
+     * scene has been upscaled, so the UI stays at native resolution.
      * 
-     * @param callback Shutdown callback function
+     * @param callback UI render callback function
      */
-    void setShutdownCallback(ShutdownCallback callback);
+    void setUIRenderCallback(RenderCallback callback);
     
     /**
-     * @brief Get the window object
+     * @brief Set the shutdown callback
      * 
-     * @return Window& Reference to the window
-     */
-    Window& getWindow();
-    
-    /**
-     * @brief Get the event handler
+     * Called once during shutdown, before cleanup.
      * 
-     * @return EventHandler& Reference to the event handler
+     * @param callback Shutdown callback function
      */
-    EventHandler& getEventHandler();
+    void setShutdownCallback(ShutdownCallback callback);
     
     /**
-     * @brief Get the renderer
+     * @brief Set the batch of JavaScript commands to apply each frame
      * 
-     * @return Renderer& Reference to the renderer
+     * The commands flushed since the previous frame are applied in one pass
+     * right before the render callback. The batch is not owned.
+     * 
+     * @param batch Command batch, or nullptr to stop applying
      */
-    Renderer& getRenderer();
+    void setCommandBatch(CommandBatch* batch);
     
-    /**
-     * @brief Request application exit
-     */
-    void quit();
+    // BasicApplication hooks, forwarding to the callbacks above
+    void onInit();
+    void onUpdate(float deltaTime);
+    void onRender();
+    void onRenderUI();
+    void onShutdown();
 
 private:
-    bool m_initialized;
-    std::unique_ptr<Window> m_window;
-    std::unique_ptr<EventHandler> m_eventHandler;
-    std::unique_ptr<Renderer> m_renderer;
-    
     InitCallback m_initCallback;
     UpdateCallback m_updateCallback;
     RenderCallback m_renderCallback;
+    RenderCallback m_uiRenderCallback;
     ShutdownCallback m_shutdownCallback;
-    
-    double m_lastFrameTime;
+    CommandBatch* m_commandBatch;
 };
 
 } // namespace crazy
@@ -0,0 +1,248 @@
+#ifndef CRAZY_APPLICATION_BASE_HPP
+#define CRAZY_APPLICATION_BASE_HPP
+
+#include "Window.hpp"
+#include "EventHandler.hpp"
+#include "Renderer.hpp"
+#include "DynamicResolution.hpp"
+#include "FrameCapture.hpp"
+#include "FrameThrottle.hpp"
+#include "ImageCache.hpp"
+#include "JobSystem.hpp"
+#include "StartupPipeline.hpp"
+#include <memory>
+#include <string>
+
+namespace crazy {
+
+/**
+ * @brief Non-template core shared by every BasicApplication instantiation
+ *
+ * Owns GLFW, the window, the event handler, the renderer and the dynamic
+ * resolution controller, and implements the individual steps of a frame.
+ * The loop that strings the steps together and calls user code lives in
+ * BasicApplication, so it can be specialised and inlined per application
+ * type while this part is compiled once.
+ */
+class ApplicationBase {
+public:
+    // Disable copy construction and assignment
+    ApplicationBase(const ApplicationBase&) = delete;
+    ApplicationBase& operator=(const ApplicationBase&) = delete;
+
+    /**
+     * @brief Check if GLFW, the window and the context were set up
+     *
+     * @return true if the application can run
+     */
+    bool isInitialized() const;
+
+    /**
+     * @brief Get the window object
+     *
+     * @return Window& Reference to the window
+     */
+    Window& getWindow();
+
+    /**
+     * @brief Get the event handler
+     *
+     * @return EventHandler& Reference to the event handler
+     */
+    EventHandler& getEventHandler();
+
+    /**
+     * @brief Get the renderer
+     *
+     * @return Renderer& Reference to the renderer
+     */
+    Renderer& getRenderer();
+
+    /**
+     * @brief Get the dynamic resolution controller
+     *
+     * Disabled by default; enable it to render the scene at a resolution
+     * that adapts to the frame-time budget.
+     *
+     * @return DynamicResolution& Reference to the controller
+     */
+    DynamicResolution& getDynamicResolution();
+
+    /**
+     * @brief Get the frame-loop throttle
+     *
+     * Enabled by default: minimised and hidden windows stop rendering,
+     * unfocused ones render at a reduced rate.
+     *
+     * @return FrameThrottle& Reference to the throttle
+     */
+    FrameThrottle& getFrameThrottle();
+
+    /**
+     * @brief Get the frame capture
+     *
+     * Inactive until started; while active, every presented frame is read
+     * back asynchronously and written to disk. Stopped on shutdown.
+     *
+     * @return FrameCapture& Reference to the frame capture
+     */
+    FrameCapture& getFrameCapture();
+
+    /**
+     * @brief Get the image cache
+     *
+     * Updated at the start of every frame; its textures are deleted on
+     * shutdown, before the window and its GL context.
+     *
+     * @return ImageCache& Reference to the image cache
+     */
+    ImageCache& getImageCache();
+
+    /**
+     * @brief Get the job system shared by the application and its subsystems
+     *
+     * Created on first use, with the main thread as owner thread, so call
+     * it from the main thread first (e.g. from the update callback). Its
+     * workers are stopped before the renderer and window are released.
+     *
+     * @return JobSystem& Reference to the job system
+     */
+    JobSystem& getJobSystem();
+
+    /**
+     * @brief Set the maximum number of frames the CPU may queue ahead of the GPU
+     *
+     * Shorthand for getRenderer().setMaxFramesInFlight(). Lower values reduce
+     * input latency, higher values absorb CPU/GPU jitter. Defaults to 2.
+     *
+     * @param frames Number of frames in flight (1 to 8)
+     */
+    void setMaxFramesInFlight(int frames);
+
+    /**
+     * @brief Request application exit
+     */
+    void quit();
+
+protected:
+    /**
+     * @brief Initialize GLFW, create the window and make its context current
+     *
+     * With a startup pipeline, its worker stages are started first, so
+     * they run while the window is created, and window creation is
+     * recorded in its timeline. The pipeline is stopped before the job
+     * system ordering its stages is destroyed.
+     *
+     * @param width Window width in pixels
+     * @param height Window height in pixels
+     * @param title Window title
+     * @param startup Startup pipeline (not owned), or nullptr
+     */
+    ApplicationBase(int width, int height, const std::string& title, StartupPipeline* startup = nullptr);
+
+    /**
+     * @brief Release all resources (no user callbacks are invoked)
+     */
+    ~ApplicationBase();
+
+    // Frame steps, in the order BasicApplication::run() calls them
+
+    /**
+     * @brief Run the startup stages the first frame waits for
+     *
+     * @return true if there is no startup pipeline or its required stages succeeded
+     */
+    bool finishStartup();
+
+    /**
+     * @brief Log startup information and reset frame timing
+     */
+    void beginRun();
+
+    /**
+     * @brief Check if the main loop should keep going
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Re-evaluate the throttle state
+     *
+     * Restarts frame timing when rendering resumes after a suspension.
+     *
+     * @return true if a frame should be rendered, false while suspended
+     */
+    bool updateThrottle();
+
+    /**
+     * @brief Sleep as long as the throttle state asks for
+     */
+    void waitThrottled();
+
+    /**
+     * @brief Compute the delta time, wait for a free frame slot, tie pending
+     *        input to the frame and run deferred main-thread startup stages
+     *
+     * @return float Seconds since the previous frame
+     */
+    float beginFrame();
+
+    /**
+     * @brief Follow the framebuffer size with the viewport and redirect
+     *        scene rendering offscreen if dynamic resolution is on
+     */
+    void beginScene();
+
+    /**
+     * @brief Check if the UI pass runs after the upscale, at native resolution
+     */
+    bool isNativeResolutionUI() const;
+
+    /**
+     * @brief Upscale the scene to the window if dynamic resolution is on
+     */
+    void endScene();
+
+    /**
+     * @brief Queue the frame capture readback, fence the frame, adapt the
+     *        render scale and swap buffers
+     */
+    void endFrame();
+
+    /**
+     * @brief Check if the framebuffer size changed since the last frame
+     *
+     * The window refresh callback renders a frame when this is true, so
+     * content keeps up while the platform blocks the loop during a resize.
+     */
+    bool needsResizeFrame() const;
+
+    /**
+     * @brief Log shutdown of the main loop
+     */
+    void endRun();
+
+    /**
+     * @brief Stop the job system, destroy the renderer, event handler and window, then terminate GLFW
+     */
+    void releaseCore();
+
+private:
+    bool m_initialized;
+    std::unique_ptr<Window> m_window;
+    std::unique_ptr<EventHandler> m_eventHandler;
+    std::unique_ptr<Renderer> m_renderer;
+    std::unique_ptr<DynamicResolution> m_dynamicResolution;
+    std::unique_ptr<FrameThrottle> m_frameThrottle;
+    std::unique_ptr<FrameCapture> m_frameCapture;
+    std::unique_ptr<ImageCache> m_imageCache;
+    std::unique_ptr<JobSystem> m_jobSystem;
+    StartupPipeline* m_startup;             // Cleared once startup completed and a frame was shown
+
+    double m_lastFrameTime;
+    int m_frameWidth;                       // Framebuffer size of the last frame, -1 before the first
+    int m_frameHeight;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_APPLICATION_BASE_HPP
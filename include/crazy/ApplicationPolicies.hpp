@@ -0,0 +1,323 @@
+#ifndef CRAZY_APPLICATION_POLICIES_HPP
+#define CRAZY_APPLICATION_POLICIES_HPP
+
+#include "NodeRuntime.hpp"
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace crazy {
+
+/**
+ * @brief Compile-time policies for BasicApplication
+ *
+ * Each policy declares the category it belongs to through a nested
+ * @c PolicyCategory type. BasicApplication picks at most one policy per
+ * category from its parameter pack and falls back to a default for the rest,
+ * so policies can be listed in any order:
+ *
+ * @code
+ * class Game : public crazy::BasicApplication<Game,
+ *                                             crazy::policy::FixedRatePacing<120>,
+ *                                             crazy::policy::WaitEvents> { ... };
+ * @endcode
+ */
+namespace policy {
+
+// Policy categories
+struct PacingTag {};
+struct ThreadingTag {};
+struct EventsTag {};
+
+// Pacing: how frames are spaced in time
+
+/**
+ * @brief Present on vertical blank (swap interval 1)
+ */
+struct VSyncPacing {
+    using PolicyCategory = PacingTag;
+    static constexpr int kSwapInterval = 1;
+
+    void waitForNextFrame() {}
+};
+
+/**
+ * @brief Present immediately and start the next frame right away
+ */
+struct UncappedPacing {
+    using PolicyCategory = PacingTag;
+    static constexpr int kSwapInterval = 0;
+
+    void waitForNextFrame() {}
+};
+
+/**
+ * @brief Present immediately, then sleep to hold a fixed frame rate
+ *
+ * @tparam FramesPerSecond Target frame rate
+ */
+template <int FramesPerSecond>
+struct FixedRatePacing {
+    static_assert(FramesPerSecond > 0, "FixedRatePacing needs a positive frame rate");
+
+    using PolicyCategory = PacingTag;
+    static constexpr int kSwapInterval = 0;
+
+    void waitForNextFrame() {
+        using Clock = std::chrono::steady_clock;
+        const auto period = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / FramesPerSecond));
+
+        auto now = Clock::now();
+        // Resynchronise instead of bursting after a long stall
+        if (m_deadline.time_since_epoch().count() == 0 || now - m_deadline > period) {
+            m_deadline = now;
+        }
+        m_deadline += period;
+        std::this_thread::sleep_until(m_deadline);
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_deadline{};
+};
+
+// Threading: how work from other threads reaches the frame loop
+
+/**
+ * @brief Everything runs on the main thread
+ *
+ * post() is not thread-safe and must only be called from the main thread;
+ * posted tasks run at the start of the next frame.
+ */
+struct SingleThreaded {
+    using PolicyCategory = ThreadingTag;
+    using Task = std::function<void()>;
+
+    void post(Task task) {
+        m_tasks.push_back(std::move(task));
+    }
+
+    void runPendingTasks() {
+        if (m_tasks.empty()) {
+            return;
+        }
+        m_running.swap(m_tasks);
+        for (Task& task : m_running) {
+            task();
+        }
+        m_running.clear();
+    }
+
+private:
+    std::vector<Task> m_tasks;
+    std::vector<Task> m_running;
+};
+
+/**
+ * @brief Any thread may post tasks to run on the main thread
+ *
+ * Posting wakes a loop blocked in WaitEvents.
+ */
+struct MainThreadQueue {
+    using PolicyCategory = ThreadingTag;
+    using Task = std::function<void()>;
+
+    void post(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        glfwPostEmptyEvent();
+    }
+
+    void runPendingTasks() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_tasks.empty()) {
+                return;
+            }
+            m_running.swap(m_tasks);
+        }
+        for (Task& task : m_running) {
+            task();
+        }
+        m_running.clear();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<Task> m_tasks;
+    std::vector<Task> m_running;
+};
+
+// Events: how the loop drains the platform event queue
+
+/**
+ * @brief Process pending events and return immediately (continuous rendering)
+ */
+struct PollEvents {
+    using PolicyCategory = EventsTag;
+
+    void processEvents() {
+        glfwPollEvents();
+    }
+
+    void requestFrame() {}
+};
+
+/**
+ * @brief Sleep until an event arrives (on-demand rendering)
+ *
+ * An idle application uses no CPU. requestFrame() makes the next wait
+ * return immediately, e.g. while an animation is running.
+ */
+struct WaitEvents {
+    using PolicyCategory = EventsTag;
+
+    void processEvents() {
+        if (m_frameRequested) {
+            m_frameRequested = false;
+            glfwPollEvents();
+        } else {
+            glfwWaitEvents();
+        }
+    }
+
+    void requestFrame() {
+        m_frameRequested = true;
+    }
+
+private:
+    bool m_frameRequested = false;
+};
+
+/**
+ * @brief Continuous rendering that also runs the embedded Node.js event loop
+ *
+ * After polling GLFW, ready libuv callbacks (JS timers, I/O, promises they
+ * settle) run for at most kTimeSlice seconds. Does nothing extra while
+ * NodeRuntime is not running.
+ */
+struct NodePollEvents {
+    using PolicyCategory = EventsTag;
+    static constexpr double kTimeSlice = 0.002;
+
+    void processEvents() {
+        glfwPollEvents();
+        NodeRuntime& node = NodeRuntime::instance();
+        if (node.isRunning()) {
+            node.runPendingEvents(kTimeSlice);
+        }
+    }
+
+    void requestFrame() {}
+};
+
+/**
+ * @brief On-demand rendering that wakes up for the embedded Node.js event loop
+ *
+ * Like WaitEvents, but while NodeRuntime is running a helper thread watches
+ * libuv and posts an empty GLFW event when I/O is ready or a JS timer is
+ * due. The main thread then runs the ready callbacks for at most kTimeSlice
+ * seconds and renders a frame. An idle application sleeps in
+ * glfwWaitEvents() with no polling.
+ *
+ * Where the watcher is unavailable (Windows), falls back to NodePollEvents
+ * behaviour.
+ */
+struct NodeWaitEvents {
+    using PolicyCategory = EventsTag;
+    static constexpr double kTimeSlice = 0.002;
+
+    ~NodeWaitEvents() {
+        if (m_watching) {
+            NodeRuntime::instance().stopEventWatcher();
+        }
+    }
+
+    void processEvents() {
+        NodeRuntime& node = NodeRuntime::instance();
+        if (!node.isRunning()) {
+            m_watching = false;
+            waitOrPoll();
+            return;
+        }
+
+        // The runtime may start after the application
+        if (!m_watching && !m_unsupported) {
+            m_watching = node.startEventWatcher([] { glfwPostEmptyEvent(); });
+            m_unsupported = !m_watching;
+        }
+
+        if (m_watching) {
+            node.armEventWatcher();
+            waitOrPoll();
+            node.disarmEventWatcher();
+        } else {
+            glfwPollEvents();
+        }
+
+        // Budget ran out: keep going next frame without waiting
+        if (node.runPendingEvents(kTimeSlice)) {
+            m_frameRequested = true;
+        }
+    }
+
+    void requestFrame() {
+        m_frameRequested = true;
+    }
+
+private:
+    void waitOrPoll() {
+        if (m_frameRequested) {
+            m_frameRequested = false;
+            glfwPollEvents();
+        } else {
+            glfwWaitEvents();
+        }
+    }
+
+    bool m_frameRequested = false;
+    bool m_watching = false;
+    bool m_unsupported = false;
+};
+
+/**
+ * @brief Select the policy of a category from a pack, or a default
+ *
+ * @tparam Tag Policy category
+ * @tparam Default Policy used when the pack has none of this category
+ */
+template <typename Tag, typename Default, typename... Policies>
+struct Select {
+    using type = Default;
+};
+
+template <typename Tag, typename Default, typename First, typename... Rest>
+struct Select<Tag, Default, First, Rest...> {
+    using type = std::conditional_t<std::is_same_v<typename First::PolicyCategory, Tag>,
+                                    First,
+                                    typename Select<Tag, Default, Rest...>::type>;
+};
+
+template <typename Tag, typename Default, typename... Policies>
+using SelectT = typename Select<Tag, Default, Policies...>::type;
+
+/**
+ * @brief Count the policies of a category in a pack
+ */
+template <typename Tag, typename... Policies>
+constexpr int count() {
+    return (0 + ... + (std::is_same_v<typename Policies::PolicyCategory, Tag> ? 1 : 0));
+}
+
+} // namespace policy
+
+} // namespace crazy
+
+#endif // CRAZY_APPLICATION_POLICIES_HPP
@@ -0,0 +1,210 @@
+#ifndef CRAZY_ASSET_PACK_HPP
+#define CRAZY_ASSET_PACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace crazy {
+
+/**
+ * @brief What an asset pack entry contains
+ */
+enum class AssetKind : std::uint16_t {
+    Raw = 0,        ///< File bytes as they were packed
+    Texture = 1     ///< Decoded image, see AssetTexture
+};
+
+/**
+ * @brief Pixel layout of a packed texture
+ */
+enum class AssetTextureFormat : std::uint32_t {
+    RGBA8 = 1       ///< 8-bit RGBA, straight alpha (GL_RGBA8 / GL_RGBA / GL_UNSIGNED_BYTE)
+};
+
+/**
+ * @brief Description of an asset pack entry
+ */
+struct AssetInfo {
+    std::string_view name;              ///< Path relative to the packed directory, '/' separated
+    std::size_t size = 0;               ///< Size in bytes once decompressed
+    std::size_t storedSize = 0;         ///< Size in bytes in the pack
+    AssetKind kind = AssetKind::Raw;    ///< Content type
+    bool compressed = false;            ///< Stored as an LZ4 block
+};
+
+/**
+ * @brief Texture ready for glTexImage2D()
+ *
+ * Rows are stored top to bottom, rowStride bytes apart (a multiple of 4,
+ * so the default GL_UNPACK_ALIGNMENT works).
+ */
+struct AssetTexture {
+    std::uint32_t width = 0;            ///< Width in pixels
+    std::uint32_t height = 0;           ///< Height in pixels
+    std::uint32_t rowStride = 0;        ///< Bytes from one row to the next
+    AssetTextureFormat format = AssetTextureFormat::RGBA8; ///< Pixel layout
+    const std::uint8_t* pixels = nullptr; ///< First row; points into the pack or the caller's scratch buffer
+};
+
+/**
+ * @brief Read-only archive of the application's assets
+ *
+ * A pack is built ahead of time by tools/asset-pack/pack.js (or the
+ * crazy_add_asset_pack() CMake function) from a directory of fonts,
+ * images, shaders and the JS bundle. At run time the whole file is mapped
+ * into memory; a lookup is a binary search over a sorted index at the
+ * front of the file, and uncompressed entries are returned as views into
+ * the mapping, so loading an asset costs page faults instead of
+ * open()/read() calls and copies.
+ *
+ * Entries may be LZ4-compressed, in which case read() decompresses them
+ * on demand. PNG images are decoded by the build step into textures that
+ * can be handed to OpenGL as they are:
+ *
+ * @code
+ * crazy::AssetPack pack;
+ * if (pack.open("assets.pack")) {
+ *     std::string_view shader = pack.view("shaders/ui.frag");
+ *
+ *     std::vector<std::uint8_t> scratch;
+ *     crazy::AssetTexture logo;
+ *     if (pack.getTexture("images/logo.png", logo, scratch)) {
+ *         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, logo.width, logo.height, 0,
+ *                      GL_RGBA, GL_UNSIGNED_BYTE, logo.pixels);
+ *     }
+ * }
+ * @endcode
+ *
+ * File layout (little-endian, every section 64-byte aligned):
+ *
+ *   header   "CRZPACK1", u32 version, u32 entry count, u64 index offset,
+ *            u64 names offset, u64 names size, u64 file size
+ *   index    32-byte entries sorted by name: u64 data offset,
+ *            u32 stored size, u32 size, u32 name offset, u32 name length,
+ *            u16 kind, u8 compression (0 none, 1 LZ4 block), u8, u32
+ *   names    entry names, not terminated
+ *   data     entry payloads; a texture payload starts with u32 width,
+ *            u32 height, u32 format, u32 row stride, then the pixels
+ *
+ * Once open, all const methods are thread-safe, so assets can be loaded
+ * from jobs. On Windows the file is read into memory instead of mapped.
+ */
+class AssetPack {
+public:
+    /**
+     * @brief Construct a closed pack
+     */
+    AssetPack();
+
+    /**
+     * @brief Unmap the pack
+     */
+    ~AssetPack();
+
+    AssetPack(AssetPack&& other) noexcept;
+    AssetPack& operator=(AssetPack&& other) noexcept;
+
+    // Disable copy construction and assignment
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    /**
+     * @brief Map a pack file and validate its index
+     *
+     * @param path Path of the pack
+     * @return true on success; on failure the pack stays closed
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmap the pack; views obtained from it become invalid
+     */
+    void close();
+
+    /**
+     * @brief Check if a pack is open
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Get the number of entries
+     */
+    std::size_t getEntryCount() const;
+
+    /**
+     * @brief Describe the entry at a position of the sorted index
+     *
+     * @return true if @p index is in range
+     */
+    bool getInfo(std::size_t index, AssetInfo& info) const;
+
+    /**
+     * @brief Look an entry up by name
+     *
+     * @return true if the pack contains @p name
+     */
+    bool find(std::string_view name, AssetInfo& info) const;
+
+    /**
+     * @brief Check if the pack contains an entry
+     */
+    bool contains(std::string_view name) const;
+
+    /**
+     * @brief Get the stored bytes of an uncompressed entry without copying
+     *
+     * The view stays valid until the pack is closed.
+     *
+     * @return The bytes, or an empty view if the entry is missing or compressed
+     */
+    std::string_view view(std::string_view name) const;
+
+    /**
+     * @brief Get the bytes of an entry, decompressing it if needed
+     *
+     * @param name Entry name
+     * @param data Receives the bytes (replaced, not appended)
+     * @return true on success
+     */
+    bool read(std::string_view name, std::vector<std::uint8_t>& data) const;
+
+    /**
+     * @brief Get a texture entry ready for upload
+     *
+     * Uncompressed textures point into the mapping; compressed ones are
+     * decompressed into @p scratch, which must outlive the use of
+     * texture.pixels.
+     *
+     * @return true if @p name is a valid texture entry
+     */
+    bool getTexture(std::string_view name, AssetTexture& texture, std::vector<std::uint8_t>& scratch) const;
+
+    /**
+     * @brief Ask the OS to start reading an entry's pages in the background
+     *
+     * Useful shortly before an asset is needed, e.g. for the next screen.
+     */
+    void prefetch(std::string_view name) const;
+
+private:
+    struct Entry;
+
+    const Entry* findEntry(std::string_view name) const;
+    std::string_view entryName(const Entry& entry) const;
+    void describe(const Entry& entry, AssetInfo& info) const;
+    bool validate(const std::string& path);
+
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+    const Entry* m_entries;
+    std::size_t m_entryCount;
+    const char* m_names;
+    std::vector<std::uint8_t> m_buffer;  // File contents where mapping is not available
+};
+
+} // namespace crazy
+
+#endif // CRAZY_ASSET_PACK_HPP
@@ -0,0 +1,216 @@
+#ifndef CRAZY_BASIC_APPLICATION_HPP
+#define CRAZY_BASIC_APPLICATION_HPP
+
+#include "ApplicationBase.hpp"
+#include "ApplicationPolicies.hpp"
+#include "Log.hpp"
+
+namespace crazy {
+
+/**
+ * @brief Compile-time application with static callback dispatch
+ *
+ * The main loop calls the derived class's hooks directly, so hot per-frame
+ * code can be inlined and there is no type erasure or null check per call.
+ * Hooks that the derived class does not declare fall back to the empty
+ * defaults below and compile away.
+ *
+ * Pacing, threading and event handling are chosen with policies from
+ * crazy::policy (see ApplicationPolicies.hpp). Defaults are VSyncPacing,
+ * SingleThreaded and PollEvents. Application uses NodePollEvents instead of
+ * PollEvents so that an embedded NodeRuntime keeps running.
+ *
+ * On top of the pacing policy, getFrameThrottle() lowers the rate of
+ * unfocused windows and suspends minimised and hidden ones.
+ *
+ * onShutdown() is called by shutdown(). The base destructor cannot call it
+ * because the derived part is already destroyed by then, so derived classes
+ * that rely on it should call shutdown() from their own destructor, as
+ * Application does.
+ *
+ * Example usage:
+ * @code
+ * class Demo : public crazy::BasicApplication<Demo, crazy::policy::WaitEvents> {
+ * public:
+ *     Demo() : BasicApplication(800, 600, "Demo") {}
+ *     ~Demo() { shutdown(); }
+ *
+ *     void onUpdate(float deltaTime) { m_angle += deltaTime; }
+ *     void onRender() { getRenderer().clear(); }
+ *
+ * private:
+ *     float m_angle = 0.0f;
+ * };
+ *
+ * int main() { return Demo().run(); }
+ * @endcode
+ *
+ * @tparam Derived The application class (CRTP)
+ * @tparam Policies Pacing, threading and event policies, in any order
+ */
+template <typename Derived, typename... Policies>
+class BasicApplication : public ApplicationBase {
+public:
+    using PacingPolicy = policy::SelectT<policy::PacingTag, policy::VSyncPacing, Policies...>;
+    using ThreadingPolicy = policy::SelectT<policy::ThreadingTag, policy::SingleThreaded, Policies...>;
+    using EventPolicy = policy::SelectT<policy::EventsTag, policy::PollEvents, Policies...>;
+    using Task = typename ThreadingPolicy::Task;
+
+    static_assert(policy::count<policy::PacingTag, Policies...>() <= 1,
+                  "BasicApplication takes at most one pacing policy");
+    static_assert(policy::count<policy::ThreadingTag, Policies...>() <= 1,
+                  "BasicApplication takes at most one threading policy");
+    static_assert(policy::count<policy::EventsTag, Policies...>() <= 1,
+                  "BasicApplication takes at most one event policy");
+
+    /**
+     * @brief Initialize GLFW, create the window and apply the pacing policy
+     *
+     * @param width Window width in pixels
+     * @param height Window height in pixels
+     * @param title Window title
+     * @param startup Startup pipeline run alongside window creation (not owned), or nullptr
+     */
+    BasicApplication(int width, int height, const std::string& title, StartupPipeline* startup = nullptr)
+        : ApplicationBase(width, height, title, startup)
+    {
+        if (isInitialized()) {
+            glfwSwapInterval(PacingPolicy::kSwapInterval);
+        }
+    }
+
+    /**
+     * @brief Call the derived class's onInit() hook
+     *
+     * @return true if initialization succeeded
+     * @return false if initialization failed
+     */
+    bool initialize() {
+        if (!isInitialized()) {
+            CRAZY_LOG_ERROR("Application initialization failed");
+            return false;
+        }
+        derived().onInit();
+        return true;
+    }
+
+    /**
+     * @brief Run the main application loop
+     *
+     * @return int Exit code (0 for success)
+     */
+    int run() {
+        if (!isInitialized()) {
+            CRAZY_LOG_ERROR("Cannot run uninitialized application");
+            return -1;
+        }
+        if (!finishStartup() || !initialize()) {
+            return -1;
+        }
+
+        beginRun();
+
+        // While the window is dragged, Windows and macOS block inside the
+        // event processing below and only call back for refreshes; render
+        // from there so content follows the new size instead of freezing
+        getEventHandler().setWindowRefreshCallback([this]() {
+            if (isRunning() && needsResizeFrame()) {
+                renderFrame();
+            }
+        });
+
+        while (isRunning()) {
+            m_threading.runPendingTasks();
+
+            // Minimised or hidden: keep tasks and events going, render nothing
+            if (!updateThrottle()) {
+                waitThrottled();
+                m_events.processEvents();
+                continue;
+            }
+
+            renderFrame();
+            m_pacing.waitForNextFrame();
+            waitThrottled();
+
+            m_events.processEvents();
+        }
+
+        getEventHandler().setWindowRefreshCallback(nullptr);
+        endRun();
+        return 0;
+    }
+
+    /**
+     * @brief Call the derived class's onShutdown() hook and release resources
+     */
+    void shutdown() {
+        if (!isInitialized()) {
+            return;
+        }
+        derived().onShutdown();
+        releaseCore();
+    }
+
+    /**
+     * @brief Queue a task to run on the main thread at the start of the next frame
+     *
+     * Thread-safe only with policy::MainThreadQueue.
+     *
+     * @param task Task to run
+     */
+    void post(Task task) {
+        m_threading.post(std::move(task));
+    }
+
+    /**
+     * @brief Ask for another frame even if no event arrives
+     *
+     * Only meaningful with policy::WaitEvents; continuous policies always
+     * render the next frame.
+     */
+    void requestFrame() {
+        m_events.requestFrame();
+    }
+
+    // Default hooks; the derived class hides the ones it needs
+    void onInit() {}
+    void onUpdate(float) {}
+    void onRender() {}
+    void onRenderUI() {}
+    void onShutdown() {}
+
+protected:
+    ~BasicApplication() = default;
+
+private:
+    Derived& derived() { return static_cast<Derived&>(*this); }
+
+    void renderFrame() {
+        float deltaTime = beginFrame();
+        derived().onUpdate(deltaTime);
+
+        // Scene (offscreen when dynamic resolution is enabled)
+        beginScene();
+        derived().onRender();
+
+        const bool nativeResolutionUI = isNativeResolutionUI();
+        if (!nativeResolutionUI) {
+            derived().onRenderUI();
+        }
+        endScene();
+        if (nativeResolutionUI) {
+            derived().onRenderUI();
+        }
+
+        endFrame();
+    }
+
+    PacingPolicy m_pacing;
+    ThreadingPolicy m_threading;
+    EventPolicy m_events;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_BASIC_APPLICATION_HPP
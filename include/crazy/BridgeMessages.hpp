@@ -0,0 +1,1481 @@
+// Generated by tools/bridge-codegen/generate.js from schema/bridge-messages.json.
+// Do not edit: change the schema and rebuild the bridge_messages target.
+#ifndef CRAZY_BRIDGE_MESSAGES_HPP
+#define CRAZY_BRIDGE_MESSAGES_HPP
+
+#include "crazy/RingChannel.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace crazy {
+namespace bridge {
+
+/**
+ * @brief Version of the message schema; both ends must agree on it
+ */
+constexpr std::uint32_t kSchemaVersion = 1;
+
+/**
+ * @brief Type id stored in the first two bytes of every message
+ */
+enum class MessageType : std::uint16_t {
+    Invalid = 0,
+    KeyEvent = 1,
+    MouseButtonEvent = 2,
+    MouseMoveEvent = 3,
+    WindowResizeEvent = 4,
+    PointerEvent = 5,
+    CreateElement = 32,
+    CreateText = 33,
+    AppendChild = 34,
+    InsertBefore = 35,
+    RemoveChild = 36,
+    DestroyNode = 37,
+    SetNumberProperty = 38,
+    SetStringProperty = 39,
+    RemoveProperty = 40,
+    SetText = 41,
+    SetTransition = 42,
+    SetEventMask = 43,
+};
+
+namespace detail {
+
+// Messages follow a 4-byte length prefix in the ring, so fields are not
+// necessarily aligned in memory; memcpy compiles to a plain load/store.
+template <typename T>
+inline T load(const unsigned char* address) {
+    T value;
+    std::memcpy(&value, address, sizeof(T));
+    return value;
+}
+
+template <typename T>
+inline void store(unsigned char* address, T value) {
+    std::memcpy(address, &value, sizeof(T));
+}
+
+inline unsigned char* storeString(unsigned char* address, std::string_view value) {
+    if (!value.empty()) {
+        std::memcpy(address, value.data(), value.size());
+    }
+    return address + value.size();
+}
+
+} // namespace detail
+
+/**
+ * @brief Get the type of an encoded message
+ *
+ * @return MessageType::Invalid if the message is too short to have one
+ */
+inline MessageType getMessageType(const void* data, std::uint32_t size) {
+    if (size < 2) {
+        return MessageType::Invalid;
+    }
+    return static_cast<MessageType>(detail::load<std::uint16_t>(static_cast<const unsigned char*>(data)));
+}
+
+/**
+ * @brief Keyboard key pressed, released or repeated (GLFW key codes)
+ */
+struct KeyEvent {
+    static constexpr MessageType kType = MessageType::KeyEvent;
+    static constexpr std::uint32_t kKeyOffset = 4;
+    static constexpr std::uint32_t kScancodeOffset = 8;
+    static constexpr std::uint32_t kModsOffset = 12;
+    static constexpr std::uint32_t kActionOffset = 16;
+    static constexpr std::uint32_t kFixedSize = 17;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size() {
+        return kFixedSize;
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::int32_t key, std::int32_t scancode, std::int32_t mods, std::uint8_t action) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kKeyOffset, key);
+        detail::store(data + kScancodeOffset, scancode);
+        detail::store(data + kModsOffset, mods);
+        detail::store(data + kActionOffset, action);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::int32_t key, std::int32_t scancode, std::int32_t mods, std::uint8_t action) {
+        void* out = ring.reserve(size());
+        if (!out) {
+            return false;
+        }
+        encode(out, key, scancode, mods, action);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType);
+        }
+
+        std::int32_t key() const {
+            return detail::load<std::int32_t>(m_data + kKeyOffset);
+        }
+
+        std::int32_t scancode() const {
+            return detail::load<std::int32_t>(m_data + kScancodeOffset);
+        }
+
+        std::int32_t mods() const {
+            return detail::load<std::int32_t>(m_data + kModsOffset);
+        }
+
+        std::uint8_t action() const {
+            return detail::load<std::uint8_t>(m_data + kActionOffset);
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief Mouse button pressed or released
+ */
+struct MouseButtonEvent {
+    static constexpr MessageType kType = MessageType::MouseButtonEvent;
+    static constexpr std::uint32_t kButtonOffset = 4;
+    static constexpr std::uint32_t kModsOffset = 8;
+    static constexpr std::uint32_t kActionOffset = 12;
+    static constexpr std::uint32_t kFixedSize = 13;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size() {
+        return kFixedSize;
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::int32_t button, std::int32_t mods, std::uint8_t action) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kButtonOffset, button);
+        detail::store(data + kModsOffset, mods);
+        detail::store(data + kActionOffset, action);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::int32_t button, std::int32_t mods, std::uint8_t action) {
+        void* out = ring.reserve(size());
+        if (!out) {
+            return false;
+        }
+        encode(out, button, mods, action);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType);
+        }
+
+        std::int32_t button() const {
+            return detail::load<std::int32_t>(m_data + kButtonOffset);
+        }
+
+        std::int32_t mods() const {
+            return detail::load<std::int32_t>(m_data + kModsOffset);
+        }
+
+        std::uint8_t action() const {
+            return detail::load<std::uint8_t>(m_data + kActionOffset);
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief Cursor moved, in window coordinates
+ */
+struct MouseMoveEvent {
+    static constexpr MessageType kType = MessageType::MouseMoveEvent;
+    static constexpr std::uint32_t kXOffset = 8;
+    static constexpr std::uint32_t kYOffset = 16;
+    static constexpr std::uint32_t kFixedSize = 24;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size() {
+        return kFixedSize;
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, double x, double y) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kXOffset, x);
+        detail::store(data + kYOffset, y);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, double x, double y) {
+        void* out = ring.reserve(size());
+        if (!out) {
+            return false;
+        }
+        encode(out, x, y);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType);
+        }
+
+        double x() const {
+            return detail::load<double>(m_data + kXOffset);
+        }
+
+        double y() const {
+            return detail::load<double>(m_data + kYOffset);
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief Framebuffer resized, in pixels
+ */
+struct WindowResizeEvent {
+    static constexpr MessageType kType = MessageType::WindowResizeEvent;
+    static constexpr std::uint32_t kWidthOffset = 4;
+    static constexpr std::uint32_t kHeightOffset = 8;
+    static constexpr std::uint32_t kFixedSize = 12;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size() {
+        return kFixedSize;
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::int32_t width, std::int32_t height) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kWidthOffset, width);
+        detail::store(data + kHeightOffset, height);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::int32_t width, std::int32_t height) {
+        void* out = ring.reserve(size());
+        if (!out) {
+            return false;
+        }
+        encode(out, width, height);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType);
+        }
+
+        std::int32_t width() const {
+            return detail::load<std::int32_t>(m_data + kWidthOffset);
+        }
+
+        std::int32_t height() const {
+            return detail::load<std::int32_t>(m_data + kHeightOffset);
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: pointer event hit-tested by UiTree; kind is a UiEventKind, coordinates are in window and target space
+ */
+struct PointerEvent {
+    static constexpr MessageType kType = MessageType::PointerEvent;
+    static constexpr std::uint32_t kTargetOffset = 4;
+    static constexpr std::uint32_t kButtonOffset = 8;
+    static constexpr std::uint32_t kModsOffset = 12;
+    static constexpr std::uint32_t kKindOffset = 16;
+    static constexpr std::uint32_t kXOffset = 24;
+    static constexpr std::uint32_t kYOffset = 32;
+    static constexpr std::uint32_t kLocalXOffset = 40;
+    static constexpr std::uint32_t kLocalYOffset = 48;
+    static constexpr std::uint32_t kFixedSize = 56;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size() {
+        return kFixedSize;
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t target, std::int32_t button, std::int32_t mods, std::uint8_t kind, double x, double y, double localX, double localY) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kTargetOffset, target);
+        detail::store(data + kButtonOffset, button);
+        detail::store(data + kModsOffset, mods);
+        detail::store(data + kKindOffset, kind);
+        detail::store(data + kXOffset, x);
+        detail::store(data + kYOffset, y);
+        detail::store(data + kLocalXOffset, localX);
+        detail::store(data + kLocalYOffset, localY);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t target, std::int32_t button, std::int32_t mods, std::uint8_t kind, double x, double y, double localX, double localY) {
+        void* out = ring.reserve(size());
+        if (!out) {
+            return false;
+        }
+        encode(out, target, button, mods, kind, x, y, localX, localY);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType);
+        }
+
+        std::uint32_t target() const {
+            return detail::load<std::uint32_t>(m_data + kTargetOffset);
+        }
+
+        std::int32_t button() const {
+            return detail::load<std::int32_t>(m_data + kButtonOffset);
+        }
+
+        std::int32_t mods() const {
+            return detail::load<std::int32_t>(m_data + kModsOffset);
+        }
+
+        std::uint8_t kind() const {
+            return detail::load<std::uint8_t>(m_data + kKindOffset);
+        }
+
+        double x() const {
+            return detail::load<double>(m_data + kXOffset);
+        }
+
+        double y() const {
+            return detail::load<double>(m_data + kYOffset);
+        }
+
+        double localX() const {
+            return detail::load<double>(m_data + kLocalXOffset);
+        }
+
+        double localY() const {
+            return detail::load<double>(m_data + kLocalYOffset);
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: create an element node of the given type
+ */
+struct CreateElement {
+    static constexpr MessageType kType = MessageType::CreateElement;
+    static constexpr std::uint32_t kIdOffset = 4;
+    static constexpr std::uint32_t kElementTypeLengthOffset = 8;
+    static constexpr std::uint32_t kFixedSize = 12;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size(std::string_view elementType) {
+        return kFixedSize
+            + static_cast<std::uint32_t>(elementType.size());
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t id, std::string_view elementType) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kIdOffset, id);
+        detail::store(data + kElementTypeLengthOffset, static_cast<std::uint32_t>(elementType.size()));
+        unsigned char* tail = data + kFixedSize;
+        tail = detail::storeString(tail, elementType);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t id, std::string_view elementType) {
+        void* out = ring.reserve(size(elementType));
+        if (!out) {
+            return false;
+        }
+        encode(out, id, elementType);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType)
+                && static_cast<std::uint64_t>(kFixedSize) + static_cast<std::uint64_t>(elementTypeLength()) <= m_size;
+        }
+
+        std::uint32_t id() const {
+            return detail::load<std::uint32_t>(m_data + kIdOffset);
+        }
+
+        std::uint32_t elementTypeLength() const {
+            return detail::load<std::uint32_t>(m_data + kElementTypeLengthOffset);
+        }
+
+        std::string_view elementType() const {
+            return std::string_view(reinterpret_cast<const char*>(m_data + kFixedSize), elementTypeLength());
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: create a text node
+ */
+struct CreateText {
+    static constexpr MessageType kType = MessageType::CreateText;
+    static constexpr std::uint32_t kIdOffset = 4;
+    static constexpr std::uint32_t kTextLengthOffset = 8;
+    static constexpr std::uint32_t kFixedSize = 12;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size(std::string_view text) {
+        return kFixedSize
+            + static_cast<std::uint32_t>(text.size());
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t id, std::string_view text) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kIdOffset, id);
+        detail::store(data + kTextLengthOffset, static_cast<std::uint32_t>(text.size()));
+        unsigned char* tail = data + kFixedSize;
+        tail = detail::storeString(tail, text);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t id, std::string_view text) {
+        void* out = ring.reserve(size(text));
+        if (!out) {
+            return false;
+        }
+        encode(out, id, text);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType)
+                && static_cast<std::uint64_t>(kFixedSize) + static_cast<std::uint64_t>(textLength()) <= m_size;
+        }
+
+        std::uint32_t id() const {
+            return detail::load<std::uint32_t>(m_data + kIdOffset);
+        }
+
+        std::uint32_t textLength() const {
+            return detail::load<std::uint32_t>(m_data + kTextLengthOffset);
+        }
+
+        std::string_view text() const {
+            return std::string_view(reinterpret_cast<const char*>(m_data + kFixedSize), textLength());
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: append a node to a parent (0 is the root container)
+ */
+struct AppendChild {
+    static constexpr MessageType kType = MessageType::AppendChild;
+    static constexpr std::uint32_t kParentOffset = 4;
+    static constexpr std::uint32_t kChildOffset = 8;
+    static constexpr std::uint32_t kFixedSize = 12;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size() {
+        return kFixedSize;
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t parent, std::uint32_t child) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kParentOffset, parent);
+        detail::store(data + kChildOffset, child);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t parent, std::uint32_t child) {
+        void* out = ring.reserve(size());
+        if (!out) {
+            return false;
+        }
+        encode(out, parent, child);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType);
+        }
+
+        std::uint32_t parent() const {
+            return detail::load<std::uint32_t>(m_data + kParentOffset);
+        }
+
+        std::uint32_t child() const {
+            return detail::load<std::uint32_t>(m_data + kChildOffset);
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: insert a node before a sibling
+ */
+struct InsertBefore {
+    static constexpr MessageType kType = MessageType::InsertBefore;
+    static constexpr std::uint32_t kParentOffset = 4;
+    static constexpr std::uint32_t kChildOffset = 8;
+    static constexpr std::uint32_t kBeforeOffset = 12;
+    static constexpr std::uint32_t kFixedSize = 16;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size() {
+        return kFixedSize;
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t parent, std::uint32_t child, std::uint32_t before) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kParentOffset, parent);
+        detail::store(data + kChildOffset, child);
+        detail::store(data + kBeforeOffset, before);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t parent, std::uint32_t child, std::uint32_t before) {
+        void* out = ring.reserve(size());
+        if (!out) {
+            return false;
+        }
+        encode(out, parent, child, before);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType);
+        }
+
+        std::uint32_t parent() const {
+            return detail::load<std::uint32_t>(m_data + kParentOffset);
+        }
+
+        std::uint32_t child() const {
+            return detail::load<std::uint32_t>(m_data + kChildOffset);
+        }
+
+        std::uint32_t before() const {
+            return detail::load<std::uint32_t>(m_data + kBeforeOffset);
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: detach a node from its parent
+ */
+struct RemoveChild {
+    static constexpr MessageType kType = MessageType::RemoveChild;
+    static constexpr std::uint32_t kParentOffset = 4;
+    static constexpr std::uint32_t kChildOffset = 8;
+    static constexpr std::uint32_t kFixedSize = 12;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size() {
+        return kFixedSize;
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t parent, std::uint32_t child) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kParentOffset, parent);
+        detail::store(data + kChildOffset, child);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t parent, std::uint32_t child) {
+        void* out = ring.reserve(size());
+        if (!out) {
+            return false;
+        }
+        encode(out, parent, child);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType);
+        }
+
+        std::uint32_t parent() const {
+            return detail::load<std::uint32_t>(m_data + kParentOffset);
+        }
+
+        std::uint32_t child() const {
+            return detail::load<std::uint32_t>(m_data + kChildOffset);
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: release a detached node
+ */
+struct DestroyNode {
+    static constexpr MessageType kType = MessageType::DestroyNode;
+    static constexpr std::uint32_t kIdOffset = 4;
+    static constexpr std::uint32_t kFixedSize = 8;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size() {
+        return kFixedSize;
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t id) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kIdOffset, id);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t id) {
+        void* out = ring.reserve(size());
+        if (!out) {
+            return false;
+        }
+        encode(out, id);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType);
+        }
+
+        std::uint32_t id() const {
+            return detail::load<std::uint32_t>(m_data + kIdOffset);
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: set a numeric property
+ */
+struct SetNumberProperty {
+    static constexpr MessageType kType = MessageType::SetNumberProperty;
+    static constexpr std::uint32_t kIdOffset = 4;
+    static constexpr std::uint32_t kValueOffset = 8;
+    static constexpr std::uint32_t kPropertyLengthOffset = 16;
+    static constexpr std::uint32_t kFixedSize = 20;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size(std::string_view property) {
+        return kFixedSize
+            + static_cast<std::uint32_t>(property.size());
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t id, double value, std::string_view property) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kIdOffset, id);
+        detail::store(data + kValueOffset, value);
+        detail::store(data + kPropertyLengthOffset, static_cast<std::uint32_t>(property.size()));
+        unsigned char* tail = data + kFixedSize;
+        tail = detail::storeString(tail, property);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t id, double value, std::string_view property) {
+        void* out = ring.reserve(size(property));
+        if (!out) {
+            return false;
+        }
+        encode(out, id, value, property);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType)
+                && static_cast<std::uint64_t>(kFixedSize) + static_cast<std::uint64_t>(propertyLength()) <= m_size;
+        }
+
+        std::uint32_t id() const {
+            return detail::load<std::uint32_t>(m_data + kIdOffset);
+        }
+
+        double value() const {
+            return detail::load<double>(m_data + kValueOffset);
+        }
+
+        std::uint32_t propertyLength() const {
+            return detail::load<std::uint32_t>(m_data + kPropertyLengthOffset);
+        }
+
+        std::string_view property() const {
+            return std::string_view(reinterpret_cast<const char*>(m_data + kFixedSize), propertyLength());
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: set a string property
+ */
+struct SetStringProperty {
+    static constexpr MessageType kType = MessageType::SetStringProperty;
+    static constexpr std::uint32_t kIdOffset = 4;
+    static constexpr std::uint32_t kPropertyLengthOffset = 8;
+    static constexpr std::uint32_t kValueLengthOffset = 12;
+    static constexpr std::uint32_t kFixedSize = 16;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size(std::string_view property, std::string_view value) {
+        return kFixedSize
+            + static_cast<std::uint32_t>(property.size())
+            + static_cast<std::uint32_t>(value.size());
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t id, std::string_view property, std::string_view value) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kIdOffset, id);
+        detail::store(data + kPropertyLengthOffset, static_cast<std::uint32_t>(property.size()));
+        detail::store(data + kValueLengthOffset, static_cast<std::uint32_t>(value.size()));
+        unsigned char* tail = data + kFixedSize;
+        tail = detail::storeString(tail, property);
+        tail = detail::storeString(tail, value);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t id, std::string_view property, std::string_view value) {
+        void* out = ring.reserve(size(property, value));
+        if (!out) {
+            return false;
+        }
+        encode(out, id, property, value);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType)
+                && static_cast<std::uint64_t>(kFixedSize) + static_cast<std::uint64_t>(propertyLength()) + static_cast<std::uint64_t>(valueLength()) <= m_size;
+        }
+
+        std::uint32_t id() const {
+            return detail::load<std::uint32_t>(m_data + kIdOffset);
+        }
+
+        std::uint32_t propertyLength() const {
+            return detail::load<std::uint32_t>(m_data + kPropertyLengthOffset);
+        }
+
+        std::string_view property() const {
+            return std::string_view(reinterpret_cast<const char*>(m_data + kFixedSize), propertyLength());
+        }
+
+        std::uint32_t valueLength() const {
+            return detail::load<std::uint32_t>(m_data + kValueLengthOffset);
+        }
+
+        std::string_view value() const {
+            return std::string_view(reinterpret_cast<const char*>(m_data + kFixedSize + propertyLength()), valueLength());
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: remove a property
+ */
+struct RemoveProperty {
+    static constexpr MessageType kType = MessageType::RemoveProperty;
+    static constexpr std::uint32_t kIdOffset = 4;
+    static constexpr std::uint32_t kPropertyLengthOffset = 8;
+    static constexpr std::uint32_t kFixedSize = 12;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size(std::string_view property) {
+        return kFixedSize
+            + static_cast<std::uint32_t>(property.size());
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t id, std::string_view property) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kIdOffset, id);
+        detail::store(data + kPropertyLengthOffset, static_cast<std::uint32_t>(property.size()));
+        unsigned char* tail = data + kFixedSize;
+        tail = detail::storeString(tail, property);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t id, std::string_view property) {
+        void* out = ring.reserve(size(property));
+        if (!out) {
+            return false;
+        }
+        encode(out, id, property);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType)
+                && static_cast<std::uint64_t>(kFixedSize) + static_cast<std::uint64_t>(propertyLength()) <= m_size;
+        }
+
+        std::uint32_t id() const {
+            return detail::load<std::uint32_t>(m_data + kIdOffset);
+        }
+
+        std::uint32_t propertyLength() const {
+            return detail::load<std::uint32_t>(m_data + kPropertyLengthOffset);
+        }
+
+        std::string_view property() const {
+            return std::string_view(reinterpret_cast<const char*>(m_data + kFixedSize), propertyLength());
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: replace the content of a text node
+ */
+struct SetText {
+    static constexpr MessageType kType = MessageType::SetText;
+    static constexpr std::uint32_t kIdOffset = 4;
+    static constexpr std::uint32_t kTextLengthOffset = 8;
+    static constexpr std::uint32_t kFixedSize = 12;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size(std::string_view text) {
+        return kFixedSize
+            + static_cast<std::uint32_t>(text.size());
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t id, std::string_view text) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kIdOffset, id);
+        detail::store(data + kTextLengthOffset, static_cast<std::uint32_t>(text.size()));
+        unsigned char* tail = data + kFixedSize;
+        tail = detail::storeString(tail, text);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t id, std::string_view text) {
+        void* out = ring.reserve(size(text));
+        if (!out) {
+            return false;
+        }
+        encode(out, id, text);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType)
+                && static_cast<std::uint64_t>(kFixedSize) + static_cast<std::uint64_t>(textLength()) <= m_size;
+        }
+
+        std::uint32_t id() const {
+            return detail::load<std::uint32_t>(m_data + kIdOffset);
+        }
+
+        std::uint32_t textLength() const {
+            return detail::load<std::uint32_t>(m_data + kTextLengthOffset);
+        }
+
+        std::string_view text() const {
+            return std::string_view(reinterpret_cast<const char*>(m_data + kFixedSize), textLength());
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: animate later changes of a numeric property natively (duration in seconds, 0 disables; easing is a UiEasing)
+ */
+struct SetTransition {
+    static constexpr MessageType kType = MessageType::SetTransition;
+    static constexpr std::uint32_t kIdOffset = 4;
+    static constexpr std::uint32_t kDurationOffset = 8;
+    static constexpr std::uint32_t kEasingOffset = 16;
+    static constexpr std::uint32_t kPropertyLengthOffset = 20;
+    static constexpr std::uint32_t kFixedSize = 24;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size(std::string_view property) {
+        return kFixedSize
+            + static_cast<std::uint32_t>(property.size());
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t id, double duration, std::uint8_t easing, std::string_view property) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kIdOffset, id);
+        detail::store(data + kDurationOffset, duration);
+        detail::store(data + kEasingOffset, easing);
+        detail::store(data + kPropertyLengthOffset, static_cast<std::uint32_t>(property.size()));
+        unsigned char* tail = data + kFixedSize;
+        tail = detail::storeString(tail, property);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t id, double duration, std::uint8_t easing, std::string_view property) {
+        void* out = ring.reserve(size(property));
+        if (!out) {
+            return false;
+        }
+        encode(out, id, duration, easing, property);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType)
+                && static_cast<std::uint64_t>(kFixedSize) + static_cast<std::uint64_t>(propertyLength()) <= m_size;
+        }
+
+        std::uint32_t id() const {
+            return detail::load<std::uint32_t>(m_data + kIdOffset);
+        }
+
+        double duration() const {
+            return detail::load<double>(m_data + kDurationOffset);
+        }
+
+        std::uint8_t easing() const {
+            return detail::load<std::uint8_t>(m_data + kEasingOffset);
+        }
+
+        std::uint32_t propertyLength() const {
+            return detail::load<std::uint32_t>(m_data + kPropertyLengthOffset);
+        }
+
+        std::string_view property() const {
+            return std::string_view(reinterpret_cast<const char*>(m_data + kFixedSize), propertyLength());
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+/**
+ * @brief UI: pointer events the node listens to (bit 1 << UiEventKind)
+ */
+struct SetEventMask {
+    static constexpr MessageType kType = MessageType::SetEventMask;
+    static constexpr std::uint32_t kIdOffset = 4;
+    static constexpr std::uint32_t kMaskOffset = 8;
+    static constexpr std::uint32_t kFixedSize = 12;
+
+    /**
+     * @brief Get the encoded size of a message
+     */
+    static constexpr std::uint32_t size() {
+        return kFixedSize;
+    }
+
+    /**
+     * @brief Encode a message into @p out, which holds at least size() bytes
+     */
+    static void encode(void* out, std::uint32_t id, std::uint32_t mask) {
+        unsigned char* data = static_cast<unsigned char*>(out);
+        detail::store(data, static_cast<std::uint16_t>(kType));
+        detail::store(data + kIdOffset, id);
+        detail::store(data + kMaskOffset, mask);
+    }
+
+    /**
+     * @brief Encode a message directly into a ring
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    static bool post(RingChannel& ring, std::uint32_t id, std::uint32_t mask) {
+        void* out = ring.reserve(size());
+        if (!out) {
+            return false;
+        }
+        encode(out, id, mask);
+        ring.commit();
+        return true;
+    }
+
+    /**
+     * @brief Read an encoded message in place
+     */
+    class Reader {
+    public:
+        Reader(const void* data, std::uint32_t size)
+            : m_data(static_cast<const unsigned char*>(data))
+            , m_size(size)
+        {
+        }
+
+        /**
+         * @brief Check the type and that every field lies within the message
+         */
+        bool isValid() const {
+            return m_size >= kFixedSize
+                && detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType);
+        }
+
+        std::uint32_t id() const {
+            return detail::load<std::uint32_t>(m_data + kIdOffset);
+        }
+
+        std::uint32_t mask() const {
+            return detail::load<std::uint32_t>(m_data + kMaskOffset);
+        }
+
+    private:
+        const unsigned char* m_data;
+        std::uint32_t m_size;
+    };
+};
+
+} // namespace bridge
+} // namespace crazy
+
+#endif // CRAZY_BRIDGE_MESSAGES_HPP
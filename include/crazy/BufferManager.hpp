@@ -0,0 +1,263 @@
+#ifndef CRAZY_BUFFER_MANAGER_HPP
+#define CRAZY_BUFFER_MANAGER_HPP
+
+#include <GLFW/glfw3.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace crazy {
+
+/**
+ * @brief A suballocated range inside one of the static buffer pages
+ */
+struct BufferAllocation {
+    GLuint buffer = 0;          ///< GL buffer object holding the range
+    std::size_t offset = 0;     ///< Byte offset of the range inside the buffer
+    std::size_t size = 0;       ///< Size of the range in bytes
+
+    /**
+     * @brief Check if the allocation refers to GPU memory
+     */
+    bool isValid() const { return buffer != 0; }
+};
+
+/**
+ * @brief A per-frame range inside the streaming ring buffer
+ *
+ * The range stays valid for the frame it was allocated in. Once the frame
+ * ends the memory is recycled as soon as the GPU has finished reading it.
+ */
+struct StreamAllocation {
+    GLuint buffer = 0;          ///< GL buffer object holding the range
+    std::size_t offset = 0;     ///< Byte offset of the range inside the buffer
+    std::size_t size = 0;       ///< Size of the range in bytes
+    void* data = nullptr;       ///< Write-only CPU pointer, valid until unmapStream()
+
+    /**
+     * @brief Check if the allocation refers to GPU memory
+     */
+    bool isValid() const { return buffer != 0; }
+};
+
+/**
+ * @brief Usage statistics reported by BufferManager
+ */
+struct BufferStats {
+    // Static pages
+    std::size_t staticPageCount = 0;        ///< Number of GL buffers backing static data
+    std::size_t staticReservedBytes = 0;    ///< Total size of all static pages
+    std::size_t staticUsedBytes = 0;        ///< Bytes handed out to live allocations
+    std::size_t staticAllocationCount = 0;  ///< Number of live static allocations
+    std::size_t staticFreeBlockCount = 0;   ///< Number of free-list blocks (fragmentation)
+    std::size_t staticLargestFreeBlock = 0; ///< Largest contiguous free block
+
+    // Streaming ring
+    std::size_t streamCapacityBytes = 0;    ///< Total ring size (all frame segments)
+    std::size_t streamFrameBytes = 0;       ///< Bytes used by the current frame
+    std::size_t streamPeakFrameBytes = 0;   ///< Highest per-frame usage seen so far
+    std::uint64_t streamOverflows = 0;      ///< Allocations refused because a segment was full
+    bool persistentMapping = false;         ///< True if the ring is persistently mapped
+};
+
+/**
+ * @brief GPU buffer manager for static and per-frame dynamic data
+ *
+ * Static geometry is suballocated from large buffer pages using a free-list,
+ * so meshes and widgets share a handful of GL buffers instead of owning one
+ * each. Dynamic vertex and uniform data is written into a ring buffer split
+ * into one segment per frame slot. Renderer fences every frame and waits on
+ * the fence of a slot before handing it out again, so the CPU never
+ * overwrites data the GPU is still reading and the driver never has to
+ * synchronise implicitly.
+ *
+ * An OpenGL context must be current whenever a method touching GPU memory is
+ * called. GL objects are created lazily on first use.
+ *
+ * Example usage:
+ * @code
+ * crazy::BufferManager& buffers = renderer.getBufferManager();
+ * crazy::BufferAllocation mesh = buffers.uploadStatic(vertices, sizeof(vertices));
+ *
+ * // Every frame (Application does begin/end for you)
+ * crazy::StreamAllocation ubo = buffers.uploadStream(&uniforms, sizeof(uniforms),
+ *                                                    buffers.getUniformAlignment());
+ * glBindBufferRange(GL_UNIFORM_BUFFER, 0, ubo.buffer, ubo.offset, ubo.size);
+ * @endcode
+ */
+class BufferManager {
+public:
+    /**
+     * @brief Construct a new Buffer Manager object
+     *
+     * @param pageSize Size of each static buffer page in bytes
+     * @param streamFrameSize Size of each per-frame ring segment in bytes
+     * @param streamFrameCount Number of frame segments in the ring (frames in flight)
+     */
+    BufferManager(std::size_t pageSize = 4 * 1024 * 1024,
+                  std::size_t streamFrameSize = 1024 * 1024,
+                  int streamFrameCount = 3);
+
+    /**
+     * @brief Destroy the Buffer Manager object and its GL buffers
+     */
+    ~BufferManager();
+
+    // Disable copy construction and assignment
+    BufferManager(const BufferManager&) = delete;
+    BufferManager& operator=(const BufferManager&) = delete;
+
+    /**
+     * @brief Reserve a range of static GPU memory
+     *
+     * Requests larger than the page size get a dedicated page.
+     *
+     * @param size Size in bytes
+     * @param alignment Required offset alignment in bytes (power of two)
+     * @return BufferAllocation Allocated range, invalid on failure
+     */
+    BufferAllocation allocateStatic(std::size_t size, std::size_t alignment = 16);
+
+    /**
+     * @brief Reserve a range of static GPU memory and fill it
+     *
+     * @param data Data to upload
+     * @param size Size in bytes
+     * @param alignment Required offset alignment in bytes (power of two)
+     * @return BufferAllocation Allocated range, invalid on failure
+     */
+    BufferAllocation uploadStatic(const void* data, std::size_t size, std::size_t alignment = 16);
+
+    /**
+     * @brief Overwrite part of a static allocation
+     *
+     * @param allocation Allocation returned by allocateStatic()
+     * @param data Data to upload
+     * @param size Size in bytes
+     * @param offset Byte offset inside the allocation
+     */
+    void updateStatic(const BufferAllocation& allocation, const void* data,
+                      std::size_t size, std::size_t offset = 0);
+
+    /**
+     * @brief Return a static range to the free-list
+     *
+     * @param allocation Allocation returned by allocateStatic()
+     */
+    void freeStatic(const BufferAllocation& allocation);
+
+    /**
+     * @brief Start a new frame in the streaming ring
+     *
+     * The caller guarantees that the GPU has finished every command that
+     * read the given slot; Renderer::beginFrame() waits on the slot's fence
+     * before calling this.
+     *
+     * @param frameSlot Frame slot whose ring segment is recycled
+     */
+    void beginFrame(int frameSlot);
+
+    /**
+     * @brief Finish the current frame, unmapping any pending range
+     */
+    void endFrame();
+
+    /**
+     * @brief Set the number of ring segments
+     *
+     * Must match the number of frames in flight. The ring is recreated at
+     * the next beginFrame().
+     *
+     * @param frameCount Number of frame segments
+     */
+    void setFrameCount(int frameCount);
+
+    /**
+     * @brief Map a range of the current frame's ring segment for writing
+     *
+     * Only one range can be mapped at a time; call unmapStream() before
+     * mapping another range or issuing draws that read it.
+     *
+     * @param size Size in bytes
+     * @param alignment Required offset alignment in bytes (power of two)
+     * @return StreamAllocation Mapped range, invalid if the segment is full
+     */
+    StreamAllocation mapStream(std::size_t size, std::size_t alignment = 16);
+
+    /**
+     * @brief Unmap the range returned by the last mapStream() call
+     */
+    void unmapStream();
+
+    /**
+     * @brief Copy data into the current frame's ring segment
+     *
+     * @param data Data to upload
+     * @param size Size in bytes
+     * @param alignment Required offset alignment in bytes (power of two)
+     * @return StreamAllocation Uploaded range (data pointer is null), invalid if full
+     */
+    StreamAllocation uploadStream(const void* data, std::size_t size, std::size_t alignment = 16);
+
+    /**
+     * @brief Get the offset alignment required for uniform buffer ranges
+     *
+     * @return std::size_t GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of the context
+     */
+    std::size_t getUniformAlignment();
+
+    /**
+     * @brief Get usage statistics
+     *
+     * @return BufferStats Current statistics
+     */
+    BufferStats getStats() const;
+
+    /**
+     * @brief Delete every GL object owned by the manager
+     *
+     * Outstanding allocations become invalid. Must be called with the owning
+     * context current; the destructor calls it automatically.
+     */
+    void release();
+
+private:
+    struct Page {
+        GLuint buffer;
+        std::size_t size;
+        std::size_t used;
+        std::size_t allocations;
+        std::map<std::size_t, std::size_t> freeBlocks; // offset -> size
+        std::uint64_t memoryId;                         // MemoryTracker handle
+    };
+
+    bool ensureStream();
+    void createStreamBuffer();
+    void destroyStreamBuffer();
+    Page* findPage(GLuint buffer);
+    bool allocateFromPage(Page& page, std::size_t size, std::size_t alignment,
+                          BufferAllocation& allocation);
+
+    std::size_t m_pageSize;
+    std::vector<Page> m_pages;
+    std::size_t m_staticAllocationCount;
+
+    std::size_t m_streamFrameSize;
+    int m_streamFrameCount;
+    GLuint m_streamBuffer;
+    std::uint64_t m_streamMemoryId;
+    unsigned char* m_streamPersistentPtr;
+    bool m_streamMapped;
+    int m_streamFrame;
+    std::size_t m_streamCursor;
+    bool m_streamOverflowed;
+    bool m_streamResize;
+
+    std::size_t m_uniformAlignment;
+    BufferStats m_stats;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_BUFFER_MANAGER_HPP
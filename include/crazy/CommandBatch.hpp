@@ -0,0 +1,131 @@
+#ifndef CRAZY_COMMAND_BATCH_HPP
+#define CRAZY_COMMAND_BATCH_HPP
+
+#include "RingChannel.hpp"
+#include "SharedMemory.hpp"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace crazy {
+
+class NodeRuntime;
+
+/**
+ * @brief Metrics of a CommandBatch
+ */
+struct CommandBatchStats {
+    std::uint64_t batches = 0;          ///< Non-empty batches applied
+    std::uint64_t commands = 0;         ///< Commands applied
+    std::uint64_t flushes = 0;          ///< Flushes from JavaScript (boundary crossings)
+    std::uint64_t overflowFlushes = 0;  ///< Flushes forced by a full ring, applied at once
+    std::uint32_t lastBatchSize = 0;    ///< Commands in the last batch
+    std::uint32_t maxBatchSize = 0;     ///< Largest batch
+    double lastLatency = 0.0;           ///< Seconds from the oldest command of the last batch being queued to its application
+    double averageLatency = 0.0;        ///< Moving average of lastLatency
+    double maxLatency = 0.0;            ///< Largest latency
+};
+
+/**
+ * @brief Per-frame batch of commands sent from JavaScript to C++
+ *
+ * Crossing into native code has a fixed cost, and a single React commit can
+ * produce thousands of small operations. JavaScript therefore appends
+ * commands (usually bridge messages, see BridgeMessages.hpp) to a shared
+ * ring without crossing, and flushes them with one native call at the end
+ * of the commit or microtask checkpoint
+ * (frontend/src/bridge/commandBatch.js). apply() then runs the handler over
+ * everything flushed so far in one pass; Application does this right
+ * before its render callback.
+ *
+ * @code
+ * crazy::CommandBatch commands;
+ * commands.setHandler([&](const void* data, std::uint32_t size) { ui.execute(data, size); });
+ * commands.attach(crazy::NodeRuntime::instance());    // crazy.shared.commands, crazy.flushCommands()
+ * app.setCommandBatch(&commands);
+ * @endcode
+ *
+ * All methods must be called on the runtime's thread.
+ */
+class CommandBatch {
+public:
+    using Handler = std::function<void(const void* data, std::uint32_t size)>;
+
+    /**
+     * @brief Create the ring
+     *
+     * @param capacity Ring capacity in bytes; a batch that does not fit is
+     *                 flushed and applied early
+     */
+    explicit CommandBatch(std::uint32_t capacity = 1u << 20);
+
+    // Disable copy construction and assignment
+    CommandBatch(const CommandBatch&) = delete;
+    CommandBatch& operator=(const CommandBatch&) = delete;
+
+    /**
+     * @brief Expose the batch to JavaScript
+     *
+     * The ring becomes crazy.shared.<name> and the flush function
+     * crazy.flush<Name> (e.g. crazy.flushCommands). The batch must outlive
+     * the runtime or NodeRuntime::shutdown().
+     *
+     * @param runtime Running runtime
+     * @param name Name of the batch
+     * @return true if the batch was exposed
+     */
+    bool attach(NodeRuntime& runtime, const std::string& name = "commands");
+
+    /**
+     * @brief Set the function that executes one command
+     */
+    void setHandler(Handler handler);
+
+    /**
+     * @brief Execute all flushed commands in order
+     *
+     * @return std::uint32_t Number of commands executed
+     */
+    std::uint32_t apply();
+
+    /**
+     * @brief Record a flush from JavaScript
+     *
+     * Called by the function exposed by attach(); an overflow flush is
+     * applied immediately so that JavaScript can continue the batch.
+     *
+     * @param pendingTime Seconds the oldest flushed command waited in JavaScript
+     * @param overflow The ring was full
+     */
+    void flush(double pendingTime, bool overflow);
+
+    /**
+     * @brief Get the ring, e.g. to attach a channel in another runtime
+     */
+    RingChannel& getChannel();
+
+    /**
+     * @brief Get the metrics
+     */
+    const CommandBatchStats& getStats() const;
+
+    /**
+     * @brief Reset the metrics
+     */
+    void resetStats();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    SharedMemory m_memory;
+    RingChannel m_channel;
+    Handler m_handler;
+    CommandBatchStats m_stats;
+    Clock::time_point m_oldestPending;
+    bool m_hasPending;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_COMMAND_BATCH_HPP
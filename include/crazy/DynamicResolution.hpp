@@ -0,0 +1,182 @@
+#ifndef CRAZY_DYNAMIC_RESOLUTION_HPP
+#define CRAZY_DYNAMIC_RESOLUTION_HPP
+
+#include "RenderTarget.hpp"
+#include <GLFW/glfw3.h>
+
+namespace crazy {
+
+/**
+ * @brief Filter used to upscale the scene to the window
+ */
+enum class UpscaleFilter {
+    Bilinear,   ///< Hardware bilinear blit, cheapest
+    Bicubic     ///< Catmull-Rom filter in a shader pass, sharper
+};
+
+/**
+ * @brief Tuning parameters for dynamic resolution scaling
+ */
+struct DynamicResolutionSettings {
+    double targetFrameTime = 1.0 / 60.0;    ///< Frame-time budget in seconds
+    float minScale = 0.5f;                  ///< Lowest per-axis render scale
+    float maxScale = 1.0f;                  ///< Highest per-axis render scale
+    float scaleStep = 0.05f;                ///< Granularity of scale changes
+    float upperThreshold = 0.95f;           ///< Scale down when frame time exceeds this fraction of the budget
+    float lowerThreshold = 0.75f;           ///< Scale up when frame time stays below this fraction of the budget
+    int scaleDownDelay = 3;                 ///< Consecutive frames over budget before scaling down
+    int scaleUpDelay = 30;                  ///< Consecutive frames under budget before scaling up
+    UpscaleFilter filter = UpscaleFilter::Bicubic;  ///< Filter used to upscale to the window
+    bool nativeResolutionUI = true;         ///< Render the UI callback after upscaling, at full resolution
+};
+
+/**
+ * @brief Dynamic resolution scaling driven by a frame-time budget
+ *
+ * When enabled, the scene is rendered into an offscreen target whose
+ * resolution follows the measured CPU and GPU frame times: the scale drops
+ * quickly when frames go over budget and recovers slowly once there is
+ * headroom again, so it does not oscillate. The target is allocated at full
+ * window size and only a sub-rectangle of it is used, so changing the scale
+ * never reallocates anything. The result is upscaled to the window with the
+ * configured filter.
+ *
+ * Application drives this automatically once enabled:
+ * @code
+ * app.getDynamicResolution().setEnabled(true);
+ * app.setRenderCallback([&]() { ... scene, at render resolution ... });
+ * app.setUIRenderCallback([&]() { ... text and chrome, at native resolution ... });
+ * @endcode
+ */
+class DynamicResolution {
+public:
+    /**
+     * @brief Construct a new Dynamic Resolution object (disabled)
+     */
+    DynamicResolution();
+
+    /**
+     * @brief Destroy the Dynamic Resolution object and its GL objects
+     */
+    ~DynamicResolution();
+
+    // Disable copy construction and assignment
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    /**
+     * @brief Enable or disable dynamic resolution
+     *
+     * @param enabled true to render the scene offscreen at a dynamic scale
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Check if dynamic resolution is enabled
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Replace the tuning parameters
+     *
+     * @param settings New settings
+     */
+    void setSettings(const DynamicResolutionSettings& settings);
+
+    /**
+     * @brief Get the tuning parameters
+     */
+    const DynamicResolutionSettings& getSettings() const;
+
+    /**
+     * @brief Get the current per-axis render scale
+     */
+    float getScale() const;
+
+    /**
+     * @brief Force the render scale
+     *
+     * The controller keeps adapting from this value on subsequent frames.
+     *
+     * @param scale Per-axis scale, clamped to [minScale, maxScale]
+     */
+    void setScale(float scale);
+
+    /**
+     * @brief Get the width the scene is currently rendered at
+     */
+    int getRenderWidth() const;
+
+    /**
+     * @brief Get the height the scene is currently rendered at
+     */
+    int getRenderHeight() const;
+
+    /**
+     * @brief Redirect scene rendering into the offscreen target
+     *
+     * Binds the target and sets viewport and scissor to the scaled region.
+     *
+     * @param outputWidth Window framebuffer width
+     * @param outputHeight Window framebuffer height
+     */
+    void beginScene(int outputWidth, int outputHeight);
+
+    /**
+     * @brief Upscale the scene to the window framebuffer
+     *
+     * Leaves the default framebuffer bound with a full-size viewport.
+     */
+    void endScene();
+
+    /**
+     * @brief Feed the controller with the latest frame timings
+     *
+     * The slower of the two decides: GPU time when fill-rate bound, CPU time
+     * when the scene is CPU bound (in which case scaling cannot help much,
+     * but it keeps the budget honest).
+     *
+     * @param cpuFrameTime CPU frame time in seconds
+     * @param gpuFrameTime GPU frame time in seconds (0 if unknown)
+     */
+    void update(double cpuFrameTime, double gpuFrameTime);
+
+    /**
+     * @brief Get the offscreen render target
+     */
+    RenderTarget& getRenderTarget();
+
+    /**
+     * @brief Delete the GL objects
+     */
+    void release();
+
+private:
+    float clampScale(float scale) const;
+    void upscaleBicubic();
+    void upscaleBilinear();
+
+    bool m_enabled;
+    DynamicResolutionSettings m_settings;
+    float m_scale;
+    int m_framesOverBudget;
+    int m_framesUnderBudget;
+    double m_smoothedFrameTime;
+
+    RenderTarget m_target;
+    int m_outputWidth;
+    int m_outputHeight;
+    int m_renderWidth;
+    int m_renderHeight;
+    bool m_inScene;
+
+    GLuint m_program;
+    GLuint m_vertexArray;
+    GLint m_sourceLocation;
+    GLint m_sourceSizeLocation;
+    GLint m_sourceRectLocation;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_DYNAMIC_RESOLUTION_HPP
@@ -1,6 +1,7 @@
 #ifndef CRAZY_EVENT_HANDLER_HPP
 #define CRAZY_EVENT_HANDLER_HPP
 
+#include "InputLatency.hpp"
 #include <GLFW/glfw3.h>
 #include <functional>
 #include <unordered_map>
@@ -19,6 +20,7 @@ enum class EventType {
     MouseButtonPress,
     MouseButtonRelease,
     MouseMove,
+    MouseScroll,
     WindowResize,
     WindowClose
 };
@@ -30,6 +32,7 @@ struct KeyEvent {
     int key;
     int scancode;
     int mods;
+    double timestamp = 0.0;     ///< glfwGetTime() when the GLFW callback received it
 };
 
 /**
@@ -38,6 +41,7 @@ struct KeyEvent {
 struct MouseButtonEvent {
     int button;
     int mods;
+    double timestamp = 0.0;     ///< glfwGetTime() when the GLFW callback received it
 };
 
 /**
@@ -46,6 +50,16 @@ struct MouseButtonEvent {
 struct MouseMoveEvent {
     double xpos;
     double ypos;
+    double timestamp = 0.0;     ///< glfwGetTime() when the GLFW callback received it
+};
+
+/**
+ * @brief Mouse wheel or touchpad scroll event data structure
+ */
+struct ScrollEvent {
+    double xoffset;             ///< Horizontal wheel or touchpad offset
+    double yoffset;             ///< Vertical offset, positive for a wheel turned away from the user
+    double timestamp = 0.0;     ///< glfwGetTime() when the GLFW callback received it
 };
 
 /**
@@ -78,8 +92,10 @@ public:
     using KeyCallback = std::function<void(const KeyEvent&)>;
     using MouseButtonCallback = std::function<void(const MouseButtonEvent&)>;
     using MouseMoveCallback = std::function<void(const MouseMoveEvent&)>;
+    using ScrollCallback = std::function<void(const ScrollEvent&)>;
     using WindowResizeCallback = std::function<void(const WindowResizeEvent&)>;
     using WindowCloseCallback = std::function<void()>;
+    using WindowRefreshCallback = std::function<void()>;
     
     /**
      * @brief Construct a new Event Handler object
@@ -140,6 +156,13 @@ public:
      */
     void setMouseMoveCallback(MouseMoveCallback callback);
     
+    /**
+     * @brief Set the scroll callback
+     * 
+     * @param callback Callback function for mouse wheel and touchpad scroll events
+     */
+    void setScrollCallback(ScrollCallback callback);
+    
     /**
      * @brief Set the window resize callback
      * 
@@ -154,24 +177,54 @@ public:
      */
     void setWindowCloseCallback(WindowCloseCallback callback);
     
+    /**
+     * @brief Set the window refresh callback
+     * 
+     * Called when the window contents need to be redrawn, including from
+     * inside the platform's modal loop while the window is being resized.
+     * Application::run() installs one that keeps rendering during live
+     * resize; setting another replaces it.
+     * 
+     * @param callback Callback function for window refresh events
+     */
+    void setWindowRefreshCallback(WindowRefreshCallback callback);
+    
     /**
      * @brief Poll for events
      * 
      * This should be called once per frame to process pending events.
      */
     static void pollEvents();
+    
+    /**
+     * @brief Take the capture time of the oldest input not yet rendered
+     * 
+     * Every key, mouse button, cursor and scroll event is stamped when GLFW
+     * delivers it. Application takes the oldest pending stamp of each kind
+     * at the start of a frame and hands it to Renderer::recordInput(), which
+     * measures when that frame is presented.
+     * 
+     * @param kind Kind of input
+     * @param timestamp Receives the glfwGetTime() of the oldest event
+     * @return true if an event of this kind arrived since the last call
+     */
+    bool takePendingInput(InputKind kind, double& timestamp);
 
 private:
     // GLFW callback functions (static)
     static void glfwKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
     static void glfwMouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
     static void glfwCursorPosCallback(GLFWwindow* window, double xpos, double ypos);
+    static void glfwScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
     static void glfwFramebufferSizeCallback(GLFWwindow* window, int width, int height);
     static void glfwWindowCloseCallback(GLFWwindow* window);
+    static void glfwWindowRefreshCallback(GLFWwindow* window);
     
     // Event handler retrieval from window user pointer
     static EventHandler* getHandlerFromWindow(GLFWwindow* window);
     
+    void notePendingInput(InputKind kind, double timestamp);
+    
     // Callback storage
     KeyCallback m_keyPressCallback;
     KeyCallback m_keyReleaseCallback;
@@ -179,8 +232,13 @@ private:
     MouseButtonCallback m_mouseButtonPressCallback;
     MouseButtonCallback m_mouseButtonReleaseCallback;
     MouseMoveCallback m_mouseMoveCallback;
+    ScrollCallback m_scrollCallback;
     WindowResizeCallback m_windowResizeCallback;
     WindowCloseCallback m_windowCloseCallback;
+    WindowRefreshCallback m_windowRefreshCallback;
+    
+    // Oldest unrendered event per input kind, -1 for none
+    double m_pendingInput[static_cast<int>(InputKind::Count)];
 };
 
 } // namespace crazy
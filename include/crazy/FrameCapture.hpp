@@ -0,0 +1,204 @@
+#ifndef CRAZY_FRAME_CAPTURE_HPP
+#define CRAZY_FRAME_CAPTURE_HPP
+
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// GLsync is declared by glext.h, which not every platform's gl.h pulls in
+typedef struct __GLsync* GLsync;
+
+namespace crazy {
+
+/**
+ * @brief Output format of a frame capture
+ */
+enum class CaptureFormat {
+    Y4M,            ///< One YUV4MPEG2 file, 4:2:0 full-range BT.601 (plays in ffplay/mpv, encodes with ffmpeg)
+    PngSequence     ///< One uncompressed RGB PNG per frame
+};
+
+/**
+ * @brief Configuration of a frame capture
+ */
+struct FrameCaptureSettings {
+    CaptureFormat format = CaptureFormat::Y4M;  ///< Output format
+    std::string path;                           ///< Y4M file, or PNG path prefix (frame number and ".png" are appended)
+    int frameRate = 60;                         ///< Frame rate written to the Y4M header
+    int bufferCount = 3;                        ///< Pixel buffers in rotation; frames a readback may lag behind
+    std::size_t maxQueuedFrames = 8;            ///< Frames waiting for the writer before new ones are dropped
+    bool simd = true;                           ///< Use SSE2 for the RGBA to YUV conversion where available
+};
+
+/**
+ * @brief Metrics of a frame capture
+ */
+struct FrameCaptureStats {
+    std::uint64_t frames = 0;           ///< Frames offered to capture()
+    std::uint64_t readBack = 0;         ///< Frames copied out of the pixel buffers
+    std::uint64_t written = 0;          ///< Frames written by the writer thread
+    std::uint64_t droppedGpu = 0;       ///< Frames dropped because every pixel buffer was still in use on the GPU
+    std::uint64_t droppedWriter = 0;    ///< Frames dropped because the writer queue was full
+    std::uint64_t droppedSize = 0;      ///< Frames dropped because the size changed during a Y4M capture
+    std::uint64_t bytesWritten = 0;     ///< Bytes written to disk
+    bool writeFailed = false;           ///< A write failed; the writer stopped writing
+};
+
+/**
+ * @brief Asynchronous capture of the rendered frames to disk
+ *
+ * Every frame, capture() starts an asynchronous glReadPixels of the back
+ * buffer into the next of a rotating set of pixel buffer objects and fences
+ * it. The frame thread never waits for the GPU: a buffer is mapped only
+ * once its fence has passed, a few frames later, and its pixels are handed
+ * to a writer thread that converts and writes them. When the GPU or the
+ * writer falls behind, frames are dropped and counted instead of stalling
+ * the frame loop.
+ *
+ * Y4M output converts RGBA to 4:2:0 YUV on the writer thread; the luma
+ * plane uses SSE2 when built for it. PNG output stores the pixels
+ * uncompressed, trading disk space for writer speed.
+ *
+ * Application drives this automatically once started:
+ * @code
+ * crazy::FrameCaptureSettings capture;
+ * capture.path = "repro.y4m";
+ * app.getFrameCapture().start(capture);
+ * ...
+ * app.getFrameCapture().stop();   // also done on shutdown
+ * @endcode
+ *
+ * ffmpeg -i repro.y4m -c:v libx264 repro.mp4 makes it shareable.
+ *
+ * start(), capture() and stop() must be called on the thread that owns the
+ * GL context; getStats() is thread-safe.
+ */
+class FrameCapture {
+public:
+    /**
+     * @brief Construct an inactive capture
+     */
+    FrameCapture();
+
+    /**
+     * @brief Stop the capture and delete the GL objects
+     */
+    ~FrameCapture();
+
+    // Disable copy construction and assignment
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    /**
+     * @brief Open the output and start the writer thread
+     *
+     * Resets the statistics.
+     *
+     * @param settings Output format and path
+     * @return true if capturing, false if already active or the output could not be opened
+     */
+    bool start(const FrameCaptureSettings& settings);
+
+    /**
+     * @brief Finish the frames in flight, flush the writer and close the output
+     *
+     * Blocks until every captured frame is on disk.
+     */
+    void stop();
+
+    /**
+     * @brief Check if a capture is running
+     */
+    bool isActive() const;
+
+    /**
+     * @brief Queue a readback of the default framebuffer's back buffer
+     *
+     * Call after the frame is rendered, before the buffers are swapped.
+     * Also hands the frames whose readback has completed to the writer.
+     *
+     * @param width Framebuffer width
+     * @param height Framebuffer height
+     */
+    void capture(int width, int height);
+
+    /**
+     * @brief Get the capture metrics
+     */
+    FrameCaptureStats getStats() const;
+
+    /**
+     * @brief Stop the capture and delete the pixel buffers
+     */
+    void release();
+
+private:
+    // A pixel buffer and the frame being read back into it
+    struct Slot {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        std::size_t capacity = 0;
+        std::uint64_t memoryId = 0;
+        int width = 0;
+        int height = 0;
+        std::uint64_t index = 0;
+        bool pending = false;
+    };
+
+    // Pixels on their way to disk, bottom row first
+    struct Frame {
+        std::vector<std::uint8_t> pixels;
+        int width = 0;
+        int height = 0;
+        std::uint64_t index = 0;
+    };
+
+    bool collect(Slot& slot, bool wait);
+    void run();
+    bool write(const Frame& frame);
+    bool writeY4m(const Frame& frame);
+    bool writePng(const Frame& frame);
+    bool writeBytes(std::FILE* file, const void* data, std::size_t size);
+
+    FrameCaptureSettings m_settings;
+    std::vector<Slot> m_slots;
+    std::size_t m_nextSlot;
+    std::uint64_t m_frameIndex;
+    int m_width;                        // Size of the Y4M stream, 0 before its first frame
+    int m_height;
+    bool m_active;
+
+    // Writer thread state, guarded by m_mutex
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Frame> m_queue;
+    std::vector<std::vector<std::uint8_t>> m_freeBuffers;
+    bool m_stopping;
+    std::thread m_thread;
+
+    // Writer-owned
+    std::FILE* m_file;
+    bool m_headerWritten;
+    std::vector<std::uint8_t> m_scratch;
+
+    std::atomic<std::uint64_t> m_frames;
+    std::atomic<std::uint64_t> m_readBack;
+    std::atomic<std::uint64_t> m_written;
+    std::atomic<std::uint64_t> m_droppedGpu;
+    std::atomic<std::uint64_t> m_droppedWriter;
+    std::atomic<std::uint64_t> m_droppedSize;
+    std::atomic<std::uint64_t> m_bytesWritten;
+    std::atomic<bool> m_writeFailed;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_FRAME_CAPTURE_HPP
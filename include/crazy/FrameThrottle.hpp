@@ -0,0 +1,172 @@
+#ifndef CRAZY_FRAME_THROTTLE_HPP
+#define CRAZY_FRAME_THROTTLE_HPP
+
+#include <cstdint>
+#include <functional>
+
+namespace crazy {
+
+class Window;
+
+/**
+ * @brief Rate the frame loop runs at
+ */
+enum class ThrottleState {
+    Full,       ///< Every frame, as the pacing policy allows
+    Reduced,    ///< Unfocused: settings.unfocusedFrameRate
+    Suspended,  ///< Iconified or hidden: no frames at all
+
+    Count
+};
+
+/**
+ * @brief Get the name of a throttle state
+ */
+const char* toString(ThrottleState state);
+
+/**
+ * @brief Throttling policy
+ */
+struct ThrottleSettings {
+    bool enabled = true;                    ///< Throttle at all; false always renders at full rate
+    double unfocusedFrameRate = 10.0;       ///< Frames per second while unfocused, 0 to suspend instead
+    bool suspendWhenIconified = true;       ///< Stop rendering while minimised
+    bool suspendWhenHidden = true;          ///< Stop rendering while the window is hidden
+    double suspendedWakeInterval = 0.25;    ///< Seconds between wake-ups while suspended, to run posted tasks
+};
+
+/**
+ * @brief Throttling metrics
+ */
+struct ThrottleStats {
+    ThrottleState state = ThrottleState::Full;  ///< Current state
+    std::uint64_t transitions = 0;              ///< State changes so far
+    double lastTransitionTime = 0.0;            ///< glfwGetTime() of the last state change
+    std::uint64_t frames[static_cast<int>(ThrottleState::Count)] = {};  ///< Frames rendered in each state
+    double time[static_cast<int>(ThrottleState::Count)] = {};           ///< Seconds spent in each state
+};
+
+/**
+ * @brief Called when the throttle state changes
+ *
+ * @param from Previous state
+ * @param to New state
+ */
+using ThrottleCallback = std::function<void(ThrottleState from, ThrottleState to)>;
+
+/**
+ * @brief Focus- and visibility-aware throttling of the frame loop
+ *
+ * Reads the GLFW focus, iconify and visibility attributes of the window
+ * once per loop iteration. A minimised or hidden window stops rendering
+ * and sleeps in glfwWaitEventsTimeout(), waking up every
+ * suspendedWakeInterval seconds so tasks posted to the main thread still
+ * run. An unfocused window keeps rendering at unfocusedFrameRate, which
+ * is enough for progress indicators and live data on a second monitor.
+ *
+ * GLFW reports no occlusion by other windows and no power state; apps that
+ * know they run on battery can lower the rates with setSettings().
+ *
+ * Animations that must stay smooth while unfocused request full rate for
+ * as long as they run; a suspended window still renders nothing:
+ * @code
+ * app.setUpdateCallback([&](float) {
+ *     if (ui.isAnimating()) {
+ *         app.getFrameThrottle().requestFullRate();
+ *     }
+ * });
+ * @endcode
+ *
+ * Application drives this automatically. After a suspension, the delta
+ * time of the next frame starts from the resume, not from the last frame
+ * before it.
+ */
+class FrameThrottle {
+public:
+    /**
+     * @brief Construct a throttle with default settings
+     */
+    FrameThrottle();
+
+    // Disable copy construction and assignment
+    FrameThrottle(const FrameThrottle&) = delete;
+    FrameThrottle& operator=(const FrameThrottle&) = delete;
+
+    /**
+     * @brief Replace the throttling policy
+     */
+    void setSettings(const ThrottleSettings& settings);
+
+    /**
+     * @brief Get the throttling policy
+     */
+    const ThrottleSettings& getSettings() const;
+
+    /**
+     * @brief Render at full rate for a while even when unfocused
+     *
+     * @param duration Seconds from now; 0 covers the next frame only
+     */
+    void requestFullRate(double duration = 0.0);
+
+    /**
+     * @brief Set the callback invoked on state changes
+     */
+    void setTransitionCallback(ThrottleCallback callback);
+
+    /**
+     * @brief Re-evaluate the state from the window attributes
+     *
+     * Records a transition if the state changed.
+     *
+     * @param window The application window
+     * @return ThrottleState The new state
+     */
+    ThrottleState update(Window& window);
+
+    /**
+     * @brief Count a rendered frame in the current state
+     */
+    void countFrame();
+
+    /**
+     * @brief Sleep in the event queue while the current state asks for it
+     *
+     * Suspended: waits for one wake-up interval. Reduced: waits until a
+     * frame period has passed since the previous call, returning early if
+     * an event moves the window out of the reduced state. Full: returns
+     * immediately. Events arriving meanwhile are processed (their callbacks
+     * run).
+     *
+     * @param window The application window
+     */
+    void wait(Window& window);
+
+    /**
+     * @brief Get the current state
+     */
+    ThrottleState getState() const;
+
+    /**
+     * @brief Get the throttling metrics
+     *
+     * The time in the current state is counted up to the last update().
+     */
+    const ThrottleStats& getStats() const;
+
+private:
+    ThrottleState evaluate(Window& window, double now) const;
+    void accumulate(double now);
+
+    ThrottleSettings m_settings;
+    ThrottleStats m_stats;
+    ThrottleCallback m_callback;
+    double m_fullRateUntil;     // glfwGetTime() until which full rate was requested, -1 for none
+    bool m_fullRateRequested;   // Full rate requested for the next frame
+    double m_lastUpdate;        // Time accumulated into m_stats.time up to here
+    double m_lastFrame;         // Start of the previous reduced-rate frame
+};
+
+} // namespace crazy
+
+#endif // CRAZY_FRAME_THROTTLE_HPP
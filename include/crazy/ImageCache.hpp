@@ -0,0 +1,336 @@
+#ifndef CRAZY_IMAGE_CACHE_HPP
+#define CRAZY_IMAGE_CACHE_HPP
+
+#include "TaskPool.hpp"
+#include <GLFW/glfw3.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace crazy {
+
+/**
+ * @brief Decoded image, 8-bit RGBA, top row first
+ */
+struct ImageBitmap {
+    int width = 0;                      ///< Width in pixels
+    int height = 0;                     ///< Height in pixels
+    std::vector<std::uint8_t> pixels;   ///< width * height * 4 bytes, not premultiplied
+};
+
+/**
+ * @brief Reads the encoded bytes of an image source
+ *
+ * Called on a TaskPool worker; must be thread-safe.
+ */
+using ImageLoader = std::function<bool(const std::string& source, std::vector<std::uint8_t>& data)>;
+
+/**
+ * @brief Decodes encoded bytes into a bitmap no larger than maxWidth x maxHeight
+ *
+ * A limit of 0 leaves that dimension unconstrained. Called on a TaskPool
+ * worker; must be thread-safe.
+ */
+using ImageDecoder = std::function<bool(const std::uint8_t* data, std::size_t size,
+                                        int maxWidth, int maxHeight, ImageBitmap& bitmap)>;
+
+/**
+ * @brief Read a file into memory (the default ImageLoader)
+ */
+bool loadImageFile(const std::string& path, std::vector<std::uint8_t>& data);
+
+/**
+ * @brief Decode binary PPM (P5/P6), PAM (P7) or uncompressed BMP (the default ImageDecoder)
+ *
+ * The image is downscaled with downscaleImage() while decoding, so a
+ * thumbnail never holds the full-size pixels longer than the decode.
+ */
+bool decodeImage(const std::uint8_t* data, std::size_t size, int maxWidth, int maxHeight, ImageBitmap& bitmap);
+
+/**
+ * @brief Shrink a bitmap to fit maxWidth x maxHeight, keeping its aspect ratio
+ *
+ * Box filter, alpha-weighted so transparent pixels do not darken the edges.
+ * Never enlarges; a limit of 0 leaves that dimension unconstrained.
+ *
+ * @return true if the bitmap was resized
+ */
+bool downscaleImage(ImageBitmap& bitmap, int maxWidth, int maxHeight);
+
+/**
+ * @brief Configuration of an ImageCache
+ */
+struct ImageCacheSettings {
+    std::size_t cpuBudget = 64u << 20;  ///< Bytes of decoded bitmaps kept after upload
+    std::size_t gpuBudget = 128u << 20; ///< Bytes of textures, mipmaps included
+    bool mipmaps = true;                ///< Generate mipmaps on upload and sample them trilinearly
+    int maxUploadsPerFrame = 4;         ///< Texture uploads per frame; further acquires stay pending
+    unsigned decodeThreads = 2;         ///< Worker threads that load and decode
+    int failedRetryFrames = 120;        ///< Frames a failed image stays Failed before it is loaded again
+};
+
+/**
+ * @brief State of an image returned by ImageCache::acquire()
+ */
+enum class ImageStatus {
+    Pending,    ///< Loading, decoding or waiting for an upload slot
+    Ready,      ///< Texture available
+    Failed      ///< The source could not be loaded or decoded
+};
+
+/**
+ * @brief Texture of a cached image
+ */
+struct ImageTexture {
+    GLuint texture = 0;     ///< GL_TEXTURE_2D, GL_RGBA8, row 0 at t = 0
+    int width = 0;          ///< Width of level 0
+    int height = 0;         ///< Height of level 0
+};
+
+/**
+ * @brief Metrics of an ImageCache
+ */
+struct ImageCacheStats {
+    std::uint64_t gpuHits = 0;          ///< acquire() calls that found the texture
+    std::uint64_t gpuMisses = 0;        ///< acquire() calls that did not, including each call while pending
+    std::uint64_t cpuHits = 0;          ///< acquire() calls without a texture that found the decoded bitmap
+    std::uint64_t cpuMisses = 0;        ///< acquire() and prefetch() calls that had to start a load
+    std::uint64_t gpuEvictions = 0;     ///< Textures deleted to stay within the GPU budget
+    std::uint64_t cpuEvictions = 0;     ///< Bitmaps dropped to stay within the CPU budget
+    std::uint64_t decodes = 0;          ///< Images decoded
+    std::uint64_t failures = 0;         ///< Images that failed to load or decode
+    std::uint64_t uploads = 0;          ///< Textures uploaded
+    std::size_t gpuBytes = 0;           ///< Bytes of resident textures
+    std::size_t cpuBytes = 0;           ///< Bytes of resident bitmaps
+    std::size_t textures = 0;           ///< Resident textures
+    std::size_t bitmaps = 0;            ///< Resident bitmaps
+    std::size_t pending = 0;            ///< Loads and decodes in flight
+
+    /**
+     * @brief Fraction of acquire() calls served by a resident texture
+     */
+    double gpuHitRate() const {
+        const std::uint64_t total = gpuHits + gpuMisses;
+        return total ? static_cast<double>(gpuHits) / static_cast<double>(total) : 0.0;
+    }
+
+    /**
+     * @brief Fraction of bitmap lookups served without a load
+     *
+     * Counts the calls that found a decoded bitmap against those that
+     * started a load; calls that found a load in flight are in neither.
+     */
+    double cpuHitRate() const {
+        const std::uint64_t total = cpuHits + cpuMisses;
+        return total ? static_cast<double>(cpuHits) / static_cast<double>(total) : 0.0;
+    }
+};
+
+/**
+ * @brief Two-tier cache of decoded images and their textures
+ *
+ * Images are keyed by source and target size, so the same file shown as a
+ * 64x64 avatar and a 512x512 preview is two entries, each decoded straight
+ * to its size: a thumbnail grid never uploads full-size images.
+ *
+ * - The GPU tier holds uploaded textures (with mipmaps unless disabled).
+ *   acquire() returns the texture of a resident entry and marks it used.
+ * - The CPU tier holds decoded bitmaps, so a texture evicted from the GPU
+ *   comes back with an upload instead of a load and decode.
+ *
+ * Loads and decodes run on a TaskPool; acquire() and update() never wait
+ * for them. Each tier has a byte budget and evicts its least recently used
+ * entries beyond it. A texture acquired since the last update() is never
+ * evicted, so the handle returned by acquire() stays valid until the next
+ * update(); acquire again every frame rather than keeping it.
+ *
+ * Application owns one and calls update() at the start of every frame:
+ * @code
+ * crazy::ImageTexture avatar;
+ * if (app.getImageCache().acquire("avatars/ada.ppm", 64, 64, avatar) == crazy::ImageStatus::Ready) {
+ *     drawTexturedQuad(avatar.texture, x, y, avatar.width, avatar.height);
+ * }
+ * @endcode
+ *
+ * Textures are accounted under MemoryCategory::Textures and bitmaps under
+ * MemoryCategory::Images. Must be used on the thread that owns the GL
+ * context.
+ */
+class ImageCache {
+public:
+    /**
+     * @brief Construct an empty cache; the decode threads start on first use
+     */
+    explicit ImageCache(const ImageCacheSettings& settings = ImageCacheSettings());
+
+    /**
+     * @brief Stop the decode threads and delete the textures
+     */
+    ~ImageCache();
+
+    // Disable copy construction and assignment
+    ImageCache(const ImageCache&) = delete;
+    ImageCache& operator=(const ImageCache&) = delete;
+
+    /**
+     * @brief Change the budgets and upload limits
+     *
+     * Smaller budgets take effect at the next update(); a different thread
+     * count takes effect once the cache is released.
+     */
+    void setSettings(const ImageCacheSettings& settings);
+
+    /**
+     * @brief Get the current settings
+     */
+    const ImageCacheSettings& getSettings() const;
+
+    /**
+     * @brief Set how sources are read; the default reads files
+     */
+    void setLoader(ImageLoader loader);
+
+    /**
+     * @brief Set how images are decoded; the default is decodeImage()
+     */
+    void setDecoder(ImageDecoder decoder);
+
+    /**
+     * @brief Get the texture of an image, starting its load if needed
+     *
+     * A source that fails to load or decode reports Failed for
+     * failedRetryFrames frames; the first acquire() after that loads it
+     * again, so a file that was not there yet shows up once it is.
+     *
+     * @param source Source passed to the loader
+     * @param maxWidth Largest width to decode to, 0 for the image's own
+     * @param maxHeight Largest height to decode to, 0 for the image's own
+     * @param texture Receives the texture when Ready
+     * @return ImageStatus Ready, Pending while it loads or waits to upload, or Failed
+     */
+    ImageStatus acquire(const std::string& source, int maxWidth, int maxHeight, ImageTexture& texture);
+
+    /**
+     * @brief Start loading and decoding an image without uploading it
+     *
+     * For images about to scroll into view. Does nothing if the image is
+     * resident or already loading.
+     */
+    void prefetch(const std::string& source, int maxWidth, int maxHeight);
+
+    /**
+     * @brief Start a frame: take in finished decodes and enforce the budgets
+     */
+    void update();
+
+    /**
+     * @brief Drop every entry of a source, e.g. after the file changed
+     *
+     * Loads in flight for it are discarded when they finish.
+     */
+    void invalidate(const std::string& source);
+
+    /**
+     * @brief Drop every entry and delete every texture
+     */
+    void clear();
+
+    /**
+     * @brief Get a snapshot of the metrics
+     */
+    ImageCacheStats getStats() const;
+
+    /**
+     * @brief Stop the decode threads, drop every entry and delete every texture
+     */
+    void release();
+
+private:
+    struct Key {
+        std::string source;
+        int width = 0;
+        int height = 0;
+
+        bool operator==(const Key& other) const {
+            return width == other.width && height == other.height && source == other.source;
+        }
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const {
+            return std::hash<std::string>()(key.source)
+                ^ (static_cast<std::size_t>(static_cast<std::uint32_t>(key.width)) * 0x9E3779B1u)
+                ^ (static_cast<std::size_t>(static_cast<std::uint32_t>(key.height)) << 20);
+        }
+    };
+
+    enum class BitmapState {
+        Loading,
+        Ready,
+        Failed
+    };
+
+    // Front of m_bitmapLru and m_textureLru is the most recently used entry
+    struct Bitmap {
+        BitmapState state = BitmapState::Loading;
+        std::uint64_t lastAcquired = 0; // Frame of the last acquire(), 0 if only prefetched
+        std::uint64_t failedFrame = 0;  // Frame the load failed in
+        std::uint64_t generation = 0;   // Matches the completion of the load that fills it
+        ImageBitmap image;
+        std::size_t bytes = 0;
+        std::list<Key>::iterator lru;   // In m_bitmapLru when Ready, m_failed when Failed
+    };
+
+    struct Texture {
+        ImageTexture texture;
+        std::size_t bytes = 0;
+        std::uint64_t memoryId = 0;
+        std::uint64_t lastUsed = 0;     // Frame of the last acquire()
+        std::list<Key>::iterator lru;
+    };
+
+    struct Completion {
+        Key key;
+        std::uint64_t generation = 0;
+        bool ok = false;
+        ImageBitmap image;
+    };
+
+    Bitmap* request(const Key& key);
+    bool upload(const Key& key, const ImageBitmap& image);
+    void dropBitmap(std::unordered_map<Key, Bitmap, KeyHash>::iterator it);
+    void dropTexture(std::unordered_map<Key, Texture, KeyHash>::iterator it);
+    void trimBitmaps();
+    void trimTextures();
+    void run(Key key, std::uint64_t generation, ImageLoader loader, ImageDecoder decoder);
+
+    ImageCacheSettings m_settings;
+    ImageLoader m_loader;
+    ImageDecoder m_decoder;
+    std::unique_ptr<TaskPool> m_pool;
+
+    std::unordered_map<Key, Bitmap, KeyHash> m_bitmaps;
+    std::unordered_map<Key, Texture, KeyHash> m_textures;
+    std::list<Key> m_bitmapLru;
+    std::list<Key> m_failed;            // Oldest failure first
+    std::list<Key> m_textureLru;
+    std::uint64_t m_frame;
+    std::uint64_t m_generation;
+    int m_uploadsThisFrame;
+
+    ImageCacheStats m_stats;
+
+    // Filled by the decode threads, drained by update()
+    std::mutex m_completedMutex;
+    std::vector<Completion> m_completed;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_IMAGE_CACHE_HPP
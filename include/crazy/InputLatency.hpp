@@ -0,0 +1,69 @@
+#ifndef CRAZY_INPUT_LATENCY_HPP
+#define CRAZY_INPUT_LATENCY_HPP
+
+#include <cstdint>
+
+namespace crazy {
+
+/**
+ * @brief Kinds of input whose latency is measured separately
+ */
+enum class InputKind {
+    Key,            ///< Key press, release and repeat
+    MouseButton,    ///< Mouse button press and release
+    MouseMove,      ///< Cursor movement
+    Scroll,         ///< Mouse wheel and touchpad scrolling
+
+    Count
+};
+
+/**
+ * @brief Get the name of an input kind
+ */
+const char* toString(InputKind kind);
+
+/**
+ * @brief Fixed-bucket histogram of latencies
+ *
+ * Buckets are kBucketWidth seconds wide; the last one also collects
+ * everything above the range. Cheap enough to update every frame and small
+ * enough to copy into a debug overlay.
+ */
+struct LatencyHistogram {
+    static constexpr int kBucketCount = 64;
+    static constexpr double kBucketWidth = 0.002;
+
+    std::uint64_t buckets[kBucketCount] = {};   ///< Samples per bucket
+    std::uint64_t count = 0;                    ///< Samples in total
+    double sum = 0.0;                           ///< Sum of the samples, in seconds
+    double max = 0.0;                           ///< Largest sample, in seconds
+
+    /**
+     * @brief Add a sample
+     *
+     * @param seconds Latency in seconds; negative values count as 0
+     */
+    void add(double seconds);
+
+    /**
+     * @brief Get the mean latency, or 0 without samples
+     */
+    double mean() const;
+
+    /**
+     * @brief Get a percentile, resolved to the upper edge of its bucket
+     *
+     * @param fraction Percentile as a fraction, e.g. 0.95
+     * @return Latency in seconds, or 0 without samples
+     */
+    double percentile(double fraction) const;
+
+    /**
+     * @brief Drop all samples
+     */
+    void reset();
+};
+
+} // namespace crazy
+
+#endif // CRAZY_INPUT_LATENCY_HPP
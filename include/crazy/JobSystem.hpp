@@ -0,0 +1,237 @@
+#ifndef CRAZY_JOB_SYSTEM_HPP
+#define CRAZY_JOB_SYSTEM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace crazy {
+
+class JobSystem;
+struct JobState;
+
+/**
+ * @brief Configuration of a JobSystem
+ */
+struct JobSystemSettings {
+    unsigned threadCount = 0;           ///< Worker threads; 0 uses the hardware threads minus one
+    std::uint32_t dequeCapacity = 4096; ///< Jobs per worker deque (power of two); overflow goes to a shared queue
+    std::uint32_t spinCount = 64;       ///< Failed attempts to find work before a worker parks
+};
+
+/**
+ * @brief Metrics of a JobSystem
+ */
+struct JobSystemStats {
+    std::uint64_t executed = 0;         ///< Jobs run
+    std::uint64_t stolen = 0;           ///< Jobs taken from another thread's deque
+    std::uint64_t overflowed = 0;       ///< Jobs queued on the shared queue (foreign thread or full deque)
+    std::uint64_t parks = 0;            ///< Times a worker went to sleep
+};
+
+/**
+ * @brief Reference to a job of a JobSystem
+ *
+ * Jobs are reference counted: a handle keeps its job alive, so it can be
+ * waited on or used as a dependency after the job has run.
+ */
+class JobHandle {
+public:
+    JobHandle() : m_job(nullptr) {}
+    JobHandle(const JobHandle& other);
+    JobHandle(JobHandle&& other) noexcept : m_job(other.m_job) { other.m_job = nullptr; }
+    JobHandle& operator=(JobHandle other) noexcept;
+    ~JobHandle();
+
+    /**
+     * @brief Check if the handle refers to a job
+     */
+    bool isValid() const { return m_job != nullptr; }
+
+    /**
+     * @brief Check if the job and all its children have finished
+     */
+    bool isDone() const;
+
+private:
+    friend class JobSystem;
+    explicit JobHandle(JobState* job);
+
+    JobState* m_job;
+};
+
+/**
+ * @brief Work-stealing job scheduler
+ *
+ * Jobs are small functions run by a fixed set of worker threads. Every
+ * worker, and the thread that created the system (normally the main
+ * thread, which helps while it waits), owns a Chase-Lev deque: the owner
+ * pushes and pops jobs at one end without locking and idle threads steal
+ * from the other end. Jobs scheduled from other threads, or that do not
+ * fit a full deque, go through a shared queue. Workers that find no work
+ * spin briefly and then park until a job is scheduled, so an idle system
+ * costs no CPU.
+ *
+ * A job starts once it is submitted and all jobs it depends on have
+ * finished (addDependency(), then()). A job finishes when its function
+ * returned and all its children (createChild()) have finished, which
+ * makes fork-join and continuation chains easy to express:
+ *
+ * @code
+ * crazy::JobSystem& jobs = app.getJobSystem();
+ * crazy::JobHandle layout = jobs.schedule([&] { computeLayout(); });
+ * crazy::JobHandle record = jobs.then(layout, [&] { buildDrawList(); });
+ * jobs.parallelFor(0, particles.size(), [&](std::size_t first, std::size_t last) {
+ *     for (std::size_t i = first; i < last; ++i) particles[i].update(dt);
+ * });
+ * jobs.wait(record);
+ * @endcode
+ *
+ * Jobs must not block on I/O or locks for long; use TaskPool for that
+ * kind of work. All methods are thread-safe. Destroying the system drops
+ * jobs that have not started: they finish without running, and so do the
+ * jobs that depend on them. Wait for the work first.
+ */
+class JobSystem {
+public:
+    /**
+     * @brief Start the workers; the calling thread becomes the owner thread
+     */
+    explicit JobSystem(const JobSystemSettings& settings = JobSystemSettings());
+
+    /**
+     * @brief Stop and join the workers
+     */
+    ~JobSystem();
+
+    // Disable copy construction and assignment
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /**
+     * @brief Create a job without starting it
+     *
+     * Add dependencies, then submit() it.
+     */
+    JobHandle create(std::function<void()> function);
+
+    /**
+     * @brief Create a job that its parent waits for
+     *
+     * The parent does not finish (and its dependents do not start) before
+     * the child has finished. Call before the parent finishes, e.g. from
+     * the parent's own function.
+     */
+    JobHandle createChild(const JobHandle& parent, std::function<void()> function);
+
+    /**
+     * @brief Make a job wait for another one
+     *
+     * @param job Job not submitted yet
+     * @param dependency Job that must finish first
+     * @return true if the dependency was added (false if a handle is invalid)
+     */
+    bool addDependency(const JobHandle& job, const JobHandle& dependency);
+
+    /**
+     * @brief Allow a created job to start once its dependencies are done
+     *
+     * @return true if the job was submitted, false if it already was
+     */
+    bool submit(const JobHandle& job);
+
+    /**
+     * @brief Create and submit a job
+     */
+    JobHandle schedule(std::function<void()> function);
+
+    /**
+     * @brief Schedule a continuation that starts when @p job has finished
+     */
+    JobHandle then(const JobHandle& job, std::function<void()> function);
+
+    /**
+     * @brief Run jobs on the calling thread until @p job has finished
+     *
+     * Never blocks the caller idly while there is work it could do, so it
+     * is safe to call from inside a job.
+     */
+    void wait(const JobHandle& job);
+
+    /**
+     * @brief Split [begin, end) into ranges and process them in parallel
+     *
+     * Returns when every range has been processed; the calling thread
+     * takes part.
+     *
+     * @param begin First index
+     * @param end One past the last index
+     * @param function Called as function(first, last) for each range
+     * @param grainSize Maximum indices per range; 0 picks about four ranges per thread
+     */
+    template <typename Function>
+    void parallelFor(std::size_t begin, std::size_t end, Function&& function, std::size_t grainSize = 0) {
+        runParallelFor(begin, end, grainSize, std::function<void(std::size_t, std::size_t)>(
+            [&function](std::size_t first, std::size_t last) { function(first, last); }));
+    }
+
+    /**
+     * @brief Get the number of worker threads (excluding the owner thread)
+     */
+    unsigned getThreadCount() const;
+
+    /**
+     * @brief Get a snapshot of the metrics
+     */
+    JobSystemStats getStats() const;
+
+private:
+    friend class JobHandle;
+    class Deque;
+
+    void runParallelFor(std::size_t begin, std::size_t end, std::size_t grainSize,
+                        const std::function<void(std::size_t, std::size_t)>& function);
+    int currentSlot() const;
+    void enqueue(JobState* job);
+    bool runOne(int slot);
+    void execute(JobState* job);
+    void finish(JobState* job);
+    void complete(JobState* job);
+    bool hasWork() const;
+    void wake();
+    void workerLoop(int slot);
+
+    std::vector<std::unique_ptr<Deque>> m_deques;   // slot 0 is the owner thread
+    std::vector<std::thread> m_threads;
+    std::thread::id m_ownerThread;
+    std::uint32_t m_spinCount;
+
+    std::mutex m_overflowMutex;
+    std::deque<JobState*> m_overflow;
+    std::atomic<std::size_t> m_overflowSize;
+
+    // Parking: a worker registers as a sleeper, re-checks for work, then
+    // waits for the epoch to change; enqueue() bumps the epoch when
+    // sleepers exist
+    std::mutex m_parkMutex;
+    std::condition_variable m_parkCondition;
+    std::atomic<int> m_sleepers;
+    std::atomic<std::uint64_t> m_epoch;
+    std::atomic<bool> m_stopping;
+
+    std::atomic<std::uint64_t> m_executed;
+    std::atomic<std::uint64_t> m_stolen;
+    std::atomic<std::uint64_t> m_overflowed;
+    std::atomic<std::uint64_t> m_parks;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_JOB_SYSTEM_HPP
@@ -0,0 +1,474 @@
+#ifndef CRAZY_LOG_HPP
+#define CRAZY_LOG_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Compile-time log level threshold. Calls below it expand to nothing, so
+ * their arguments are not even evaluated. Override with
+ * -DCRAZY_LOG_LEVEL=CRAZY_LOG_LEVEL_WARNING (or the CMake cache variable
+ * CRAZY_LOG_LEVEL=WARNING).
+ */
+#define CRAZY_LOG_LEVEL_TRACE   0
+#define CRAZY_LOG_LEVEL_DEBUG   1
+#define CRAZY_LOG_LEVEL_INFO    2
+#define CRAZY_LOG_LEVEL_WARNING 3
+#define CRAZY_LOG_LEVEL_ERROR   4
+#define CRAZY_LOG_LEVEL_OFF     5
+
+#ifndef CRAZY_LOG_LEVEL
+#ifdef NDEBUG
+#define CRAZY_LOG_LEVEL CRAZY_LOG_LEVEL_INFO
+#else
+#define CRAZY_LOG_LEVEL CRAZY_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+namespace crazy {
+
+/**
+ * @brief Severity of a log message
+ */
+enum class LogLevel : int {
+    Trace = CRAZY_LOG_LEVEL_TRACE,
+    Debug = CRAZY_LOG_LEVEL_DEBUG,
+    Info = CRAZY_LOG_LEVEL_INFO,
+    Warning = CRAZY_LOG_LEVEL_WARNING,
+    Error = CRAZY_LOG_LEVEL_ERROR,
+    Off = CRAZY_LOG_LEVEL_OFF
+};
+
+/**
+ * @brief Get the lower-case name of a level ("info", "error", ...)
+ */
+const char* toString(LogLevel level);
+
+/**
+ * @brief A formatted message handed to sinks
+ */
+struct LogMessage {
+    LogLevel level;
+    std::chrono::system_clock::time_point time;
+    std::uint32_t threadId;     ///< Small sequential id of the logging thread
+    std::string_view text;      ///< Formatted message, valid during LogSink::write()
+};
+
+/**
+ * @brief Destination for log messages
+ *
+ * Sinks are only called from the logger's background thread.
+ */
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+
+    /**
+     * @brief Write one message
+     */
+    virtual void write(const LogMessage& message) = 0;
+
+    /**
+     * @brief Flush buffered output; called after each drained batch
+     */
+    virtual void flush() {}
+};
+
+/**
+ * @brief Sink writing to stdout (info and below) and stderr (warnings, errors)
+ */
+class ConsoleLogSink : public LogSink {
+public:
+    void write(const LogMessage& message) override;
+    void flush() override;
+
+private:
+    std::string m_line;
+};
+
+/**
+ * @brief Sink writing to a file that is rotated once it reaches a size limit
+ *
+ * When @c path exceeds @c maxBytes it is renamed to @c path.1, the previous
+ * @c path.1 to @c path.2 and so on, keeping at most @c maxFiles old files.
+ */
+class RotatingFileLogSink : public LogSink {
+public:
+    /**
+     * @brief Construct a new Rotating File Log Sink object
+     *
+     * @param path Log file path
+     * @param maxBytes Size at which the file is rotated
+     * @param maxFiles Number of rotated files kept
+     */
+    RotatingFileLogSink(const std::string& path, std::size_t maxBytes = 10 * 1024 * 1024,
+                        int maxFiles = 3);
+    ~RotatingFileLogSink() override;
+
+    void write(const LogMessage& message) override;
+    void flush() override;
+
+private:
+    void rotate();
+
+    std::string m_path;
+    std::size_t m_maxBytes;
+    int m_maxFiles;
+    std::FILE* m_file;
+    std::size_t m_size;
+    std::string m_line;
+};
+
+/**
+ * @brief Sink keeping the most recent messages in memory
+ *
+ * Useful for in-app consoles, crash reports and tests.
+ */
+class MemoryLogSink : public LogSink {
+public:
+    /**
+     * @brief Construct a new Memory Log Sink object
+     *
+     * @param capacity Number of lines kept
+     */
+    explicit MemoryLogSink(std::size_t capacity = 1000);
+
+    void write(const LogMessage& message) override;
+
+    /**
+     * @brief Get a copy of the stored lines, oldest first
+     */
+    std::vector<std::string> getLines() const;
+
+    /**
+     * @brief Remove all stored lines
+     */
+    void clear();
+
+private:
+    std::size_t m_capacity;
+    mutable std::mutex m_mutex;
+    std::deque<std::string> m_lines;
+};
+
+namespace detail {
+
+// Argument type tags of the encoded record payload
+enum class LogArgType : unsigned char {
+    Int,
+    UInt,
+    Double,
+    Bool,
+    Char,
+    String,
+    Pointer
+};
+
+/**
+ * @brief Writes arguments into a record payload without allocating
+ *
+ * Strings are copied (and truncated if the payload is full) because the
+ * message is formatted later, on the background thread.
+ */
+class LogArgEncoder {
+public:
+    LogArgEncoder(unsigned char* buffer, std::size_t capacity)
+        : m_buffer(buffer), m_capacity(capacity), m_size(0) {}
+
+    template <typename T>
+    void encode(const T& value) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, bool>) {
+            putScalar(LogArgType::Bool, static_cast<unsigned char>(value));
+        } else if constexpr (std::is_same_v<U, char>) {
+            putScalar(LogArgType::Char, value);
+        } else if constexpr (std::is_enum_v<U>) {
+            encode(static_cast<std::underlying_type_t<U>>(value));
+        } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            putScalar(LogArgType::Int, static_cast<std::int64_t>(value));
+        } else if constexpr (std::is_integral_v<U>) {
+            putScalar(LogArgType::UInt, static_cast<std::uint64_t>(value));
+        } else if constexpr (std::is_floating_point_v<U>) {
+            putScalar(LogArgType::Double, static_cast<double>(value));
+        } else if constexpr (std::is_array_v<T>) {
+            putString(std::string_view(value));
+        } else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+            putString(value ? std::string_view(value) : std::string_view("(null)"));
+        } else if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+            putString(std::string_view(value));
+        } else if constexpr (std::is_pointer_v<U>) {
+            putScalar(LogArgType::Pointer, reinterpret_cast<std::uintptr_t>(value));
+        } else {
+            static_assert(std::is_arithmetic_v<U>, "Unsupported log argument type");
+        }
+    }
+
+    std::size_t size() const { return m_size; }
+
+private:
+    template <typename T>
+    void putScalar(LogArgType type, T value) {
+        if (m_size + 1 + sizeof(T) > m_capacity) {
+            return;
+        }
+        m_buffer[m_size++] = static_cast<unsigned char>(type);
+        std::memcpy(m_buffer + m_size, &value, sizeof(T));
+        m_size += sizeof(T);
+    }
+
+    void putString(std::string_view text) {
+        const std::size_t header = 1 + sizeof(std::uint16_t);
+        if (m_size + header > m_capacity) {
+            return;
+        }
+        std::uint16_t length = static_cast<std::uint16_t>(
+            std::min<std::size_t>(text.size(), m_capacity - m_size - header));
+        m_buffer[m_size++] = static_cast<unsigned char>(LogArgType::String);
+        std::memcpy(m_buffer + m_size, &length, sizeof(length));
+        m_size += sizeof(length);
+        std::memcpy(m_buffer + m_size, text.data(), length);
+        m_size += length;
+    }
+
+    unsigned char* m_buffer;
+    std::size_t m_capacity;
+    std::size_t m_size;
+};
+
+} // namespace detail
+
+/**
+ * @brief Asynchronous logger with a lock-free multi-producer queue
+ *
+ * Logging threads claim a fixed-size record in a bounded MPSC ring buffer,
+ * store the format string pointer and the raw arguments in it and return;
+ * nothing is formatted, allocated or written on the calling thread. A
+ * background thread drains the ring, formats the messages and hands them to
+ * the sinks. When the ring is full, messages are dropped and counted rather
+ * than blocking the frame thread.
+ *
+ * Format strings use "{}" placeholders and must outlive the logger (string
+ * literals); the CRAZY_LOG_* macros enforce this.
+ *
+ * Example usage:
+ * @code
+ * CRAZY_LOG_INFO("Window resized to {}x{}", width, height);
+ *
+ * crazy::Logger::instance().addSink(
+ *     std::make_shared<crazy::RotatingFileLogSink>("crazy.log"));
+ * @endcode
+ */
+class Logger {
+public:
+    /// Payload bytes per record; longer messages are truncated
+    static constexpr std::size_t kRecordPayload = 200;
+
+    /// Number of records in the ring (power of two)
+    static constexpr std::size_t kCapacity = 4096;
+
+    /**
+     * @brief Get the process-wide logger, starting it on first use
+     *
+     * Starts with a single ConsoleLogSink.
+     */
+    static Logger& instance();
+
+    /**
+     * @brief Destroy the Logger object, draining pending messages
+     */
+    ~Logger();
+
+    // Disable copy construction and assignment
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /**
+     * @brief Queue a message
+     *
+     * Prefer the CRAZY_LOG_* macros, which also filter at compile time.
+     *
+     * @param level Message level
+     * @param format Format string with "{}" placeholders (string literal)
+     * @param args Arguments (arithmetic, strings, pointers, enums)
+     */
+    template <std::size_t N, typename... Args>
+    void log(LogLevel level, const char (&format)[N], const Args&... args) {
+        if (static_cast<int>(level) < m_level.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Record* record = claim();
+        if (!record) {
+            return;
+        }
+        record->level = level;
+        record->format = format;
+        detail::LogArgEncoder encoder(record->payload, kRecordPayload);
+        (encoder.encode(args), ...);
+        record->payloadSize = static_cast<std::uint16_t>(encoder.size());
+        publish(record, level >= LogLevel::Error);
+    }
+
+    /**
+     * @brief Set the runtime level threshold
+     *
+     * Only levels at or above the compile-time threshold can be enabled.
+     */
+    void setLevel(LogLevel level);
+
+    /**
+     * @brief Get the runtime level threshold
+     */
+    LogLevel getLevel() const;
+
+    /**
+     * @brief Add a sink
+     */
+    void addSink(std::shared_ptr<LogSink> sink);
+
+    /**
+     * @brief Remove a sink
+     */
+    void removeSink(const std::shared_ptr<LogSink>& sink);
+
+    /**
+     * @brief Remove all sinks, including the default console sink
+     */
+    void clearSinks();
+
+    /**
+     * @brief Block until every message queued so far has reached the sinks
+     */
+    void flush();
+
+    /**
+     * @brief Get the number of messages dropped because the ring was full
+     */
+    std::uint64_t getDroppedCount() const;
+
+private:
+    struct Record {
+        std::atomic<std::size_t> sequence;
+        LogLevel level;
+        std::uint32_t threadId;
+        std::int64_t timestamp;         // system_clock ticks
+        const char* format;
+        std::uint16_t payloadSize;
+        unsigned char payload[kRecordPayload];
+    };
+
+    Logger();
+
+    Record* claim();
+    void publish(Record* record, bool urgent);
+    void run();
+    std::size_t drain();
+    void format(const Record& record, std::string& out) const;
+
+    std::unique_ptr<Record[]> m_records;
+    alignas(64) std::atomic<std::size_t> m_enqueuePos;
+    alignas(64) std::atomic<std::size_t> m_dequeuePos;
+    std::atomic<std::uint64_t> m_dropped;
+    std::atomic<int> m_level;
+
+    std::atomic<bool> m_sleeping;
+    std::atomic<bool> m_running;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+
+    std::mutex m_sinkMutex;
+    std::vector<std::shared_ptr<LogSink>> m_sinks;
+
+    std::thread m_thread;
+};
+
+/**
+ * @brief Lets through at most N events per time window
+ *
+ * Used to keep error storms (e.g. a GLFW error raised every frame) from
+ * flooding the log.
+ *
+ * Example usage:
+ * @code
+ * static crazy::LogRateLimiter limiter(10, 1.0);
+ * std::uint64_t suppressed = 0;
+ * if (limiter.allow(suppressed)) {
+ *     CRAZY_LOG_ERROR("Something failed ({} similar messages suppressed)", suppressed);
+ * }
+ * @endcode
+ */
+class LogRateLimiter {
+public:
+    /**
+     * @brief Construct a new Log Rate Limiter object
+     *
+     * @param maxEvents Events allowed per window
+     * @param windowSeconds Window length in seconds
+     */
+    LogRateLimiter(std::uint32_t maxEvents, double windowSeconds);
+
+    /**
+     * @brief Check whether an event may be logged
+     *
+     * @param suppressed Receives the number of events refused since the last
+     *                   allowed one
+     * @return true if the event should be logged
+     */
+    bool allow(std::uint64_t& suppressed);
+
+private:
+    std::uint32_t m_maxEvents;
+    std::int64_t m_windowTicks;
+    std::atomic<std::int64_t> m_windowStart;
+    std::atomic<std::uint32_t> m_count;
+    std::atomic<std::uint64_t> m_suppressed;
+};
+
+} // namespace crazy
+
+#define CRAZY_LOG_AT(level, ...) ::crazy::Logger::instance().log(level, __VA_ARGS__)
+
+#if CRAZY_LOG_LEVEL <= CRAZY_LOG_LEVEL_TRACE
+#define CRAZY_LOG_TRACE(...) CRAZY_LOG_AT(::crazy::LogLevel::Trace, __VA_ARGS__)
+#else
+#define CRAZY_LOG_TRACE(...) ((void)0)
+#endif
+
+#if CRAZY_LOG_LEVEL <= CRAZY_LOG_LEVEL_DEBUG
+#define CRAZY_LOG_DEBUG(...) CRAZY_LOG_AT(::crazy::LogLevel::Debug, __VA_ARGS__)
+#else
+#define CRAZY_LOG_DEBUG(...) ((void)0)
+#endif
+
+#if CRAZY_LOG_LEVEL <= CRAZY_LOG_LEVEL_INFO
+#define CRAZY_LOG_INFO(...) CRAZY_LOG_AT(::crazy::LogLevel::Info, __VA_ARGS__)
+#else
+#define CRAZY_LOG_INFO(...) ((void)0)
+#endif
+
+#if CRAZY_LOG_LEVEL <= CRAZY_LOG_LEVEL_WARNING
+#define CRAZY_LOG_WARNING(...) CRAZY_LOG_AT(::crazy::LogLevel::Warning, __VA_ARGS__)
+#else
+#define CRAZY_LOG_WARNING(...) ((void)0)
+#endif
+
+#if CRAZY_LOG_LEVEL <= CRAZY_LOG_LEVEL_ERROR
+#define CRAZY_LOG_ERROR(...) CRAZY_LOG_AT(::crazy::LogLevel::Error, __VA_ARGS__)
+#else
+#define CRAZY_LOG_ERROR(...) ((void)0)
+#endif
+
+#endif // CRAZY_LOG_HPP
@@ -0,0 +1,276 @@
+#ifndef CRAZY_MEMORY_TRACKER_HPP
+#define CRAZY_MEMORY_TRACKER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace crazy {
+
+/**
+ * @brief What a block of tracked memory is used for
+ */
+enum class MemoryCategory {
+    // GPU
+    Textures,           ///< Application textures (images, asset pack textures)
+    GlyphAtlas,         ///< Font glyph atlases
+    VertexBuffers,      ///< BufferManager static pages and streaming ring
+    FramebufferLayers,  ///< RenderTarget color textures and depth-stencil buffers
+
+    // CPU
+    UiTree,             ///< UiTree nodes and node index
+    DrawLists,          ///< Per-frame draw lists (UiRenderer instances)
+    Images,             ///< Decoded image bitmaps (ImageCache)
+    Jobs,               ///< JobSystem job records
+    General,            ///< Other framework allocations
+
+    Count
+};
+
+/**
+ * @brief Get the name of a memory category
+ */
+const char* toString(MemoryCategory category);
+
+/**
+ * @brief Check if a memory category holds GPU memory
+ */
+bool isGpuCategory(MemoryCategory category);
+
+/**
+ * @brief Totals of one memory category
+ */
+struct MemoryCategoryStats {
+    std::size_t bytes = 0;              ///< Bytes currently held
+    std::size_t peakBytes = 0;          ///< High-water mark since start or resetPeaks()
+    std::size_t count = 0;              ///< Live resources or allocations
+    std::size_t budget = 0;             ///< Budget in bytes, 0 for none
+};
+
+/**
+ * @brief A live tracked resource, as reported by getRecords()
+ */
+struct MemoryRecord {
+    std::uint64_t id = 0;               ///< Handle returned by track(); increases with creation order
+    MemoryCategory category = MemoryCategory::General; ///< Category
+    std::size_t bytes = 0;              ///< Estimated size
+    std::string label;                  ///< Description given to track()
+};
+
+/**
+ * @brief Called when a category goes over its budget
+ *
+ * @param category The category
+ * @param excess Bytes above the budget
+ */
+using MemoryBudgetCallback = std::function<void(MemoryCategory category, std::size_t excess)>;
+
+/**
+ * @brief Process-wide memory accounting per resource category
+ *
+ * GPU resources created by the framework (RenderTarget layers,
+ * BufferManager pages and the streaming ring) are registered here with an
+ * estimated size and a label; applications register their own textures
+ * and glyph atlases the same way. Framework CPU allocations (UiTree nodes,
+ * draw lists, job records) go through a TrackedMemoryResource of their
+ * category, which only counts bytes.
+ *
+ * Totals and high-water marks can be queried at any time, e.g. for a
+ * debug overlay. A budget per category calls back when the category goes
+ * over it, so caches can evict. getRecords() and logReport() list the live
+ * resources; comparing against a mark taken with getLastId() finds what was
+ * created and never released:
+ *
+ * @code
+ * auto& memory = crazy::MemoryTracker::instance();
+ *
+ * GLuint texture = ...;
+ * auto handle = memory.track(crazy::MemoryCategory::Textures,
+ *     crazy::MemoryTracker::estimateTextureSize(width, height, 4, true), "logo.png");
+ * ...
+ * glDeleteTextures(1, &texture);
+ * memory.untrack(handle);
+ *
+ * memory.setBudget(crazy::MemoryCategory::Textures, 256 << 20,
+ *     [&](crazy::MemoryCategory, std::size_t excess) { textureCache.evict(excess); });
+ * @endcode
+ *
+ * All methods are thread-safe. Budget callbacks run on the thread whose
+ * allocation crossed the budget, outside the tracker's lock; allocations
+ * made from the callback do not trigger it again.
+ */
+class MemoryTracker {
+public:
+    /**
+     * @brief Get the process-wide tracker
+     */
+    static MemoryTracker& instance();
+
+    // Disable copy construction and assignment
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    /**
+     * @brief Register a resource
+     *
+     * @param category What the resource is used for
+     * @param bytes Estimated size
+     * @param label Description shown by getRecords() and logReport()
+     * @return Handle for resize() and untrack(), never 0
+     */
+    std::uint64_t track(MemoryCategory category, std::size_t bytes, std::string label);
+
+    /**
+     * @brief Change the size of a registered resource (e.g. on reallocation)
+     */
+    void resize(std::uint64_t id, std::size_t bytes);
+
+    /**
+     * @brief Unregister a resource; 0 and unknown handles are ignored
+     */
+    void untrack(std::uint64_t id);
+
+    /**
+     * @brief Count an anonymous allocation, as TrackedMemoryResource does
+     */
+    void allocate(MemoryCategory category, std::size_t bytes);
+
+    /**
+     * @brief Count the release of an anonymous allocation
+     */
+    void deallocate(MemoryCategory category, std::size_t bytes);
+
+    /**
+     * @brief Get the totals of a category
+     */
+    MemoryCategoryStats getStats(MemoryCategory category) const;
+
+    /**
+     * @brief Get the bytes currently held by all GPU or all CPU categories
+     */
+    std::size_t getTotalBytes(bool gpu) const;
+
+    /**
+     * @brief Reset the high-water marks to the current totals
+     */
+    void resetPeaks();
+
+    /**
+     * @brief Set the budget of a category
+     *
+     * @param category The category
+     * @param bytes Budget in bytes, 0 to remove it
+     * @param callback Called each time the category goes from within the
+     *                 budget to over it; should free at least the excess
+     */
+    void setBudget(MemoryCategory category, std::size_t bytes, MemoryBudgetCallback callback);
+
+    /**
+     * @brief Get the handle of the most recently registered resource
+     *
+     * Use as a mark: records with a larger id were created after it.
+     */
+    std::uint64_t getLastId() const;
+
+    /**
+     * @brief List the live registered resources, in creation order
+     *
+     * @param since Only list resources with an id greater than this mark
+     */
+    std::vector<MemoryRecord> getRecords(std::uint64_t since = 0) const;
+
+    /**
+     * @brief Log the category totals and the live resources
+     *
+     * @param since Only list resources with an id greater than this mark
+     */
+    void logReport(std::uint64_t since = 0) const;
+
+    /**
+     * @brief Get the memory resource counting allocations into a category
+     *
+     * The resource allocates from the default heap and lives as long as
+     * the process.
+     */
+    std::pmr::memory_resource* getResource(MemoryCategory category);
+
+    /**
+     * @brief Estimate the size of a 2D texture
+     *
+     * @param width Width in pixels
+     * @param height Height in pixels
+     * @param bytesPerPixel Bytes per pixel (4 for GL_RGBA8)
+     * @param mipmaps Include a full mipmap chain (adds a third)
+     */
+    static std::size_t estimateTextureSize(int width, int height, int bytesPerPixel, bool mipmaps = false);
+
+private:
+    MemoryTracker();
+
+    struct Category {
+        std::atomic<std::size_t> bytes{0};
+        std::atomic<std::size_t> peakBytes{0};
+        std::atomic<std::size_t> count{0};
+        std::atomic<std::size_t> budget{0};
+    };
+
+    void add(MemoryCategory category, std::size_t bytes);
+    void subtract(MemoryCategory category, std::size_t bytes);
+
+    static constexpr int kCategoryCount = static_cast<int>(MemoryCategory::Count);
+
+    Category m_categories[kCategoryCount];
+    std::unique_ptr<std::pmr::memory_resource> m_resources[kCategoryCount];
+
+    // Guards the registry and the budget callbacks
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::uint64_t, MemoryRecord> m_records;
+    MemoryBudgetCallback m_callbacks[kCategoryCount];
+    std::uint64_t m_lastId;
+};
+
+/**
+ * @brief Memory resource that counts its allocations into a MemoryCategory
+ *
+ * For std::pmr containers and for class-specific operator new/delete:
+ *
+ * @code
+ * std::pmr::vector<Instance> instances{
+ *     crazy::MemoryTracker::instance().getResource(crazy::MemoryCategory::DrawLists)};
+ * @endcode
+ */
+class TrackedMemoryResource : public std::pmr::memory_resource {
+public:
+    /**
+     * @brief Construct a resource
+     *
+     * @param category Category the allocations are counted into
+     * @param upstream Resource doing the allocations
+     */
+    explicit TrackedMemoryResource(MemoryCategory category,
+                                   std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    /**
+     * @brief Get the category the allocations are counted into
+     */
+    MemoryCategory getCategory() const;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    MemoryCategory m_category;
+    std::pmr::memory_resource* m_upstream;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_MEMORY_TRACKER_HPP
@@ -0,0 +1,458 @@
+#ifndef CRAZY_NODE_RUNTIME_HPP
+#define CRAZY_NODE_RUNTIME_HPP
+
+#include "TaskPool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace crazy {
+
+/**
+ * @brief A JavaScript value crossing the C++/JS boundary
+ *
+ * Covers the primitive types (undefined, null, boolean, number, string).
+ * Objects and arrays are converted to undefined; pass structured data as
+ * strings (e.g. JSON) or through a binary channel.
+ */
+class NodeValue {
+public:
+    enum class Type {
+        Undefined,
+        Null,
+        Boolean,
+        Number,
+        String
+    };
+
+    NodeValue() : m_type(Type::Undefined), m_number(0.0) {}
+    NodeValue(bool value) : m_type(Type::Boolean), m_number(value ? 1.0 : 0.0) {}
+    NodeValue(int value) : m_type(Type::Number), m_number(value) {}
+    NodeValue(double value) : m_type(Type::Number), m_number(value) {}
+    NodeValue(const char* value) : m_type(Type::String), m_number(0.0), m_string(value ? value : "") {}
+    NodeValue(std::string value) : m_type(Type::String), m_number(0.0), m_string(std::move(value)) {}
+
+    static NodeValue null() {
+        NodeValue value;
+        value.m_type = Type::Null;
+        return value;
+    }
+
+    Type getType() const { return m_type; }
+    bool isUndefined() const { return m_type == Type::Undefined; }
+    bool isNull() const { return m_type == Type::Null; }
+    bool isBoolean() const { return m_type == Type::Boolean; }
+    bool isNumber() const { return m_type == Type::Number; }
+    bool isString() const { return m_type == Type::String; }
+
+    bool asBoolean() const { return m_number != 0.0; }
+    double asNumber() const { return m_number; }
+    const std::string& asString() const { return m_string; }
+
+private:
+    Type m_type;
+    double m_number;
+    std::string m_string;
+};
+
+/**
+ * @brief Cancellation state of an asynchronous native call
+ *
+ * Set when the AbortSignal passed by JavaScript fires or the runtime shuts
+ * down. Long-running functions should poll isCancelled() and return early;
+ * their result is discarded either way.
+ */
+class NodeCancellation {
+public:
+    NodeCancellation() = default;
+    explicit NodeCancellation(std::shared_ptr<const std::atomic<bool>> flag) : m_flag(std::move(flag)) {}
+
+    bool isCancelled() const { return m_flag && m_flag->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<const std::atomic<bool>> m_flag;
+};
+
+/**
+ * @brief Result of an asynchronous native call
+ *
+ * The promise returned to JavaScript resolves with the value, or with an
+ * ArrayBuffer over the bytes of fromBuffer() (handed over without a copy),
+ * or rejects with an Error carrying the message of fromError().
+ */
+class NodeAsyncResult {
+public:
+    NodeAsyncResult() = default;
+    NodeAsyncResult(NodeValue value) : m_value(std::move(value)) {}
+
+    static NodeAsyncResult fromBuffer(std::vector<std::uint8_t> bytes) {
+        NodeAsyncResult result;
+        result.m_buffer = std::move(bytes);
+        result.m_hasBuffer = true;
+        return result;
+    }
+
+    static NodeAsyncResult fromError(std::string message) {
+        NodeAsyncResult result;
+        result.m_error = std::move(message);
+        result.m_isError = true;
+        return result;
+    }
+
+    bool isError() const { return m_isError; }
+    bool hasBuffer() const { return m_hasBuffer; }
+    const NodeValue& getValue() const { return m_value; }
+    std::vector<std::uint8_t>& getBuffer() { return m_buffer; }
+    const std::string& getError() const { return m_error; }
+
+private:
+    NodeValue m_value;
+    std::vector<std::uint8_t> m_buffer;
+    std::string m_error;
+    bool m_hasBuffer = false;
+    bool m_isError = false;
+};
+
+/**
+ * @brief In-process Node.js runtime
+ *
+ * Embeds libnode: one node::MultiIsolatePlatform, one isolate and one Node
+ * environment are created by start() and kept until shutdown(), so calling
+ * into JavaScript costs a function call instead of a process spawn and a
+ * Node boot. Node can only be initialized once per process, which is why
+ * this is a singleton and cannot be restarted after shutdown().
+ *
+ * All methods must be called from one thread, normally the main thread.
+ * start() (and a first loadScript()) may instead run on another thread,
+ * e.g. as a StartupPipeline worker stage required for the first frame,
+ * provided nothing else uses the runtime until it returns.
+ *
+ * Native functions registered with registerFunction() appear in JavaScript
+ * as properties of the global @c crazy object. Functions registered with
+ * registerAsyncFunction() run on a TaskPool instead and return promises.
+ *
+ * Startup can skip evaluating the frontend bundle: buildSnapshot() (run at
+ * build time, in its own process) evaluates it and writes a V8 startup
+ * snapshot of the resulting heap. A runtime given that snapshot with
+ * setStartupSnapshot() deserializes it, and loadScript() of the same bundle
+ * then returns its exports without running it. Modules that are still
+ * compiled at run time (e.g. lazily loaded chunks) can keep their V8 code
+ * cache on disk, see setCodeCacheDirectory().
+ *
+ * Embedding is only compiled in when the library is built with
+ * NODE_INCLUDE_DIR and NODE_LIBRARY (see isAvailable()); otherwise start()
+ * fails and the other methods do nothing.
+ *
+ * Example usage:
+ * @code
+ * auto& node = crazy::NodeRuntime::instance();
+ * node.registerFunction("log", [](const std::vector<crazy::NodeValue>& args) {
+ *     CRAZY_LOG_INFO("js: {}", args.empty() ? "" : args[0].asString());
+ *     return crazy::NodeValue();
+ * });
+ *
+ * if (node.start() && node.loadScript("frontend/dist/bundle.js")) {
+ *     crazy::NodeValue sum;
+ *     node.call("add", {2, 3}, &sum);
+ * }
+ * @endcode
+ */
+class NodeRuntime {
+public:
+    using NativeFunction = std::function<NodeValue(const std::vector<NodeValue>& args)>;
+    using AsyncFunction = std::function<NodeAsyncResult(const std::vector<NodeValue>& args,
+                                                        const NodeCancellation& cancellation)>;
+
+    /**
+     * @brief Get the process-wide runtime
+     */
+    static NodeRuntime& instance();
+
+    /**
+     * @brief Check if the library was built with Node.js embedding
+     *
+     * @return true if start() can succeed
+     */
+    static bool isAvailable();
+
+    /**
+     * @brief Initialize Node.js, V8 and the environment
+     *
+     * @param args Command line passed to Node (e.g. {"app", "--max-old-space-size=512"});
+     *             the first entry is the program name
+     * @return true if the runtime is running
+     */
+    bool start(const std::vector<std::string>& args = {});
+
+    /**
+     * @brief Check if start() succeeded and shutdown() was not called
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Evaluate a bundle and save the resulting heap as a startup snapshot
+     *
+     * Build step, used instead of start(): Node can only be initialized once
+     * per process, so the runtime cannot be started afterwards. The bundle
+     * runs as a CommonJS module whose require() only provides Node builtins
+     * (userland modules must be bundled in), and native functions are not
+     * registered yet. Asynchronous work it starts is run to completion before
+     * the snapshot is taken. v8.startupSnapshot.addDeserializeCallback() can
+     * be used to refresh state when the snapshot is loaded.
+     *
+     * The snapshot records the bundle's path and a hash of its contents, and
+     * only works with the Node.js build that wrote it. Needs Node.js 20 or
+     * newer; older builds fail here.
+     *
+     * @param bundlePath Script to evaluate
+     * @param snapshotPath File to write
+     * @param args Command line passed to Node, as in start()
+     * @return true if the snapshot was written
+     */
+    bool buildSnapshot(const std::string& bundlePath, const std::string& snapshotPath,
+                       const std::vector<std::string>& args = {});
+
+    /**
+     * @brief Start from a snapshot written by buildSnapshot()
+     *
+     * Call before start(). If the file is missing, was written by another
+     * Node.js build or Node.js is older than 20, start() logs a warning and
+     * boots normally; see
+     * isSnapshotLoaded().
+     *
+     * @param path Snapshot file; empty to boot normally
+     */
+    void setStartupSnapshot(const std::string& path);
+
+    /**
+     * @brief Check if start() deserialized the startup snapshot
+     */
+    bool isSnapshotLoaded() const;
+
+    /**
+     * @brief Keep V8 code caches of CommonJS modules in a directory
+     *
+     * Call before start(). Modules loaded with require() (including through
+     * loadScript()) are compiled with the cache entry matching a hash of
+     * their source, so an edited module never uses stale code; V8 rejects
+     * entries from another V8 version or flags, and they are rewritten.
+     * Entries are written when the process exits, so they include functions
+     * compiled lazily during the session. Hit and miss counts are available
+     * to JavaScript as crazy.codeCache.
+     *
+     * @param directory Cache directory, created if needed; empty disables the cache
+     */
+    void setCodeCacheDirectory(const std::string& directory);
+
+    /**
+     * @brief Load a CommonJS module (e.g. the frontend bundle) with require()
+     *
+     * Functions exported by the most recently loaded module are found by
+     * call() before globals. If the startup snapshot contains this bundle
+     * with the same contents, its exports are used without running it; a
+     * bundle changed since the snapshot was built is loaded normally.
+     *
+     * @param path Path of the script, absolute or relative to the working directory
+     * @return true if the module was loaded without throwing
+     */
+    bool loadScript(const std::string& path);
+
+    /**
+     * @brief Run a piece of JavaScript in the global scope
+     *
+     * @param source Source code
+     * @param result Receives the completion value (optional)
+     * @return true if the script ran without throwing
+     */
+    bool evaluate(const std::string& source, NodeValue* result = nullptr);
+
+    /**
+     * @brief Call a JavaScript function
+     *
+     * The function is looked up by name in the loaded module's exports, then
+     * in the global object; dotted names (e.g. "app.render") are supported.
+     * Lookups are cached, so repeated calls only pay for argument conversion
+     * and the call itself. Microtasks (e.g. promise continuations) run before
+     * the call returns.
+     *
+     * @param function Function name
+     * @param args Arguments
+     * @param result Receives the return value (optional)
+     * @return true if the function exists and did not throw
+     */
+    bool call(const std::string& function,
+              const std::vector<NodeValue>& args = {},
+              NodeValue* result = nullptr);
+
+    /**
+     * @brief Expose a C++ function to JavaScript as crazy.<name>
+     *
+     * May be called before or after start(). Registering a name again
+     * replaces the previous function.
+     *
+     * @param name Property name on the global crazy object
+     * @param function Function to call
+     */
+    void registerFunction(const std::string& name, NativeFunction function);
+
+    /**
+     * @brief Expose a C++ function to JavaScript as an async function crazy.<name>
+     *
+     * Calling it from JavaScript returns a Promise at once; the function
+     * runs on the task pool (see getTaskPool()) and the promise settles on
+     * the runtime's thread during runPendingEvents(). A last argument of the
+     * form { signal } takes an AbortSignal: aborting rejects the promise
+     * with the signal's reason right away and sets the cancellation flag
+     * seen by the function. When the pool's queue is full the promise
+     * rejects immediately. C++ exceptions reject the promise.
+     *
+     * The function runs on a worker thread and must not use the runtime.
+     * May be called before or after start(); registering a name again
+     * replaces the function for later calls.
+     *
+     * @code
+     * node.registerAsyncFunction("readFile", [](const std::vector<crazy::NodeValue>& args,
+     *                                           const crazy::NodeCancellation& cancellation) {
+     *     std::vector<std::uint8_t> bytes;
+     *     if (!readAll(args.at(0).asString(), bytes, cancellation)) {
+     *         return crazy::NodeAsyncResult::fromError("cannot read " + args.at(0).asString());
+     *     }
+     *     return crazy::NodeAsyncResult::fromBuffer(std::move(bytes));
+     * });
+     * // JS: const data = await crazy.readFile('scene.bin', { signal: controller.signal });
+     * @endcode
+     *
+     * @param name Property name on the global crazy object
+     * @param function Function to run on the pool
+     */
+    void registerAsyncFunction(const std::string& name, AsyncFunction function);
+
+    /**
+     * @brief Configure the task pool running async functions
+     *
+     * Call before the pool is first used.
+     */
+    void setTaskPoolSettings(const TaskPoolSettings& settings);
+
+    /**
+     * @brief Get the task pool running async functions
+     *
+     * Created on first use. The host may queue its own work on it too; it
+     * is shut down by shutdown().
+     */
+    TaskPool& getTaskPool();
+
+    /**
+     * @brief Expose C++ memory to JavaScript as crazy.shared.<name>
+     *
+     * The memory appears as a SharedArrayBuffer over the same bytes, without
+     * copying. It is not owned by JavaScript: the caller keeps it alive until
+     * shutdown(). Used with RingChannel for zero-copy bridge transports.
+     *
+     * @param name Property name on crazy.shared
+     * @param data Start of the memory
+     * @param size Size in bytes
+     * @return true if the buffer was exposed
+     */
+    bool shareMemory(const std::string& name, void* data, size_t size);
+
+    /**
+     * @brief Queue a call to a JavaScript function from any thread
+     *
+     * Wakes the event loop; the call runs on the runtime's thread during the
+     * next runPendingEvents(). Return values and exceptions are discarded
+     * (exceptions are logged).
+     *
+     * @param function Function name, resolved as in call()
+     * @param args Arguments
+     * @return true if the call was queued
+     */
+    bool postCall(const std::string& function, std::vector<NodeValue> args = {});
+
+    /**
+     * @brief Run ready libuv callbacks and platform tasks without blocking
+     *
+     * Call once per frame so timers, I/O and promises settled by them make
+     * progress while the application owns the main loop. Passes over the
+     * loop repeat while callbacks keep making more work ready, until the
+     * time budget is spent, so a burst of I/O cannot stall a frame.
+     *
+     * @param timeBudget Maximum time to spend, in seconds
+     * @return true if ready work is left because the budget ran out
+     */
+    bool runPendingEvents(double timeBudget = 0.002);
+
+    /**
+     * @brief Start a helper thread that reports libuv activity
+     *
+     * The thread polls the loop's backend file descriptor with the timeout
+     * of the next timer and calls @p wakeup (e.g. glfwPostEmptyEvent) when
+     * I/O is ready or a timer is due, so the main thread can block in
+     * glfwWaitEvents() instead of polling the loop every frame. It only
+     * watches while armed, see armEventWatcher().
+     *
+     * Not supported where libuv has no pollable backend fd (Windows).
+     *
+     * @param wakeup Called from the helper thread; must be thread-safe
+     * @return true if the watcher is running
+     */
+    bool startEventWatcher(std::function<void()> wakeup);
+
+    /**
+     * @brief Stop and join the helper thread
+     */
+    void stopEventWatcher();
+
+    /**
+     * @brief Check if the event watcher is running
+     */
+    bool isEventWatcherRunning() const;
+
+    /**
+     * @brief Let the watcher wake the main thread once
+     *
+     * Call right before the main thread blocks. The next timer's deadline is
+     * taken from the loop now, so timers added by JS during the frame are
+     * honoured.
+     */
+    void armEventWatcher();
+
+    /**
+     * @brief Stop the watcher from waking the main thread
+     *
+     * Call after the main thread wakes up. No wakeup callback runs after
+     * this returns.
+     */
+    void disarmEventWatcher();
+
+    /**
+     * @brief Stop the environment and tear down Node.js and V8
+     *
+     * Node cannot be started again in the same process afterwards.
+     */
+    void shutdown();
+
+    /**
+     * @brief Get the message of the last JavaScript exception or startup error
+     */
+    const std::string& getLastError() const;
+
+    // Disable copy construction and assignment
+    NodeRuntime(const NodeRuntime&) = delete;
+    NodeRuntime& operator=(const NodeRuntime&) = delete;
+
+private:
+    NodeRuntime();
+    ~NodeRuntime();
+
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+    std::string m_lastError;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_NODE_RUNTIME_HPP
@@ -0,0 +1,177 @@
+#ifndef CRAZY_NODE_WORKER_HPP
+#define CRAZY_NODE_WORKER_HPP
+
+#include "NodeRuntime.hpp"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace crazy {
+
+/**
+ * @brief Settings for NodeWorker
+ */
+struct NodeWorkerOptions {
+    std::string nodeExecutable = "node";         ///< Looked up in PATH
+    std::string workerScript = "nodeWorker.js";  ///< frontend/src/bridge/nodeWorker.js
+    std::string script;                          ///< Module whose exports are called
+    std::vector<std::string> nodeArguments;      ///< Extra arguments for node, before the worker script
+    double healthCheckInterval = 0.0;            ///< Seconds between pings; 0 disables health checks and restarts
+    double healthCheckTimeout = 2.0;             ///< Seconds without a reply before the worker is restarted
+    int maxRestarts = 5;                         ///< Restarts before giving up
+};
+
+/**
+ * @brief Long-lived Node.js child process for when libnode is not available
+ *
+ * Starts one `node` process with posix_spawn and talks to it over a Unix
+ * socket pair (fd 3 in the child) with length-prefixed binary frames. Calls
+ * are asynchronous and pipelined: callAsync() queues a request and returns
+ * at once, several requests can be in flight, and responses (which may
+ * arrive out of order when JavaScript returns promises) are dispatched to
+ * their callbacks by poll(), typically once per frame.
+ *
+ * The child runs frontend/src/bridge/nodeWorker.js, which loads
+ * NodeWorkerOptions::script and calls its exports (or globals) by name,
+ * like NodeRuntime::call().
+ *
+ * With health checks enabled, the worker is pinged periodically and
+ * restarted when it exits or stops answering; requests in flight fail.
+ *
+ * Not thread-safe: use from one thread. Not available on Windows.
+ */
+class NodeWorker {
+public:
+    /**
+     * @brief Receives the outcome of a call
+     *
+     * @param ok true if the function returned (or its promise resolved)
+     * @param result Return value if ok
+     * @param error Error message otherwise
+     */
+    using Callback = std::function<void(bool ok, const NodeValue& result, const std::string& error)>;
+
+    NodeWorker();
+
+    /**
+     * @brief Stop the worker
+     */
+    ~NodeWorker();
+
+    // Disable copy construction and assignment
+    NodeWorker(const NodeWorker&) = delete;
+    NodeWorker& operator=(const NodeWorker&) = delete;
+
+    /**
+     * @brief Spawn the worker process
+     *
+     * Returns once the process is started; the script is loaded
+     * asynchronously and calls made meanwhile are queued.
+     *
+     * @param options Worker settings
+     * @return true if the process was spawned
+     */
+    bool start(const NodeWorkerOptions& options);
+
+    /**
+     * @brief Check if the worker process is running
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Call a JavaScript function without waiting for the result
+     *
+     * @param function Function name, resolved in the script's exports, then globally
+     * @param args Arguments
+     * @param callback Called from poll() with the result; may be empty
+     * @return std::uint32_t Request id, or 0 if the worker is not running
+     */
+    std::uint32_t callAsync(const std::string& function, const std::vector<NodeValue>& args = {},
+                            Callback callback = nullptr);
+
+    /**
+     * @brief Call a JavaScript function and wait for the result
+     *
+     * Other responses that arrive meanwhile are dispatched as usual.
+     *
+     * @param function Function name
+     * @param args Arguments
+     * @param result Receives the return value (optional)
+     * @param timeoutSeconds Maximum time to wait; negative waits forever
+     * @return true if the call succeeded; see getLastError() otherwise
+     */
+    bool call(const std::string& function, const std::vector<NodeValue>& args = {},
+              NodeValue* result = nullptr, double timeoutSeconds = -1.0);
+
+    /**
+     * @brief Send queued requests and dispatch responses that have arrived
+     *
+     * Also runs health checks. Call regularly, e.g. once per frame.
+     *
+     * @param timeoutSeconds Time to wait for a response if none is ready
+     * @return std::size_t Number of responses dispatched
+     */
+    std::size_t poll(double timeoutSeconds = 0.0);
+
+    /**
+     * @brief Stop the worker; requests in flight fail
+     */
+    void stop();
+
+    /**
+     * @brief Get the socket, e.g. to wake an event loop when responses arrive
+     *
+     * @return int Descriptor, or -1 if not running
+     */
+    int getFd() const;
+
+    /**
+     * @brief Get the number of requests waiting for a response
+     */
+    std::size_t getPendingCount() const;
+
+    /**
+     * @brief Get the number of times the worker was restarted
+     */
+    int getRestartCount() const;
+
+    /**
+     * @brief Get the last error message
+     */
+    const std::string& getLastError() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool spawn();
+    void terminate();
+    void fail(const std::string& error);
+    std::uint32_t send(std::uint8_t kind, const std::string& name, const std::vector<NodeValue>& args,
+                       Callback callback);
+    bool flushOutput();
+    bool readInput();
+    std::size_t dispatchResponses();
+    void checkHealth();
+
+    NodeWorkerOptions m_options;
+    int m_pid;
+    int m_fd;
+    std::uint32_t m_nextId;
+    std::unordered_map<std::uint32_t, Callback> m_pending;
+    std::vector<unsigned char> m_output;
+    std::size_t m_outputOffset;
+    std::vector<unsigned char> m_input;
+    std::size_t m_inputOffset;
+    std::uint32_t m_pingId;
+    Clock::time_point m_lastPing;
+    Clock::time_point m_lastReply;
+    int m_restarts;
+    std::string m_lastError;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_NODE_WORKER_HPP
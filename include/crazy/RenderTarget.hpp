@@ -0,0 +1,134 @@
+#ifndef CRAZY_RENDER_TARGET_HPP
+#define CRAZY_RENDER_TARGET_HPP
+
+#include <GLFW/glfw3.h>
+#include <cstdint>
+
+namespace crazy {
+
+/**
+ * @brief Offscreen render target (framebuffer object)
+ * 
+ * Wraps an FBO with an RGBA8 color texture and an optional depth/stencil
+ * renderbuffer. The color texture can be sampled once rendering is done,
+ * e.g. to upscale or composite it onto the window.
+ * 
+ * Example usage:
+ * @code
+ * crazy::RenderTarget target;
+ * target.resize(1280, 720);
+ * target.bind();
+ * // ... render offscreen ...
+ * crazy::RenderTarget::bindDefault();
+ * @endcode
+ */
+class RenderTarget {
+public:
+    /**
+     * @brief Construct a new Render Target object
+     * 
+     * No GL objects are created until the first resize().
+     * 
+     * @param depthStencil Attach a depth/stencil renderbuffer if true
+     */
+    explicit RenderTarget(bool depthStencil = true);
+    
+    /**
+     * @brief Destroy the Render Target object and its GL objects
+     */
+    ~RenderTarget();
+    
+    // Disable copy construction and assignment
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+    
+    /**
+     * @brief Allocate storage for the given size
+     * 
+     * Does nothing if the target already has exactly this size.
+     * 
+     * @param width Width in pixels
+     * @param height Height in pixels
+     * @return true if the framebuffer is complete
+     */
+    bool resize(int width, int height);
+    
+    /**
+     * @brief Make the target at least the given size, reallocating sparingly
+     * 
+     * For targets that follow the window. Storage grows in steps of
+     * kGrowthBucket pixels per axis, so a window being dragged larger
+     * reallocates every few hundred pixels instead of every frame. It
+     * shrinks (to the bucket above the request) only once the request has
+     * used at most half of the storage area for @p shrinkDelay seconds.
+     * Render into the top-left width x height pixels; getWidth() and
+     * getHeight() report the storage, which may be larger.
+     * 
+     * @param width Minimum width in pixels
+     * @param height Minimum height in pixels
+     * @param shrinkDelay Seconds a smaller size must persist before shrinking
+     * @return true if the framebuffer is complete
+     */
+    bool ensureSize(int width, int height, double shrinkDelay = 0.5);
+    
+    /// Storage granularity of ensureSize(), in pixels
+    static constexpr int kGrowthBucket = 256;
+    
+    /**
+     * @brief Bind the target for drawing
+     */
+    void bind();
+    
+    /**
+     * @brief Bind the window's default framebuffer for drawing
+     */
+    static void bindDefault();
+    
+    /**
+     * @brief Check if the target has complete storage
+     */
+    bool isValid() const;
+    
+    /**
+     * @brief Get the allocated width in pixels
+     */
+    int getWidth() const;
+    
+    /**
+     * @brief Get the allocated height in pixels
+     */
+    int getHeight() const;
+    
+    /**
+     * @brief Get the framebuffer object name
+     */
+    GLuint getFramebuffer() const;
+    
+    /**
+     * @brief Get the color attachment texture name
+     */
+    GLuint getColorTexture() const;
+    
+    /**
+     * @brief Delete the GL objects
+     * 
+     * Must be called with the owning context current; the destructor calls
+     * it automatically.
+     */
+    void release();
+
+private:
+    bool m_depthStencil;
+    GLuint m_framebuffer;
+    GLuint m_colorTexture;
+    GLuint m_depthStencilBuffer;
+    int m_width;
+    int m_height;
+    bool m_complete;
+    std::uint64_t m_memoryId;
+    double m_shrinkSince;       // When ensureSize() requests started to fit in half the storage, or < 0
+};
+
+} // namespace crazy
+
+#endif // CRAZY_RENDER_TARGET_HPP
@@ -1,10 +1,36 @@
 #ifndef CRAZY_RENDERER_HPP
 #define CRAZY_RENDERER_HPP
 
+#include "BufferManager.hpp"
+#include "InputLatency.hpp"
 #include <GLFW/glfw3.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// GLsync is declared by glext.h, which not every platform's gl.h pulls in
+typedef struct __GLsync* GLsync;
 
 namespace crazy {
 
+/**
+ * @brief Frame pacing statistics reported by the Renderer
+ */
+struct FrameStats {
+    std::uint64_t frameIndex = 0;       ///< Number of frames begun so far
+    int frameSlot = 0;                  ///< Slot of the current frame (frameIndex % framesInFlight)
+    int maxFramesInFlight = 0;          ///< Active frames-in-flight limit
+    double fenceWaitTime = 0.0;         ///< Time the current frame waited for the GPU, in seconds
+    double totalFenceWaitTime = 0.0;    ///< Accumulated wait time, in seconds
+    std::uint64_t fenceWaits = 0;       ///< Frames that had to wait for the GPU
+    double cpuFrameTime = 0.0;          ///< CPU time between beginFrame() and endFrame() of the last frame, in seconds
+    double gpuFrameTime = 0.0;          ///< GPU time of the most recent completed frame, in seconds
+    std::uint32_t drawCalls = 0;        ///< Draw calls recorded between beginFrame() and endFrame() of the last frame
+    std::uint32_t stateChanges = 0;     ///< Pipeline state changes recorded during the last frame
+    double inputLatency[static_cast<int>(InputKind::Count)] = {};  ///< Input-to-present latency per kind of the last frame that presented such input, in seconds
+    LatencyHistogram inputLatencyHistogram[static_cast<int>(InputKind::Count)];  ///< Per-frame input-to-present latencies per kind since start or resetInputLatency()
+};
+
 /**
  * @brief Renderer class for OpenGL rendering operations
  * 
@@ -103,9 +129,149 @@ public:
      * @return const char* OpenGL renderer string or nullptr if unavailable
      */
     static const char* getOpenGLRenderer();
+    
+    /**
+     * @brief Begin a new frame
+     * 
+     * Waits on the fence inserted maxFramesInFlight frames ago, so the CPU
+     * never runs further ahead of the GPU than that, then recycles the
+     * per-frame resources of the frame slot and starts the GPU timer query
+     * of the slot. Called by Application before the update callback.
+     */
+    void beginFrame();
+    
+    /**
+     * @brief End the current frame
+     * 
+     * Inserts a fence for the frame slot. Called by Application after the
+     * render callback, before the buffers are swapped.
+     */
+    void endFrame();
+    
+    /**
+     * @brief Set the maximum number of frames in flight
+     * 
+     * Bounds how many frames the CPU may queue ahead of the GPU, which
+     * bounds input latency independently of the driver. Takes effect at the
+     * next beginFrame(), after the GPU has drained.
+     * 
+     * @param frames Number of frames (1 to 8, default 2)
+     */
+    void setMaxFramesInFlight(int frames);
+    
+    /**
+     * @brief Get the maximum number of frames in flight
+     * 
+     * @return int Frames-in-flight limit
+     */
+    int getMaxFramesInFlight() const;
+    
+    /**
+     * @brief Get the slot of the current frame
+     * 
+     * Per-frame resources (streaming buffers, query pools) indexed by this
+     * slot are guaranteed to be idle on the GPU between beginFrame() and
+     * endFrame().
+     * 
+     * @return int Slot in [0, getMaxFramesInFlight())
+     */
+    int getFrameSlot() const;
+    
+    /**
+     * @brief Get frame pacing statistics
+     * 
+     * @return const FrameStats& Statistics for the current frame
+     */
+    const FrameStats& getFrameStats() const;
+    
+    /**
+     * @brief Count draw calls issued in the current frame
+     * 
+     * Renderer counts nothing by itself; UiRenderer and other passes report
+     * what they submit, so regressions in batching show up in FrameStats.
+     * 
+     * @param count Number of draw calls
+     */
+    void recordDrawCalls(std::uint32_t count = 1);
+    
+    /**
+     * @brief Count pipeline state changes made in the current frame
+     * 
+     * Bindings (program, vertex array, buffers, textures, framebuffers),
+     * enables/disables, blend functions, uniforms and viewports each count
+     * as one. The Renderer state setters record themselves.
+     * 
+     * @param count Number of state changes
+     */
+    void recordStateChanges(std::uint32_t count = 1);
+    
+    /**
+     * @brief Tie an input event to the current frame
+     * 
+     * The frame is taken to present the effect of every input received
+     * before it began. Once the frame has completed on the GPU (a few
+     * frames later, when its slot is reused), the latency from the oldest
+     * input of each kind to the frame's presentation goes into FrameStats.
+     * Presentation is the later of swapBuffers() returning and the end of
+     * the frame's GPU work, which is read with a GL timestamp query where
+     * the driver supports one. Scanout adds up to one refresh interval that
+     * OpenGL cannot observe.
+     * 
+     * @param kind Kind of input
+     * @param timestamp glfwGetTime() when the event was received
+     */
+    void recordInput(InputKind kind, double timestamp);
+    
+    /**
+     * @brief Record that the current frame's buffers were swapped
+     * 
+     * Called by Application right after swapBuffers().
+     */
+    void framePresented();
+    
+    /**
+     * @brief Clear the input latency histograms
+     */
+    void resetInputLatency();
+    
+    /**
+     * @brief Get the GPU buffer manager
+     * 
+     * @return BufferManager& Reference to the buffer manager
+     */
+    BufferManager& getBufferManager();
 
 private:
+    void waitForFence(GLsync fence);
+    void applyFramesInFlight();
+    void readTimerQuery(int slot);
+    void readInputLatency(int slot);
+    
+    // Inputs presented by a frame slot, and when it was presented
+    struct SlotInput {
+        double inputTime[static_cast<int>(InputKind::Count)];   // -1 for none
+        double swapTime = -1.0;
+        bool hasInput = false;
+        bool timestampPending = false;
+        
+        SlotInput();
+    };
+    
     float m_clearColor[4];
+    std::unique_ptr<BufferManager> m_bufferManager;
+    
+    std::vector<GLsync> m_frameFences;
+    std::vector<GLuint> m_timerQueries;
+    std::vector<bool> m_timerQueryPending;
+    std::vector<GLuint> m_timestampQueries;
+    std::vector<SlotInput> m_slotInputs;
+    double m_gpuClockOffset;            // glfwGetTime() minus GL_TIMESTAMP, in seconds
+    double m_frameStartTime;
+    std::uint32_t m_drawCalls;
+    std::uint32_t m_stateChanges;
+    int m_maxFramesInFlight;
+    int m_pendingFramesInFlight;
+    FrameStats m_frameStats;
 };
 
 } // namespace crazy
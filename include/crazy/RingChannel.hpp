@@ -0,0 +1,226 @@
+#ifndef CRAZY_RING_CHANNEL_HPP
+#define CRAZY_RING_CHANNEL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace crazy {
+
+/**
+ * @brief Single-producer/single-consumer message ring in shared memory
+ *
+ * The ring lives entirely in a caller-provided region (see SharedMemory),
+ * so both ends can be in different threads, in different processes, or one
+ * in C++ and one in JavaScript (frontend/src/bridge/ringChannel.js reads
+ * the same layout through a SharedArrayBuffer).
+ *
+ * Messages are written and read in place: the producer reserves space,
+ * fills it and commits; the consumer peeks at the message and releases it.
+ * In steady state there are no copies beyond filling the message, no locks
+ * and no system calls. A wakeup is only sent when the consumer has parked
+ * itself because the ring was empty.
+ *
+ * Layout (all integers little-endian 32-bit, indices are byte counters
+ * modulo 2^32, hot fields on separate cache lines):
+ *
+ *   offset 0    magic, version, capacity
+ *   offset 64   write index   (producer)
+ *   offset 128  read index    (consumer)
+ *   offset 192  parked flag   (consumer sets, producer clears)
+ *   offset 256  data, capacity bytes (a power of two)
+ *
+ * Each message is a 32-bit length followed by the payload, padded to 8
+ * bytes. A length of 0xFFFFFFFF marks unused space at the end of the
+ * data area; the message continues at the start.
+ *
+ * One RingChannel object is used per end; the producer only calls the
+ * producer methods and the consumer only the consumer methods.
+ */
+class RingChannel {
+public:
+    static constexpr std::uint32_t kMagic = 0x5a52524b;   // "KRRZ"
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::uint32_t kHeaderSize = 256;
+    static constexpr std::uint32_t kWrapMarker = 0xFFFFFFFFu;
+
+    /**
+     * @brief Region size needed for a ring with the given capacity
+     *
+     * @param capacity Data capacity in bytes, rounded up to a power of two (at least 64)
+     */
+    static std::size_t requiredSize(std::uint32_t capacity);
+
+    /**
+     * @brief Construct an unattached, invalid channel
+     */
+    RingChannel();
+
+    /**
+     * @brief Attach to a ring in @p memory
+     *
+     * @param memory Region of at least requiredSize() bytes, 8-byte aligned
+     * @param size Size of the region in bytes
+     * @param initialize Write a fresh header (exactly one end does this,
+     *                   before the other attaches)
+     */
+    RingChannel(void* memory, std::size_t size, bool initialize);
+
+    /**
+     * @brief Check if the channel is attached to a valid ring
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Get the data capacity in bytes
+     */
+    std::uint32_t getCapacity() const;
+
+    /**
+     * @brief Get the largest message that always fits in an empty ring
+     */
+    std::uint32_t getMaxMessageSize() const;
+
+    // Producer
+
+    /**
+     * @brief Reserve space for a message of @p size bytes
+     *
+     * The returned pointer stays valid until commit(). Calling reserve()
+     * again before commit() adds another message after it, so a batch of
+     * messages can be published with a single commit(). A failed reserve()
+     * keeps the earlier reservations.
+     *
+     * @return void* Where to write the payload, or nullptr if the ring is full
+     */
+    void* reserve(std::uint32_t size);
+
+    /**
+     * @brief Publish the reserved messages
+     *
+     * Wakes the consumer through the wakeup callback if it is parked.
+     */
+    void commit();
+
+    /**
+     * @brief Copy a message into the ring (reserve + memcpy + commit)
+     *
+     * @return true if the message was written, false if the ring is full
+     */
+    bool write(const void* data, std::uint32_t size);
+
+    /**
+     * @brief Set how a parked consumer is woken up
+     *
+     * The default wakes a C++ consumer blocked in wait(), including one in
+     * another process. A JavaScript consumer needs something that reaches
+     * its event loop instead, e.g. NodeRuntime::postCall().
+     *
+     * @param callback Called by commit() on the producer's thread
+     */
+    void setWakeupCallback(std::function<void()> callback);
+
+    /**
+     * @brief Get the number of messages rejected because the ring was full
+     */
+    std::uint64_t getDroppedCount() const;
+
+    // Consumer
+
+    /**
+     * @brief Get the oldest message without removing it
+     *
+     * @param size Receives the payload size
+     * @return const void* The payload, or nullptr if the ring is empty
+     */
+    const void* peek(std::uint32_t& size);
+
+    /**
+     * @brief Remove the message returned by the last peek()
+     */
+    void release();
+
+    /**
+     * @brief Call @p handler for each available message, in place
+     *
+     * @param handler Called as handler(const void* data, std::uint32_t size)
+     * @param maxMessages Stop after this many messages
+     * @return std::size_t Number of messages handled
+     */
+    template <typename Handler>
+    std::size_t drain(Handler&& handler, std::size_t maxMessages = SIZE_MAX) {
+        std::size_t count = 0;
+        std::uint32_t size = 0;
+        while (count < maxMessages) {
+            const void* data = peek(size);
+            if (!data) {
+                break;
+            }
+            handler(data, size);
+            release();
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Announce that the consumer is about to sleep
+     *
+     * @return true if the ring is still empty and the consumer may sleep
+     *         until woken; false if a message arrived (the flag is cleared)
+     */
+    bool park();
+
+    /**
+     * @brief Clear the parked flag after waking up or giving up on sleeping
+     */
+    void unpark();
+
+    /**
+     * @brief Block until a message is available or the timeout expires
+     *
+     * Parks, sleeps until the default wakeup callback fires, and unparks.
+     *
+     * @param timeoutSeconds Maximum time to wait; negative waits forever
+     * @return true if a message is available
+     */
+    bool wait(double timeoutSeconds);
+
+    /**
+     * @brief Wake a consumer blocked in wait()
+     */
+    void notify();
+
+    /**
+     * @brief Check if the ring has no messages
+     */
+    bool isEmpty() const;
+
+private:
+    std::atomic<std::uint32_t>& writeIndex() const;
+    std::atomic<std::uint32_t>& readIndex() const;
+    std::atomic<std::uint32_t>& parkedFlag() const;
+    unsigned char* slot(std::uint32_t index) const;
+
+    unsigned char* m_base;
+    unsigned char* m_data;
+    std::uint32_t m_capacity;
+    std::uint32_t m_mask;
+
+    // Producer-local state
+    std::uint32_t m_readCache;
+    std::uint32_t m_reservedEnd;
+    bool m_reserved;
+    std::uint64_t m_dropped;
+    std::function<void()> m_wakeupCallback;
+
+    // Consumer-local state
+    std::uint32_t m_writeCache;
+    std::uint32_t m_peekedEnd;
+    bool m_peeked;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_RING_CHANNEL_HPP
@@ -0,0 +1,91 @@
+#ifndef CRAZY_SHARED_MEMORY_HPP
+#define CRAZY_SHARED_MEMORY_HPP
+
+#include <cstddef>
+
+namespace crazy {
+
+/**
+ * @brief A memory region that can be shared with JavaScript or another process
+ *
+ * On Linux the region is a memfd, elsewhere on POSIX an unlinked shm object;
+ * either way getFd() can be inherited by or sent to a child process, which
+ * maps the same pages with SharedMemory(fd, size). On Windows the region is
+ * private to the process (getFd() returns -1), which is enough for an
+ * embedded runtime.
+ *
+ * The region is zero-filled and page aligned.
+ */
+class SharedMemory {
+public:
+    /**
+     * @brief Construct an empty, invalid region
+     */
+    SharedMemory();
+
+    /**
+     * @brief Create and map a new region
+     *
+     * @param size Size in bytes
+     * @param name Debug name (shown in /proc/<pid>/fd on Linux)
+     */
+    explicit SharedMemory(std::size_t size, const char* name = "crazy");
+
+    /**
+     * @brief Map a region created by another process
+     *
+     * Takes ownership of @p fd.
+     *
+     * @param fd File descriptor of the region
+     * @param size Size in bytes
+     */
+    SharedMemory(int fd, std::size_t size);
+
+    /**
+     * @brief Unmap the region and close its descriptor
+     */
+    ~SharedMemory();
+
+    SharedMemory(SharedMemory&& other) noexcept;
+    SharedMemory& operator=(SharedMemory&& other) noexcept;
+
+    // Disable copy construction and assignment
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    /**
+     * @brief Check if the region is mapped
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Get the start of the mapping
+     */
+    void* getData() const;
+
+    /**
+     * @brief Get the size of the mapping in bytes
+     */
+    std::size_t getSize() const;
+
+    /**
+     * @brief Get the descriptor to share with another process
+     *
+     * @return int Descriptor, or -1 if the region cannot be shared
+     */
+    int getFd() const;
+
+    /**
+     * @brief Unmap the region and close its descriptor
+     */
+    void release();
+
+private:
+    void* m_data;
+    std::size_t m_size;
+    int m_fd;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_SHARED_MEMORY_HPP
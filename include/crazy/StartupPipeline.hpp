@@ -0,0 +1,245 @@
+#ifndef CRAZY_STARTUP_PIPELINE_HPP
+#define CRAZY_STARTUP_PIPELINE_HPP
+
+#include "JobSystem.hpp"
+#include "TaskPool.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace crazy {
+
+/**
+ * @brief Where a startup stage runs
+ */
+enum class StartupAffinity {
+    Worker,     ///< On a startup thread, concurrently with window creation
+    Main        ///< On the main thread once the GL context is current
+};
+
+/**
+ * @brief Outcome of a startup stage
+ */
+enum class StartupStatus {
+    Pending,    ///< Not started yet
+    Running,    ///< Started, not finished
+    Done,       ///< Finished successfully
+    Failed,     ///< Returned false or threw
+    Skipped     ///< Not run because a dependency did not succeed
+};
+
+/**
+ * @brief One unit of startup work
+ */
+struct StartupStage {
+    std::string name;                           ///< Unique name, used for dependencies and the timeline
+    std::function<bool()> run;                  ///< The work; returns false on failure
+    std::vector<std::string> dependencies;      ///< Stages that must succeed first
+    StartupAffinity affinity = StartupAffinity::Worker; ///< Thread the stage runs on
+    bool requiredForFirstFrame = true;          ///< The first frame waits for it (and its dependencies)
+};
+
+/**
+ * @brief A span of the startup timeline
+ */
+struct StartupTimelineEntry {
+    std::string name;                           ///< Stage or span name
+    double start = 0.0;                         ///< Seconds since the pipeline was created
+    double end = 0.0;                           ///< Seconds since the pipeline was created
+    int thread = 0;                             ///< 0 for the main thread, 1.. for other threads
+    StartupStatus status = StartupStatus::Pending; ///< Outcome
+};
+
+/**
+ * @brief Staged application startup with a timeline report
+ *
+ * Startup work is described as stages with dependencies. Passed to the
+ * Application constructor, the pipeline starts its worker stages (JS
+ * runtime boot, asset pack mapping, shader binary loading, ...) before
+ * GLFW is initialized, so they overlap window creation. They block on I/O,
+ * so they run on a TaskPool of the pipeline's own; the application's
+ * JobSystem only orders them, starting each one once its dependencies have
+ * finished. Stages that need OpenGL use StartupAffinity::Main and run on
+ * the main thread once the context is current.
+ *
+ * run() shows the first frame as soon as every stage marked
+ * requiredForFirstFrame (and everything those depend on) has finished;
+ * the other stages keep running in the background, main-thread ones
+ * between frames. If a required stage fails, run() fails. A stage whose
+ * dependency did not succeed is skipped.
+ *
+ * The timeline (window creation, every stage, the first frame) can be
+ * written as a Chrome trace file, viewable in chrome://tracing or
+ * Perfetto, to track time to first frame:
+ *
+ * @code
+ * crazy::StartupPipeline startup;
+ * startup.setTimelinePath("startup-trace.json");
+ *
+ * crazy::AssetPack pack;
+ * startup.addStage({"assets", [&] { return pack.open("assets.pack"); }});
+ * startup.addStage({"shaders", [&] { return shaders.load(pack); }, {"assets"},
+ *                   crazy::StartupAffinity::Main});
+ * startup.addStage({"fonts", [&] { return fonts.warmUp(pack); }, {"assets"},
+ *                   crazy::StartupAffinity::Worker, false});
+ *
+ * crazy::Application app(1280, 720, "App", &startup);
+ * return app.run();
+ * @endcode
+ *
+ * The pipeline must outlive the application. Stages are added before the
+ * application is constructed; the other methods are driven by
+ * ApplicationBase on the main thread.
+ */
+class StartupPipeline {
+public:
+    /**
+     * @brief Create an empty pipeline; its creation time is the timeline origin
+     */
+    StartupPipeline();
+
+    /**
+     * @brief Stop the pipeline, see stop()
+     */
+    ~StartupPipeline();
+
+    // Disable copy construction and assignment
+    StartupPipeline(const StartupPipeline&) = delete;
+    StartupPipeline& operator=(const StartupPipeline&) = delete;
+
+    /**
+     * @brief Add a stage
+     *
+     * @return true if added, false if the name is taken or the pipeline started
+     */
+    bool addStage(StartupStage stage);
+
+    /**
+     * @brief Write the timeline to a file once startup has completed
+     *
+     * @param path Chrome trace (JSON) file, or empty to not write one
+     */
+    void setTimelinePath(const std::string& path);
+
+    /**
+     * @brief Validate the dependencies and start the worker stages
+     *
+     * @param jobs Job system that orders the stages; must stay alive until stop()
+     * @return true if the stage graph is valid (no unknown names or cycles)
+     */
+    bool start(JobSystem& jobs);
+
+    /**
+     * @brief Wait for worker stages still running and start no other stage
+     *
+     * Called before the job system passed to start() is destroyed. Stages
+     * that have not started stay Pending.
+     */
+    void stop();
+
+    /**
+     * @brief Run main-thread stages until the first frame can be shown
+     *
+     * Blocks while worker stages run. Call with the GL context current.
+     *
+     * @return true if every stage required for the first frame succeeded
+     */
+    bool runUntilReady();
+
+    /**
+     * @brief Run main-thread stages that became ready, between frames
+     *
+     * @param timeBudget Seconds to spend; at least one ready stage runs
+     * @return true while stages are still pending or running
+     */
+    bool pump(double timeBudget = 0.002);
+
+    /**
+     * @brief Record the first presented frame
+     */
+    void markFirstFrame();
+
+    /**
+     * @brief Record work done outside a stage (e.g. window creation)
+     *
+     * @param name Span name
+     * @param start Start time, from now()
+     * @param end End time, from now()
+     */
+    void addSpan(const std::string& name, double start, double end);
+
+    /**
+     * @brief Get the time since the pipeline was created, in seconds
+     */
+    double now() const;
+
+    /**
+     * @brief Check if every stage has finished
+     */
+    bool isComplete() const;
+
+    /**
+     * @brief Get the outcome of a stage
+     */
+    StartupStatus getStatus(const std::string& name) const;
+
+    /**
+     * @brief Get the time to first frame in seconds, or 0 before it
+     */
+    double getTimeToFirstFrame() const;
+
+    /**
+     * @brief Get the recorded spans, in start order
+     */
+    std::vector<StartupTimelineEntry> getTimeline() const;
+
+    /**
+     * @brief Write the timeline as a Chrome trace file
+     *
+     * @return true on success
+     */
+    bool writeTimeline(const std::string& path) const;
+
+private:
+    struct Stage;
+
+    void launchStage(Stage& stage);
+    void runStage(Stage& stage);
+    bool isReady(const Stage& stage) const;
+    bool hasReadyMainStage(bool requiredOnly) const;
+    bool runReadyMainStages(bool requiredOnly, double deadline);
+    int threadIndex();
+    void finishIfComplete();
+
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point m_origin;
+    std::vector<std::unique_ptr<Stage>> m_stages;
+    std::string m_timelinePath;
+    JobSystem* m_jobs;
+    std::unique_ptr<TaskPool> m_pool;       // Runs the worker stages
+    std::thread::id m_mainThread;
+    bool m_started;
+    bool m_reported;
+
+    // Guards the timeline, thread indices and stage outcomes; signalled
+    // whenever a stage finishes
+    mutable std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::vector<StartupTimelineEntry> m_spans;
+    std::vector<std::thread::id> m_threads;
+    std::size_t m_finished;
+    std::size_t m_running;                  // Worker stages handed to m_pool and not finished
+    bool m_stopping;
+    double m_firstFrame;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_STARTUP_PIPELINE_HPP
@@ -0,0 +1,141 @@
+#ifndef CRAZY_TASK_POOL_HPP
+#define CRAZY_TASK_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace crazy {
+
+/**
+ * @brief Configuration of a TaskPool
+ */
+struct TaskPoolSettings {
+    unsigned threadCount = 0;           ///< Worker threads; 0 uses the hardware threads minus one (at least 1)
+    std::size_t maxQueuedTasks = 1024;  ///< Tasks waiting to run; submit() fails beyond this
+};
+
+/**
+ * @brief Metrics of a TaskPool
+ */
+struct TaskPoolStats {
+    std::uint64_t submitted = 0;        ///< Tasks accepted by submit()
+    std::uint64_t rejected = 0;         ///< Tasks refused because the queue was full or the pool stopped
+    std::uint64_t completed = 0;        ///< Tasks that ran to the end (or threw)
+    std::uint64_t stolen = 0;           ///< Tasks run by a worker other than the one they were queued on
+    std::uint64_t discarded = 0;        ///< Queued tasks dropped by shutdown()
+};
+
+/**
+ * @brief Bounded pool of worker threads with work stealing
+ *
+ * Each worker owns a deque of tasks. Tasks submitted by a worker go to its
+ * own deque; tasks submitted from other threads are spread over the deques
+ * in turn. A worker runs its own tasks first, then steals from the others,
+ * and sleeps when there is nothing left, so an idle pool costs no CPU.
+ *
+ * The number of queued tasks is bounded: submit() returns false instead of
+ * letting a burst of requests grow the queues without limit.
+ *
+ * @code
+ * crazy::TaskPool pool;
+ * pool.submit([] { decodeImage("logo.png"); });
+ * @endcode
+ *
+ * All methods are thread-safe.
+ */
+class TaskPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Start the worker threads
+     */
+    explicit TaskPool(const TaskPoolSettings& settings = TaskPoolSettings());
+
+    /**
+     * @brief Stop the pool, see shutdown()
+     */
+    ~TaskPool();
+
+    // Disable copy construction and assignment
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /**
+     * @brief Queue a task
+     *
+     * Exceptions escaping the task are logged and swallowed.
+     *
+     * @param task Task to run on a worker thread
+     * @return true if the task was queued, false if the queue is full or
+     *         the pool was shut down
+     */
+    bool submit(Task task);
+
+    /**
+     * @brief Stop the workers
+     *
+     * Tasks already running finish; tasks still queued are dropped. Blocks
+     * until every worker has exited. Must not be called from a task.
+     */
+    void shutdown();
+
+    /**
+     * @brief Get the number of worker threads
+     */
+    unsigned getThreadCount() const;
+
+    /**
+     * @brief Get the number of tasks waiting to run
+     */
+    std::size_t getQueuedCount() const;
+
+    /**
+     * @brief Check if the calling thread is one of this pool's workers
+     */
+    bool isWorkerThread() const;
+
+    /**
+     * @brief Get a snapshot of the metrics
+     */
+    TaskPoolStats getStats() const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    void run(std::size_t index);
+    bool take(std::size_t index, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    const std::size_t m_maxQueued;
+
+    // Sleeping workers wait on the condition; m_queued is only raised under
+    // the mutex so a wakeup cannot be missed
+    mutable std::mutex m_sleepMutex;
+    std::condition_variable m_wakeup;
+    std::atomic<std::size_t> m_queued;
+    std::atomic<std::size_t> m_nextWorker;
+    std::atomic<bool> m_stopping;
+
+    std::atomic<std::uint64_t> m_submitted;
+    std::atomic<std::uint64_t> m_rejected;
+    std::atomic<std::uint64_t> m_completed;
+    std::atomic<std::uint64_t> m_stolen;
+    std::atomic<std::uint64_t> m_discarded;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_TASK_POOL_HPP
@@ -0,0 +1,248 @@
+#ifndef CRAZY_UI_RENDERER_HPP
+#define CRAZY_UI_RENDERER_HPP
+
+#include "JobSystem.hpp"
+#include "UiTileCache.hpp"
+#include <GLFW/glfw3.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+namespace crazy {
+
+class Renderer;
+class UiTree;
+struct UiNode;
+
+/**
+ * @brief Tiling of scroll containers
+ */
+struct UiScrollSettings {
+    int tileSize = 256;             ///< Tile edge in framebuffer pixels
+    int atlasTiles = 8;             ///< Tiles per edge of the cache atlas; atlasTiles² tiles are cached (16 MiB at the defaults)
+    int prefetchTiles = 1;          ///< Rows and columns of tiles rasterised beyond the visible ones
+    int maxRasterPerFrame = 4;      ///< Tiles rasterised per frame; the rest follow in later frames
+};
+
+/**
+ * @brief Per-frame metrics of the scroll containers drawn by the last render()
+ */
+struct UiScrollStats {
+    std::uint32_t layers = 0;           ///< Scroll containers on screen
+    std::uint32_t tilesVisible = 0;     ///< Non-empty tiles intersecting the visible part of their container
+    std::uint32_t tilesDrawn = 0;       ///< Tiles composited (includes stale ones)
+    std::uint32_t tilesMissing = 0;     ///< Visible tiles not rasterised yet (their area shows the container background)
+    std::uint32_t tilesStale = 0;       ///< Visible tiles drawn from outdated content while they wait to be refilled
+    std::uint32_t tilesRasterised = 0;  ///< Tiles rasterised this frame
+    std::uint32_t contentBuilds = 0;    ///< Containers whose content was flattened and queued for binning
+};
+
+/**
+ * @brief Draws a UiTree
+ *
+ * Every visible element with a background color becomes one instance of a
+ * rounded rectangle; instances are written to the Renderer's streaming
+ * buffer and drawn with a single instanced draw call, in tree order
+ * (parents below children, earlier siblings below later ones). Elements
+ * outside the viewport are culled.
+ *
+ * The content of a scroll container ("scroll" element) is not drawn node
+ * by node. When it changes, it is flattened into rectangles in content
+ * coordinates and binned into fixed-size tiles on the JobSystem (see
+ * setJobSystem()); each tile's rectangles are hashed. Visible tiles plus a
+ * prefetch margin are rasterised, at most maxRasterPerFrame per frame,
+ * into a UiTileCache atlas, and only tiles whose hash changed are redrawn.
+ * Each frame composites the cached tiles with the current scroll offset in
+ * one draw, clipped to the container: scrolling costs neither layout, nor
+ * JavaScript, nor rasterisation beyond the tiles scrolling into view.
+ * Until a tile is ready, its previous content (or nothing) is shown.
+ * Scroll containers nested in one are flattened into its tiles.
+ *
+ * Text nodes are not drawn yet.
+ *
+ * @code
+ * crazy::UiRenderer uiRenderer;
+ * app.setRenderCallback([&]() {
+ *     uiRenderer.render(ui, app.getRenderer(), framebufferWidth, framebufferHeight, contentScale);
+ * });
+ * @endcode
+ */
+class UiRenderer {
+public:
+    UiRenderer();
+
+    /**
+     * @brief Destroy the renderer and its GL objects
+     */
+    ~UiRenderer();
+
+    // Disable copy construction and assignment
+    UiRenderer(const UiRenderer&) = delete;
+    UiRenderer& operator=(const UiRenderer&) = delete;
+
+    /**
+     * @brief Draw the tree into the current framebuffer
+     *
+     * Must be called between Renderer::beginFrame() and endFrame(), e.g.
+     * from the render callback. Call UiTree::update() first. Blending,
+     * depth testing, the program and the vertex array are restored.
+     *
+     * @param tree Tree to draw
+     * @param renderer Renderer whose streaming buffer receives the instances
+     * @param width Framebuffer width in pixels
+     * @param height Framebuffer height in pixels
+     * @param contentScale Framebuffer pixels per window coordinate (HiDPI)
+     */
+    void render(const UiTree& tree, Renderer& renderer, int width, int height, float contentScale = 1.0f);
+
+    /**
+     * @brief Get the number of rectangles drawn by the last render()
+     *
+     * Rectangles inside scroll containers are drawn through their tiles
+     * and not counted.
+     */
+    std::uint32_t getQuadCount() const;
+
+    /**
+     * @brief Bin the tiles of scroll containers on a job system
+     *
+     * Without one, binning runs inline in render().
+     *
+     * @param jobs Job system that outlives the renderer, or nullptr
+     */
+    void setJobSystem(JobSystem* jobs);
+
+    /**
+     * @brief Replace the tiling settings; changing the tile geometry drops the cached tiles
+     */
+    void setScrollSettings(const UiScrollSettings& settings);
+
+    /**
+     * @brief Get the tiling settings
+     */
+    const UiScrollSettings& getScrollSettings() const;
+
+    /**
+     * @brief Get the scroll container metrics of the last render()
+     */
+    const UiScrollStats& getScrollStats() const;
+
+    /**
+     * @brief Get the tile cache, e.g. for its hit rate
+     */
+    const UiTileCache& getTileCache() const;
+
+    /**
+     * @brief Check if tiles are still being binned or rasterised
+     *
+     * Applications that only render on change keep rendering while this
+     * is true, so the refill completes.
+     */
+    bool isRefilling() const;
+
+    /**
+     * @brief Delete the GL objects
+     *
+     * Requires the context to be current; the destructor calls it
+     * automatically.
+     */
+    void release();
+
+private:
+    struct Instance {
+        float rect[4];              // x, y, width, height in framebuffer pixels
+        unsigned char color[4];     // RGBA
+        float radius;
+    };
+
+    // A scroll container's rectangles in content pixels, binned into tiles
+    struct TileContent {
+        std::vector<Instance> instances;
+        int columns = 0;
+        int rows = 0;
+        std::vector<std::uint32_t> offsets;     // Per tile, row-major, into indices; one extra at the end
+        std::vector<std::uint32_t> indices;
+        std::vector<std::uint64_t> hashes;      // Per tile, of its rectangles
+    };
+
+    struct Layer {
+        std::shared_ptr<const TileContent> content;
+        std::uint64_t version = 0;          // UiNode::contentVersion of content
+        float scale = 0.0f;                 // Pixels per content unit of content
+        std::shared_ptr<TileContent> building;
+        std::uint64_t buildingVersion = 0;
+        float buildingScale = 0.0f;
+        JobHandle job;
+        std::uint64_t lastFrame = 0;
+    };
+
+    // A scroll container on screen, composited after the rectangles before it
+    struct LayerDraw {
+        std::uint32_t rectEnd;              // Rectangles drawn before the layer
+        std::uint32_t node;
+        std::shared_ptr<const TileContent> content;
+        float clip[4];                      // Visible part of the container, framebuffer pixels: x0, y0, x1, y1
+        float originX;                      // Framebuffer position of the content origin
+        float originY;
+        float tileScale;                    // Framebuffer pixels per content pixel
+        float opacity;
+        int firstColumn;                    // Visible tiles
+        int lastColumn;
+        int firstRow;
+        int lastRow;
+        std::uint32_t tileFirst = 0;        // Range of m_tileInstances
+        std::uint32_t tileCount = 0;
+    };
+
+    struct TileRaster {
+        std::shared_ptr<const TileContent> content;
+        UiTileKey key;
+        bool visible;
+    };
+
+    struct TileInstance {
+        float rect[4];                      // x, y, width, height in framebuffer pixels
+        float uv[4];                        // Atlas coordinates of the top-left and bottom-right corners
+        float opacity;
+    };
+
+    void collect(const UiNode& node, float width, float height, float contentScale);
+    void addLayer(const UiNode& node, float width, float height, float contentScale);
+    void flatten(const UiNode& node, const UiNode& container, float contentScale,
+                 float offsetX, float offsetY, const float* clip, std::vector<Instance>& out) const;
+    static void bin(TileContent& content, int tileSize);
+    bool createPrograms();
+    void pointInstances(GLuint buffer, std::size_t offset);
+    void pointTileInstances(GLuint buffer, std::size_t offset);
+    std::uint32_t rasterTiles(Renderer& renderer);
+    void buildTileInstances();
+
+    GLuint m_program;
+    GLuint m_vertexArray;
+    GLint m_viewportLocation;
+    GLuint m_tileProgram;
+    GLuint m_tileVertexArray;
+    GLint m_tileViewportLocation;
+    GLint m_tileAtlasLocation;
+    bool m_failed;
+    std::pmr::vector<Instance> m_instances;
+
+    UiScrollSettings m_scrollSettings;
+    UiScrollStats m_scrollStats;
+    UiTileCache m_tiles;
+    JobSystem* m_jobs;
+    std::unordered_map<std::uint32_t, Layer> m_layers;
+    std::vector<LayerDraw> m_layerDraws;
+    std::vector<TileRaster> m_rasterQueue;
+    std::vector<Instance> m_rasterInstances;
+    std::vector<TileInstance> m_tileInstances;
+    std::uint64_t m_frame;
+    bool m_refilling;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_UI_RENDERER_HPP
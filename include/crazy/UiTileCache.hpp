@@ -0,0 +1,172 @@
+#ifndef CRAZY_UI_TILE_CACHE_HPP
+#define CRAZY_UI_TILE_CACHE_HPP
+
+#include "RenderTarget.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace crazy {
+
+/**
+ * @brief Identifies a tile of a scroll container's content
+ */
+struct UiTileKey {
+    std::uint32_t node = 0;     ///< Scroll container id
+    std::int32_t column = 0;    ///< Tile column in the content
+    std::int32_t row = 0;       ///< Tile row in the content
+
+    bool operator==(const UiTileKey& other) const {
+        return node == other.node && column == other.column && row == other.row;
+    }
+};
+
+/**
+ * @brief Metrics of a UiTileCache
+ */
+struct UiTileCacheStats {
+    std::uint64_t hits = 0;         ///< Lookups that found the tile
+    std::uint64_t misses = 0;       ///< Lookups that did not
+    std::uint64_t evictions = 0;    ///< Tiles dropped to make room for others
+    std::size_t tiles = 0;          ///< Tiles resident
+    std::size_t capacity = 0;       ///< Tiles the atlas holds
+};
+
+/**
+ * @brief LRU cache of rasterised UI tiles in a GPU atlas
+ *
+ * Tiles are square, tileSize pixels on a side, and live in slots of one
+ * RGBA8 atlas texture of atlasTiles x atlasTiles slots, so any number of
+ * them composite with a single texture bound. Each tile carries a hash of
+ * the content it was rasterised from; a caller whose content hashes
+ * differently re-rasterises it in place.
+ *
+ * When the atlas is full, allocate() reuses the least recently used slot,
+ * but never one used since the last beginFrame(): tiles on screen are not
+ * evicted by the tiles that replace them.
+ *
+ * Used by UiRenderer for scroll containers. Requires the GL context to be
+ * current for allocate() and release(). Not thread-safe.
+ */
+class UiTileCache {
+public:
+    /**
+     * @brief Construct an empty cache; the atlas is allocated on first use
+     *
+     * @param tileSize Tile edge in pixels
+     * @param atlasTiles Slots per atlas edge
+     */
+    explicit UiTileCache(int tileSize = 256, int atlasTiles = 8);
+
+    // Disable copy construction and assignment
+    UiTileCache(const UiTileCache&) = delete;
+    UiTileCache& operator=(const UiTileCache&) = delete;
+
+    /**
+     * @brief Change the geometry, dropping every tile
+     *
+     * @param tileSize Tile edge in pixels
+     * @param atlasTiles Slots per atlas edge
+     */
+    void configure(int tileSize, int atlasTiles);
+
+    /**
+     * @brief Start a frame; tiles looked up or allocated from now on are protected from eviction
+     */
+    void beginFrame();
+
+    /**
+     * @brief Look up a tile and mark it used
+     *
+     * @param key Tile
+     * @param hash Receives the hash of the content the tile was rasterised from
+     * @return int Slot, or -1 if the tile is not cached
+     */
+    int find(const UiTileKey& key, std::uint64_t& hash);
+
+    /**
+     * @brief Look up a tile without counting or marking it
+     *
+     * @param key Tile
+     * @param hash Receives the hash of the content the tile was rasterised from
+     * @return int Slot, or -1 if the tile is not cached
+     */
+    int peek(const UiTileKey& key, std::uint64_t& hash) const;
+
+    /**
+     * @brief Get a slot to rasterise a tile into
+     *
+     * Returns the tile's own slot if it is cached, else a free or the least
+     * recently used slot. The caller must rasterise the slot before the
+     * frame is drawn.
+     *
+     * @param key Tile
+     * @param hash Hash of the content that will be rasterised
+     * @return int Slot, or -1 if every slot is in use this frame or the atlas could not be allocated
+     */
+    int allocate(const UiTileKey& key, std::uint64_t hash);
+
+    /**
+     * @brief Drop every tile
+     */
+    void clear();
+
+    /**
+     * @brief Get the pixel position of a slot in the atlas
+     */
+    void getSlotOrigin(int slot, int& x, int& y) const;
+
+    /**
+     * @brief Get the atlas the tiles are rasterised into
+     */
+    RenderTarget& getAtlas();
+
+    /**
+     * @brief Get the tile edge in pixels
+     */
+    int getTileSize() const;
+
+    /**
+     * @brief Get the atlas edge in pixels
+     */
+    int getAtlasSize() const;
+
+    /**
+     * @brief Get the cache metrics
+     */
+    UiTileCacheStats getStats() const;
+
+    /**
+     * @brief Drop every tile and delete the atlas
+     */
+    void release();
+
+private:
+    struct Slot {
+        UiTileKey key;
+        std::uint64_t hash = 0;
+        std::uint64_t lastUsed = 0;     // Frame of the last lookup or allocation
+        bool occupied = false;
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const UiTileKey& key) const {
+            return (static_cast<std::size_t>(key.node) * 0x9E3779B1u)
+                ^ (static_cast<std::size_t>(static_cast<std::uint32_t>(key.column)) << 16)
+                ^ static_cast<std::size_t>(static_cast<std::uint32_t>(key.row)) * 0x85EBCA77u;
+        }
+    };
+
+    int m_tileSize;
+    int m_atlasTiles;
+    RenderTarget m_atlas;
+    std::vector<Slot> m_slots;
+    std::unordered_map<UiTileKey, int, KeyHash> m_index;
+    std::uint64_t m_frame;
+    UiTileCacheStats m_stats;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_UI_TILE_CACHE_HPP
@@ -0,0 +1,324 @@
+#ifndef CRAZY_UI_TREE_HPP
+#define CRAZY_UI_TREE_HPP
+
+#include "EventHandler.hpp"
+#include "RingChannel.hpp"
+#include "SharedMemory.hpp"
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace crazy {
+
+class CommandBatch;
+class NodeRuntime;
+
+/**
+ * @brief Properties of a UI node known to the core
+ *
+ * Positions and sizes are in window coordinates (screen coordinates, as
+ * reported by the cursor callbacks); x and y are relative to the parent.
+ * Colors are packed 0xRRGGBBAA. Every property except Visible can be
+ * animated with a transition; a transition on ScrollX/ScrollY makes
+ * scrolling smooth.
+ */
+enum class UiProperty : std::uint8_t {
+    X,
+    Y,
+    Width,
+    Height,
+    Opacity,
+    TranslateX,
+    TranslateY,
+    Scale,              ///< Uniform, around the node's center; applies to children
+    BorderRadius,
+    BackgroundColor,
+    Color,
+    Visible,            ///< 0 hides the node and its children
+    ScrollX,            ///< "scrollLeft": content offset of a scroll element; never moves world positions
+    ScrollY,            ///< "scrollTop"
+    Count
+};
+
+/**
+ * @brief Pointer event kinds sent to JavaScript (bridge::PointerEvent::kind)
+ */
+enum class UiEventKind : std::uint8_t {
+    PointerDown,
+    PointerUp,
+    PointerMove,
+    PointerEnter,       ///< Sent to each listening node the pointer enters, does not bubble
+    PointerLeave,       ///< Sent to each listening node the pointer leaves, does not bubble
+    Click               ///< Pointer pressed and released on the same node
+};
+
+/**
+ * @brief Timing curves of transitions (bridge::SetTransition::easing)
+ */
+enum class UiEasing : std::uint8_t {
+    Linear,
+    EaseIn,
+    EaseOut,
+    EaseInOut
+};
+
+/**
+ * @brief A node of the UI tree
+ *
+ * Read-only outside UiTree. World values are computed by UiTree::update().
+ *
+ * Elements of type "scroll" are scroll containers: their children are laid
+ * out in content coordinates and shown through the element's bounds,
+ * shifted by ScrollX/ScrollY. The world values of their descendants ignore
+ * the scroll offset, which hit-testing and rendering apply on top, so
+ * scrolling never recomputes them.
+ */
+struct UiNode {
+    std::uint32_t id = 0;
+    bool isText = false;
+    bool scrolls = false;                       ///< Scroll container (element type "scroll")
+    std::string type;                           ///< Element type; empty for text nodes
+    std::string text;                           ///< Content of text nodes (or element text content)
+    UiNode* parent = nullptr;
+    std::vector<UiNode*> children;
+    double values[static_cast<int>(UiProperty::Count)] = {};   ///< Current, possibly animated, values
+    std::uint32_t eventMask = 0;                ///< Bit (1 << UiEventKind) per listened event
+    std::unordered_map<std::string, double> numbers;         ///< Numeric properties unknown to the core
+    std::unordered_map<std::string, std::string> strings;     ///< String properties
+
+    double worldX = 0.0;                        ///< Window position of the node's origin, unscrolled
+    double worldY = 0.0;
+    double worldScale = 1.0;                    ///< Accumulated scale
+    double worldOpacity = 1.0;                  ///< Accumulated opacity
+    bool worldVisible = true;                   ///< Visible and all ancestors visible
+
+    double contentWidth = 0.0;                  ///< Scroll containers: extent of the children, in local units
+    double contentHeight = 0.0;
+    std::uint64_t contentVersion = 0;           ///< Scroll containers: bumped by every change to the content
+
+    double get(UiProperty property) const { return values[static_cast<int>(property)]; }
+
+    // Counted in MemoryCategory::UiTree
+    static void* operator new(std::size_t size);
+    static void operator delete(void* p, std::size_t size);
+};
+
+/**
+ * @brief Native retained UI tree driven by the React host renderer
+ *
+ * JavaScript (frontend/src/renderer) turns React's host operations into UI
+ * bridge messages (CreateElement, AppendChild, SetNumberProperty, ...)
+ * batched through a CommandBatch; apply() executes them. The tree keeps
+ * the properties the core understands in typed slots (UiProperty), so
+ * rendering and hit-testing never look up strings.
+ *
+ * Properties marked with a transition (bridge::SetTransition) animate
+ * natively: later changes interpolate in update() without JavaScript
+ * running per frame.
+ *
+ * Pointer input is hit-tested against the tree and only reaches JavaScript
+ * when a node on the path listens for it (bridge::SetEventMask), as
+ * bridge::PointerEvent messages on an event ring; key events are forwarded
+ * as bridge::KeyEvent. Wheel input scrolls the innermost scroll container
+ * under the pointer natively, without a round trip through JavaScript.
+ *
+ * @code
+ * crazy::UiTree ui;
+ * ui.attach(crazy::NodeRuntime::instance(), commands);    // after commands.attach()
+ * app.setUpdateCallback([&](float dt) { ui.update(dt); });
+ * app.setRenderCallback([&]() { uiRenderer.render(ui, app.getRenderer(), width, height); });
+ * handler.setMouseMoveCallback([&](const crazy::MouseMoveEvent& e) { ui.handleMouseMove(e); });
+ * @endcode
+ *
+ * Layout is absolute: nodes are placed by x/y/width/height. Not thread-safe.
+ */
+class UiTree {
+public:
+    /**
+     * @brief Create an empty tree with the root container (id 0)
+     *
+     * @param eventCapacity Capacity of the event ring in bytes
+     */
+    explicit UiTree(std::uint32_t eventCapacity = 64 * 1024);
+
+    // Disable copy construction and assignment
+    UiTree(const UiTree&) = delete;
+    UiTree& operator=(const UiTree&) = delete;
+
+    /**
+     * @brief Connect the tree to JavaScript
+     *
+     * Makes @p commands execute UI messages on this tree and exposes the
+     * event ring as crazy.shared.uiEvents. When JavaScript is idle, new
+     * events wake it with NodeRuntime::postCall("crazy.dispatchUiEvents").
+     * The tree must outlive the runtime or NodeRuntime::shutdown().
+     *
+     * @param runtime Running runtime
+     * @param commands Batch attached to the runtime
+     * @return true if the event ring was exposed
+     */
+    bool attach(NodeRuntime& runtime, CommandBatch& commands);
+
+    /**
+     * @brief Execute one UI bridge message
+     *
+     * @param data Encoded message
+     * @param size Size in bytes
+     * @return true if it was a valid UI message for existing nodes
+     */
+    bool apply(const void* data, std::uint32_t size);
+
+    /**
+     * @brief Advance animations and recompute world positions
+     *
+     * @param deltaTime Seconds since the last update
+     */
+    void update(double deltaTime);
+
+    /**
+     * @brief Check if transitions are running (the next frames will change)
+     */
+    bool isAnimating() const;
+
+    /**
+     * @brief Get a counter incremented by every change to the tree
+     */
+    std::uint64_t getRevision() const;
+
+    /**
+     * @brief Get the root container
+     */
+    const UiNode& getRoot() const;
+
+    /**
+     * @brief Find a node by id
+     *
+     * @return const UiNode* Node, or nullptr if there is none
+     */
+    const UiNode* find(std::uint32_t id) const;
+
+    /**
+     * @brief Get the number of nodes, including the root and detached nodes
+     */
+    std::size_t getNodeCount() const;
+
+    /**
+     * @brief Find the topmost visible element under a point
+     *
+     * Children are tested before their parent and later siblings before
+     * earlier ones; children outside their parent's bounds are found too,
+     * except for scroll containers, which clip their content.
+     *
+     * @param x Window x coordinate
+     * @param y Window y coordinate
+     * @return const UiNode* Element, or nullptr if the point hits nothing
+     */
+    const UiNode* hitTest(double x, double y) const;
+
+    /**
+     * @brief Track the pointer; sends move, enter and leave events
+     *
+     * @return true if a node listens to the event
+     */
+    bool handleMouseMove(const MouseMoveEvent& event);
+
+    /**
+     * @brief Send pointer down, up and click events at the last pointer position
+     *
+     * @param event Button event
+     * @param pressed true for a press, false for a release
+     * @return true if a node listens to the event
+     */
+    bool handleMouseButton(const MouseButtonEvent& event, bool pressed);
+
+    /**
+     * @brief Scroll the innermost scroll container under the pointer
+     *
+     * Containers that cannot move further in the wheel's direction pass
+     * the scroll on to the next one out. Offsets are clamped to the content
+     * extent and animate if the container has a transition on them. Only
+     * the scroll offset changes: world positions, layout and JavaScript are
+     * not involved.
+     *
+     * @param event Scroll event; one unit scrolls kWheelStep window units
+     * @return true if a container scrolled
+     */
+    bool handleScroll(const ScrollEvent& event);
+
+    /// Window units scrolled per unit of wheel offset
+    static constexpr double kWheelStep = 48.0;
+
+    /**
+     * @brief Forward a key event to JavaScript
+     *
+     * @param event Key event
+     * @param action GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+     * @return true if the event was queued
+     */
+    bool handleKey(const KeyEvent& event, int action);
+
+    /**
+     * @brief Get the ring carrying events to JavaScript
+     */
+    RingChannel& getEventChannel();
+
+    /**
+     * @brief Find the property slot of a property name
+     *
+     * @param name Property name as used by JavaScript, e.g. "backgroundColor"
+     * @param property Receives the slot
+     * @return true if the core knows the property
+     */
+    static bool findProperty(std::string_view name, UiProperty& property);
+
+private:
+    struct Transition {
+        UiProperty property;
+        UiEasing easing;
+        double duration;
+    };
+
+    struct Animation {
+        std::uint32_t node;
+        UiProperty property;
+        UiEasing easing;
+        double from;
+        double to;
+        double elapsed;
+        double duration;
+    };
+
+    UiNode* lookup(std::uint32_t id);
+    UiNode* create(std::uint32_t id, bool isText, std::string_view typeOrText);
+    void detach(UiNode* node);
+    void destroy(UiNode* node);
+    void setValue(UiNode* node, UiProperty property, double value);
+    double scrollTarget(const UiNode* node, UiProperty property) const;
+    void markContent(UiNode* node);
+    void updateWorld(UiNode* node, const UiNode* parent);
+    const UiNode* hitTest(const UiNode* node, double x, double y) const;
+    bool listens(const UiNode* node, UiEventKind kind) const;
+    bool post(const UiNode* target, UiEventKind kind, int button, int mods);
+
+    std::pmr::unordered_map<std::uint32_t, std::unique_ptr<UiNode>> m_nodes;
+    std::pmr::unordered_map<std::uint32_t, std::vector<Transition>> m_transitions;
+    std::vector<Animation> m_animations;
+    UiNode* m_root;
+    std::uint64_t m_revision;
+    bool m_worldDirty;
+
+    SharedMemory m_eventMemory;
+    RingChannel m_events;
+    double m_pointerX;
+    double m_pointerY;
+    std::vector<std::uint32_t> m_hoverPath;
+    std::uint32_t m_pressedNode;
+};
+
+} // namespace crazy
+
+#endif // CRAZY_UI_TREE_HPP
@@ -0,0 +1,287 @@
+#include "crazy/ApplicationBase.hpp"
+#include "crazy/Log.hpp"
+
+namespace crazy {
+
+ApplicationBase::ApplicationBase(int width, int height, const std::string& title, StartupPipeline* startup)
+    : m_initialized(false)
+    , m_window(nullptr)
+    , m_eventHandler(nullptr)
+    , m_renderer(nullptr)
+    , m_dynamicResolution(nullptr)
+    , m_frameThrottle(nullptr)
+    , m_frameCapture(nullptr)
+    , m_imageCache(nullptr)
+    , m_jobSystem(nullptr)
+    , m_startup(startup)
+    , m_lastFrameTime(0.0)
+    , m_frameWidth(-1)
+    , m_frameHeight(-1)
+{
+    // Worker stages overlap everything below
+    if (m_startup) {
+        m_startup->start(getJobSystem());
+    }
+    double spanStart = m_startup ? m_startup->now() : 0.0;
+    auto endSpan = [&](const char* name) {
+        if (m_startup) {
+            const double now = m_startup->now();
+            m_startup->addSpan(name, spanStart, now);
+            spanStart = now;
+        }
+    };
+
+    // Set error callback for GLFW
+    glfwSetErrorCallback([](int error, const char* description) {
+        // Some errors repeat every frame; keep them from flooding the log
+        static LogRateLimiter s_limiter(10, 1.0);
+        std::uint64_t suppressed = 0;
+        if (!s_limiter.allow(suppressed)) {
+            return;
+        }
+        if (suppressed > 0) {
+            CRAZY_LOG_WARNING("{} GLFW errors suppressed", suppressed);
+        }
+        CRAZY_LOG_ERROR("GLFW Error {}: {}", error, description);
+    });
+
+    // Initialize GLFW
+    if (!glfwInit()) {
+        CRAZY_LOG_ERROR("Failed to initialize GLFW");
+        return;
+    }
+    endSpan("glfwInit");
+
+    // Create window
+    m_window = std::make_unique<Window>(width, height, title);
+    if (!m_window->isValid()) {
+        CRAZY_LOG_ERROR("Failed to create window");
+        glfwTerminate();
+        return;
+    }
+
+    // Make context current
+    m_window->makeContextCurrent();
+    endSpan("window");
+
+    // Create event handler and renderer
+    m_eventHandler = std::make_unique<EventHandler>();
+    m_renderer = std::make_unique<Renderer>();
+    m_dynamicResolution = std::make_unique<DynamicResolution>();
+    m_frameThrottle = std::make_unique<FrameThrottle>();
+    m_frameCapture = std::make_unique<FrameCapture>();
+    m_imageCache = std::make_unique<ImageCache>();
+
+    // Attach event handler to window
+    m_eventHandler->attachToWindow(*m_window);
+
+    // Enable VSync by default
+    m_window->setVSync(true);
+    endSpan("renderer");
+
+    m_initialized = true;
+}
+
+ApplicationBase::~ApplicationBase() {
+    releaseCore();
+}
+
+bool ApplicationBase::isInitialized() const {
+    return m_initialized;
+}
+
+Window& ApplicationBase::getWindow() {
+    return *m_window;
+}
+
+EventHandler& ApplicationBase::getEventHandler() {
+    return *m_eventHandler;
+}
+
+Renderer& ApplicationBase::getRenderer() {
+    return *m_renderer;
+}
+
+DynamicResolution& ApplicationBase::getDynamicResolution() {
+    return *m_dynamicResolution;
+}
+
+FrameThrottle& ApplicationBase::getFrameThrottle() {
+    return *m_frameThrottle;
+}
+
+FrameCapture& ApplicationBase::getFrameCapture() {
+    return *m_frameCapture;
+}
+
+ImageCache& ApplicationBase::getImageCache() {
+    return *m_imageCache;
+}
+
+JobSystem& ApplicationBase::getJobSystem() {
+    if (!m_jobSystem) {
+        m_jobSystem = std::make_unique<JobSystem>();
+    }
+    return *m_jobSystem;
+}
+
+void ApplicationBase::setMaxFramesInFlight(int frames) {
+    if (m_renderer) {
+        m_renderer->setMaxFramesInFlight(frames);
+    }
+}
+
+void ApplicationBase::quit() {
+    if (m_window) {
+        m_window->setShouldClose(true);
+    }
+}
+
+bool ApplicationBase::finishStartup() {
+    if (m_startup && !m_startup->runUntilReady()) {
+        CRAZY_LOG_ERROR("Startup failed");
+        return false;
+    }
+    return true;
+}
+
+void ApplicationBase::beginRun() {
+    CRAZY_LOG_INFO("Application started successfully");
+    CRAZY_LOG_INFO("OpenGL Version: {}", Renderer::getOpenGLVersion());
+
+    // Initialize timing
+    m_lastFrameTime = glfwGetTime();
+}
+
+bool ApplicationBase::isRunning() const {
+    return !m_window->shouldClose();
+}
+
+bool ApplicationBase::updateThrottle() {
+    const ThrottleState previous = m_frameThrottle->getState();
+    const ThrottleState state = m_frameThrottle->update(*m_window);
+    
+    // Don't hand the first frame after a suspension its whole duration
+    if (previous == ThrottleState::Suspended && state != ThrottleState::Suspended) {
+        m_lastFrameTime = glfwGetTime();
+    }
+    return state != ThrottleState::Suspended;
+}
+
+void ApplicationBase::waitThrottled() {
+    m_frameThrottle->wait(*m_window);
+}
+
+float ApplicationBase::beginFrame() {
+    // Calculate delta time
+    double currentTime = glfwGetTime();
+    float deltaTime = static_cast<float>(currentTime - m_lastFrameTime);
+    m_lastFrameTime = currentTime;
+
+    // Wait for the frame slot to be free on the GPU
+    m_renderer->beginFrame();
+    
+    // This frame presents every input received since the previous one
+    for (int kind = 0; kind < static_cast<int>(InputKind::Count); ++kind) {
+        double timestamp = 0.0;
+        if (m_eventHandler->takePendingInput(static_cast<InputKind>(kind), timestamp)) {
+            m_renderer->recordInput(static_cast<InputKind>(kind), timestamp);
+        }
+    }
+
+    // Finished decodes become available for upload; textures unused since
+    // the previous frame may be evicted
+    m_imageCache->update();
+
+    // Deferred startup stages run between frames
+    if (m_startup) {
+        m_startup->pump();
+    }
+
+    return deltaTime;
+}
+
+void ApplicationBase::beginScene() {
+    const int width = m_window->getWidth();
+    const int height = m_window->getHeight();
+    
+    // Follow the framebuffer, so apps don't have to on every resize event
+    if (width != m_frameWidth || height != m_frameHeight) {
+        m_frameWidth = width;
+        m_frameHeight = height;
+        m_renderer->setViewport(0, 0, width, height);
+    }
+    
+    m_dynamicResolution->beginScene(width, height);
+}
+
+bool ApplicationBase::isNativeResolutionUI() const {
+    return m_dynamicResolution->getSettings().nativeResolutionUI;
+}
+
+void ApplicationBase::endScene() {
+    m_dynamicResolution->endScene();
+}
+
+void ApplicationBase::endFrame() {
+    // Read back the finished back buffer without waiting for it
+    if (m_frameCapture->isActive()) {
+        m_frameCapture->capture(m_window->getWidth(), m_window->getHeight());
+    }
+    
+    // Fence this frame's GPU resources
+    m_renderer->endFrame();
+
+    // Adapt the render scale to the measured frame times
+    const FrameStats& frameStats = m_renderer->getFrameStats();
+    m_dynamicResolution->update(frameStats.cpuFrameTime, frameStats.gpuFrameTime);
+
+    // Swap buffers
+    m_window->swapBuffers();
+    m_renderer->framePresented();
+    m_frameThrottle->countFrame();
+
+    if (m_startup) {
+        m_startup->markFirstFrame();
+        if (m_startup->isComplete()) {
+            m_startup = nullptr;
+        }
+    }
+}
+
+bool ApplicationBase::needsResizeFrame() const {
+    return m_window->getWidth() != m_frameWidth || m_window->getHeight() != m_frameHeight;
+}
+
+void ApplicationBase::endRun() {
+    CRAZY_LOG_INFO("Application shutting down");
+}
+
+void ApplicationBase::releaseCore() {
+    // Worker stages still running signal the job system when they finish
+    if (m_startup) {
+        m_startup->stop();
+        m_startup = nullptr;
+    }
+
+    if (!m_initialized) {
+        return;
+    }
+
+    // Clean up; jobs may still reference the other subsystems
+    m_jobSystem.reset();
+    m_imageCache.reset();
+    m_frameCapture.reset();
+    m_dynamicResolution.reset();
+    m_frameThrottle.reset();
+    m_renderer.reset();
+    m_eventHandler.reset();
+    m_window.reset();
+
+    // Terminate GLFW
+    glfwTerminate();
+
+    m_initialized = false;
+}
+
+} // namespace crazy
@@ -0,0 +1,423 @@
+#include "crazy/AssetPack.hpp"
+#include "crazy/Log.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace crazy {
+
+// Index entry as stored in the file
+struct AssetPack::Entry {
+    std::uint64_t dataOffset;
+    std::uint32_t storedSize;
+    std::uint32_t size;
+    std::uint32_t nameOffset;
+    std::uint32_t nameLength;
+    std::uint16_t kind;
+    std::uint8_t compression;
+    std::uint8_t reserved0;
+    std::uint32_t reserved1;
+};
+
+namespace {
+
+constexpr char kMagic[8] = { 'C', 'R', 'Z', 'P', 'A', 'C', 'K', '1' };
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kHeaderSize = 64;
+constexpr std::size_t kTextureHeaderSize = 16;
+constexpr std::uint8_t kCompressionNone = 0;
+constexpr std::uint8_t kCompressionLz4 = 1;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t entryCount;
+    std::uint64_t indexOffset;
+    std::uint64_t namesOffset;
+    std::uint64_t namesSize;
+    std::uint64_t fileSize;
+};
+
+std::uint32_t readU32(const std::uint8_t* data) {
+    std::uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Decodes one LZ4 block (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+// Every read and write is bounds checked, and the block must produce
+// exactly dstSize bytes.
+bool decompressLz4(const std::uint8_t* src, std::size_t srcSize, std::uint8_t* dst, std::size_t dstSize) {
+    const std::uint8_t* ip = src;
+    const std::uint8_t* const ipEnd = src + srcSize;
+    std::uint8_t* op = dst;
+    std::uint8_t* const opEnd = dst + dstSize;
+
+    auto readLength = [&](std::size_t& length) {
+        std::uint8_t byte;
+        do {
+            if (ip >= ipEnd) {
+                return false;
+            }
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (ip < ipEnd) {
+        const std::uint8_t token = *ip++;
+
+        std::size_t literals = token >> 4;
+        if (literals == 15 && !readLength(literals)) {
+            return false;
+        }
+        if (literals > static_cast<std::size_t>(ipEnd - ip) || literals > static_cast<std::size_t>(opEnd - op)) {
+            return false;
+        }
+        std::memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        // The last sequence has no match
+        if (ip == ipEnd) {
+            break;
+        }
+
+        if (ipEnd - ip < 2) {
+            return false;
+        }
+        const std::size_t offset = static_cast<std::size_t>(ip[0]) | (static_cast<std::size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<std::size_t>(op - dst)) {
+            return false;
+        }
+
+        std::size_t length = token & 15;
+        if (length == 15 && !readLength(length)) {
+            return false;
+        }
+        length += 4;
+        if (length > static_cast<std::size_t>(opEnd - op)) {
+            return false;
+        }
+
+        // Matches may overlap their own output (run-length style)
+        const std::uint8_t* match = op - offset;
+        if (offset >= length) {
+            std::memcpy(op, match, length);
+            op += length;
+        } else {
+            for (std::size_t i = 0; i < length; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+    return op == opEnd;
+}
+
+} // namespace
+
+AssetPack::AssetPack()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_entries(nullptr)
+    , m_entryCount(0)
+    , m_names(nullptr)
+{
+}
+
+AssetPack::~AssetPack() {
+    close();
+}
+
+AssetPack::AssetPack(AssetPack&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_entries(std::exchange(other.m_entries, nullptr))
+    , m_entryCount(std::exchange(other.m_entryCount, 0))
+    , m_names(std::exchange(other.m_names, nullptr))
+    , m_buffer(std::move(other.m_buffer))
+{
+}
+
+AssetPack& AssetPack::operator=(AssetPack&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_entries = std::exchange(other.m_entries, nullptr);
+        m_entryCount = std::exchange(other.m_entryCount, 0);
+        m_names = std::exchange(other.m_names, nullptr);
+        m_buffer = std::move(other.m_buffer);
+    }
+    return *this;
+}
+
+bool AssetPack::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        CRAZY_LOG_ERROR("AssetPack: Cannot open {}", path.c_str());
+        return false;
+    }
+    m_buffer.resize(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()))) {
+        CRAZY_LOG_ERROR("AssetPack: Cannot read {}", path.c_str());
+        m_buffer.clear();
+        return false;
+    }
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        CRAZY_LOG_ERROR("AssetPack: Cannot open {}: {}", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size <= 0) {
+        CRAZY_LOG_ERROR("AssetPack: {} is empty or unreadable", path.c_str());
+        ::close(fd);
+        return false;
+    }
+    const std::size_t size = static_cast<std::size_t>(status.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        CRAZY_LOG_ERROR("AssetPack: Failed to map {}: {}", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    m_data = static_cast<const std::uint8_t*>(data);
+    m_size = size;
+#endif
+
+    if (!validate(path)) {
+        close();
+        return false;
+    }
+
+#ifndef _WIN32
+    // Lookups touch the index and names first; fault them in together
+    Header header;
+    std::memcpy(&header, m_data, sizeof(header));
+    madvise(const_cast<std::uint8_t*>(m_data), header.namesOffset + header.namesSize, MADV_WILLNEED);
+#endif
+
+    CRAZY_LOG_DEBUG("AssetPack: Opened {} ({} entries, {} bytes)", path.c_str(), m_entryCount, m_size);
+    return true;
+}
+
+void AssetPack::close() {
+#ifndef _WIN32
+    if (m_data && m_buffer.empty()) {
+        munmap(const_cast<std::uint8_t*>(m_data), m_size);
+    }
+#endif
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_data = nullptr;
+    m_size = 0;
+    m_entries = nullptr;
+    m_entryCount = 0;
+    m_names = nullptr;
+}
+
+bool AssetPack::isOpen() const {
+    return m_data != nullptr;
+}
+
+std::size_t AssetPack::getEntryCount() const {
+    return m_entryCount;
+}
+
+bool AssetPack::getInfo(std::size_t index, AssetInfo& info) const {
+    if (index >= m_entryCount) {
+        return false;
+    }
+    describe(m_entries[index], info);
+    return true;
+}
+
+bool AssetPack::find(std::string_view name, AssetInfo& info) const {
+    const Entry* entry = findEntry(name);
+    if (!entry) {
+        return false;
+    }
+    describe(*entry, info);
+    return true;
+}
+
+bool AssetPack::contains(std::string_view name) const {
+    return findEntry(name) != nullptr;
+}
+
+std::string_view AssetPack::view(std::string_view name) const {
+    const Entry* entry = findEntry(name);
+    if (!entry || entry->compression != kCompressionNone) {
+        return {};
+    }
+    return std::string_view(reinterpret_cast<const char*>(m_data + entry->dataOffset), entry->storedSize);
+}
+
+bool AssetPack::read(std::string_view name, std::vector<std::uint8_t>& data) const {
+    const Entry* entry = findEntry(name);
+    if (!entry) {
+        return false;
+    }
+
+    const std::uint8_t* stored = m_data + entry->dataOffset;
+    if (entry->compression == kCompressionNone) {
+        data.assign(stored, stored + entry->storedSize);
+        return true;
+    }
+
+    data.resize(entry->size);
+    if (!decompressLz4(stored, entry->storedSize, data.data(), data.size())) {
+        CRAZY_LOG_ERROR("AssetPack: Corrupt LZ4 data in {}", std::string(name).c_str());
+        data.clear();
+        return false;
+    }
+    return true;
+}
+
+bool AssetPack::getTexture(std::string_view name, AssetTexture& texture, std::vector<std::uint8_t>& scratch) const {
+    const Entry* entry = findEntry(name);
+    if (!entry || entry->kind != static_cast<std::uint16_t>(AssetKind::Texture)) {
+        return false;
+    }
+
+    const std::uint8_t* payload = m_data + entry->dataOffset;
+    if (entry->compression != kCompressionNone) {
+        if (!read(name, scratch)) {
+            return false;
+        }
+        payload = scratch.data();
+    }
+    if (entry->size < kTextureHeaderSize) {
+        return false;
+    }
+
+    const std::uint32_t width = readU32(payload);
+    const std::uint32_t height = readU32(payload + 4);
+    const std::uint32_t format = readU32(payload + 8);
+    const std::uint32_t rowStride = readU32(payload + 12);
+    if (format != static_cast<std::uint32_t>(AssetTextureFormat::RGBA8)
+        || rowStride < static_cast<std::uint64_t>(width) * 4
+        || static_cast<std::uint64_t>(rowStride) * height > entry->size - kTextureHeaderSize) {
+        CRAZY_LOG_ERROR("AssetPack: Invalid texture {}", std::string(name).c_str());
+        return false;
+    }
+
+    texture.width = width;
+    texture.height = height;
+    texture.rowStride = rowStride;
+    texture.format = AssetTextureFormat::RGBA8;
+    texture.pixels = payload + kTextureHeaderSize;
+    return true;
+}
+
+void AssetPack::prefetch(std::string_view name) const {
+#ifdef _WIN32
+    (void)name;
+#else
+    const Entry* entry = findEntry(name);
+    if (!entry || !m_buffer.empty()) {
+        return;
+    }
+    const std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(m_data + entry->dataOffset) & ~(page - 1);
+    const std::uintptr_t end = reinterpret_cast<std::uintptr_t>(m_data + entry->dataOffset + entry->storedSize);
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#endif
+}
+
+const AssetPack::Entry* AssetPack::findEntry(std::string_view name) const {
+    const Entry* end = m_entries + m_entryCount;
+    const Entry* entry = std::lower_bound(m_entries, end, name, [this](const Entry& candidate, std::string_view key) {
+        return entryName(candidate) < key;
+    });
+    if (entry == end || entryName(*entry) != name) {
+        return nullptr;
+    }
+    return entry;
+}
+
+std::string_view AssetPack::entryName(const Entry& entry) const {
+    return std::string_view(m_names + entry.nameOffset, entry.nameLength);
+}
+
+void AssetPack::describe(const Entry& entry, AssetInfo& info) const {
+    info.name = entryName(entry);
+    info.size = entry.size;
+    info.storedSize = entry.storedSize;
+    info.kind = static_cast<AssetKind>(entry.kind);
+    info.compressed = entry.compression != kCompressionNone;
+}
+
+bool AssetPack::validate(const std::string& path) {
+    static_assert(sizeof(Entry) == 32, "asset pack index entries are 32 bytes");
+
+    if (m_size < kHeaderSize) {
+        CRAZY_LOG_ERROR("AssetPack: {} is not an asset pack", path.c_str());
+        return false;
+    }
+    Header header;
+    std::memcpy(&header, m_data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        CRAZY_LOG_ERROR("AssetPack: {} is not an asset pack", path.c_str());
+        return false;
+    }
+    if (header.version != kVersion) {
+        CRAZY_LOG_ERROR("AssetPack: {} has version {}, expected {}", path.c_str(), header.version, kVersion);
+        return false;
+    }
+    if (header.fileSize != m_size) {
+        CRAZY_LOG_ERROR("AssetPack: {} is truncated ({} of {} bytes)", path.c_str(), m_size, header.fileSize);
+        return false;
+    }
+    if (header.indexOffset % alignof(Entry) != 0
+        || header.indexOffset > m_size
+        || header.entryCount > (m_size - header.indexOffset) / sizeof(Entry)
+        || header.namesOffset > m_size
+        || header.namesSize > m_size - header.namesOffset) {
+        CRAZY_LOG_ERROR("AssetPack: {} has a corrupt header", path.c_str());
+        return false;
+    }
+
+    m_entries = reinterpret_cast<const Entry*>(m_data + header.indexOffset);
+    m_entryCount = header.entryCount;
+    m_names = reinterpret_cast<const char*>(m_data + header.namesOffset);
+
+    // Checked once here so lookups and views need no bounds checks
+    for (std::size_t i = 0; i < m_entryCount; ++i) {
+        const Entry& entry = m_entries[i];
+        const bool valid = static_cast<std::uint64_t>(entry.nameOffset) + entry.nameLength <= header.namesSize
+            && entry.dataOffset <= m_size
+            && entry.storedSize <= m_size - entry.dataOffset
+            && (entry.compression == kCompressionLz4
+                || (entry.compression == kCompressionNone && entry.storedSize == entry.size))
+            && (i == 0 || entryName(m_entries[i - 1]) < entryName(entry));
+        if (!valid) {
+            CRAZY_LOG_ERROR("AssetPack: {} has a corrupt index entry {}", path.c_str(), i);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace crazy
@@ -0,0 +1,401 @@
+#include "crazy/BufferManager.hpp"
+#include "crazy/MemoryTracker.hpp"
+#include "GLFunctions.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace crazy {
+
+namespace {
+
+// Buffers are created and filled through GL_COPY_WRITE_BUFFER so that
+// uploads never disturb the vertex array or uniform bindings of the caller.
+const GLenum kUploadTarget = GL_COPY_WRITE_BUFFER;
+
+std::size_t alignUp(std::size_t value, std::size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+BufferManager::BufferManager(std::size_t pageSize, std::size_t streamFrameSize, int streamFrameCount)
+    : m_pageSize(pageSize)
+    , m_staticAllocationCount(0)
+    , m_streamFrameSize(streamFrameSize)
+    , m_streamFrameCount(std::max(streamFrameCount, 1))
+    , m_streamBuffer(0)
+    , m_streamMemoryId(0)
+    , m_streamPersistentPtr(nullptr)
+    , m_streamMapped(false)
+    , m_streamFrame(0)
+    , m_streamCursor(0)
+    , m_streamOverflowed(false)
+    , m_streamResize(false)
+    , m_uniformAlignment(0)
+{
+}
+
+BufferManager::~BufferManager() {
+    release();
+}
+
+BufferAllocation BufferManager::allocateStatic(std::size_t size, std::size_t alignment) {
+    BufferAllocation allocation;
+    if (size == 0 || !gl::load()) {
+        return allocation;
+    }
+    alignment = std::max<std::size_t>(alignment, 1);
+
+    for (Page& page : m_pages) {
+        if (allocateFromPage(page, size, alignment, allocation)) {
+            return allocation;
+        }
+    }
+
+    // No page has room: create a new one, sized up for oversized requests
+    Page page;
+    page.size = std::max(m_pageSize, alignUp(size, alignment));
+    page.used = 0;
+    page.allocations = 0;
+    page.buffer = 0;
+    page.memoryId = 0;
+
+    gl::GenBuffers(1, &page.buffer);
+    gl::BindBuffer(kUploadTarget, page.buffer);
+    gl::BufferData(kUploadTarget, static_cast<GLsizeiptr>(page.size), nullptr, GL_STATIC_DRAW);
+    gl::BindBuffer(kUploadTarget, 0);
+    page.freeBlocks[0] = page.size;
+    page.memoryId = MemoryTracker::instance().track(MemoryCategory::VertexBuffers, page.size,
+                                                    "BufferManager static page");
+
+    m_pages.push_back(page);
+    allocateFromPage(m_pages.back(), size, alignment, allocation);
+    return allocation;
+}
+
+BufferAllocation BufferManager::uploadStatic(const void* data, std::size_t size, std::size_t alignment) {
+    BufferAllocation allocation = allocateStatic(size, alignment);
+    if (allocation.isValid() && data) {
+        updateStatic(allocation, data, size);
+    }
+    return allocation;
+}
+
+void BufferManager::updateStatic(const BufferAllocation& allocation, const void* data,
+                                 std::size_t size, std::size_t offset) {
+    if (!allocation.isValid() || !data || offset + size > allocation.size) {
+        return;
+    }
+
+    gl::BindBuffer(kUploadTarget, allocation.buffer);
+    gl::BufferSubData(kUploadTarget, static_cast<GLintptr>(allocation.offset + offset),
+                      static_cast<GLsizeiptr>(size), data);
+    gl::BindBuffer(kUploadTarget, 0);
+}
+
+void BufferManager::freeStatic(const BufferAllocation& allocation) {
+    if (!allocation.isValid()) {
+        return;
+    }
+
+    Page* page = findPage(allocation.buffer);
+    if (!page) {
+        return;
+    }
+
+    // Insert the block and coalesce with its neighbours
+    auto& blocks = page->freeBlocks;
+    std::size_t offset = allocation.offset;
+    std::size_t size = allocation.size;
+
+    auto next = blocks.lower_bound(offset);
+    if (next != blocks.end() && offset + size == next->first) {
+        size += next->second;
+        next = blocks.erase(next);
+    }
+    if (next != blocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            offset = prev->first;
+            size += prev->second;
+            blocks.erase(prev);
+        }
+    }
+    blocks[offset] = size;
+
+    page->used -= allocation.size;
+    page->allocations--;
+    m_staticAllocationCount--;
+
+    // Give empty pages back to the driver. Dedicated pages for oversized
+    // requests always go; one standard page is kept around for reuse.
+    if (page->allocations == 0) {
+        bool dedicated = page->size != m_pageSize;
+        std::size_t standardPages = std::count_if(m_pages.begin(), m_pages.end(),
+            [this](const Page& p) { return p.size == m_pageSize; });
+        if (dedicated || standardPages > 1) {
+            gl::DeleteBuffers(1, &page->buffer);
+            MemoryTracker::instance().untrack(page->memoryId);
+            m_pages.erase(m_pages.begin() + (page - m_pages.data()));
+        }
+    }
+}
+
+void BufferManager::beginFrame(int frameSlot) {
+    m_streamFrame = frameSlot % m_streamFrameCount;
+    m_streamCursor = 0;
+    m_stats.streamFrameBytes = 0;
+
+    if (!m_streamBuffer) {
+        return;
+    }
+
+    // A segment overflowed last frame or the slot count changed: recreate
+    // the ring. The old buffer is only released by the driver once the GPU
+    // is done with it.
+    if (m_streamOverflowed || m_streamResize) {
+        if (m_streamOverflowed) {
+            std::size_t frameSize = m_streamFrameSize * 2;
+            while (frameSize < m_stats.streamPeakFrameBytes) {
+                frameSize *= 2;
+            }
+            m_streamFrameSize = frameSize;
+        }
+        destroyStreamBuffer();
+        createStreamBuffer();
+    }
+}
+
+void BufferManager::endFrame() {
+    unmapStream();
+}
+
+void BufferManager::setFrameCount(int frameCount) {
+    frameCount = std::max(frameCount, 1);
+    if (frameCount != m_streamFrameCount) {
+        m_streamFrameCount = frameCount;
+        m_streamFrame %= m_streamFrameCount;
+        m_streamResize = true;
+    }
+}
+
+StreamAllocation BufferManager::mapStream(std::size_t size, std::size_t alignment) {
+    StreamAllocation allocation;
+    if (size == 0 || !ensureStream()) {
+        return allocation;
+    }
+    unmapStream();
+
+    alignment = std::max<std::size_t>(alignment, 1);
+    std::size_t cursor = alignUp(m_streamCursor, alignment);
+    if (cursor + size > m_streamFrameSize) {
+        m_stats.streamOverflows++;
+        m_streamOverflowed = true;
+        m_stats.streamPeakFrameBytes = std::max(m_stats.streamPeakFrameBytes, cursor + size);
+        return allocation;
+    }
+
+    std::size_t offset = static_cast<std::size_t>(m_streamFrame) * m_streamFrameSize + cursor;
+
+    if (m_streamPersistentPtr) {
+        allocation.data = m_streamPersistentPtr + offset;
+    } else {
+        // The fence already guarantees the GPU is done with this segment,
+        // so the driver must not synchronise on the mapping.
+        gl::BindBuffer(kUploadTarget, m_streamBuffer);
+        allocation.data = gl::MapBufferRange(kUploadTarget, static_cast<GLintptr>(offset),
+                                             static_cast<GLsizeiptr>(size),
+                                             GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                             GL_MAP_INVALIDATE_RANGE_BIT);
+        gl::BindBuffer(kUploadTarget, 0);
+        if (!allocation.data) {
+            return StreamAllocation();
+        }
+        m_streamMapped = true;
+    }
+
+    allocation.buffer = m_streamBuffer;
+    allocation.offset = offset;
+    allocation.size = size;
+
+    m_streamCursor = cursor + size;
+    m_stats.streamFrameBytes = m_streamCursor;
+    m_stats.streamPeakFrameBytes = std::max(m_stats.streamPeakFrameBytes, m_streamCursor);
+    return allocation;
+}
+
+void BufferManager::unmapStream() {
+    if (!m_streamMapped) {
+        return;
+    }
+
+    gl::BindBuffer(kUploadTarget, m_streamBuffer);
+    gl::UnmapBuffer(kUploadTarget);
+    gl::BindBuffer(kUploadTarget, 0);
+    m_streamMapped = false;
+}
+
+StreamAllocation BufferManager::uploadStream(const void* data, std::size_t size, std::size_t alignment) {
+    StreamAllocation allocation = mapStream(size, alignment);
+    if (allocation.isValid()) {
+        std::memcpy(allocation.data, data, size);
+        unmapStream();
+        allocation.data = nullptr;
+    }
+    return allocation;
+}
+
+std::size_t BufferManager::getUniformAlignment() {
+    if (m_uniformAlignment == 0 && glfwGetCurrentContext()) {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_uniformAlignment = alignment > 0 ? static_cast<std::size_t>(alignment) : 256;
+    }
+    return m_uniformAlignment ? m_uniformAlignment : 256;
+}
+
+BufferStats BufferManager::getStats() const {
+    BufferStats stats = m_stats;
+
+    stats.staticPageCount = m_pages.size();
+    stats.staticAllocationCount = m_staticAllocationCount;
+    for (const Page& page : m_pages) {
+        stats.staticReservedBytes += page.size;
+        stats.staticUsedBytes += page.used;
+        stats.staticFreeBlockCount += page.freeBlocks.size();
+        for (const auto& block : page.freeBlocks) {
+            stats.staticLargestFreeBlock = std::max(stats.staticLargestFreeBlock, block.second);
+        }
+    }
+
+    stats.streamCapacityBytes = m_streamBuffer ? m_streamFrameSize * m_streamFrameCount : 0;
+    stats.persistentMapping = m_streamPersistentPtr != nullptr;
+    return stats;
+}
+
+void BufferManager::release() {
+    if (!gl::isLoaded()) {
+        return;
+    }
+
+    for (Page& page : m_pages) {
+        gl::DeleteBuffers(1, &page.buffer);
+        MemoryTracker::instance().untrack(page.memoryId);
+    }
+    m_pages.clear();
+    m_staticAllocationCount = 0;
+
+    destroyStreamBuffer();
+}
+
+bool BufferManager::ensureStream() {
+    if (m_streamBuffer) {
+        return true;
+    }
+    if (!gl::load()) {
+        return false;
+    }
+    createStreamBuffer();
+    return m_streamBuffer != 0;
+}
+
+void BufferManager::createStreamBuffer() {
+    std::size_t capacity = m_streamFrameSize * m_streamFrameCount;
+
+    gl::GenBuffers(1, &m_streamBuffer);
+    gl::BindBuffer(kUploadTarget, m_streamBuffer);
+
+    // Prefer one persistent, coherent mapping for the lifetime of the ring
+    if (gl::BufferStorage && glfwExtensionSupported("GL_ARB_buffer_storage")) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        gl::BufferStorage(kUploadTarget, static_cast<GLsizeiptr>(capacity), nullptr, flags);
+        m_streamPersistentPtr = static_cast<unsigned char*>(
+            gl::MapBufferRange(kUploadTarget, 0, static_cast<GLsizeiptr>(capacity), flags));
+    }
+    if (!m_streamPersistentPtr) {
+        gl::BufferData(kUploadTarget, static_cast<GLsizeiptr>(capacity), nullptr, GL_STREAM_DRAW);
+    }
+
+    gl::BindBuffer(kUploadTarget, 0);
+    m_streamMemoryId = MemoryTracker::instance().track(MemoryCategory::VertexBuffers, capacity,
+                                                       "BufferManager streaming ring");
+
+    m_streamCursor = 0;
+    m_streamOverflowed = false;
+    m_streamResize = false;
+    m_stats.streamFrameBytes = 0;
+}
+
+void BufferManager::destroyStreamBuffer() {
+    if (!m_streamBuffer) {
+        return;
+    }
+
+    unmapStream();
+    if (m_streamPersistentPtr) {
+        gl::BindBuffer(kUploadTarget, m_streamBuffer);
+        gl::UnmapBuffer(kUploadTarget);
+        gl::BindBuffer(kUploadTarget, 0);
+        m_streamPersistentPtr = nullptr;
+    }
+
+    gl::DeleteBuffers(1, &m_streamBuffer);
+    m_streamBuffer = 0;
+    MemoryTracker::instance().untrack(m_streamMemoryId);
+    m_streamMemoryId = 0;
+}
+
+BufferManager::Page* BufferManager::findPage(GLuint buffer) {
+    for (Page& page : m_pages) {
+        if (page.buffer == buffer) {
+            return &page;
+        }
+    }
+    return nullptr;
+}
+
+bool BufferManager::allocateFromPage(Page& page, std::size_t size, std::size_t alignment,
+                                     BufferAllocation& allocation) {
+    // Best fit keeps large blocks intact for large meshes
+    auto best = page.freeBlocks.end();
+    for (auto it = page.freeBlocks.begin(); it != page.freeBlocks.end(); ++it) {
+        std::size_t aligned = alignUp(it->first, alignment);
+        std::size_t padding = aligned - it->first;
+        if (it->second < padding + size) {
+            continue;
+        }
+        if (best == page.freeBlocks.end() || it->second < best->second) {
+            best = it;
+        }
+    }
+    if (best == page.freeBlocks.end()) {
+        return false;
+    }
+
+    std::size_t blockOffset = best->first;
+    std::size_t blockSize = best->second;
+    std::size_t aligned = alignUp(blockOffset, alignment);
+    std::size_t padding = aligned - blockOffset;
+    page.freeBlocks.erase(best);
+
+    // Alignment padding and the tail stay on the free-list
+    if (padding > 0) {
+        page.freeBlocks[blockOffset] = padding;
+    }
+    std::size_t tail = blockSize - padding - size;
+    if (tail > 0) {
+        page.freeBlocks[aligned + size] = tail;
+    }
+
+    allocation.buffer = page.buffer;
+    allocation.offset = aligned;
+    allocation.size = size;
+
+    page.used += size;
+    page.allocations++;
+    m_staticAllocationCount++;
+    return true;
+}
+
+} // namespace crazy
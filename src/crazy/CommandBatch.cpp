@@ -0,0 +1,103 @@
+#include "crazy/CommandBatch.hpp"
+#include "crazy/Log.hpp"
+#include "crazy/NodeRuntime.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace crazy {
+
+namespace {
+
+// Weight of the newest sample in the moving average
+constexpr double kLatencySmoothing = 0.1;
+
+} // namespace
+
+CommandBatch::CommandBatch(std::uint32_t capacity)
+    : m_memory(RingChannel::requiredSize(capacity), "crazy-commands")
+    , m_channel(m_memory.getData(), m_memory.getSize(), true)
+    , m_hasPending(false)
+{
+}
+
+bool CommandBatch::attach(NodeRuntime& runtime, const std::string& name) {
+    if (!m_channel.isValid() || name.empty()) {
+        return false;
+    }
+    if (!runtime.shareMemory(name, m_memory.getData(), m_memory.getSize())) {
+        return false;
+    }
+
+    // crazy.flush<Name>(pendingMilliseconds, overflow)
+    std::string function = "flush" + name;
+    function[5] = static_cast<char>(std::toupper(static_cast<unsigned char>(function[5])));
+    runtime.registerFunction(function, [this](const std::vector<NodeValue>& args) {
+        double pendingTime = args.size() > 0 ? args[0].asNumber() / 1000.0 : 0.0;
+        bool overflow = args.size() > 1 && args[1].asBoolean();
+        flush(pendingTime, overflow);
+        return NodeValue();
+    });
+    return true;
+}
+
+void CommandBatch::setHandler(Handler handler) {
+    m_handler = std::move(handler);
+}
+
+std::uint32_t CommandBatch::apply() {
+    std::uint32_t count = 0;
+    if (m_handler) {
+        count = static_cast<std::uint32_t>(m_channel.drain(m_handler));
+    } else {
+        count = static_cast<std::uint32_t>(m_channel.drain([](const void*, std::uint32_t) {}));
+        if (count > 0) {
+            CRAZY_LOG_WARNING("CommandBatch: {} commands discarded, no handler set", count);
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    ++m_stats.batches;
+    m_stats.commands += count;
+    m_stats.lastBatchSize = count;
+    m_stats.maxBatchSize = std::max(m_stats.maxBatchSize, count);
+
+    if (m_hasPending) {
+        double latency = std::chrono::duration<double>(Clock::now() - m_oldestPending).count();
+        m_stats.lastLatency = latency;
+        m_stats.averageLatency = m_stats.batches == 1
+            ? latency
+            : m_stats.averageLatency + (latency - m_stats.averageLatency) * kLatencySmoothing;
+        m_stats.maxLatency = std::max(m_stats.maxLatency, latency);
+        m_hasPending = false;
+    }
+    return count;
+}
+
+void CommandBatch::flush(double pendingTime, bool overflow) {
+    ++m_stats.flushes;
+    if (!m_hasPending) {
+        m_oldestPending = Clock::now()
+            - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(std::max(pendingTime, 0.0)));
+        m_hasPending = true;
+    }
+    if (overflow) {
+        ++m_stats.overflowFlushes;
+        apply();
+    }
+}
+
+RingChannel& CommandBatch::getChannel() {
+    return m_channel;
+}
+
+const CommandBatchStats& CommandBatch::getStats() const {
+    return m_stats;
+}
+
+void CommandBatch::resetStats() {
+    m_stats = CommandBatchStats();
+}
+
+} // namespace crazy
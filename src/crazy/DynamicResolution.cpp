@@ -0,0 +1,302 @@
+#include "crazy/DynamicResolution.hpp"
+#include "GLShader.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace crazy {
+
+namespace {
+
+// Catmull-Rom upscale using 9 bilinear taps instead of 16 point taps.
+// Taps are clamped to the rendered sub-rectangle so the unused part of the
+// target never bleeds into the edges.
+const char* const kBicubicFragmentShader = R"(#version 330 core
+uniform sampler2D uSource;
+uniform vec2 uSourceSize;
+uniform vec4 uSourceRect;
+in vec2 vUV;
+out vec4 fragColor;
+
+vec2 clampToRect(vec2 texel) {
+    return clamp(texel, uSourceRect.xy + 0.5, uSourceRect.zw - 0.5) / uSourceSize;
+}
+
+void main() {
+    vec2 samplePos = mix(uSourceRect.xy, uSourceRect.zw, vUV);
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+
+    vec2 t0 = clampToRect(texPos1 - 1.0);
+    vec2 t12 = clampToRect(texPos1 + w2 / w12);
+    vec2 t3 = clampToRect(texPos1 + 2.0);
+
+    vec4 result = vec4(0.0);
+    result += texture(uSource, vec2(t0.x, t0.y)) * w0.x * w0.y;
+    result += texture(uSource, vec2(t12.x, t0.y)) * w12.x * w0.y;
+    result += texture(uSource, vec2(t3.x, t0.y)) * w3.x * w0.y;
+    result += texture(uSource, vec2(t0.x, t12.y)) * w0.x * w12.y;
+    result += texture(uSource, vec2(t12.x, t12.y)) * w12.x * w12.y;
+    result += texture(uSource, vec2(t3.x, t12.y)) * w3.x * w12.y;
+    result += texture(uSource, vec2(t0.x, t3.y)) * w0.x * w3.y;
+    result += texture(uSource, vec2(t12.x, t3.y)) * w12.x * w3.y;
+    result += texture(uSource, vec2(t3.x, t3.y)) * w3.x * w3.y;
+    fragColor = max(result, vec4(0.0));
+}
+)";
+
+// Weight of a new sample in the smoothed frame time
+const double kSmoothing = 0.2;
+
+} // namespace
+
+DynamicResolution::DynamicResolution()
+    : m_enabled(false)
+    , m_scale(1.0f)
+    , m_framesOverBudget(0)
+    , m_framesUnderBudget(0)
+    , m_smoothedFrameTime(0.0)
+    , m_target(true)
+    , m_outputWidth(0)
+    , m_outputHeight(0)
+    , m_renderWidth(0)
+    , m_renderHeight(0)
+    , m_inScene(false)
+    , m_program(0)
+    , m_vertexArray(0)
+    , m_sourceLocation(-1)
+    , m_sourceSizeLocation(-1)
+    , m_sourceRectLocation(-1)
+{
+    m_scale = m_settings.maxScale;
+}
+
+DynamicResolution::~DynamicResolution() {
+    release();
+}
+
+void DynamicResolution::setEnabled(bool enabled) {
+    m_enabled = enabled;
+    m_framesOverBudget = 0;
+    m_framesUnderBudget = 0;
+    m_smoothedFrameTime = 0.0;
+}
+
+bool DynamicResolution::isEnabled() const {
+    return m_enabled;
+}
+
+void DynamicResolution::setSettings(const DynamicResolutionSettings& settings) {
+    m_settings = settings;
+    m_settings.minScale = std::clamp(m_settings.minScale, 0.1f, 1.0f);
+    m_settings.maxScale = std::clamp(m_settings.maxScale, m_settings.minScale, 1.0f);
+    m_settings.scaleStep = std::max(m_settings.scaleStep, 0.01f);
+    m_scale = clampScale(m_scale);
+}
+
+const DynamicResolutionSettings& DynamicResolution::getSettings() const {
+    return m_settings;
+}
+
+float DynamicResolution::getScale() const {
+    return m_enabled ? m_scale : 1.0f;
+}
+
+void DynamicResolution::setScale(float scale) {
+    m_scale = clampScale(scale);
+    m_framesOverBudget = 0;
+    m_framesUnderBudget = 0;
+}
+
+int DynamicResolution::getRenderWidth() const {
+    return m_enabled ? m_renderWidth : m_outputWidth;
+}
+
+int DynamicResolution::getRenderHeight() const {
+    return m_enabled ? m_renderHeight : m_outputHeight;
+}
+
+void DynamicResolution::beginScene(int outputWidth, int outputHeight) {
+    m_outputWidth = outputWidth;
+    m_outputHeight = outputHeight;
+    m_renderWidth = outputWidth;
+    m_renderHeight = outputHeight;
+
+    if (!m_enabled || outputWidth <= 0 || outputHeight <= 0) {
+        return;
+    }
+
+    // Storage at least the window size: scale changes only move the
+    // viewport, and window resizes reallocate in buckets, not every frame
+    if (!m_target.ensureSize(outputWidth, outputHeight)) {
+        return;
+    }
+
+    m_renderWidth = std::max(1, static_cast<int>(std::lround(outputWidth * m_scale)));
+    m_renderHeight = std::max(1, static_cast<int>(std::lround(outputHeight * m_scale)));
+
+    m_target.bind();
+    glViewport(0, 0, m_renderWidth, m_renderHeight);
+
+    // Scissor so clears only touch the pixels that are actually rendered
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, m_renderWidth, m_renderHeight);
+
+    m_inScene = true;
+}
+
+void DynamicResolution::endScene() {
+    if (!m_inScene) {
+        return;
+    }
+    m_inScene = false;
+
+    glDisable(GL_SCISSOR_TEST);
+
+    if (m_settings.filter == UpscaleFilter::Bicubic && m_program == 0) {
+        m_program = gl::createProgram(gl::kFullscreenVertexShader, kBicubicFragmentShader,
+                                      "dynamic resolution upscale");
+        if (m_program) {
+            m_sourceLocation = gl::GetUniformLocation(m_program, "uSource");
+            m_sourceSizeLocation = gl::GetUniformLocation(m_program, "uSourceSize");
+            m_sourceRectLocation = gl::GetUniformLocation(m_program, "uSourceRect");
+            gl::GenVertexArrays(1, &m_vertexArray);
+        } else {
+            // Don't retry every frame
+            m_settings.filter = UpscaleFilter::Bilinear;
+        }
+    }
+
+    if (m_settings.filter == UpscaleFilter::Bicubic && m_program) {
+        upscaleBicubic();
+    } else {
+        upscaleBilinear();
+    }
+
+    RenderTarget::bindDefault();
+    glViewport(0, 0, m_outputWidth, m_outputHeight);
+}
+
+void DynamicResolution::update(double cpuFrameTime, double gpuFrameTime) {
+    if (!m_enabled) {
+        return;
+    }
+
+    double frameTime = std::max(cpuFrameTime, gpuFrameTime);
+    if (frameTime <= 0.0) {
+        return;
+    }
+
+    m_smoothedFrameTime = m_smoothedFrameTime > 0.0
+        ? m_smoothedFrameTime + (frameTime - m_smoothedFrameTime) * kSmoothing
+        : frameTime;
+
+    const double budget = m_settings.targetFrameTime;
+
+    if (frameTime > budget * m_settings.upperThreshold) {
+        m_framesUnderBudget = 0;
+        if (++m_framesOverBudget < m_settings.scaleDownDelay) {
+            return;
+        }
+
+        // Cost is proportional to pixel count, i.e. scale squared: aim for
+        // the middle of the hysteresis band in one step.
+        double goal = budget * 0.5 * (m_settings.upperThreshold + m_settings.lowerThreshold);
+        double load = std::max(m_smoothedFrameTime, frameTime);
+        float desired = static_cast<float>(m_scale * std::sqrt(goal / load));
+        float quantized = std::floor(desired / m_settings.scaleStep) * m_settings.scaleStep;
+        m_scale = clampScale(std::min(quantized, m_scale - m_settings.scaleStep));
+
+        m_framesOverBudget = 0;
+        m_smoothedFrameTime = 0.0;
+    } else if (frameTime < budget * m_settings.lowerThreshold) {
+        m_framesOverBudget = 0;
+        if (++m_framesUnderBudget < m_settings.scaleUpDelay) {
+            return;
+        }
+
+        // Recover slowly so a single cheap frame doesn't undo the scaling
+        m_scale = clampScale(m_scale + m_settings.scaleStep);
+        m_framesUnderBudget = 0;
+    } else {
+        m_framesOverBudget = 0;
+        m_framesUnderBudget = 0;
+    }
+}
+
+RenderTarget& DynamicResolution::getRenderTarget() {
+    return m_target;
+}
+
+void DynamicResolution::release() {
+    if (gl::isLoaded()) {
+        if (m_program) {
+            gl::DeleteProgram(m_program);
+            m_program = 0;
+        }
+        if (m_vertexArray) {
+            gl::DeleteVertexArrays(1, &m_vertexArray);
+            m_vertexArray = 0;
+        }
+    }
+    m_target.release();
+}
+
+float DynamicResolution::clampScale(float scale) const {
+    return std::clamp(scale, m_settings.minScale, m_settings.maxScale);
+}
+
+void DynamicResolution::upscaleBicubic() {
+    // Save the state the pass touches
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    GLint program = 0;
+    GLint vertexArray = 0;
+    GLint activeTexture = 0;
+    GLint texture = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+    gl::ActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+
+    RenderTarget::bindDefault();
+    glViewport(0, 0, m_outputWidth, m_outputHeight);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    gl::UseProgram(m_program);
+    gl::Uniform1i(m_sourceLocation, 0);
+    gl::Uniform2f(m_sourceSizeLocation, static_cast<float>(m_target.getWidth()),
+                  static_cast<float>(m_target.getHeight()));
+    gl::Uniform4f(m_sourceRectLocation, 0.0f, 0.0f, static_cast<float>(m_renderWidth),
+                  static_cast<float>(m_renderHeight));
+    glBindTexture(GL_TEXTURE_2D, m_target.getColorTexture());
+    gl::BindVertexArray(m_vertexArray);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // Restore
+    gl::BindVertexArray(static_cast<GLuint>(vertexArray));
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(texture));
+    gl::ActiveTexture(static_cast<GLenum>(activeTexture));
+    gl::UseProgram(static_cast<GLuint>(program));
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    if (blend) glEnable(GL_BLEND);
+}
+
+void DynamicResolution::upscaleBilinear() {
+    bool identity = m_renderWidth == m_outputWidth && m_renderHeight == m_outputHeight;
+
+    gl::BindFramebuffer(GL_READ_FRAMEBUFFER, m_target.getFramebuffer());
+    gl::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    gl::BlitFramebuffer(0, 0, m_renderWidth, m_renderHeight,
+                        0, 0, m_outputWidth, m_outputHeight,
+                        GL_COLOR_BUFFER_BIT, identity ? GL_NEAREST : GL_LINEAR);
+}
+
+} // namespace crazy
@@ -10,9 +10,14 @@ EventHandler::EventHandler()
     , m_mouseButtonPressCallback(nullptr)
     , m_mouseButtonReleaseCallback(nullptr)
     , m_mouseMoveCallback(nullptr)
+    , m_scrollCallback(nullptr)
     , m_windowResizeCallback(nullptr)
     , m_windowCloseCallback(nullptr)
+    , m_windowRefreshCallback(nullptr)
 {
+    for (double& timestamp : m_pendingInput) {
+        timestamp = -1.0;
+    }
 }
 
 EventHandler::~EventHandler() {
@@ -28,8 +33,10 @@ void EventHandler::attachToWindow(Window& window) {
         glfwSetKeyCallback(glfwWindow, glfwKeyCallback);
         glfwSetMouseButtonCallback(glfwWindow, glfwMouseButtonCallback);
         glfwSetCursorPosCallback(glfwWindow, glfwCursorPosCallback);
+        glfwSetScrollCallback(glfwWindow, glfwScrollCallback);
         glfwSetFramebufferSizeCallback(glfwWindow, glfwFramebufferSizeCallback);
         glfwSetWindowCloseCallback(glfwWindow, glfwWindowCloseCallback);
+        glfwSetWindowRefreshCallback(glfwWindow, glfwWindowRefreshCallback);
     }
 }
 
@@ -57,6 +64,10 @@ void EventHandler::setMouseMoveCallback(MouseMoveCallback callback) {
     m_mouseMoveCallback = callback;
 }
 
+void EventHandler::setScrollCallback(ScrollCallback callback) {
+    m_scrollCallback = callback;
+}
+
 void EventHandler::setWindowResizeCallback(WindowResizeCallback callback) {
     m_windowResizeCallback = callback;
 }
@@ -65,16 +76,38 @@ void EventHandler::setWindowCloseCallback(WindowCloseCallback callback) {
     m_windowCloseCallback = callback;
 }
 
+void EventHandler::setWindowRefreshCallback(WindowRefreshCallback callback) {
+    m_windowRefreshCallback = callback;
+}
+
 void EventHandler::pollEvents() {
     glfwPollEvents();
 }
 
+bool EventHandler::takePendingInput(InputKind kind, double& timestamp) {
+    double& pending = m_pendingInput[static_cast<int>(kind)];
+    if (pending < 0.0) {
+        return false;
+    }
+    timestamp = pending;
+    pending = -1.0;
+    return true;
+}
+
+void EventHandler::notePendingInput(InputKind kind, double timestamp) {
+    double& pending = m_pendingInput[static_cast<int>(kind)];
+    if (pending < 0.0) {
+        pending = timestamp;
+    }
+}
+
 // Static GLFW callbacks
 void EventHandler::glfwKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     EventHandler* handler = getHandlerFromWindow(window);
     if (!handler) return;
     
-    KeyEvent event{key, scancode, mods};
+    KeyEvent event{key, scancode, mods, glfwGetTime()};
+    handler->notePendingInput(InputKind::Key, event.timestamp);
     
     if (action == GLFW_PRESS && handler->m_keyPressCallback) {
         handler->m_keyPressCallback(event);
@@ -89,7 +122,8 @@ void EventHandler::glfwMouseButtonCallback(GLFWwindow* window, int button, int a
     EventHandler* handler = getHandlerFromWindow(window);
     if (!handler) return;
     
-    MouseButtonEvent event{button, mods};
+    MouseButtonEvent event{button, mods, glfwGetTime()};
+    handler->notePendingInput(InputKind::MouseButton, event.timestamp);
     
     if (action == GLFW_PRESS && handler->m_mouseButtonPressCallback) {
         handler->m_mouseButtonPressCallback(event);
@@ -102,12 +136,26 @@ void EventHandler::glfwCursorPosCallback(GLFWwindow* window, double xpos, double
     EventHandler* handler = getHandlerFromWindow(window);
     if (!handler) return;
     
+    MouseMoveEvent event{xpos, ypos, glfwGetTime()};
+    handler->notePendingInput(InputKind::MouseMove, event.timestamp);
+    
     if (handler->m_mouseMoveCallback) {
-        MouseMoveEvent event{xpos, ypos};
         handler->m_mouseMoveCallback(event);
     }
 }
 
+void EventHandler::glfwScrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
+    EventHandler* handler = getHandlerFromWindow(window);
+    if (!handler) return;
+    
+    ScrollEvent event{xoffset, yoffset, glfwGetTime()};
+    handler->notePendingInput(InputKind::Scroll, event.timestamp);
+    
+    if (handler->m_scrollCallback) {
+        handler->m_scrollCallback(event);
+    }
+}
+
 void EventHandler::glfwFramebufferSizeCallback(GLFWwindow* window, int width, int height) {
     EventHandler* handler = getHandlerFromWindow(window);
     if (!handler) return;
@@ -127,6 +175,15 @@ void EventHandler::glfwWindowCloseCallback(GLFWwindow* window) {
     }
 }
 
+void EventHandler::glfwWindowRefreshCallback(GLFWwindow* window) {
+    EventHandler* handler = getHandlerFromWindow(window);
+    if (!handler) return;
+    
+    if (handler->m_windowRefreshCallback) {
+        handler->m_windowRefreshCallback();
+    }
+}
+
 EventHandler* EventHandler::getHandlerFromWindow(GLFWwindow* window) {
     return static_cast<EventHandler*>(glfwGetWindowUserPointer(window));
 }
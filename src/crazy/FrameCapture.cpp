@@ -0,0 +1,578 @@
+#include "crazy/FrameCapture.hpp"
+#include "crazy/Log.hpp"
+#include "crazy/MemoryTracker.hpp"
+#include "GLFunctions.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CRAZY_CAPTURE_SSE2 1
+#endif
+
+namespace crazy {
+
+namespace {
+
+// Upper bound for a single glClientWaitSync call, in nanoseconds
+const GLuint64 kFenceTimeout = 100000000;
+
+// Largest payload of a stored (uncompressed) deflate block
+const std::size_t kStoredBlockSize = 65535;
+
+// Full-range BT.601 (JFIF) coefficients in 8-bit fixed point
+inline std::uint8_t luma(int r, int g, int b) {
+    return static_cast<std::uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+inline std::uint8_t chromaBlue(int r, int g, int b) {
+    return static_cast<std::uint8_t>(std::clamp(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128, 0, 255));
+}
+
+inline std::uint8_t chromaRed(int r, int g, int b) {
+    return static_cast<std::uint8_t>(std::clamp(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128, 0, 255));
+}
+
+void convertLumaScalar(const std::uint8_t* rgba, std::uint8_t* out, int count) {
+    for (int i = 0; i < count; ++i, rgba += 4) {
+        out[i] = luma(rgba[0], rgba[1], rgba[2]);
+    }
+}
+
+#if CRAZY_CAPTURE_SSE2
+// Luma of 4 RGBA pixels as 32-bit lanes
+inline __m128i lumaSse2(__m128i pixels, __m128i coefficients) {
+    const __m128i zero = _mm_setzero_si128();
+    // (r*77 + g*150, b*29 + a*0) per pixel
+    const __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), coefficients);
+    const __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), coefficients);
+    const __m128i rg = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high),
+                                                       _MM_SHUFFLE(2, 0, 2, 0)));
+    const __m128i ba = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high),
+                                                       _MM_SHUFFLE(3, 1, 3, 1)));
+    return _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(rg, ba), _mm_set1_epi32(128)), 8);
+}
+
+void convertLumaSse2(const std::uint8_t* rgba, std::uint8_t* out, int count) {
+    const __m128i coefficients = _mm_setr_epi16(77, 150, 29, 0, 77, 150, 29, 0);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i first = lumaSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4)),
+                                       coefficients);
+        const __m128i second = lumaSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4 + 16)),
+                                        coefficients);
+        const __m128i words = _mm_packs_epi32(first, second);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(words, words));
+    }
+    convertLumaScalar(rgba + i * 4, out + i, count - i);
+}
+#endif
+
+// Chroma of one output row from the two source rows it covers
+void convertChroma(const std::uint8_t* top, const std::uint8_t* bottom, int width,
+                   std::uint8_t* blue, std::uint8_t* red) {
+    for (int x = 0; x < width; x += 2) {
+        const int right = std::min(x + 1, width - 1) * 4;
+        const int left = x * 4;
+        const int r = (top[left] + top[right] + bottom[left] + bottom[right] + 2) >> 2;
+        const int g = (top[left + 1] + top[right + 1] + bottom[left + 1] + bottom[right + 1] + 2) >> 2;
+        const int b = (top[left + 2] + top[right + 2] + bottom[left + 2] + bottom[right + 2] + 2) >> 2;
+        blue[x / 2] = chromaBlue(r, g, b);
+        red[x / 2] = chromaRed(r, g, b);
+    }
+}
+
+std::uint32_t crc32(std::uint32_t crc, const std::uint8_t* data, std::size_t size) {
+    static const auto s_table = [] {
+        std::vector<std::uint32_t> table(256);
+        for (std::uint32_t n = 0; n < 256; ++n) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return table;
+    }();
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i) {
+        crc = s_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void storeBigEndian(std::uint8_t* out, std::uint32_t value) {
+    out[0] = static_cast<std::uint8_t>(value >> 24);
+    out[1] = static_cast<std::uint8_t>(value >> 16);
+    out[2] = static_cast<std::uint8_t>(value >> 8);
+    out[3] = static_cast<std::uint8_t>(value);
+}
+
+} // namespace
+
+FrameCapture::FrameCapture()
+    : m_nextSlot(0)
+    , m_frameIndex(0)
+    , m_width(0)
+    , m_height(0)
+    , m_active(false)
+    , m_stopping(false)
+    , m_file(nullptr)
+    , m_headerWritten(false)
+    , m_frames(0)
+    , m_readBack(0)
+    , m_written(0)
+    , m_droppedGpu(0)
+    , m_droppedWriter(0)
+    , m_droppedSize(0)
+    , m_bytesWritten(0)
+    , m_writeFailed(false)
+{
+}
+
+FrameCapture::~FrameCapture() {
+    release();
+}
+
+bool FrameCapture::start(const FrameCaptureSettings& settings) {
+    if (m_active) {
+        CRAZY_LOG_WARNING("FrameCapture: already capturing");
+        return false;
+    }
+    if (!gl::isLoaded()) {
+        CRAZY_LOG_ERROR("FrameCapture: OpenGL functions not loaded");
+        return false;
+    }
+    if (settings.path.empty()) {
+        CRAZY_LOG_ERROR("FrameCapture: no output path");
+        return false;
+    }
+
+    m_settings = settings;
+    m_settings.bufferCount = std::max(settings.bufferCount, 2);
+    m_settings.maxQueuedFrames = std::max<std::size_t>(settings.maxQueuedFrames, 1);
+    m_settings.frameRate = std::max(settings.frameRate, 1);
+
+    m_file = nullptr;
+    if (m_settings.format == CaptureFormat::Y4M) {
+        m_file = std::fopen(m_settings.path.c_str(), "wb");
+        if (!m_file) {
+            CRAZY_LOG_ERROR("FrameCapture: cannot open {}", m_settings.path.c_str());
+            return false;
+        }
+    }
+
+    // Buffers of a previous capture are reused when the count matches
+    if (m_slots.size() != static_cast<std::size_t>(m_settings.bufferCount)) {
+        release();
+        m_slots.resize(m_settings.bufferCount);
+    }
+    m_nextSlot = 0;
+    m_frameIndex = 0;
+    m_width = 0;
+    m_height = 0;
+    m_headerWritten = false;
+    m_stopping = false;
+
+    m_frames = 0;
+    m_readBack = 0;
+    m_written = 0;
+    m_droppedGpu = 0;
+    m_droppedWriter = 0;
+    m_droppedSize = 0;
+    m_bytesWritten = 0;
+    m_writeFailed = false;
+
+    m_thread = std::thread(&FrameCapture::run, this);
+    m_active = true;
+    CRAZY_LOG_INFO("FrameCapture: recording to {}", m_settings.path.c_str());
+    return true;
+}
+
+void FrameCapture::stop() {
+    if (!m_active) {
+        return;
+    }
+
+    // Frames still on the GPU are part of the recording
+    for (std::size_t i = 0; i < m_slots.size(); ++i) {
+        collect(m_slots[(m_nextSlot + i) % m_slots.size()], true);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+    m_active = false;
+
+    FrameCaptureStats stats = getStats();
+    CRAZY_LOG_INFO("FrameCapture: {} of {} frames written to {} ({} dropped on the GPU, {} by the writer, {} on resize)",
+                   stats.written, stats.frames, m_settings.path.c_str(), stats.droppedGpu, stats.droppedWriter,
+                   stats.droppedSize);
+}
+
+bool FrameCapture::isActive() const {
+    return m_active;
+}
+
+void FrameCapture::capture(int width, int height) {
+    if (!m_active || width <= 0 || height <= 0) {
+        return;
+    }
+    const std::uint64_t index = m_frameIndex++;
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+
+    // Hand over completed readbacks, oldest first, without waiting
+    for (std::size_t i = 0; i < m_slots.size(); ++i) {
+        collect(m_slots[(m_nextSlot + i) % m_slots.size()], false);
+    }
+
+    // A Y4M stream has one size for its whole length
+    if (m_settings.format == CaptureFormat::Y4M) {
+        if (m_width == 0) {
+            m_width = width;
+            m_height = height;
+        } else if (width != m_width || height != m_height) {
+            if (m_droppedSize.fetch_add(1, std::memory_order_relaxed) == 0) {
+                CRAZY_LOG_WARNING("FrameCapture: window resized to {}x{}, dropping frames until it is {}x{} again",
+                                  width, height, m_width, m_height);
+            }
+            return;
+        }
+    }
+
+    // The oldest buffer is next; if the GPU still owns it, skip rather than stall
+    Slot& slot = m_slots[m_nextSlot];
+    if (slot.pending) {
+        m_droppedGpu.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // The readback must not leak state into the application's rendering
+    GLint previousPackBuffer = 0;
+    GLint previousReadFramebuffer = 0;
+    GLint previousReadBuffer = GL_BACK;
+    GLint previousAlignment = 4;
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &previousPackBuffer);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousReadFramebuffer);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &previousAlignment);
+
+    const std::size_t size = static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4;
+    if (!slot.buffer) {
+        gl::GenBuffers(1, &slot.buffer);
+    }
+    gl::BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.capacity < size) {
+        gl::BufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ);
+        slot.capacity = size;
+        if (slot.memoryId) {
+            MemoryTracker::instance().resize(slot.memoryId, size);
+        } else {
+            slot.memoryId = MemoryTracker::instance().track(MemoryCategory::FramebufferLayers, size,
+                                                            "FrameCapture pixel buffer");
+        }
+    }
+
+    gl::BindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    // The read buffer belongs to the framebuffer, so it is saved once bound
+    glGetIntegerv(GL_READ_BUFFER, &previousReadBuffer);
+    glReadBuffer(GL_BACK);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, previousAlignment);
+    glReadBuffer(static_cast<GLenum>(previousReadBuffer));
+    gl::BindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previousReadFramebuffer));
+    gl::BindBuffer(GL_PIXEL_PACK_BUFFER, static_cast<GLuint>(previousPackBuffer));
+
+    slot.fence = gl::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.index = index;
+    slot.pending = true;
+    m_nextSlot = (m_nextSlot + 1) % m_slots.size();
+}
+
+FrameCaptureStats FrameCapture::getStats() const {
+    FrameCaptureStats stats;
+    stats.frames = m_frames.load(std::memory_order_relaxed);
+    stats.readBack = m_readBack.load(std::memory_order_relaxed);
+    stats.written = m_written.load(std::memory_order_relaxed);
+    stats.droppedGpu = m_droppedGpu.load(std::memory_order_relaxed);
+    stats.droppedWriter = m_droppedWriter.load(std::memory_order_relaxed);
+    stats.droppedSize = m_droppedSize.load(std::memory_order_relaxed);
+    stats.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+    stats.writeFailed = m_writeFailed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FrameCapture::release() {
+    stop();
+    for (Slot& slot : m_slots) {
+        if (gl::isLoaded()) {
+            if (slot.fence) {
+                gl::DeleteSync(slot.fence);
+            }
+            if (slot.buffer) {
+                gl::DeleteBuffers(1, &slot.buffer);
+            }
+        }
+        MemoryTracker::instance().untrack(slot.memoryId);
+    }
+    m_slots.clear();
+    m_freeBuffers.clear();
+}
+
+bool FrameCapture::collect(Slot& slot, bool wait) {
+    if (!slot.pending) {
+        return true;
+    }
+
+    GLenum result = gl::ClientWaitSync(slot.fence, 0, 0);
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+        if (!wait) {
+            return false;
+        }
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        do {
+            result = gl::ClientWaitSync(slot.fence, flags, kFenceTimeout);
+            flags = 0;
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    gl::DeleteSync(slot.fence);
+    slot.fence = nullptr;
+    slot.pending = false;
+
+    Frame frame;
+    frame.width = slot.width;
+    frame.height = slot.height;
+    frame.index = slot.index;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Draining on stop() keeps everything; otherwise a slow disk costs frames, not frame time
+        if (!wait && m_queue.size() >= m_settings.maxQueuedFrames) {
+            m_droppedWriter.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if (!m_freeBuffers.empty()) {
+            frame.pixels = std::move(m_freeBuffers.back());
+            m_freeBuffers.pop_back();
+        }
+    }
+
+    const std::size_t size = static_cast<std::size_t>(slot.width) * static_cast<std::size_t>(slot.height) * 4;
+    frame.pixels.resize(size);
+    gl::BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* mapped = gl::MapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT);
+    if (mapped) {
+        std::memcpy(frame.pixels.data(), mapped, size);
+        gl::UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    gl::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!mapped) {
+        CRAZY_LOG_ERROR("FrameCapture: failed to map pixel buffer");
+        m_droppedGpu.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    m_readBack.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(frame));
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+void FrameCapture::run() {
+    for (;;) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return !m_queue.empty() || m_stopping; });
+            if (m_queue.empty()) {
+                return;
+            }
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        if (!m_writeFailed.load(std::memory_order_relaxed)) {
+            if (write(frame)) {
+                m_written.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                CRAZY_LOG_ERROR("FrameCapture: writing frame {} failed, recording stopped", frame.index);
+                m_writeFailed = true;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_freeBuffers.push_back(std::move(frame.pixels));
+    }
+}
+
+bool FrameCapture::write(const Frame& frame) {
+    return m_settings.format == CaptureFormat::Y4M ? writeY4m(frame) : writePng(frame);
+}
+
+bool FrameCapture::writeY4m(const Frame& frame) {
+    if (!m_headerWritten) {
+        char header[128];
+        const int length = std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+                                         frame.width, frame.height, m_settings.frameRate);
+        if (!writeBytes(m_file, header, static_cast<std::size_t>(length))) {
+            return false;
+        }
+        m_headerWritten = true;
+    }
+
+    const int width = frame.width;
+    const int height = frame.height;
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    const std::size_t lumaSize = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    const std::size_t chromaSize = static_cast<std::size_t>(chromaWidth) * static_cast<std::size_t>(chromaHeight);
+    m_scratch.resize(lumaSize + 2 * chromaSize);
+
+    std::uint8_t* lumaPlane = m_scratch.data();
+    std::uint8_t* bluePlane = lumaPlane + lumaSize;
+    std::uint8_t* redPlane = bluePlane + chromaSize;
+    const std::size_t stride = static_cast<std::size_t>(width) * 4;
+
+    // GL rows run bottom to top, Y4M rows top to bottom
+    auto sourceRow = [&](int y) { return frame.pixels.data() + static_cast<std::size_t>(height - 1 - y) * stride; };
+
+    for (int y = 0; y < height; ++y) {
+#if CRAZY_CAPTURE_SSE2
+        if (m_settings.simd) {
+            convertLumaSse2(sourceRow(y), lumaPlane + static_cast<std::size_t>(y) * width, width);
+            continue;
+        }
+#endif
+        convertLumaScalar(sourceRow(y), lumaPlane + static_cast<std::size_t>(y) * width, width);
+    }
+    for (int y = 0; y < chromaHeight; ++y) {
+        const int top = y * 2;
+        const int bottom = std::min(top + 1, height - 1);
+        convertChroma(sourceRow(top), sourceRow(bottom), width,
+                      bluePlane + static_cast<std::size_t>(y) * chromaWidth,
+                      redPlane + static_cast<std::size_t>(y) * chromaWidth);
+    }
+
+    static const char kFrameHeader[] = "FRAME\n";
+    return writeBytes(m_file, kFrameHeader, sizeof(kFrameHeader) - 1) &&
+           writeBytes(m_file, m_scratch.data(), m_scratch.size());
+}
+
+bool FrameCapture::writePng(const Frame& frame) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "%06llu.png", static_cast<unsigned long long>(frame.index));
+    const std::string path = m_settings.path + suffix;
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        CRAZY_LOG_ERROR("FrameCapture: cannot open {}", path.c_str());
+        return false;
+    }
+
+    // Filter type 0 and RGB for every row, top to bottom
+    const int width = frame.width;
+    const int height = frame.height;
+    const std::size_t rowSize = 1 + static_cast<std::size_t>(width) * 3;
+    m_scratch.resize(rowSize * static_cast<std::size_t>(height));
+    for (int y = 0; y < height; ++y) {
+        const std::uint8_t* source = frame.pixels.data() + static_cast<std::size_t>(height - 1 - y) * width * 4;
+        std::uint8_t* row = m_scratch.data() + static_cast<std::size_t>(y) * rowSize;
+        row[0] = 0;
+        for (int x = 0; x < width; ++x) {
+            row[1 + x * 3] = source[x * 4];
+            row[2 + x * 3] = source[x * 4 + 1];
+            row[3 + x * 3] = source[x * 4 + 2];
+        }
+    }
+
+    bool ok = true;
+    std::uint32_t crc = 0;
+    auto put = [&](const void* data, std::size_t size) {
+        crc = crc32(crc, static_cast<const std::uint8_t*>(data), size);
+        ok = ok && writeBytes(file, data, size);
+    };
+    auto beginChunk = [&](const char* type, std::size_t length) {
+        std::uint8_t header[4];
+        storeBigEndian(header, static_cast<std::uint32_t>(length));
+        ok = ok && writeBytes(file, header, 4);
+        crc = 0;
+        put(type, 4);
+    };
+    auto endChunk = [&]() {
+        std::uint8_t trailer[4];
+        storeBigEndian(trailer, crc);
+        ok = ok && writeBytes(file, trailer, 4);
+    };
+
+    static const std::uint8_t kSignature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    ok = writeBytes(file, kSignature, sizeof(kSignature));
+
+    std::uint8_t header[13] = {};
+    storeBigEndian(header, static_cast<std::uint32_t>(width));
+    storeBigEndian(header + 4, static_cast<std::uint32_t>(height));
+    header[8] = 8;      // Bit depth
+    header[9] = 2;      // Color type: RGB
+    beginChunk("IHDR", sizeof(header));
+    put(header, sizeof(header));
+    endChunk();
+
+    // zlib stream of stored deflate blocks: no compression, no zlib dependency
+    const std::size_t raw = m_scratch.size();
+    const std::size_t blocks = std::max<std::size_t>((raw + kStoredBlockSize - 1) / kStoredBlockSize, 1);
+    beginChunk("IDAT", 2 + raw + blocks * 5 + 4);
+    static const std::uint8_t kZlibHeader[] = {0x78, 0x01};
+    put(kZlibHeader, sizeof(kZlibHeader));
+    std::uint32_t adlerA = 1;
+    std::uint32_t adlerB = 0;
+    for (std::size_t offset = 0, block = 0; block < blocks; ++block) {
+        const std::size_t length = std::min(kStoredBlockSize, raw - offset);
+        const std::uint8_t blockHeader[5] = {
+            static_cast<std::uint8_t>(block + 1 == blocks ? 1 : 0),
+            static_cast<std::uint8_t>(length), static_cast<std::uint8_t>(length >> 8),
+            static_cast<std::uint8_t>(~length), static_cast<std::uint8_t>(~length >> 8)};
+        put(blockHeader, sizeof(blockHeader));
+        put(m_scratch.data() + offset, length);
+        // 5552 bytes is the most that cannot overflow before the modulo
+        for (std::size_t i = 0; i < length;) {
+            const std::size_t end = std::min(length, i + 5552);
+            for (; i < end; ++i) {
+                adlerA += m_scratch[offset + i];
+                adlerB += adlerA;
+            }
+            adlerA %= 65521;
+            adlerB %= 65521;
+        }
+        offset += length;
+    }
+    std::uint8_t adler[4];
+    storeBigEndian(adler, (adlerB << 16) | adlerA);
+    put(adler, sizeof(adler));
+    endChunk();
+
+    beginChunk("IEND", 0);
+    endChunk();
+
+    return std::fclose(file) == 0 && ok;
+}
+
+bool FrameCapture::writeBytes(std::FILE* file, const void* data, std::size_t size) {
+    if (size > 0 && std::fwrite(data, 1, size, file) != size) {
+        return false;
+    }
+    m_bytesWritten.fetch_add(size, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace crazy
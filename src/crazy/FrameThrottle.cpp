@@ -0,0 +1,134 @@
+#include "crazy/FrameThrottle.hpp"
+#include "crazy/Log.hpp"
+#include "crazy/Window.hpp"
+#include <GLFW/glfw3.h>
+#include <utility>
+
+namespace crazy {
+
+const char* toString(ThrottleState state) {
+    switch (state) {
+        case ThrottleState::Full:      return "Full";
+        case ThrottleState::Reduced:   return "Reduced";
+        case ThrottleState::Suspended: return "Suspended";
+        case ThrottleState::Count:     break;
+    }
+    return "Unknown";
+}
+
+FrameThrottle::FrameThrottle()
+    : m_callback(nullptr)
+    , m_fullRateUntil(-1.0)
+    , m_fullRateRequested(false)
+    , m_lastUpdate(-1.0)
+    , m_lastFrame(0.0)
+{
+}
+
+void FrameThrottle::setSettings(const ThrottleSettings& settings) {
+    m_settings = settings;
+}
+
+const ThrottleSettings& FrameThrottle::getSettings() const {
+    return m_settings;
+}
+
+void FrameThrottle::requestFullRate(double duration) {
+    if (duration <= 0.0) {
+        m_fullRateRequested = true;
+        return;
+    }
+    const double until = glfwGetTime() + duration;
+    if (until > m_fullRateUntil) {
+        m_fullRateUntil = until;
+    }
+}
+
+void FrameThrottle::setTransitionCallback(ThrottleCallback callback) {
+    m_callback = std::move(callback);
+}
+
+ThrottleState FrameThrottle::update(Window& window) {
+    const double now = glfwGetTime();
+    accumulate(now);
+
+    const ThrottleState state = evaluate(window, now);
+    // A request for the next frame only is served by this one
+    m_fullRateRequested = false;
+
+    const ThrottleState previous = m_stats.state;
+    if (state != previous) {
+        m_stats.state = state;
+        m_stats.transitions++;
+        m_stats.lastTransitionTime = now;
+        CRAZY_LOG_DEBUG("Frame throttle: {} -> {}", toString(previous), toString(state));
+        if (m_callback) {
+            m_callback(previous, state);
+        }
+    }
+    return state;
+}
+
+void FrameThrottle::countFrame() {
+    m_stats.frames[static_cast<int>(m_stats.state)]++;
+}
+
+void FrameThrottle::wait(Window& window) {
+    switch (m_stats.state) {
+        case ThrottleState::Full:
+        case ThrottleState::Count:
+            return;
+
+        case ThrottleState::Suspended:
+            // Iconify, focus and posted empty events end the wait early
+            glfwWaitEventsTimeout(m_settings.suspendedWakeInterval);
+            return;
+
+        case ThrottleState::Reduced: {
+            const double deadline = m_lastFrame + 1.0 / m_settings.unfocusedFrameRate;
+            double now = glfwGetTime();
+            // Input while unfocused (hover, scroll) must not speed up the rate
+            while (now < deadline && evaluate(window, now) == ThrottleState::Reduced) {
+                glfwWaitEventsTimeout(deadline - now);
+                now = glfwGetTime();
+            }
+            m_lastFrame = now;
+            return;
+        }
+    }
+}
+
+ThrottleState FrameThrottle::getState() const {
+    return m_stats.state;
+}
+
+const ThrottleStats& FrameThrottle::getStats() const {
+    return m_stats;
+}
+
+ThrottleState FrameThrottle::evaluate(Window& window, double now) const {
+    if (!m_settings.enabled) {
+        return ThrottleState::Full;
+    }
+
+    GLFWwindow* native = window.getNativeWindow();
+    if (m_settings.suspendWhenIconified && glfwGetWindowAttrib(native, GLFW_ICONIFIED)) {
+        return ThrottleState::Suspended;
+    }
+    if (m_settings.suspendWhenHidden && !glfwGetWindowAttrib(native, GLFW_VISIBLE)) {
+        return ThrottleState::Suspended;
+    }
+    if (glfwGetWindowAttrib(native, GLFW_FOCUSED) || m_fullRateRequested || now < m_fullRateUntil) {
+        return ThrottleState::Full;
+    }
+    return m_settings.unfocusedFrameRate > 0.0 ? ThrottleState::Reduced : ThrottleState::Suspended;
+}
+
+void FrameThrottle::accumulate(double now) {
+    if (m_lastUpdate >= 0.0 && now > m_lastUpdate) {
+        m_stats.time[static_cast<int>(m_stats.state)] += now - m_lastUpdate;
+    }
+    m_lastUpdate = now;
+}
+
+} // namespace crazy
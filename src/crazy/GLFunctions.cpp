@@ -0,0 +1,48 @@
+#include "GLFunctions.hpp"
+
+namespace crazy {
+namespace gl {
+
+#define CRAZY_GL_DEFINE_FUNCTION(type, name) type name = nullptr;
+CRAZY_GL_REQUIRED_FUNCTIONS(CRAZY_GL_DEFINE_FUNCTION)
+CRAZY_GL_OPTIONAL_FUNCTIONS(CRAZY_GL_DEFINE_FUNCTION)
+#undef CRAZY_GL_DEFINE_FUNCTION
+
+namespace {
+bool s_loaded = false;
+}
+
+bool load() {
+    if (s_loaded) {
+        return true;
+    }
+
+    // Without a current context glfwGetProcAddress has nothing to resolve
+    if (!glfwGetCurrentContext()) {
+        return false;
+    }
+
+    bool complete = true;
+
+#define CRAZY_GL_LOAD_REQUIRED(type, name) \
+    name = reinterpret_cast<type>(glfwGetProcAddress("gl" #name)); \
+    if (!name) complete = false;
+#define CRAZY_GL_LOAD_OPTIONAL(type, name) \
+    name = reinterpret_cast<type>(glfwGetProcAddress("gl" #name));
+
+    CRAZY_GL_REQUIRED_FUNCTIONS(CRAZY_GL_LOAD_REQUIRED)
+    CRAZY_GL_OPTIONAL_FUNCTIONS(CRAZY_GL_LOAD_OPTIONAL)
+
+#undef CRAZY_GL_LOAD_REQUIRED
+#undef CRAZY_GL_LOAD_OPTIONAL
+
+    s_loaded = complete;
+    return s_loaded;
+}
+
+bool isLoaded() {
+    return s_loaded;
+}
+
+} // namespace gl
+} // namespace crazy
@@ -0,0 +1,107 @@
+#ifndef CRAZY_GL_FUNCTIONS_HPP
+#define CRAZY_GL_FUNCTIONS_HPP
+
+#include <GLFW/glfw3.h>
+#if defined(__APPLE__)
+#include <OpenGL/glext.h>
+#else
+#include <GL/glext.h>
+#endif
+
+namespace crazy {
+namespace gl {
+
+/*
+ * OpenGL entry points beyond 1.1 are not exported by every platform's GL
+ * library, so the framework resolves them through glfwGetProcAddress once a
+ * context is current. Each entry is X(pointer type, name) and is looked up as
+ * "gl" #name, e.g. gl::GenBuffers -> glGenBuffers.
+ */
+
+// Entry points required by the framework (all core in OpenGL 3.3)
+#define CRAZY_GL_REQUIRED_FUNCTIONS(X) \
+    X(PFNGLGENBUFFERSPROC, GenBuffers) \
+    X(PFNGLDELETEBUFFERSPROC, DeleteBuffers) \
+    X(PFNGLBINDBUFFERPROC, BindBuffer) \
+    X(PFNGLBUFFERDATAPROC, BufferData) \
+    X(PFNGLBUFFERSUBDATAPROC, BufferSubData) \
+    X(PFNGLMAPBUFFERRANGEPROC, MapBufferRange) \
+    X(PFNGLFLUSHMAPPEDBUFFERRANGEPROC, FlushMappedBufferRange) \
+    X(PFNGLUNMAPBUFFERPROC, UnmapBuffer) \
+    X(PFNGLFENCESYNCPROC, FenceSync) \
+    X(PFNGLCLIENTWAITSYNCPROC, ClientWaitSync) \
+    X(PFNGLDELETESYNCPROC, DeleteSync) \
+    X(PFNGLGENQUERIESPROC, GenQueries) \
+    X(PFNGLDELETEQUERIESPROC, DeleteQueries) \
+    X(PFNGLBEGINQUERYPROC, BeginQuery) \
+    X(PFNGLENDQUERYPROC, EndQuery) \
+    X(PFNGLGETQUERYOBJECTIVPROC, GetQueryObjectiv) \
+    X(PFNGLGETQUERYOBJECTUI64VPROC, GetQueryObjectui64v) \
+    X(PFNGLGENFRAMEBUFFERSPROC, GenFramebuffers) \
+    X(PFNGLDELETEFRAMEBUFFERSPROC, DeleteFramebuffers) \
+    X(PFNGLBINDFRAMEBUFFERPROC, BindFramebuffer) \
+    X(PFNGLFRAMEBUFFERTEXTURE2DPROC, FramebufferTexture2D) \
+    X(PFNGLFRAMEBUFFERRENDERBUFFERPROC, FramebufferRenderbuffer) \
+    X(PFNGLCHECKFRAMEBUFFERSTATUSPROC, CheckFramebufferStatus) \
+    X(PFNGLBLITFRAMEBUFFERPROC, BlitFramebuffer) \
+    X(PFNGLGENRENDERBUFFERSPROC, GenRenderbuffers) \
+    X(PFNGLDELETERENDERBUFFERSPROC, DeleteRenderbuffers) \
+    X(PFNGLBINDRENDERBUFFERPROC, BindRenderbuffer) \
+    X(PFNGLRENDERBUFFERSTORAGEPROC, RenderbufferStorage) \
+    X(PFNGLACTIVETEXTUREPROC, ActiveTexture) \
+    X(PFNGLGENERATEMIPMAPPROC, GenerateMipmap) \
+    X(PFNGLBLENDFUNCSEPARATEPROC, BlendFuncSeparate) \
+    X(PFNGLGENVERTEXARRAYSPROC, GenVertexArrays) \
+    X(PFNGLDELETEVERTEXARRAYSPROC, DeleteVertexArrays) \
+    X(PFNGLBINDVERTEXARRAYPROC, BindVertexArray) \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, EnableVertexAttribArray) \
+    X(PFNGLVERTEXATTRIBPOINTERPROC, VertexAttribPointer) \
+    X(PFNGLVERTEXATTRIBDIVISORPROC, VertexAttribDivisor) \
+    X(PFNGLDRAWARRAYSINSTANCEDPROC, DrawArraysInstanced) \
+    X(PFNGLCREATESHADERPROC, CreateShader) \
+    X(PFNGLDELETESHADERPROC, DeleteShader) \
+    X(PFNGLSHADERSOURCEPROC, ShaderSource) \
+    X(PFNGLCOMPILESHADERPROC, CompileShader) \
+    X(PFNGLGETSHADERIVPROC, GetShaderiv) \
+    X(PFNGLGETSHADERINFOLOGPROC, GetShaderInfoLog) \
+    X(PFNGLCREATEPROGRAMPROC, CreateProgram) \
+    X(PFNGLDELETEPROGRAMPROC, DeleteProgram) \
+    X(PFNGLATTACHSHADERPROC, AttachShader) \
+    X(PFNGLLINKPROGRAMPROC, LinkProgram) \
+    X(PFNGLGETPROGRAMIVPROC, GetProgramiv) \
+    X(PFNGLGETPROGRAMINFOLOGPROC, GetProgramInfoLog) \
+    X(PFNGLUSEPROGRAMPROC, UseProgram) \
+    X(PFNGLGETUNIFORMLOCATIONPROC, GetUniformLocation) \
+    X(PFNGLUNIFORM1IPROC, Uniform1i) \
+    X(PFNGLUNIFORM2FPROC, Uniform2f) \
+    X(PFNGLUNIFORM4FPROC, Uniform4f)
+
+// Entry points that are used when the driver provides them
+#define CRAZY_GL_OPTIONAL_FUNCTIONS(X) \
+    X(PFNGLBUFFERSTORAGEPROC, BufferStorage) \
+    X(PFNGLQUERYCOUNTERPROC, QueryCounter) \
+    X(PFNGLGETINTEGER64VPROC, GetInteger64v)
+
+#define CRAZY_GL_DECLARE_FUNCTION(type, name) extern type name;
+CRAZY_GL_REQUIRED_FUNCTIONS(CRAZY_GL_DECLARE_FUNCTION)
+CRAZY_GL_OPTIONAL_FUNCTIONS(CRAZY_GL_DECLARE_FUNCTION)
+#undef CRAZY_GL_DECLARE_FUNCTION
+
+/**
+ * @brief Resolve all entry points for the current context
+ *
+ * Safe to call repeatedly; only the first successful call does any work.
+ *
+ * @return true if every required entry point was found
+ */
+bool load();
+
+/**
+ * @brief Check whether load() has succeeded
+ */
+bool isLoaded();
+
+} // namespace gl
+} // namespace crazy
+
+#endif // CRAZY_GL_FUNCTIONS_HPP
@@ -0,0 +1,75 @@
+#include "GLShader.hpp"
+#include "crazy/Log.hpp"
+#include <vector>
+
+namespace crazy {
+namespace gl {
+
+const char* const kFullscreenVertexShader = R"(#version 330 core
+out vec2 vUV;
+void main() {
+    vUV = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(vUV * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+namespace {
+
+GLuint compileShader(GLenum type, const char* source, const char* name) {
+    GLuint shader = CreateShader(type);
+    ShaderSource(shader, 1, &source, nullptr);
+    CompileShader(shader);
+
+    GLint status = GL_FALSE;
+    GetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint length = 0;
+        GetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::vector<GLchar> log(length > 0 ? length : 1, '\0');
+        GetShaderInfoLog(shader, static_cast<GLsizei>(log.size()), nullptr, log.data());
+        CRAZY_LOG_ERROR("Failed to compile {} shader '{}': {}",
+                        type == GL_VERTEX_SHADER ? "vertex" : "fragment", name, log.data());
+        DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+} // namespace
+
+GLuint createProgram(const char* vertexSource, const char* fragmentSource, const char* name) {
+    if (!load()) {
+        return 0;
+    }
+
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, vertexSource, name);
+    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, fragmentSource, name);
+    if (!vertex || !fragment) {
+        if (vertex) DeleteShader(vertex);
+        if (fragment) DeleteShader(fragment);
+        return 0;
+    }
+
+    GLuint program = CreateProgram();
+    AttachShader(program, vertex);
+    AttachShader(program, fragment);
+    LinkProgram(program);
+    DeleteShader(vertex);
+    DeleteShader(fragment);
+
+    GLint status = GL_FALSE;
+    GetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint length = 0;
+        GetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::vector<GLchar> log(length > 0 ? length : 1, '\0');
+        GetProgramInfoLog(program, static_cast<GLsizei>(log.size()), nullptr, log.data());
+        CRAZY_LOG_ERROR("Failed to link program '{}': {}", name, log.data());
+        DeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+} // namespace gl
+} // namespace crazy
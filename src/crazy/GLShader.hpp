@@ -0,0 +1,32 @@
+#ifndef CRAZY_GL_SHADER_HPP
+#define CRAZY_GL_SHADER_HPP
+
+#include "GLFunctions.hpp"
+
+namespace crazy {
+namespace gl {
+
+/**
+ * @brief Compile and link a program from vertex and fragment sources
+ *
+ * Compile and link errors are reported on stderr together with the name.
+ *
+ * @param vertexSource GLSL vertex shader source
+ * @param fragmentSource GLSL fragment shader source
+ * @param name Name used in error messages
+ * @return GLuint Program object, or 0 on failure
+ */
+GLuint createProgram(const char* vertexSource, const char* fragmentSource, const char* name);
+
+/**
+ * @brief Vertex shader emitting a full-screen triangle from gl_VertexID
+ *
+ * Outputs vUV in [0, 1]. Draw with glDrawArrays(GL_TRIANGLES, 0, 3) and any
+ * vertex array object bound.
+ */
+extern const char* const kFullscreenVertexShader;
+
+} // namespace gl
+} // namespace crazy
+
+#endif // CRAZY_GL_SHADER_HPP
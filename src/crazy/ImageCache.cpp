@@ -0,0 +1,673 @@
+#include "crazy/ImageCache.hpp"
+#include "crazy/Log.hpp"
+#include "crazy/MemoryTracker.hpp"
+#include "GLFunctions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+namespace crazy {
+
+namespace {
+
+// Larger images are rejected rather than risk a huge allocation
+constexpr int kMaxDimension = 16384;
+
+// A bitmap acquired within this many frames may be waiting for an upload
+// slot, so it is kept even over the CPU budget
+constexpr std::uint64_t kUploadGraceFrames = 2;
+
+std::uint32_t readLe(const std::uint8_t* p, int bytes) {
+    std::uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+// Extracts a channel of a BMP bitfield pixel scaled to 8 bits
+struct BitField {
+    std::uint32_t mask = 0;
+    int shift = 0;
+    std::uint32_t max = 0;
+
+    explicit BitField(std::uint32_t m) : mask(m) {
+        if (mask) {
+            while (!((mask >> shift) & 1u)) {
+                ++shift;
+            }
+            max = mask >> shift;
+        }
+    }
+
+    std::uint8_t get(std::uint32_t pixel, std::uint8_t fallback) const {
+        if (!max) {
+            return fallback;
+        }
+        return static_cast<std::uint8_t>(static_cast<std::uint64_t>((pixel & mask) >> shift) * 255u / max);
+    }
+};
+
+bool decodeBmp(const std::uint8_t* data, std::size_t size, ImageBitmap& bitmap) {
+    if (size < 54) {
+        return false;
+    }
+    const std::uint32_t offset = readLe(data + 10, 4);
+    const std::uint32_t headerSize = readLe(data + 14, 4);
+    const std::int32_t width = static_cast<std::int32_t>(readLe(data + 18, 4));
+    const std::int32_t rawHeight = static_cast<std::int32_t>(readLe(data + 22, 4));
+    const int bpp = static_cast<int>(readLe(data + 28, 2));
+    const std::uint32_t compression = readLe(data + 30, 4);
+    if (headerSize < 40 || width <= 0 || rawHeight == 0 || rawHeight == INT32_MIN) {
+        return false;
+    }
+    const bool topDown = rawHeight < 0;
+    const int height = topDown ? -rawHeight : rawHeight;
+    if (width > kMaxDimension || height > kMaxDimension) {
+        return false;
+    }
+
+    // 24-bit BGR, or 32-bit with the default BGRX or explicit masks
+    BitField red(0x00FF0000u);
+    BitField green(0x0000FF00u);
+    BitField blue(0x000000FFu);
+    BitField alpha(0);
+    if (compression == 3 && bpp == 32) {
+        if (size < 14 + 40 + 12) {
+            return false;
+        }
+        red = BitField(readLe(data + 54, 4));
+        green = BitField(readLe(data + 58, 4));
+        blue = BitField(readLe(data + 62, 4));
+        if (headerSize >= 56 && size >= 70) {
+            alpha = BitField(readLe(data + 66, 4));
+        }
+    } else if (compression != 0 || (bpp != 24 && bpp != 32)) {
+        return false;
+    }
+
+    const std::size_t stride = (static_cast<std::size_t>(width) * bpp + 31) / 32 * 4;
+    if (offset > size || (size - offset) / stride < static_cast<std::size_t>(height)) {
+        return false;
+    }
+
+    bitmap.width = width;
+    bitmap.height = height;
+    bitmap.pixels.resize(static_cast<std::size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        const std::uint8_t* row = data + offset + stride * static_cast<std::size_t>(topDown ? y : height - 1 - y);
+        std::uint8_t* out = bitmap.pixels.data() + static_cast<std::size_t>(y) * width * 4;
+        for (int x = 0; x < width; ++x, out += 4) {
+            if (bpp == 24) {
+                out[0] = row[x * 3 + 2];
+                out[1] = row[x * 3 + 1];
+                out[2] = row[x * 3];
+                out[3] = 255;
+            } else {
+                const std::uint32_t pixel = readLe(row + x * 4, 4);
+                out[0] = red.get(pixel, 0);
+                out[1] = green.get(pixel, 0);
+                out[2] = blue.get(pixel, 0);
+                out[3] = alpha.get(pixel, 255);
+            }
+        }
+    }
+    return true;
+}
+
+// Reads the whitespace-separated header tokens of PNM and PAM files
+class HeaderReader {
+public:
+    HeaderReader(const std::uint8_t* data, std::size_t size) : m_data(data), m_size(size), m_pos(2) {}
+
+    bool token(std::string& out) {
+        skipSpace();
+        out.clear();
+        while (m_pos < m_size && !isSpace(m_data[m_pos])) {
+            out.push_back(static_cast<char>(m_data[m_pos++]));
+        }
+        return !out.empty();
+    }
+
+    bool number(int& out) {
+        std::string text;
+        if (!token(text) || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        out = std::atoi(text.c_str());
+        return true;
+    }
+
+    // The raster starts after exactly one whitespace byte following the header
+    bool endHeader() {
+        if (m_pos >= m_size || !isSpace(m_data[m_pos])) {
+            return false;
+        }
+        ++m_pos;
+        return true;
+    }
+
+    std::size_t position() const {
+        return m_pos;
+    }
+
+private:
+    static bool isSpace(std::uint8_t c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    void skipSpace() {
+        while (m_pos < m_size) {
+            if (isSpace(m_data[m_pos])) {
+                ++m_pos;
+            } else if (m_data[m_pos] == '#') {
+                while (m_pos < m_size && m_data[m_pos] != '\n') {
+                    ++m_pos;
+                }
+            } else {
+                break;
+            }
+        }
+    }
+
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+    std::size_t m_pos;
+};
+
+bool decodeNetpbm(const std::uint8_t* data, std::size_t size, ImageBitmap& bitmap) {
+    HeaderReader header(data, size);
+    int width = 0;
+    int height = 0;
+    int depth = 0;
+    int maxValue = 0;
+    if (data[1] == '5' || data[1] == '6') {
+        depth = data[1] == '5' ? 1 : 3;
+        if (!header.number(width) || !header.number(height) || !header.number(maxValue) || !header.endHeader()) {
+            return false;
+        }
+    } else {
+        std::string key;
+        std::string value;
+        while (header.token(key) && key != "ENDHDR") {
+            if (key == "TUPLTYPE") {
+                header.token(value);
+            } else if (key == "WIDTH") {
+                header.number(width);
+            } else if (key == "HEIGHT") {
+                header.number(height);
+            } else if (key == "DEPTH") {
+                header.number(depth);
+            } else if (key == "MAXVAL") {
+                header.number(maxValue);
+            } else {
+                return false;
+            }
+        }
+        if (key != "ENDHDR" || !header.endHeader()) {
+            return false;
+        }
+    }
+    // 16-bit samples are not supported
+    if (width <= 0 || height <= 0 || width > kMaxDimension || height > kMaxDimension ||
+        depth < 1 || depth > 4 || maxValue < 1 || maxValue > 255) {
+        return false;
+    }
+
+    const std::size_t count = static_cast<std::size_t>(width) * height;
+    if ((size - header.position()) / depth < count) {
+        return false;
+    }
+
+    bitmap.width = width;
+    bitmap.height = height;
+    bitmap.pixels.resize(count * 4);
+    const std::uint8_t* in = data + header.position();
+    std::uint8_t* out = bitmap.pixels.data();
+    auto scale = [maxValue](std::uint8_t v) {
+        return static_cast<std::uint8_t>(std::min<int>(v, maxValue) * 255 / maxValue);
+    };
+    for (std::size_t i = 0; i < count; ++i, in += depth, out += 4) {
+        // Gray, gray + alpha, RGB or RGBA
+        if (depth <= 2) {
+            out[0] = out[1] = out[2] = scale(in[0]);
+            out[3] = depth == 2 ? scale(in[1]) : 255;
+        } else {
+            out[0] = scale(in[0]);
+            out[1] = scale(in[1]);
+            out[2] = scale(in[2]);
+            out[3] = depth == 4 ? scale(in[3]) : 255;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool loadImageFile(const std::string& path, std::vector<std::uint8_t>& data) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    data.clear();
+    std::uint8_t buffer[64 * 1024];
+    std::size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + read);
+    }
+    const bool ok = !std::ferror(file);
+    std::fclose(file);
+    return ok;
+}
+
+bool decodeImage(const std::uint8_t* data, std::size_t size, int maxWidth, int maxHeight, ImageBitmap& bitmap) {
+    if (!data || size < 3) {
+        return false;
+    }
+    bool decoded = false;
+    if (data[0] == 'B' && data[1] == 'M') {
+        decoded = decodeBmp(data, size, bitmap);
+    } else if (data[0] == 'P' && (data[1] == '5' || data[1] == '6' || data[1] == '7')) {
+        decoded = decodeNetpbm(data, size, bitmap);
+    }
+    if (!decoded) {
+        bitmap = ImageBitmap();
+        return false;
+    }
+    downscaleImage(bitmap, maxWidth, maxHeight);
+    return true;
+}
+
+bool downscaleImage(ImageBitmap& bitmap, int maxWidth, int maxHeight) {
+    const int width = bitmap.width;
+    const int height = bitmap.height;
+    double scale = 1.0;
+    if (maxWidth > 0 && width > maxWidth) {
+        scale = std::min(scale, static_cast<double>(maxWidth) / width);
+    }
+    if (maxHeight > 0 && height > maxHeight) {
+        scale = std::min(scale, static_cast<double>(maxHeight) / height);
+    }
+    if (scale >= 1.0) {
+        return false;
+    }
+    int targetWidth = std::max(1, static_cast<int>(std::lround(width * scale)));
+    int targetHeight = std::max(1, static_cast<int>(std::lround(height * scale)));
+    if (maxWidth > 0) {
+        targetWidth = std::min(targetWidth, maxWidth);
+    }
+    if (maxHeight > 0) {
+        targetHeight = std::min(targetHeight, maxHeight);
+    }
+
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(targetWidth) * targetHeight * 4);
+    std::uint8_t* out = pixels.data();
+    for (int ty = 0; ty < targetHeight; ++ty) {
+        const int y0 = static_cast<int>(static_cast<std::int64_t>(ty) * height / targetHeight);
+        const int y1 = std::max(y0 + 1, static_cast<int>(static_cast<std::int64_t>(ty + 1) * height / targetHeight));
+        for (int tx = 0; tx < targetWidth; ++tx, out += 4) {
+            const int x0 = static_cast<int>(static_cast<std::int64_t>(tx) * width / targetWidth);
+            const int x1 = std::max(x0 + 1, static_cast<int>(static_cast<std::int64_t>(tx + 1) * width / targetWidth));
+
+            // Colors are weighted by alpha; a fully transparent box keeps its plain average
+            std::uint64_t weighted[3] = {0, 0, 0};
+            std::uint64_t plain[3] = {0, 0, 0};
+            std::uint64_t alpha = 0;
+            for (int y = y0; y < y1; ++y) {
+                const std::uint8_t* in = bitmap.pixels.data() + (static_cast<std::size_t>(y) * width + x0) * 4;
+                for (int x = x0; x < x1; ++x, in += 4) {
+                    for (int c = 0; c < 3; ++c) {
+                        weighted[c] += static_cast<std::uint64_t>(in[c]) * in[3];
+                        plain[c] += in[c];
+                    }
+                    alpha += in[3];
+                }
+            }
+            const std::uint64_t count = static_cast<std::uint64_t>(x1 - x0) * (y1 - y0);
+            for (int c = 0; c < 3; ++c) {
+                out[c] = static_cast<std::uint8_t>(alpha ? (weighted[c] + alpha / 2) / alpha : (plain[c] + count / 2) / count);
+            }
+            out[3] = static_cast<std::uint8_t>((alpha + count / 2) / count);
+        }
+    }
+
+    bitmap.width = targetWidth;
+    bitmap.height = targetHeight;
+    bitmap.pixels.swap(pixels);
+    return true;
+}
+
+ImageCache::ImageCache(const ImageCacheSettings& settings)
+    : m_settings(settings)
+    , m_loader(loadImageFile)
+    , m_decoder(decodeImage)
+    , m_pool(nullptr)
+    , m_frame(1)
+    , m_generation(0)
+    , m_uploadsThisFrame(0)
+{
+}
+
+ImageCache::~ImageCache() {
+    release();
+}
+
+void ImageCache::setSettings(const ImageCacheSettings& settings) {
+    m_settings = settings;
+}
+
+const ImageCacheSettings& ImageCache::getSettings() const {
+    return m_settings;
+}
+
+void ImageCache::setLoader(ImageLoader loader) {
+    m_loader = loader ? std::move(loader) : ImageLoader(loadImageFile);
+}
+
+void ImageCache::setDecoder(ImageDecoder decoder) {
+    m_decoder = decoder ? std::move(decoder) : ImageDecoder(decodeImage);
+}
+
+ImageStatus ImageCache::acquire(const std::string& source, int maxWidth, int maxHeight, ImageTexture& texture) {
+    const Key key{source, std::max(maxWidth, 0), std::max(maxHeight, 0)};
+
+    auto resident = m_textures.find(key);
+    if (resident != m_textures.end()) {
+        Texture& entry = resident->second;
+        entry.lastUsed = m_frame;
+        m_textureLru.splice(m_textureLru.begin(), m_textureLru, entry.lru);
+        m_stats.gpuHits++;
+        texture = entry.texture;
+        return ImageStatus::Ready;
+    }
+
+    // Every call that finds no texture is a miss, including the frames it stays pending
+    m_stats.gpuMisses++;
+    auto it = m_bitmaps.find(key);
+    if (it == m_bitmaps.end()) {
+        Bitmap* bitmap = request(key);
+        if (bitmap) {
+            bitmap->lastAcquired = m_frame;
+        }
+        return ImageStatus::Pending;
+    }
+    Bitmap& bitmap = it->second;
+    bitmap.lastAcquired = m_frame;
+    if (bitmap.state == BitmapState::Failed) {
+        return ImageStatus::Failed;
+    }
+    if (bitmap.state == BitmapState::Loading) {
+        return ImageStatus::Pending;
+    }
+    m_stats.cpuHits++;
+    m_bitmapLru.splice(m_bitmapLru.begin(), m_bitmapLru, bitmap.lru);
+    if (m_uploadsThisFrame >= m_settings.maxUploadsPerFrame || !upload(key, bitmap.image)) {
+        return ImageStatus::Pending;
+    }
+    texture = m_textures[key].texture;
+    return ImageStatus::Ready;
+}
+
+void ImageCache::prefetch(const std::string& source, int maxWidth, int maxHeight) {
+    const Key key{source, std::max(maxWidth, 0), std::max(maxHeight, 0)};
+    if (m_textures.count(key) || m_bitmaps.count(key)) {
+        return;
+    }
+    request(key);
+}
+
+void ImageCache::update() {
+    ++m_frame;
+    m_uploadsThisFrame = 0;
+
+    std::vector<Completion> completed;
+    {
+        std::lock_guard<std::mutex> lock(m_completedMutex);
+        completed.swap(m_completed);
+    }
+    for (Completion& completion : completed) {
+        m_stats.pending--;
+        if (completion.ok) {
+            m_stats.decodes++;
+        } else {
+            m_stats.failures++;
+        }
+
+        // Dropped by clear() or invalidate() while it was loading
+        auto it = m_bitmaps.find(completion.key);
+        if (it == m_bitmaps.end() || it->second.generation != completion.generation) {
+            continue;
+        }
+        Bitmap& bitmap = it->second;
+        if (completion.ok) {
+            bitmap.state = BitmapState::Ready;
+            bitmap.image = std::move(completion.image);
+            bitmap.bytes = bitmap.image.pixels.size();
+            MemoryTracker::instance().allocate(MemoryCategory::Images, bitmap.bytes);
+            m_stats.cpuBytes += bitmap.bytes;
+            m_stats.bitmaps++;
+            m_bitmapLru.push_front(completion.key);
+            bitmap.lru = m_bitmapLru.begin();
+        } else {
+            bitmap.state = BitmapState::Failed;
+            bitmap.failedFrame = m_frame;
+            m_failed.push_back(completion.key);
+            bitmap.lru = std::prev(m_failed.end());
+        }
+    }
+
+    // Failures are kept only long enough not to reload every frame; the
+    // next acquire() after that loads the source again
+    while (!m_failed.empty()) {
+        auto it = m_bitmaps.find(m_failed.front());
+        if (it->second.failedFrame + static_cast<std::uint64_t>(std::max(m_settings.failedRetryFrames, 0)) > m_frame) {
+            break;
+        }
+        dropBitmap(it);
+    }
+
+    trimBitmaps();
+    trimTextures();
+}
+
+void ImageCache::invalidate(const std::string& source) {
+    for (auto it = m_textures.begin(); it != m_textures.end();) {
+        auto next = std::next(it);
+        if (it->first.source == source) {
+            dropTexture(it);
+        }
+        it = next;
+    }
+    for (auto it = m_bitmaps.begin(); it != m_bitmaps.end();) {
+        auto next = std::next(it);
+        if (it->first.source == source) {
+            dropBitmap(it);
+        }
+        it = next;
+    }
+}
+
+void ImageCache::clear() {
+    while (!m_textures.empty()) {
+        dropTexture(m_textures.begin());
+    }
+    while (!m_bitmaps.empty()) {
+        dropBitmap(m_bitmaps.begin());
+    }
+}
+
+ImageCacheStats ImageCache::getStats() const {
+    return m_stats;
+}
+
+void ImageCache::release() {
+    // Running decodes finish; queued ones are dropped and never complete
+    if (m_pool) {
+        m_pool->shutdown();
+        m_pool.reset();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_completedMutex);
+        m_completed.clear();
+    }
+    m_stats.pending = 0;
+    clear();
+}
+
+ImageCache::Bitmap* ImageCache::request(const Key& key) {
+    if (!m_pool) {
+        TaskPoolSettings settings;
+        settings.threadCount = std::max(m_settings.decodeThreads, 1u);
+        m_pool = std::make_unique<TaskPool>(settings);
+    }
+
+    const std::uint64_t generation = ++m_generation;
+    ImageLoader loader = m_loader;
+    ImageDecoder decoder = m_decoder;
+    bool queued = m_pool->submit([this, key, generation, loader, decoder]() {
+        run(key, generation, loader, decoder);
+    });
+    if (!queued) {
+        // Retried by the next acquire() or prefetch()
+        return nullptr;
+    }
+
+    Bitmap& bitmap = m_bitmaps[key];
+    bitmap.generation = generation;
+    m_stats.cpuMisses++;
+    m_stats.pending++;
+    return &bitmap;
+}
+
+bool ImageCache::upload(const Key& key, const ImageBitmap& image) {
+    GLint previousTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    if (!id) {
+        CRAZY_LOG_ERROR("ImageCache: Cannot create a texture for '{}'", key.source.c_str());
+        return false;
+    }
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+    if (m_settings.mipmaps) {
+        gl::GenerateMipmap(GL_TEXTURE_2D);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_settings.mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previousTexture));
+
+    Texture& entry = m_textures[key];
+    entry.texture.texture = id;
+    entry.texture.width = image.width;
+    entry.texture.height = image.height;
+    entry.bytes = MemoryTracker::estimateTextureSize(image.width, image.height, 4, m_settings.mipmaps);
+    entry.memoryId = MemoryTracker::instance().track(MemoryCategory::Textures, entry.bytes, "Image " + key.source);
+    entry.lastUsed = m_frame;
+    m_textureLru.push_front(key);
+    entry.lru = m_textureLru.begin();
+
+    m_uploadsThisFrame++;
+    m_stats.uploads++;
+    m_stats.gpuBytes += entry.bytes;
+    m_stats.textures++;
+
+    // Make room now rather than at the next frame, sparing what this frame uses
+    trimTextures();
+    return true;
+}
+
+void ImageCache::dropBitmap(std::unordered_map<Key, Bitmap, KeyHash>::iterator it) {
+    Bitmap& bitmap = it->second;
+    if (bitmap.state == BitmapState::Ready) {
+        m_bitmapLru.erase(bitmap.lru);
+    } else if (bitmap.state == BitmapState::Failed) {
+        m_failed.erase(bitmap.lru);
+    }
+    if (bitmap.bytes) {
+        MemoryTracker::instance().deallocate(MemoryCategory::Images, bitmap.bytes);
+        m_stats.cpuBytes -= bitmap.bytes;
+        m_stats.bitmaps--;
+    }
+    m_bitmaps.erase(it);
+}
+
+void ImageCache::dropTexture(std::unordered_map<Key, Texture, KeyHash>::iterator it) {
+    Texture& entry = it->second;
+    glDeleteTextures(1, &entry.texture.texture);
+    MemoryTracker::instance().untrack(entry.memoryId);
+    m_stats.gpuBytes -= entry.bytes;
+    m_stats.textures--;
+    m_textureLru.erase(entry.lru);
+    m_textures.erase(it);
+}
+
+void ImageCache::trimBitmaps() {
+    // Bitmaps acquired in the last frames and not uploaded yet are kept, even
+    // over budget; one that scrolled away before its upload ages out
+    auto lru = m_bitmapLru.end();
+    while (m_stats.cpuBytes > m_settings.cpuBudget && lru != m_bitmapLru.begin()) {
+        --lru;
+        auto it = m_bitmaps.find(*lru);
+        if (it->second.lastAcquired + kUploadGraceFrames > m_frame && !m_textures.count(*lru)) {
+            continue;
+        }
+        auto newer = std::next(lru);
+        dropBitmap(it);
+        lru = newer;
+        m_stats.cpuEvictions++;
+    }
+}
+
+void ImageCache::trimTextures() {
+    // The list is ordered by last use, so once a texture used this frame
+    // is reached, every remaining one was too
+    while (m_stats.gpuBytes > m_settings.gpuBudget && !m_textureLru.empty()) {
+        auto it = m_textures.find(m_textureLru.back());
+        if (it->second.lastUsed == m_frame) {
+            break;
+        }
+        dropTexture(it);
+        m_stats.gpuEvictions++;
+    }
+}
+
+void ImageCache::run(Key key, std::uint64_t generation, ImageLoader loader, ImageDecoder decoder) {
+    Completion completion;
+    completion.key = std::move(key);
+    completion.generation = generation;
+    try {
+        std::vector<std::uint8_t> data;
+        if (!loader(completion.key.source, data)) {
+            CRAZY_LOG_WARNING("ImageCache: Cannot load '{}'", completion.key.source.c_str());
+        } else if (!decoder(data.data(), data.size(), completion.key.width, completion.key.height, completion.image) ||
+                   completion.image.width <= 0 || completion.image.height <= 0 ||
+                   completion.image.pixels.size() != static_cast<std::size_t>(completion.image.width) * completion.image.height * 4) {
+            CRAZY_LOG_WARNING("ImageCache: Cannot decode '{}'", completion.key.source.c_str());
+        } else {
+            // Custom decoders may ignore the target size
+            downscaleImage(completion.image, completion.key.width, completion.key.height);
+            completion.ok = true;
+        }
+    } catch (const std::exception& e) {
+        CRAZY_LOG_ERROR("ImageCache: Loading '{}' threw: {}", completion.key.source.c_str(), e.what());
+    } catch (...) {
+        // Whatever was thrown, the entry must not stay Loading
+        CRAZY_LOG_ERROR("ImageCache: Loading '{}' threw an unknown exception", completion.key.source.c_str());
+        completion.ok = false;
+    }
+    if (!completion.ok) {
+        completion.image = ImageBitmap();
+    }
+
+    std::lock_guard<std::mutex> lock(m_completedMutex);
+    m_completed.push_back(std::move(completion));
+}
+
+} // namespace crazy
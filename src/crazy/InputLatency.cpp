@@ -0,0 +1,50 @@
+#include "crazy/InputLatency.hpp"
+#include <algorithm>
+
+namespace crazy {
+
+const char* toString(InputKind kind) {
+    switch (kind) {
+        case InputKind::Key:         return "Key";
+        case InputKind::MouseButton: return "MouseButton";
+        case InputKind::MouseMove:   return "MouseMove";
+        case InputKind::Scroll:      return "Scroll";
+        case InputKind::Count:       break;
+    }
+    return "Unknown";
+}
+
+void LatencyHistogram::add(double seconds) {
+    seconds = std::max(seconds, 0.0);
+    const int bucket = std::min(static_cast<int>(seconds / kBucketWidth), kBucketCount - 1);
+    buckets[bucket]++;
+    count++;
+    sum += seconds;
+    max = std::max(max, seconds);
+}
+
+double LatencyHistogram::mean() const {
+    return count ? sum / static_cast<double>(count) : 0.0;
+}
+
+double LatencyHistogram::percentile(double fraction) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    const double rank = std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count);
+    std::uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount - 1; ++i) {
+        seen += buckets[i];
+        if (static_cast<double>(seen) >= rank && seen > 0) {
+            return std::min((i + 1) * kBucketWidth, max);
+        }
+    }
+    // Overflow bucket: the only bound known is the maximum
+    return max;
+}
+
+void LatencyHistogram::reset() {
+    *this = LatencyHistogram();
+}
+
+} // namespace crazy
@@ -0,0 +1,548 @@
+#include "crazy/JobSystem.hpp"
+#include "crazy/Log.hpp"
+#include "crazy/MemoryTracker.hpp"
+#include <algorithm>
+#include <exception>
+
+namespace crazy {
+
+struct JobState {
+    JobSystem* system = nullptr;
+    std::function<void()> function;
+    JobState* parent = nullptr;
+    std::atomic<int> references{0};
+    std::atomic<int> blockers{1};       // not-yet-submitted token + unfinished dependencies
+    std::atomic<int> unfinished{1};     // own function + unfinished children
+    std::atomic<bool> submitted{false};
+    std::atomic<bool> done{false};
+
+    std::mutex dependentsMutex;
+    std::vector<JobState*> dependents;  // each holds a reference
+    bool completed = false;             // guarded by dependentsMutex
+
+    // Counted in MemoryCategory::Jobs
+    static void* operator new(std::size_t size) {
+        return MemoryTracker::instance().getResource(MemoryCategory::Jobs)->allocate(size, alignof(JobState));
+    }
+    static void operator delete(void* p, std::size_t size) {
+        MemoryTracker::instance().getResource(MemoryCategory::Jobs)->deallocate(p, size, alignof(JobState));
+    }
+};
+
+namespace {
+
+// Finished jobs are recycled per thread, so steady-state scheduling does
+// not allocate beyond what the job's function captures
+struct JobCache {
+    std::vector<JobState*> free;
+
+    ~JobCache() {
+        for (JobState* job : free) {
+            delete job;
+        }
+    }
+};
+
+constexpr std::size_t kMaxCachedJobs = 1024;
+thread_local JobCache t_jobCache;
+
+thread_local const JobSystem* t_system = nullptr;
+thread_local int t_slot = -1;
+
+JobState* allocateJob(JobSystem* system, std::function<void()> function) {
+    JobState* job;
+    if (!t_jobCache.free.empty()) {
+        job = t_jobCache.free.back();
+        t_jobCache.free.pop_back();
+        job->references.store(0, std::memory_order_relaxed);
+        job->blockers.store(1, std::memory_order_relaxed);
+        job->unfinished.store(1, std::memory_order_relaxed);
+        job->submitted.store(false, std::memory_order_relaxed);
+        job->done.store(false, std::memory_order_relaxed);
+        job->completed = false;
+    } else {
+        job = new JobState();
+    }
+    job->system = system;
+    job->parent = nullptr;
+    job->function = std::move(function);
+    return job;
+}
+
+void retain(JobState* job) {
+    job->references.fetch_add(1, std::memory_order_relaxed);
+}
+
+void release(JobState* job) {
+    if (job->references.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    job->function = nullptr;
+    // A job that never completed still holds its dependents and parent
+    for (JobState* dependent : job->dependents) {
+        release(dependent);
+    }
+    job->dependents.clear();
+    if (job->parent) {
+        release(job->parent);
+        job->parent = nullptr;
+    }
+    if (t_jobCache.free.size() < kMaxCachedJobs) {
+        t_jobCache.free.push_back(job);
+    } else {
+        delete job;
+    }
+}
+
+std::uint32_t roundUpToPowerOfTwo(std::uint32_t value) {
+    std::uint32_t result = 2;
+    while (result < value && result < (1u << 30)) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+// Chase-Lev work-stealing deque with the C11 memory orderings of Lê et al.,
+// "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+// Fixed capacity: push() fails when full instead of growing.
+class JobSystem::Deque {
+public:
+    explicit Deque(std::uint32_t capacity)
+        : m_top(0)
+        , m_bottom(0)
+        , m_buffer(capacity)
+        , m_mask(static_cast<std::int64_t>(capacity) - 1)
+    {
+    }
+
+    // Owner only
+    bool push(JobState* job) {
+        const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const std::int64_t top = m_top.load(std::memory_order_acquire);
+        if (bottom - top > m_mask) {
+            return false;
+        }
+        m_buffer[static_cast<std::size_t>(bottom & m_mask)].store(job, std::memory_order_relaxed);
+        // Publishes the job to thieves (a release store rather than the
+        // paper's fence, which is equivalent here and visible to TSan)
+        m_bottom.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Owner only; takes the most recently pushed job
+    JobState* pop() {
+        const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        JobState* job = m_buffer[static_cast<std::size_t>(bottom & m_mask)].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // Last job: race the thieves for it
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                               std::memory_order_relaxed)) {
+                job = nullptr;
+            }
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    // Any thread; takes the oldest job, or nullptr if empty or lost a race
+    JobState* steal() {
+        std::int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+        JobState* job = m_buffer[static_cast<std::size_t>(top & m_mask)].load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                           std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return job;
+    }
+
+    bool isEmpty() const {
+        return m_bottom.load(std::memory_order_acquire) <= m_top.load(std::memory_order_acquire);
+    }
+
+private:
+    // Owner and thieves write different ends; keep them on separate lines
+    alignas(64) std::atomic<std::int64_t> m_top;
+    alignas(64) std::atomic<std::int64_t> m_bottom;
+    std::vector<std::atomic<JobState*>> m_buffer;
+    std::int64_t m_mask;
+};
+
+JobHandle::JobHandle(JobState* job)
+    : m_job(job)
+{
+    if (m_job) {
+        retain(m_job);
+    }
+}
+
+JobHandle::JobHandle(const JobHandle& other)
+    : m_job(other.m_job)
+{
+    if (m_job) {
+        retain(m_job);
+    }
+}
+
+JobHandle& JobHandle::operator=(JobHandle other) noexcept {
+    std::swap(m_job, other.m_job);
+    return *this;
+}
+
+JobHandle::~JobHandle() {
+    if (m_job) {
+        release(m_job);
+    }
+}
+
+bool JobHandle::isDone() const {
+    return m_job && m_job->done.load(std::memory_order_acquire);
+}
+
+JobSystem::JobSystem(const JobSystemSettings& settings)
+    : m_ownerThread(std::this_thread::get_id())
+    , m_spinCount(std::max<std::uint32_t>(settings.spinCount, 1))
+    , m_overflowSize(0)
+    , m_sleepers(0)
+    , m_epoch(0)
+    , m_stopping(false)
+    , m_executed(0)
+    , m_stolen(0)
+    , m_overflowed(0)
+    , m_parks(0)
+{
+    unsigned count = settings.threadCount;
+    if (count == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        count = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    const std::uint32_t capacity = roundUpToPowerOfTwo(settings.dequeCapacity);
+    for (unsigned slot = 0; slot <= count; ++slot) {
+        m_deques.push_back(std::make_unique<Deque>(capacity));
+    }
+    // Started once every deque exists, since workers steal from all of them
+    m_threads.reserve(count);
+    for (unsigned slot = 1; slot <= count; ++slot) {
+        m_threads.emplace_back([this, slot] { workerLoop(static_cast<int>(slot)); });
+    }
+    CRAZY_LOG_DEBUG("JobSystem: Started {} workers", count);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_parkMutex);
+        m_stopping.store(true, std::memory_order_release);
+        m_epoch.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_parkCondition.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+
+    // Jobs that never started complete without running, so their parents
+    // finish and their dependents are queued, to be dropped in turn
+    std::size_t dropped = 0;
+    while (true) {
+        JobState* job = nullptr;
+        for (std::size_t slot = 0; slot < m_deques.size() && !job; ++slot) {
+            job = m_deques[slot]->steal();
+        }
+        if (!job && !m_overflow.empty()) {
+            job = m_overflow.front();
+            m_overflow.pop_front();
+            m_overflowSize.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (!job) {
+            break;
+        }
+        job->function = nullptr;
+        finish(job);
+        ++dropped;
+    }
+    if (dropped > 0) {
+        CRAZY_LOG_WARNING("JobSystem: {} jobs dropped at shutdown", dropped);
+    }
+}
+
+JobHandle JobSystem::create(std::function<void()> function) {
+    return JobHandle(allocateJob(this, std::move(function)));
+}
+
+JobHandle JobSystem::createChild(const JobHandle& parent, std::function<void()> function) {
+    JobHandle child = create(std::move(function));
+    if (parent.m_job) {
+        parent.m_job->unfinished.fetch_add(1, std::memory_order_relaxed);
+        retain(parent.m_job);
+        child.m_job->parent = parent.m_job;
+    }
+    return child;
+}
+
+bool JobSystem::addDependency(const JobHandle& job, const JobHandle& dependency) {
+    if (!job.m_job || !dependency.m_job || job.m_job == dependency.m_job) {
+        return false;
+    }
+    if (job.m_job->submitted.load(std::memory_order_acquire)) {
+        CRAZY_LOG_WARNING("JobSystem: Dependency added to a submitted job, ignored");
+        return false;
+    }
+
+    job.m_job->blockers.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_job->dependentsMutex);
+        if (!dependency.m_job->completed) {
+            retain(job.m_job);
+            dependency.m_job->dependents.push_back(job.m_job);
+            return true;
+        }
+    }
+    // Already finished; the submit token keeps this above zero
+    job.m_job->blockers.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobSystem::submit(const JobHandle& job) {
+    if (!job.m_job || job.m_job->submitted.exchange(true, std::memory_order_acq_rel)) {
+        return false;
+    }
+    // Released when the job completes
+    retain(job.m_job);
+    if (job.m_job->blockers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        enqueue(job.m_job);
+    }
+    return true;
+}
+
+JobHandle JobSystem::schedule(std::function<void()> function) {
+    JobHandle job = create(std::move(function));
+    submit(job);
+    return job;
+}
+
+JobHandle JobSystem::then(const JobHandle& job, std::function<void()> function) {
+    JobHandle continuation = create(std::move(function));
+    addDependency(continuation, job);
+    submit(continuation);
+    return continuation;
+}
+
+void JobSystem::wait(const JobHandle& job) {
+    if (!job.m_job) {
+        return;
+    }
+    const int slot = currentSlot();
+    std::uint32_t idle = 0;
+    while (!job.m_job->done.load(std::memory_order_acquire)) {
+        if (runOne(slot)) {
+            idle = 0;
+        } else if (++idle < m_spinCount) {
+            std::this_thread::yield();
+        } else {
+            // The remaining work runs elsewhere; don't burn a core on it
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+unsigned JobSystem::getThreadCount() const {
+    return static_cast<unsigned>(m_threads.size());
+}
+
+JobSystemStats JobSystem::getStats() const {
+    JobSystemStats stats;
+    stats.executed = m_executed.load(std::memory_order_relaxed);
+    stats.stolen = m_stolen.load(std::memory_order_relaxed);
+    stats.overflowed = m_overflowed.load(std::memory_order_relaxed);
+    stats.parks = m_parks.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void JobSystem::runParallelFor(std::size_t begin, std::size_t end, std::size_t grainSize,
+                               const std::function<void(std::size_t, std::size_t)>& function) {
+    if (end <= begin) {
+        return;
+    }
+    const std::size_t count = end - begin;
+    const std::size_t threads = m_threads.size() + 1;
+    const std::size_t grain = grainSize > 0 ? grainSize : std::max<std::size_t>(1, count / (threads * 4));
+    if (count <= grain || m_threads.empty()) {
+        function(begin, end);
+        return;
+    }
+
+    JobHandle root = create([] {});
+    for (std::size_t first = begin; first < end; first += grain) {
+        const std::size_t last = std::min(end, first + grain);
+        submit(createChild(root, [&function, first, last] { function(first, last); }));
+    }
+    submit(root);
+    wait(root);
+}
+
+int JobSystem::currentSlot() const {
+    if (t_system == this) {
+        return t_slot;
+    }
+    return std::this_thread::get_id() == m_ownerThread ? 0 : -1;
+}
+
+void JobSystem::enqueue(JobState* job) {
+    const int slot = currentSlot();
+    if (slot < 0 || !m_deques[static_cast<std::size_t>(slot)]->push(job)) {
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        m_overflow.push_back(job);
+        m_overflowSize.fetch_add(1, std::memory_order_release);
+        m_overflowed.fetch_add(1, std::memory_order_relaxed);
+    }
+    wake();
+}
+
+bool JobSystem::runOne(int slot) {
+    JobState* job = slot >= 0 ? m_deques[static_cast<std::size_t>(slot)]->pop() : nullptr;
+
+    if (!job && m_overflowSize.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        if (!m_overflow.empty()) {
+            job = m_overflow.front();
+            m_overflow.pop_front();
+            m_overflowSize.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (!job) {
+        const std::size_t count = m_deques.size();
+        const std::size_t start = slot >= 0 ? static_cast<std::size_t>(slot) + 1 : 0;
+        for (std::size_t offset = 0; offset < count && !job; ++offset) {
+            const std::size_t victim = (start + offset) % count;
+            if (static_cast<int>(victim) != slot && (job = m_deques[victim]->steal())) {
+                m_stolen.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    if (!job) {
+        return false;
+    }
+    execute(job);
+    return true;
+}
+
+void JobSystem::execute(JobState* job) {
+    try {
+        if (job->function) {
+            job->function();
+        }
+    } catch (const std::exception& e) {
+        CRAZY_LOG_ERROR("JobSystem: Job threw: {}", e.what());
+    } catch (...) {
+        CRAZY_LOG_ERROR("JobSystem: Job threw an unknown exception");
+    }
+    m_executed.fetch_add(1, std::memory_order_relaxed);
+    finish(job);
+}
+
+void JobSystem::finish(JobState* job) {
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        complete(job);
+    }
+}
+
+void JobSystem::complete(JobState* job) {
+    std::vector<JobState*> dependents;
+    {
+        std::lock_guard<std::mutex> lock(job->dependentsMutex);
+        job->completed = true;
+        dependents.swap(job->dependents);
+    }
+    job->done.store(true, std::memory_order_release);
+
+    for (JobState* dependent : dependents) {
+        if (dependent->blockers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            enqueue(dependent);
+        }
+        release(dependent);
+    }
+
+    if (JobState* parent = job->parent) {
+        job->parent = nullptr;
+        finish(parent);
+        release(parent);
+    }
+    // Reference taken by submit()
+    release(job);
+}
+
+bool JobSystem::hasWork() const {
+    if (m_overflowSize.load(std::memory_order_acquire) > 0) {
+        return true;
+    }
+    for (const std::unique_ptr<Deque>& deque : m_deques) {
+        if (!deque->isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::wake() {
+    // Pairs with the fence in workerLoop(): either the worker sees the new
+    // job or this sees the worker registered as a sleeper
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_relaxed) > 0) {
+        {
+            std::lock_guard<std::mutex> lock(m_parkMutex);
+            m_epoch.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_parkCondition.notify_one();
+    }
+}
+
+void JobSystem::workerLoop(int slot) {
+    t_system = this;
+    t_slot = slot;
+
+    std::uint32_t idle = 0;
+    while (!m_stopping.load(std::memory_order_acquire)) {
+        if (runOne(slot)) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < m_spinCount) {
+            std::this_thread::yield();
+            continue;
+        }
+        idle = 0;
+
+        std::unique_lock<std::mutex> lock(m_parkMutex);
+        const std::uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+        m_sleepers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!hasWork() && !m_stopping.load(std::memory_order_acquire)) {
+            m_parks.fetch_add(1, std::memory_order_relaxed);
+            m_parkCondition.wait(lock, [this, epoch] {
+                return m_epoch.load(std::memory_order_relaxed) != epoch || m_stopping.load(std::memory_order_acquire);
+            });
+        }
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    t_system = nullptr;
+    t_slot = -1;
+}
+
+} // namespace crazy
@@ -0,0 +1,446 @@
+#include "crazy/Log.hpp"
+#include <ctime>
+
+namespace crazy {
+
+namespace {
+
+std::uint32_t currentThreadId() {
+    static std::atomic<std::uint32_t> s_nextId{1};
+    thread_local std::uint32_t id = s_nextId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+// How long the background thread sleeps when nobody wakes it
+const auto kIdleWait = std::chrono::milliseconds(10);
+
+// "HH:MM:SS.mmm [level] text\n"
+void formatLine(const LogMessage& message, std::string& line) {
+    using namespace std::chrono;
+    std::time_t seconds = system_clock::to_time_t(message.time);
+    int millis = static_cast<int>(
+        duration_cast<milliseconds>(message.time.time_since_epoch()).count() % 1000);
+
+    std::tm local{};
+#if defined(_WIN32)
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+
+    char prefix[48];
+    int length = std::snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%03d [%s] ",
+                               local.tm_hour, local.tm_min, local.tm_sec, millis,
+                               toString(message.level));
+    line.assign(prefix, length > 0 ? static_cast<std::size_t>(length) : 0);
+    line.append(message.text.data(), message.text.size());
+    line.push_back('\n');
+}
+
+} // namespace
+
+const char* toString(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "trace";
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info: return "info";
+        case LogLevel::Warning: return "warning";
+        case LogLevel::Error: return "error";
+        case LogLevel::Off: return "off";
+    }
+    return "unknown";
+}
+
+// ConsoleLogSink
+
+void ConsoleLogSink::write(const LogMessage& message) {
+    formatLine(message, m_line);
+    std::FILE* stream = message.level >= LogLevel::Warning ? stderr : stdout;
+    std::fwrite(m_line.data(), 1, m_line.size(), stream);
+}
+
+void ConsoleLogSink::flush() {
+    std::fflush(stdout);
+    std::fflush(stderr);
+}
+
+// RotatingFileLogSink
+
+RotatingFileLogSink::RotatingFileLogSink(const std::string& path, std::size_t maxBytes, int maxFiles)
+    : m_path(path)
+    , m_maxBytes(maxBytes)
+    , m_maxFiles(maxFiles)
+    , m_file(nullptr)
+    , m_size(0)
+{
+    m_file = std::fopen(m_path.c_str(), "ab");
+    if (m_file) {
+        std::fseek(m_file, 0, SEEK_END);
+        long position = std::ftell(m_file);
+        m_size = position > 0 ? static_cast<std::size_t>(position) : 0;
+    }
+}
+
+RotatingFileLogSink::~RotatingFileLogSink() {
+    if (m_file) {
+        std::fclose(m_file);
+    }
+}
+
+void RotatingFileLogSink::write(const LogMessage& message) {
+    if (!m_file) {
+        return;
+    }
+
+    formatLine(message, m_line);
+    if (m_size + m_line.size() > m_maxBytes && m_size > 0) {
+        rotate();
+        if (!m_file) {
+            return;
+        }
+    }
+
+    m_size += std::fwrite(m_line.data(), 1, m_line.size(), m_file);
+}
+
+void RotatingFileLogSink::flush() {
+    if (m_file) {
+        std::fflush(m_file);
+    }
+}
+
+void RotatingFileLogSink::rotate() {
+    std::fclose(m_file);
+    m_file = nullptr;
+
+    // path.(n-1) -> path.n, ..., path -> path.1
+    for (int i = m_maxFiles - 1; i >= 1; --i) {
+        std::string from = m_path + "." + std::to_string(i);
+        std::string to = m_path + "." + std::to_string(i + 1);
+        std::remove(to.c_str());
+        std::rename(from.c_str(), to.c_str());
+    }
+    if (m_maxFiles > 0) {
+        std::string first = m_path + ".1";
+        std::remove(first.c_str());
+        std::rename(m_path.c_str(), first.c_str());
+    }
+
+    m_file = std::fopen(m_path.c_str(), "wb");
+    m_size = 0;
+}
+
+// MemoryLogSink
+
+MemoryLogSink::MemoryLogSink(std::size_t capacity)
+    : m_capacity(capacity)
+{
+}
+
+void MemoryLogSink::write(const LogMessage& message) {
+    std::string line;
+    formatLine(message, line);
+    line.pop_back();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lines.push_back(std::move(line));
+    while (m_lines.size() > m_capacity) {
+        m_lines.pop_front();
+    }
+}
+
+std::vector<std::string> MemoryLogSink::getLines() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::vector<std::string>(m_lines.begin(), m_lines.end());
+}
+
+void MemoryLogSink::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lines.clear();
+}
+
+// Logger
+
+Logger& Logger::instance() {
+    static Logger s_logger;
+    return s_logger;
+}
+
+Logger::Logger()
+    : m_records(new Record[kCapacity])
+    , m_enqueuePos(0)
+    , m_dequeuePos(0)
+    , m_dropped(0)
+    , m_level(CRAZY_LOG_LEVEL)
+    , m_sleeping(false)
+    , m_running(true)
+{
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "Logger capacity must be a power of two");
+
+    for (std::size_t i = 0; i < kCapacity; ++i) {
+        m_records[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    m_sinks.push_back(std::make_shared<ConsoleLogSink>());
+    m_thread = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_running.store(false, std::memory_order_release);
+    }
+    m_wakeCondition.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void Logger::setLevel(LogLevel level) {
+    // Levels compiled out cannot be re-enabled at runtime
+    int value = std::max(static_cast<int>(level), CRAZY_LOG_LEVEL);
+    m_level.store(value, std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLevel() const {
+    return static_cast<LogLevel>(m_level.load(std::memory_order_relaxed));
+}
+
+void Logger::addSink(std::shared_ptr<LogSink> sink) {
+    if (!sink) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_sinkMutex);
+    m_sinks.push_back(std::move(sink));
+}
+
+void Logger::removeSink(const std::shared_ptr<LogSink>& sink) {
+    std::lock_guard<std::mutex> lock(m_sinkMutex);
+    m_sinks.erase(std::remove(m_sinks.begin(), m_sinks.end(), sink), m_sinks.end());
+}
+
+void Logger::clearSinks() {
+    std::lock_guard<std::mutex> lock(m_sinkMutex);
+    m_sinks.clear();
+}
+
+void Logger::flush() {
+    std::size_t target = m_enqueuePos.load(std::memory_order_acquire);
+    while (m_dequeuePos.load(std::memory_order_acquire) < target &&
+           m_running.load(std::memory_order_acquire)) {
+        m_wakeCondition.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Sinks are flushed after every batch; take the lock so the last batch
+    // has finished writing when we return
+    std::lock_guard<std::mutex> lock(m_sinkMutex);
+}
+
+std::uint64_t Logger::getDroppedCount() const {
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+Logger::Record* Logger::claim() {
+    // Bounded MPMC queue (Vyukov): each record's sequence tells whether it is
+    // free for the producer at this position
+    std::size_t position = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Record& record = m_records[position & (kCapacity - 1)];
+        std::size_t sequence = record.sequence.load(std::memory_order_acquire);
+        std::intptr_t difference = static_cast<std::intptr_t>(sequence) -
+                                   static_cast<std::intptr_t>(position);
+        if (difference == 0) {
+            if (m_enqueuePos.compare_exchange_weak(position, position + 1,
+                                                   std::memory_order_relaxed)) {
+                record.threadId = currentThreadId();
+                record.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+                return &record;
+            }
+        } else if (difference < 0) {
+            // Full: never block the caller
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            position = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Logger::publish(Record* record, bool urgent) {
+    std::size_t position = record->sequence.load(std::memory_order_relaxed);
+    record->sequence.store(position + 1, std::memory_order_release);
+
+    // Only pay for a wakeup when the consumer is parked
+    if (urgent || m_sleeping.load(std::memory_order_relaxed)) {
+        m_wakeCondition.notify_one();
+    }
+}
+
+void Logger::run() {
+    while (true) {
+        std::size_t drained = drain();
+        if (drained > 0) {
+            continue;
+        }
+
+        if (!m_running.load(std::memory_order_acquire)) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_sleeping.store(true, std::memory_order_relaxed);
+        m_wakeCondition.wait_for(lock, kIdleWait);
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    // Final drain after shutdown was requested
+    drain();
+}
+
+std::size_t Logger::drain() {
+    std::string text;
+    std::size_t count = 0;
+
+    std::lock_guard<std::mutex> lock(m_sinkMutex);
+    for (;;) {
+        std::size_t position = m_dequeuePos.load(std::memory_order_relaxed);
+        Record& record = m_records[position & (kCapacity - 1)];
+        std::size_t sequence = record.sequence.load(std::memory_order_acquire);
+        if (sequence != position + 1) {
+            break;
+        }
+
+        format(record, text);
+
+        LogMessage message;
+        message.level = record.level;
+        message.time = std::chrono::system_clock::time_point(
+            std::chrono::system_clock::duration(record.timestamp));
+        message.threadId = record.threadId;
+        message.text = text;
+
+        // Release the record before calling the sinks
+        record.sequence.store(position + kCapacity, std::memory_order_release);
+        m_dequeuePos.store(position + 1, std::memory_order_release);
+
+        for (const auto& sink : m_sinks) {
+            sink->write(message);
+        }
+        ++count;
+    }
+
+    if (count > 0) {
+        for (const auto& sink : m_sinks) {
+            sink->flush();
+        }
+    }
+    return count;
+}
+
+void Logger::format(const Record& record, std::string& out) const {
+    out.clear();
+
+    const unsigned char* args = record.payload;
+    const unsigned char* end = record.payload + record.payloadSize;
+
+    auto appendNext = [&]() {
+        if (args >= end) {
+            out += "{}";
+            return;
+        }
+        auto type = static_cast<detail::LogArgType>(*args++);
+        char buffer[32];
+        switch (type) {
+            case detail::LogArgType::Int: {
+                std::int64_t value;
+                std::memcpy(&value, args, sizeof(value));
+                args += sizeof(value);
+                std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+                out += buffer;
+                break;
+            }
+            case detail::LogArgType::UInt: {
+                std::uint64_t value;
+                std::memcpy(&value, args, sizeof(value));
+                args += sizeof(value);
+                std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+                out += buffer;
+                break;
+            }
+            case detail::LogArgType::Double: {
+                double value;
+                std::memcpy(&value, args, sizeof(value));
+                args += sizeof(value);
+                std::snprintf(buffer, sizeof(buffer), "%g", value);
+                out += buffer;
+                break;
+            }
+            case detail::LogArgType::Bool:
+                out += *args++ ? "true" : "false";
+                break;
+            case detail::LogArgType::Char:
+                out += static_cast<char>(*args++);
+                break;
+            case detail::LogArgType::String: {
+                std::uint16_t length;
+                std::memcpy(&length, args, sizeof(length));
+                args += sizeof(length);
+                out.append(reinterpret_cast<const char*>(args), length);
+                args += length;
+                break;
+            }
+            case detail::LogArgType::Pointer: {
+                std::uintptr_t value;
+                std::memcpy(&value, args, sizeof(value));
+                args += sizeof(value);
+                std::snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(value));
+                out += buffer;
+                break;
+            }
+        }
+    };
+
+    for (const char* p = record.format; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}') {
+            appendNext();
+            ++p;
+        } else {
+            out += *p;
+        }
+    }
+}
+
+// LogRateLimiter
+
+LogRateLimiter::LogRateLimiter(std::uint32_t maxEvents, double windowSeconds)
+    : m_maxEvents(maxEvents)
+    , m_windowTicks(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(windowSeconds)).count())
+    , m_windowStart(0)
+    , m_count(0)
+    , m_suppressed(0)
+{
+}
+
+bool LogRateLimiter::allow(std::uint64_t& suppressed) {
+    std::int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::int64_t start = m_windowStart.load(std::memory_order_relaxed);
+
+    // Open a new window; only the thread that wins the exchange resets it
+    if (now - start >= m_windowTicks &&
+        m_windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        m_count.store(0, std::memory_order_relaxed);
+    }
+
+    if (m_count.fetch_add(1, std::memory_order_relaxed) < m_maxEvents) {
+        suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+    suppressed = 0;
+    return false;
+}
+
+} // namespace crazy
@@ -0,0 +1,260 @@
+#include "crazy/MemoryTracker.hpp"
+#include "crazy/Log.hpp"
+#include <algorithm>
+
+namespace crazy {
+
+namespace {
+
+// Set while a budget callback runs, so evicting (or allocating) from the
+// callback does not re-enter it
+thread_local bool t_inBudgetCallback = false;
+
+std::size_t kibibytes(std::size_t bytes) {
+    return (bytes + 1023) / 1024;
+}
+
+} // namespace
+
+const char* toString(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::Textures:          return "Textures";
+        case MemoryCategory::GlyphAtlas:        return "GlyphAtlas";
+        case MemoryCategory::VertexBuffers:     return "VertexBuffers";
+        case MemoryCategory::FramebufferLayers: return "FramebufferLayers";
+        case MemoryCategory::UiTree:            return "UiTree";
+        case MemoryCategory::DrawLists:         return "DrawLists";
+        case MemoryCategory::Images:            return "Images";
+        case MemoryCategory::Jobs:              return "Jobs";
+        case MemoryCategory::General:           return "General";
+        case MemoryCategory::Count:             break;
+    }
+    return "Unknown";
+}
+
+bool isGpuCategory(MemoryCategory category) {
+    return category < MemoryCategory::UiTree;
+}
+
+MemoryTracker& MemoryTracker::instance() {
+    // Never destroyed: resources may be released from static destructors
+    // and thread exit, after a function-local static would be gone
+    static MemoryTracker* s_tracker = new MemoryTracker();
+    return *s_tracker;
+}
+
+MemoryTracker::MemoryTracker()
+    : m_lastId(0)
+{
+    for (int i = 0; i < kCategoryCount; ++i) {
+        m_resources[i] = std::make_unique<TrackedMemoryResource>(static_cast<MemoryCategory>(i));
+    }
+}
+
+std::uint64_t MemoryTracker::track(MemoryCategory category, std::size_t bytes, std::string label) {
+    std::uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        id = ++m_lastId;
+        MemoryRecord& record = m_records[id];
+        record.id = id;
+        record.category = category;
+        record.bytes = bytes;
+        record.label = std::move(label);
+    }
+    m_categories[static_cast<int>(category)].count.fetch_add(1, std::memory_order_relaxed);
+    add(category, bytes);
+    return id;
+}
+
+void MemoryTracker::resize(std::uint64_t id, std::size_t bytes) {
+    MemoryCategory category;
+    std::size_t previous;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_records.find(id);
+        if (it == m_records.end()) {
+            return;
+        }
+        category = it->second.category;
+        previous = it->second.bytes;
+        it->second.bytes = bytes;
+    }
+    if (bytes > previous) {
+        add(category, bytes - previous);
+    } else {
+        subtract(category, previous - bytes);
+    }
+}
+
+void MemoryTracker::untrack(std::uint64_t id) {
+    if (id == 0) {
+        return;
+    }
+    MemoryCategory category;
+    std::size_t bytes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_records.find(id);
+        if (it == m_records.end()) {
+            return;
+        }
+        category = it->second.category;
+        bytes = it->second.bytes;
+        m_records.erase(it);
+    }
+    m_categories[static_cast<int>(category)].count.fetch_sub(1, std::memory_order_relaxed);
+    subtract(category, bytes);
+}
+
+void MemoryTracker::allocate(MemoryCategory category, std::size_t bytes) {
+    m_categories[static_cast<int>(category)].count.fetch_add(1, std::memory_order_relaxed);
+    add(category, bytes);
+}
+
+void MemoryTracker::deallocate(MemoryCategory category, std::size_t bytes) {
+    m_categories[static_cast<int>(category)].count.fetch_sub(1, std::memory_order_relaxed);
+    subtract(category, bytes);
+}
+
+MemoryCategoryStats MemoryTracker::getStats(MemoryCategory category) const {
+    const Category& totals = m_categories[static_cast<int>(category)];
+    MemoryCategoryStats stats;
+    stats.bytes = totals.bytes.load(std::memory_order_relaxed);
+    stats.peakBytes = totals.peakBytes.load(std::memory_order_relaxed);
+    stats.count = totals.count.load(std::memory_order_relaxed);
+    stats.budget = totals.budget.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::size_t MemoryTracker::getTotalBytes(bool gpu) const {
+    std::size_t total = 0;
+    for (int i = 0; i < kCategoryCount; ++i) {
+        if (isGpuCategory(static_cast<MemoryCategory>(i)) == gpu) {
+            total += m_categories[i].bytes.load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+void MemoryTracker::resetPeaks() {
+    for (Category& totals : m_categories) {
+        totals.peakBytes.store(totals.bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+void MemoryTracker::setBudget(MemoryCategory category, std::size_t bytes, MemoryBudgetCallback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_callbacks[static_cast<int>(category)] = bytes ? std::move(callback) : nullptr;
+    m_categories[static_cast<int>(category)].budget.store(bytes, std::memory_order_relaxed);
+}
+
+std::uint64_t MemoryTracker::getLastId() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastId;
+}
+
+std::vector<MemoryRecord> MemoryTracker::getRecords(std::uint64_t since) const {
+    std::vector<MemoryRecord> records;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& entry : m_records) {
+            if (entry.first > since) {
+                records.push_back(entry.second);
+            }
+        }
+    }
+    std::sort(records.begin(), records.end(),
+              [](const MemoryRecord& a, const MemoryRecord& b) { return a.id < b.id; });
+    return records;
+}
+
+void MemoryTracker::logReport(std::uint64_t since) const {
+    CRAZY_LOG_INFO("Memory: GPU {} KiB, CPU {} KiB", kibibytes(getTotalBytes(true)),
+                   kibibytes(getTotalBytes(false)));
+    for (int i = 0; i < kCategoryCount; ++i) {
+        MemoryCategoryStats stats = getStats(static_cast<MemoryCategory>(i));
+        if (stats.count == 0 && stats.peakBytes == 0) {
+            continue;
+        }
+        CRAZY_LOG_INFO("Memory:   {}: {} KiB in {}, peak {} KiB, budget {} KiB",
+                       toString(static_cast<MemoryCategory>(i)), kibibytes(stats.bytes), stats.count,
+                       kibibytes(stats.peakBytes), kibibytes(stats.budget));
+    }
+    for (const MemoryRecord& record : getRecords(since)) {
+        CRAZY_LOG_INFO("Memory:   #{} {} {} bytes {}", record.id, toString(record.category),
+                       record.bytes, record.label.c_str());
+    }
+}
+
+std::pmr::memory_resource* MemoryTracker::getResource(MemoryCategory category) {
+    return m_resources[static_cast<int>(category)].get();
+}
+
+std::size_t MemoryTracker::estimateTextureSize(int width, int height, int bytesPerPixel, bool mipmaps) {
+    if (width <= 0 || height <= 0 || bytesPerPixel <= 0) {
+        return 0;
+    }
+    std::size_t bytes = static_cast<std::size_t>(width) * static_cast<std::size_t>(height) *
+                        static_cast<std::size_t>(bytesPerPixel);
+    return mipmaps ? bytes + bytes / 3 : bytes;
+}
+
+void MemoryTracker::add(MemoryCategory category, std::size_t bytes) {
+    Category& totals = m_categories[static_cast<int>(category)];
+    std::size_t previous = totals.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    std::size_t current = previous + bytes;
+
+    std::size_t peak = totals.peakBytes.load(std::memory_order_relaxed);
+    while (current > peak &&
+           !totals.peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+
+    std::size_t budget = totals.budget.load(std::memory_order_relaxed);
+    if (budget == 0 || previous > budget || current <= budget || t_inBudgetCallback) {
+        return;
+    }
+
+    MemoryBudgetCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        callback = m_callbacks[static_cast<int>(category)];
+    }
+    if (callback) {
+        t_inBudgetCallback = true;
+        callback(category, current - budget);
+        t_inBudgetCallback = false;
+    }
+}
+
+void MemoryTracker::subtract(MemoryCategory category, std::size_t bytes) {
+    m_categories[static_cast<int>(category)].bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+TrackedMemoryResource::TrackedMemoryResource(MemoryCategory category, std::pmr::memory_resource* upstream)
+    : m_category(category)
+    , m_upstream(upstream)
+{
+}
+
+MemoryCategory TrackedMemoryResource::getCategory() const {
+    return m_category;
+}
+
+void* TrackedMemoryResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    void* p = m_upstream->allocate(bytes, alignment);
+    MemoryTracker::instance().allocate(m_category, bytes);
+    return p;
+}
+
+void TrackedMemoryResource::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+    m_upstream->deallocate(p, bytes, alignment);
+    MemoryTracker::instance().deallocate(m_category, bytes);
+}
+
+bool TrackedMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    auto tracked = dynamic_cast<const TrackedMemoryResource*>(&other);
+    return tracked && tracked->m_category == m_category && tracked->m_upstream->is_equal(*m_upstream);
+}
+
+} // namespace crazy
@@ -0,0 +1,1424 @@
+#include "crazy/NodeRuntime.hpp"
+#include "crazy/Log.hpp"
+#include <map>
+#include <unordered_map>
+
+#ifdef NODE_EMBED_ENABLED
+#include <node.h>
+#include <uv.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// The embedder snapshot API (EmbedderSnapshotData, CreateForSnapshotting,
+// CreateFromSnapshot) arrived in Node.js 20; older builds boot without one
+#define CRAZY_NODE_SNAPSHOTS NODE_VERSION_AT_LEAST(20, 0, 0)
+#endif
+
+namespace crazy {
+
+#ifdef NODE_EMBED_ENABLED
+
+namespace {
+
+// Bootstrap run as the environment's main script: keep a public require()
+// for loadScript() and create the object native functions are attached to.
+const char* const kBootstrapSource =
+    "globalThis.require = require('node:module').createRequire(process.cwd() + '/');"
+    "globalThis.crazy = globalThis.crazy || {};";
+
+// Snapshot builder run by buildSnapshot(). Only builtin modules can be
+// required in a snapshot, so the bundle gets the builtin require(); its
+// exports and identity are kept on crazy.snapshot for loadScript(). The
+// deserialize main function re-creates the public require().
+const char* const kSnapshotBuilderSource = R"js(
+const fs = require('fs');
+const path = require('path');
+const v8 = require('v8');
+const [, , bundlePath, bundleHash] = process.argv;
+globalThis.crazy = { snapshot: { path: bundlePath, hash: bundleHash, exports: undefined } };
+const bundle = { exports: {} };
+const source = fs.readFileSync(bundlePath, 'utf8');
+new Function('exports', 'require', 'module', '__filename', '__dirname',
+             source + '\n//# sourceURL=' + bundlePath)(
+    bundle.exports, require, bundle, bundlePath, path.dirname(bundlePath));
+globalThis.crazy.snapshot.exports = bundle.exports;
+v8.startupSnapshot.setDeserializeMainFunction(() => {
+  globalThis.require = require('module').createRequire(process.cwd() + '/');
+});
+)js";
+
+// Installs the code cache for CommonJS modules (see setCodeCacheDirectory()).
+// Called with the cache directory; entries are keyed by a hash of the
+// Node.js version and the module source, and written at exit.
+const char* const kCodeCacheSource = R"js(
+(function (directory) {
+  const Module = require('module');
+  const crypto = require('crypto');
+  const fs = require('fs');
+  const path = require('path');
+  const vm = require('vm');
+
+  fs.mkdirSync(directory, { recursive: true });
+  const stats = { hits: 0, misses: 0, rejected: 0, written: 0 };
+  const dirty = new Map();
+  const compile = Module.prototype._compile;
+
+  Module.prototype._compile = function (content, filename) {
+    if (content.startsWith('#!')) {
+      return compile.call(this, content, filename);
+    }
+    const key = crypto.createHash('sha256').update(process.version).update('\0').update(content).digest('hex');
+    const file = path.join(directory, key + '.bin');
+    let cachedData;
+    try {
+      cachedData = fs.readFileSync(file);
+    } catch {
+      cachedData = undefined;
+    }
+    const script = new vm.Script(Module.wrap(content), { filename, cachedData });
+    if (!cachedData) {
+      stats.misses++;
+      dirty.set(file, script);
+    } else if (script.cachedDataRejected) {
+      stats.rejected++;
+      dirty.set(file, script);
+    } else {
+      stats.hits++;
+    }
+
+    const module = this;
+    const require = (id) => module.require(id);
+    require.resolve = (request, options) => Module._resolveFilename(request, module, false, options);
+    require.main = process.mainModule;
+    require.extensions = Module._extensions;
+    require.cache = Module._cache;
+    return script.runInThisContext({ displayErrors: true })
+      .call(module.exports, module.exports, require, module, filename, path.dirname(filename));
+  };
+
+  process.on('exit', () => {
+    for (const [file, script] of dirty) {
+      const temporary = `${file}.${process.pid}`;
+      try {
+        fs.writeFileSync(temporary, script.createCachedData());
+        fs.renameSync(temporary, file);
+        stats.written++;
+      } catch {
+        // A read-only or full cache directory only costs compile time
+      }
+    }
+  });
+  return stats;
+})
+)js";
+
+// FNV-1a of a file's contents, as hex; empty if the file cannot be read
+std::string hashFile(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return std::string();
+    }
+    std::uint64_t hash = 14695981039346656037ull;
+    unsigned char buffer[65536];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        for (size_t i = 0; i < read; ++i) {
+            hash = (hash ^ buffer[i]) * 1099511628211ull;
+        }
+    }
+    std::fclose(file);
+
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return hex;
+}
+
+std::string canonicalPath(const std::string& path) {
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::canonical(path, error);
+    return error ? path : canonical.string();
+}
+
+// Enters the isolate and the environment's context for one API call
+struct EnvironmentScope {
+    explicit EnvironmentScope(node::CommonEnvironmentSetup& setup)
+        : locker(setup.isolate())
+        , isolateScope(setup.isolate())
+        , handleScope(setup.isolate())
+        , context(setup.context())
+        , contextScope(context)
+    {
+    }
+
+    v8::Locker locker;
+    v8::Isolate::Scope isolateScope;
+    v8::HandleScope handleScope;
+    v8::Local<v8::Context> context;
+    v8::Context::Scope contextScope;
+};
+
+v8::Local<v8::String> toV8String(v8::Isolate* isolate, const std::string& value) {
+    return v8::String::NewFromUtf8(isolate, value.data(), v8::NewStringType::kNormal,
+                                   static_cast<int>(value.size())).ToLocalChecked();
+}
+
+v8::Local<v8::Value> toV8(v8::Isolate* isolate, const NodeValue& value) {
+    switch (value.getType()) {
+        case NodeValue::Type::Null:
+            return v8::Null(isolate);
+        case NodeValue::Type::Boolean:
+            return v8::Boolean::New(isolate, value.asBoolean());
+        case NodeValue::Type::Number:
+            return v8::Number::New(isolate, value.asNumber());
+        case NodeValue::Type::String:
+            return toV8String(isolate, value.asString());
+        case NodeValue::Type::Undefined:
+        default:
+            return v8::Undefined(isolate);
+    }
+}
+
+NodeValue fromV8(v8::Isolate* isolate, v8::Local<v8::Value> value) {
+    if (value.IsEmpty() || value->IsUndefined()) {
+        return NodeValue();
+    }
+    if (value->IsNull()) {
+        return NodeValue::null();
+    }
+    if (value->IsBoolean()) {
+        return NodeValue(value->BooleanValue(isolate));
+    }
+    if (value->IsNumber()) {
+        return NodeValue(value.As<v8::Number>()->Value());
+    }
+    if (value->IsString()) {
+        v8::String::Utf8Value utf8(isolate, value);
+        return NodeValue(std::string(*utf8 ? *utf8 : "", utf8.length()));
+    }
+    return NodeValue();
+}
+
+std::string describeException(v8::Isolate* isolate, v8::Local<v8::Context> context,
+                              const v8::TryCatch& tryCatch) {
+    v8::Local<v8::Value> trace;
+    if (tryCatch.StackTrace(context).ToLocal(&trace) && trace->IsString()) {
+        return fromV8(isolate, trace).asString();
+    }
+    v8::String::Utf8Value message(isolate, tryCatch.Exception());
+    return *message ? std::string(*message, message.length()) : "unknown exception";
+}
+
+// Trampoline from JavaScript into a registered NativeFunction
+void invokeNative(const v8::FunctionCallbackInfo<v8::Value>& info) {
+    v8::Isolate* isolate = info.GetIsolate();
+    auto* function = static_cast<NodeRuntime::NativeFunction*>(
+        info.Data().As<v8::External>()->Value());
+
+    std::vector<NodeValue> args;
+    args.reserve(static_cast<size_t>(info.Length()));
+    for (int i = 0; i < info.Length(); ++i) {
+        args.push_back(fromV8(isolate, info[i]));
+    }
+
+    // C++ exceptions must not unwind through V8 frames
+    try {
+        info.GetReturnValue().Set(toV8(isolate, (*function)(args)));
+    } catch (const std::exception& e) {
+        isolate->ThrowException(v8::Exception::Error(toV8String(isolate, e.what())));
+    } catch (...) {
+        isolate->ThrowException(v8::Exception::Error(toV8String(isolate, "native function failed")));
+    }
+}
+
+} // namespace
+
+struct NodeRuntime::Impl {
+    struct CachedFunction {
+        v8::Global<v8::Object> receiver;
+        v8::Global<v8::Function> function;
+    };
+
+    std::unique_ptr<node::MultiIsolatePlatform> platform;
+#if CRAZY_NODE_SNAPSHOTS
+    // Must outlive the isolate created from it
+    node::EmbedderSnapshotData::Pointer snapshot;
+#endif
+    std::unique_ptr<node::CommonEnvironmentSetup> setup;
+
+    v8::Global<v8::Object> nativeObject;
+    v8::Global<v8::Function> require;
+    v8::Global<v8::Object> exports;
+    std::unordered_map<std::string, CachedFunction> functionCache;
+
+    // Heap entries keep their address when the map grows; JS functions
+    // point at them through v8::External
+    std::map<std::string, std::unique_ptr<NativeFunction>> natives;
+
+    // Async functions; tasks hold their own reference to the function, so
+    // replacing it does not affect calls in flight
+    struct AsyncEntry {
+        Impl* impl;
+        std::shared_ptr<AsyncFunction> function;
+    };
+    std::map<std::string, std::unique_ptr<AsyncEntry>> asyncNatives;
+
+    // Promises of async calls in flight, only touched on the runtime's thread
+    struct PendingCall {
+        v8::Global<v8::Promise::Resolver> resolver;
+        v8::Global<v8::Object> signal;
+        v8::Global<v8::Function> abortListener;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+    std::unordered_map<std::uint64_t, PendingCall> pendingCalls;
+    std::uint64_t nextCallId = 1;
+
+    TaskPoolSettings taskPoolSettings;
+    std::unique_ptr<TaskPool> taskPool;
+
+    std::string snapshotPath;
+    std::string codeCacheDirectory;
+
+    // Bundle evaluated in the loaded snapshot, until loadScript() adopts it
+    std::string snapshotBundlePath;
+    std::string snapshotBundleHash;
+    v8::Global<v8::Value> snapshotExports;
+
+    bool started = false;
+    bool running = false;
+
+    // Calls queued by postCall() and async results, from any thread
+    uv_async_t postHandle;
+    std::mutex postMutex;
+    std::vector<std::pair<std::string, std::vector<NodeValue>>> postedCalls;
+    std::vector<std::pair<std::uint64_t, NodeAsyncResult>> completedCalls;
+
+    // Helper thread waking the main thread for libuv (see startEventWatcher())
+    struct EventWatcher {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::function<void()> wakeup;
+        int backendFd = -1;
+        int interruptFds[2] = {-1, -1};
+        int timeoutMs = -1;
+        std::uint64_t generation = 0;
+        bool armed = false;
+        bool stopping = false;
+    } watcher;
+
+#ifndef _WIN32
+    void interruptWatcher() {
+        const char byte = 0;
+        // A full pipe already guarantees a wakeup
+        ssize_t written = write(watcher.interruptFds[1], &byte, 1);
+        (void)written;
+    }
+
+    void watchLoop() {
+        std::unique_lock<std::mutex> lock(watcher.mutex);
+        while (!watcher.stopping) {
+            watcher.condition.wait(lock, [this] { return watcher.armed || watcher.stopping; });
+            if (watcher.stopping) {
+                break;
+            }
+            const std::uint64_t generation = watcher.generation;
+            const int timeoutMs = watcher.timeoutMs;
+            lock.unlock();
+
+            pollfd fds[2] = {
+                {watcher.backendFd, POLLIN, 0},
+                {watcher.interruptFds[0], POLLIN, 0}
+            };
+            int ready = poll(fds, 2, timeoutMs);
+            if (ready > 0 && (fds[1].revents & POLLIN)) {
+                char drain[64];
+                ssize_t drained = read(watcher.interruptFds[0], drain, sizeof(drain));
+                (void)drained;
+            }
+
+            lock.lock();
+            // Re-armed or disarmed while polling: start over with fresh state
+            if (!watcher.armed || watcher.generation != generation) {
+                continue;
+            }
+            const bool timerDue = ready == 0;
+            const bool ioReady = ready > 0 && (fds[0].revents & (POLLIN | POLLERR | POLLHUP));
+            if (timerDue || ioReady) {
+                // One wakeup per arm; called under the lock so that
+                // disarmEventWatcher() cannot return while it runs
+                watcher.armed = false;
+                watcher.wakeup();
+            }
+        }
+    }
+#endif
+
+    // Node, V8 and the platform, once per process; returns null on failure.
+    // InitializeOncePerProcess() returns a unique_ptr up to Node 20 and a
+    // shared_ptr from Node 22; both convert to shared_ptr
+    std::shared_ptr<node::InitializationResult> initializeProcess(const std::vector<std::string>& args,
+                                                                  std::string& error) {
+        if (started) {
+            error = "Node.js can only be initialized once per process";
+            CRAZY_LOG_ERROR("NodeRuntime: {}", error.c_str());
+            return nullptr;
+        }
+        started = true;
+
+        std::vector<std::string> argv = args;
+        if (argv.empty()) {
+            argv.push_back("crazy");
+        }
+
+        // V8 and the platform are set up here so that the platform is owned
+        // by the runtime and outlives the environment
+        auto init = node::InitializeOncePerProcess(
+            argv, {node::ProcessInitializationFlags::kNoInitializeV8,
+                   node::ProcessInitializationFlags::kNoInitializeNodeV8Platform});
+        for (const std::string& message : init->errors()) {
+            CRAZY_LOG_ERROR("NodeRuntime: {}", message.c_str());
+        }
+        if (init->early_return() != 0) {
+            error = init->errors().empty() ? "Node.js initialization failed" : init->errors().front();
+            return nullptr;
+        }
+
+        platform = node::MultiIsolatePlatform::Create(4);
+        v8::V8::InitializePlatform(platform.get());
+        v8::V8::Initialize();
+        return init;
+    }
+
+    void disposeProcess() {
+        v8::V8::Dispose();
+        v8::V8::DisposePlatform();
+        platform.reset();
+        node::TearDownOncePerProcess();
+    }
+
+    bool hasSnapshot() const {
+#if CRAZY_NODE_SNAPSHOTS
+        return snapshot != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    // Keep the bundle evaluated by the snapshot builder for loadScript()
+    void adoptSnapshotBundle(v8::Isolate* isolate, v8::Local<v8::Context> context) {
+        v8::Local<v8::Value> snapshotInfo;
+        v8::Local<v8::Value> path;
+        v8::Local<v8::Value> hash;
+        v8::Local<v8::Value> bundleExports;
+        if (!nativeObject.Get(isolate)->Get(context, toV8String(isolate, "snapshot")).ToLocal(&snapshotInfo)
+            || !snapshotInfo->IsObject()) {
+            return;
+        }
+        v8::Local<v8::Object> info = snapshotInfo.As<v8::Object>();
+        if (info->Get(context, toV8String(isolate, "path")).ToLocal(&path) && path->IsString()
+            && info->Get(context, toV8String(isolate, "hash")).ToLocal(&hash) && hash->IsString()
+            && info->Get(context, toV8String(isolate, "exports")).ToLocal(&bundleExports)) {
+            snapshotBundlePath = fromV8(isolate, path).asString();
+            snapshotBundleHash = fromV8(isolate, hash).asString();
+            snapshotExports.Reset(isolate, bundleExports);
+        }
+    }
+
+    void installCodeCache(v8::Isolate* isolate, v8::Local<v8::Context> context) {
+        v8::TryCatch tryCatch(isolate);
+        v8::Local<v8::Script> script;
+        v8::Local<v8::Value> installer;
+        v8::Local<v8::Value> stats;
+        v8::Local<v8::Value> argv[] = { toV8String(isolate, codeCacheDirectory) };
+        if (!v8::Script::Compile(context, toV8String(isolate, kCodeCacheSource)).ToLocal(&script)
+            || !script->Run(context).ToLocal(&installer) || !installer->IsFunction()
+            || !installer.As<v8::Function>()->Call(context, context->Global(), 1, argv).ToLocal(&stats)) {
+            CRAZY_LOG_WARNING("NodeRuntime: Code cache disabled: {}",
+                              describeException(isolate, context, tryCatch).c_str());
+            return;
+        }
+        nativeObject.Get(isolate)->Set(context, toV8String(isolate, "codeCache"), stats).Check();
+    }
+
+    void installNative(v8::Isolate* isolate, v8::Local<v8::Context> context,
+                       const std::string& name, v8::FunctionCallback callback, void* data) {
+        v8::Local<v8::FunctionTemplate> tmpl = v8::FunctionTemplate::New(
+            isolate, callback, v8::External::New(isolate, data));
+        v8::Local<v8::Function> jsFunction;
+        if (!tmpl->GetFunction(context).ToLocal(&jsFunction)) {
+            return;
+        }
+        v8::Local<v8::String> key = toV8String(isolate, name);
+        jsFunction->SetName(key);
+        nativeObject.Get(isolate)->Set(context, key, jsFunction).Check();
+    }
+
+    TaskPool& getTaskPool() {
+        if (!taskPool) {
+            taskPool = std::make_unique<TaskPool>(taskPoolSettings);
+        }
+        return *taskPool;
+    }
+
+    // Trampoline from JavaScript into a registered AsyncFunction
+    static void invokeAsync(const v8::FunctionCallbackInfo<v8::Value>& info) {
+        v8::Isolate* isolate = info.GetIsolate();
+        v8::Local<v8::Context> context = isolate->GetCurrentContext();
+        auto* entry = static_cast<AsyncEntry*>(info.Data().As<v8::External>()->Value());
+        Impl* impl = entry->impl;
+
+        v8::Local<v8::Promise::Resolver> resolver;
+        if (!v8::Promise::Resolver::New(context).ToLocal(&resolver)) {
+            return;
+        }
+        info.GetReturnValue().Set(resolver->GetPromise());
+
+        // A trailing { signal } object is the options, not an argument
+        int argc = info.Length();
+        v8::Local<v8::Object> signal;
+        if (argc > 0 && info[argc - 1]->IsObject() && !info[argc - 1]->IsFunction()) {
+            v8::Local<v8::Value> value;
+            if (info[argc - 1].As<v8::Object>()->Get(context, toV8String(isolate, "signal")).ToLocal(&value)
+                && value->IsObject()) {
+                signal = value.As<v8::Object>();
+            }
+            --argc;
+        }
+
+        if (!signal.IsEmpty()) {
+            v8::Local<v8::Value> aborted;
+            if (signal->Get(context, toV8String(isolate, "aborted")).ToLocal(&aborted)
+                && aborted->BooleanValue(isolate)) {
+                v8::Local<v8::Value> reason;
+                if (!signal->Get(context, toV8String(isolate, "reason")).ToLocal(&reason)) {
+                    reason = v8::Undefined(isolate);
+                }
+                resolver->Reject(context, reason).Check();
+                return;
+            }
+        }
+
+        std::vector<NodeValue> args;
+        args.reserve(static_cast<size_t>(argc));
+        for (int i = 0; i < argc; ++i) {
+            args.push_back(fromV8(isolate, info[i]));
+        }
+
+        const std::uint64_t id = impl->nextCallId++;
+        PendingCall& pending = impl->pendingCalls[id];
+        pending.resolver.Reset(isolate, resolver);
+        pending.cancelled = std::make_shared<std::atomic<bool>>(false);
+
+        if (!signal.IsEmpty()) {
+            v8::Local<v8::Value> data[] = {
+                v8::External::New(isolate, impl),
+                v8::Number::New(isolate, static_cast<double>(id))
+            };
+            v8::Local<v8::Function> listener;
+            v8::Local<v8::Value> addEventListener;
+            if (v8::Function::New(context, onAbort, v8::Array::New(isolate, data, 2)).ToLocal(&listener)
+                && signal->Get(context, toV8String(isolate, "addEventListener")).ToLocal(&addEventListener)
+                && addEventListener->IsFunction()) {
+                v8::Local<v8::Value> argv[] = { toV8String(isolate, "abort"), listener };
+                if (!addEventListener.As<v8::Function>()->Call(context, signal, 2, argv).IsEmpty()) {
+                    pending.signal.Reset(isolate, signal);
+                    pending.abortListener.Reset(isolate, listener);
+                }
+            }
+        }
+
+        std::shared_ptr<AsyncFunction> function = entry->function;
+        std::shared_ptr<std::atomic<bool>> cancelled = pending.cancelled;
+        bool queued = impl->getTaskPool().submit([impl, id, function, cancelled, args = std::move(args)]() {
+            // Aborted while queued: the promise is already settled
+            if (cancelled->load(std::memory_order_relaxed)) {
+                return;
+            }
+            NodeAsyncResult result;
+            try {
+                result = (*function)(args, NodeCancellation(cancelled));
+            } catch (const std::exception& e) {
+                result = NodeAsyncResult::fromError(e.what());
+            } catch (...) {
+                result = NodeAsyncResult::fromError("native function failed");
+            }
+            std::lock_guard<std::mutex> lock(impl->postMutex);
+            impl->completedCalls.emplace_back(id, std::move(result));
+            uv_async_send(&impl->postHandle);
+        });
+        if (!queued) {
+            impl->settle(isolate, context, id, NodeAsyncResult::fromError("task pool queue is full"));
+        }
+    }
+
+    // Abort listener of a pending call; data is [External(impl), id]
+    static void onAbort(const v8::FunctionCallbackInfo<v8::Value>& info) {
+        v8::Isolate* isolate = info.GetIsolate();
+        v8::Local<v8::Context> context = isolate->GetCurrentContext();
+        v8::Local<v8::Array> data = info.Data().As<v8::Array>();
+        v8::Local<v8::Value> impl;
+        v8::Local<v8::Value> id;
+        if (!data->Get(context, 0).ToLocal(&impl) || !data->Get(context, 1).ToLocal(&id)) {
+            return;
+        }
+        static_cast<Impl*>(impl.As<v8::External>()->Value())->abort(
+            isolate, context, static_cast<std::uint64_t>(id.As<v8::Number>()->Value()));
+    }
+
+    void abort(v8::Isolate* isolate, v8::Local<v8::Context> context, std::uint64_t id) {
+        auto it = pendingCalls.find(id);
+        if (it == pendingCalls.end()) {
+            return;
+        }
+        it->second.cancelled->store(true, std::memory_order_relaxed);
+        v8::Local<v8::Value> reason;
+        if (!it->second.signal.Get(isolate)->Get(context, toV8String(isolate, "reason")).ToLocal(&reason)) {
+            reason = v8::Undefined(isolate);
+        }
+        v8::Local<v8::Promise::Resolver> resolver = it->second.resolver.Get(isolate);
+        releasePending(isolate, context, it->second);
+        pendingCalls.erase(it);
+        resolver->Reject(context, reason).Check();
+    }
+
+    // Settle the promise of a call; results of aborted calls are dropped
+    void settle(v8::Isolate* isolate, v8::Local<v8::Context> context, std::uint64_t id, NodeAsyncResult result) {
+        auto it = pendingCalls.find(id);
+        if (it == pendingCalls.end()) {
+            return;
+        }
+        v8::Local<v8::Promise::Resolver> resolver = it->second.resolver.Get(isolate);
+        releasePending(isolate, context, it->second);
+        pendingCalls.erase(it);
+
+        if (result.isError()) {
+            resolver->Reject(context, v8::Exception::Error(toV8String(isolate, result.getError()))).Check();
+        } else if (result.hasBuffer()) {
+            // The ArrayBuffer takes over the vector's storage
+            auto* bytes = new std::vector<std::uint8_t>(std::move(result.getBuffer()));
+            std::unique_ptr<v8::BackingStore> store = v8::ArrayBuffer::NewBackingStore(
+                bytes->data(), bytes->size(),
+                [](void*, size_t, void* owner) { delete static_cast<std::vector<std::uint8_t>*>(owner); },
+                bytes);
+            resolver->Resolve(context, v8::ArrayBuffer::New(isolate, std::move(store))).Check();
+        } else {
+            resolver->Resolve(context, toV8(isolate, result.getValue())).Check();
+        }
+    }
+
+    void releasePending(v8::Isolate* isolate, v8::Local<v8::Context> context, PendingCall& pending) {
+        if (pending.abortListener.IsEmpty()) {
+            return;
+        }
+        v8::Local<v8::Object> signal = pending.signal.Get(isolate);
+        v8::Local<v8::Value> removeEventListener;
+        if (signal->Get(context, toV8String(isolate, "removeEventListener")).ToLocal(&removeEventListener)
+            && removeEventListener->IsFunction()) {
+            v8::Local<v8::Value> argv[] = { toV8String(isolate, "abort"), pending.abortListener.Get(isolate) };
+            // Best effort; an exception is swallowed by the TryCatch
+            v8::TryCatch tryCatch(isolate);
+            v8::MaybeLocal<v8::Value> removed = removeEventListener.As<v8::Function>()->Call(context, signal, 2, argv);
+            (void)removed;
+        }
+    }
+
+    // Runs on the runtime's thread from the post handle
+    void settleCompletedCalls() {
+        std::vector<std::pair<std::uint64_t, NodeAsyncResult>> completed;
+        {
+            std::lock_guard<std::mutex> lock(postMutex);
+            completed.swap(completedCalls);
+        }
+        if (completed.empty()) {
+            return;
+        }
+
+        EnvironmentScope scope(*setup);
+        v8::Isolate* isolate = setup->isolate();
+        // Promise reactions run when the callback scope closes
+        node::CallbackScope callbackScope(isolate, v8::Object::New(isolate), {0, 0});
+        for (auto& entry : completed) {
+            settle(isolate, scope.context, entry.first, std::move(entry.second));
+        }
+    }
+
+    // Resolve a dotted name against the exports of the loaded module, then globalThis
+    bool resolve(v8::Isolate* isolate, v8::Local<v8::Context> context, const std::string& name,
+                 v8::Local<v8::Object>& receiver, v8::Local<v8::Function>& function) {
+        v8::Local<v8::Object> roots[2] = {
+            exports.IsEmpty() ? v8::Local<v8::Object>() : exports.Get(isolate),
+            context->Global()
+        };
+        for (v8::Local<v8::Object> root : roots) {
+            if (root.IsEmpty()) {
+                continue;
+            }
+            v8::Local<v8::Object> holder = root;
+            v8::Local<v8::Value> current = root;
+            size_t start = 0;
+            bool found = true;
+            while (start <= name.size()) {
+                size_t end = name.find('.', start);
+                if (end == std::string::npos) {
+                    end = name.size();
+                }
+                if (!current->IsObject()) {
+                    found = false;
+                    break;
+                }
+                holder = current.As<v8::Object>();
+                if (!holder->Get(context, toV8String(isolate, name.substr(start, end - start))).ToLocal(&current)
+                    || current->IsUndefined()) {
+                    found = false;
+                    break;
+                }
+                start = end + 1;
+            }
+            if (found && current->IsFunction()) {
+                receiver = holder;
+                function = current.As<v8::Function>();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+NodeRuntime::NodeRuntime()
+    : m_impl(std::make_unique<Impl>())
+{
+}
+
+NodeRuntime::~NodeRuntime() {
+    shutdown();
+}
+
+bool NodeRuntime::isAvailable() {
+    return true;
+}
+
+bool NodeRuntime::start(const std::vector<std::string>& args) {
+    if (m_impl->running) {
+        return true;
+    }
+
+    std::shared_ptr<node::InitializationResult> init = m_impl->initializeProcess(args, m_lastError);
+    if (!init) {
+        return false;
+    }
+
+#if CRAZY_NODE_SNAPSHOTS
+    if (!m_impl->snapshotPath.empty()) {
+        if (std::FILE* file = std::fopen(m_impl->snapshotPath.c_str(), "rb")) {
+            m_impl->snapshot = node::EmbedderSnapshotData::FromFile(file);
+            std::fclose(file);
+        }
+        if (!m_impl->snapshot) {
+            CRAZY_LOG_WARNING("NodeRuntime: Cannot use snapshot {}, starting without it",
+                              m_impl->snapshotPath.c_str());
+        }
+    }
+#else
+    if (!m_impl->snapshotPath.empty()) {
+        CRAZY_LOG_WARNING("NodeRuntime: Startup snapshots need Node.js 20 or newer, starting without {}",
+                          m_impl->snapshotPath.c_str());
+    }
+#endif
+
+    std::vector<std::string> errors;
+#if CRAZY_NODE_SNAPSHOTS
+    if (m_impl->snapshot) {
+        m_impl->setup = node::CommonEnvironmentSetup::CreateFromSnapshot(
+            m_impl->platform.get(), &errors, m_impl->snapshot.get(), init->args(), init->exec_args());
+    } else
+#endif
+    {
+        m_impl->setup = node::CommonEnvironmentSetup::Create(
+            m_impl->platform.get(), &errors, init->args(), init->exec_args());
+    }
+    if (!m_impl->setup) {
+        m_lastError = errors.empty() ? "Failed to create Node.js environment" : errors.front();
+        CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+        return false;
+    }
+
+    {
+        EnvironmentScope scope(*m_impl->setup);
+        v8::Isolate* isolate = m_impl->setup->isolate();
+
+        // A snapshot runs its deserialize main function instead of a script
+        v8::MaybeLocal<v8::Value> loaded = m_impl->hasSnapshot()
+            ? node::LoadEnvironment(m_impl->setup->env(), node::StartExecutionCallback{})
+            : node::LoadEnvironment(m_impl->setup->env(), kBootstrapSource);
+        if (loaded.IsEmpty()) {
+            m_lastError = "Failed to bootstrap Node.js environment";
+            CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+            m_impl->setup.reset();
+            return false;
+        }
+
+        v8::Local<v8::Object> global = scope.context->Global();
+        v8::Local<v8::Value> nativeObject;
+        v8::Local<v8::Value> require;
+        if (!global->Get(scope.context, toV8String(isolate, "crazy")).ToLocal(&nativeObject)
+            || !nativeObject->IsObject()
+            || !global->Get(scope.context, toV8String(isolate, "require")).ToLocal(&require)
+            || !require->IsFunction()) {
+            m_lastError = "Node.js bootstrap script did not run";
+            CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+            m_impl->setup.reset();
+            return false;
+        }
+        m_impl->nativeObject.Reset(isolate, nativeObject.As<v8::Object>());
+        m_impl->require.Reset(isolate, require.As<v8::Function>());
+
+        if (m_impl->hasSnapshot()) {
+            m_impl->adoptSnapshotBundle(isolate, scope.context);
+        }
+        if (!m_impl->codeCacheDirectory.empty()) {
+            m_impl->installCodeCache(isolate, scope.context);
+        }
+
+        // Functions registered before start()
+        for (auto& entry : m_impl->natives) {
+            m_impl->installNative(isolate, scope.context, entry.first, invokeNative, entry.second.get());
+        }
+        for (auto& entry : m_impl->asyncNatives) {
+            m_impl->installNative(isolate, scope.context, entry.first, Impl::invokeAsync, entry.second.get());
+        }
+    }
+
+    // Kept referenced: uv_run() returns at once when no referenced handle is
+    // left, and would then never deliver posted calls. It is closed in
+    // shutdown(), and being idle it never makes the backend timeout zero.
+    uv_async_init(m_impl->setup->event_loop(), &m_impl->postHandle, [](uv_async_t* handle) {
+        NodeRuntime* runtime = static_cast<NodeRuntime*>(handle->data);
+        std::vector<std::pair<std::string, std::vector<NodeValue>>> calls;
+        {
+            std::lock_guard<std::mutex> lock(runtime->m_impl->postMutex);
+            calls.swap(runtime->m_impl->postedCalls);
+        }
+        for (const auto& posted : calls) {
+            runtime->call(posted.first, posted.second);
+        }
+        runtime->m_impl->settleCompletedCalls();
+    });
+    m_impl->postHandle.data = this;
+
+    m_impl->running = true;
+    CRAZY_LOG_INFO("NodeRuntime: Node.js {} started{}", NODE_VERSION_STRING,
+                   m_impl->hasSnapshot() ? " from snapshot" : "");
+    return true;
+}
+
+bool NodeRuntime::buildSnapshot(const std::string& bundlePath, const std::string& snapshotPath,
+                                const std::vector<std::string>& args) {
+    if (m_impl->running) {
+        m_lastError = "Cannot build a snapshot while the runtime is running";
+        CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+        return false;
+    }
+
+#if !CRAZY_NODE_SNAPSHOTS
+    (void)bundlePath;
+    (void)snapshotPath;
+    (void)args;
+    m_lastError = "Startup snapshots need Node.js 20 or newer";
+    CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+    return false;
+#else
+    const std::string bundle = canonicalPath(bundlePath);
+    const std::string hash = hashFile(bundle);
+    if (hash.empty()) {
+        m_lastError = "Cannot read " + bundlePath;
+        CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+        return false;
+    }
+
+    std::shared_ptr<node::InitializationResult> init = m_impl->initializeProcess(args, m_lastError);
+    if (!init) {
+        return false;
+    }
+
+    // argv[1] becomes the builder's __filename; an anonymous one keeps
+    // build paths out of the snapshot. The builder reads argv[2] and argv[3].
+    std::vector<std::string> builderArgs = init->args();
+    builderArgs.resize(1);
+    builderArgs.push_back(node::GetAnonymousMainPath());
+    builderArgs.push_back(bundle);
+    builderArgs.push_back(hash);
+
+    std::vector<std::string> errors;
+    std::unique_ptr<node::CommonEnvironmentSetup> setup = node::CommonEnvironmentSetup::CreateForSnapshotting(
+        m_impl->platform.get(), &errors, builderArgs, init->exec_args());
+    if (!setup) {
+        m_lastError = errors.empty() ? "Failed to create Node.js environment" : errors.front();
+        CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+        m_impl->disposeProcess();
+        return false;
+    }
+
+    bool ok = false;
+    {
+        EnvironmentScope scope(*setup);
+        // Exceptions are reported by Node's own handler
+        if (!node::LoadEnvironment(setup->env(), kSnapshotBuilderSource).IsEmpty()) {
+            ok = node::SpinEventLoop(setup->env()).FromMaybe(1) == 0;
+        }
+    }
+
+    // Taken outside of any scope: V8 requires no active handles
+    node::EmbedderSnapshotData::Pointer snapshot;
+    if (ok) {
+        snapshot = setup->CreateSnapshot();
+    }
+
+    std::FILE* file = nullptr;
+    const std::string temporaryPath = snapshotPath + ".tmp";
+    if (!ok || !snapshot) {
+        m_lastError = "Failed to evaluate " + bundlePath + " for the snapshot";
+    } else if (!(file = std::fopen(temporaryPath.c_str(), "wb"))) {
+        m_lastError = "Cannot write " + snapshotPath;
+    } else {
+        snapshot->ToFile(file);
+        ok = std::fclose(file) == 0 && std::rename(temporaryPath.c_str(), snapshotPath.c_str()) == 0;
+        if (!ok) {
+            std::remove(temporaryPath.c_str());
+            m_lastError = "Cannot write " + snapshotPath;
+        }
+    }
+    ok = ok && snapshot;
+
+    setup.reset();
+    m_impl->disposeProcess();
+
+    if (!ok) {
+        CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+        return false;
+    }
+    CRAZY_LOG_INFO("NodeRuntime: Wrote snapshot of {} to {}", bundlePath.c_str(), snapshotPath.c_str());
+    return true;
+#endif
+}
+
+void NodeRuntime::setStartupSnapshot(const std::string& path) {
+    m_impl->snapshotPath = path;
+}
+
+bool NodeRuntime::isSnapshotLoaded() const {
+    return m_impl->running && m_impl->hasSnapshot();
+}
+
+void NodeRuntime::setCodeCacheDirectory(const std::string& directory) {
+    m_impl->codeCacheDirectory = directory;
+}
+
+bool NodeRuntime::isRunning() const {
+    return m_impl->running;
+}
+
+bool NodeRuntime::loadScript(const std::string& path) {
+    if (!m_impl->running) {
+        return false;
+    }
+
+    EnvironmentScope scope(*m_impl->setup);
+    v8::Isolate* isolate = m_impl->setup->isolate();
+
+    if (!m_impl->snapshotExports.IsEmpty() && canonicalPath(path) == m_impl->snapshotBundlePath) {
+        v8::Local<v8::Value> exports = m_impl->snapshotExports.Get(isolate);
+        m_impl->snapshotExports.Reset();
+        if (hashFile(m_impl->snapshotBundlePath) == m_impl->snapshotBundleHash) {
+            if (exports->IsObject()) {
+                m_impl->exports.Reset(isolate, exports.As<v8::Object>());
+            } else {
+                m_impl->exports.Reset();
+            }
+            m_impl->functionCache.clear();
+            return true;
+        }
+        CRAZY_LOG_WARNING("NodeRuntime: {} changed since the snapshot was built, loading it again",
+                          path.c_str());
+    }
+
+    v8::TryCatch tryCatch(isolate);
+
+    // Bare paths would be resolved as package names
+    std::string specifier = path;
+    if (!specifier.empty() && specifier[0] != '/' && specifier[0] != '.') {
+        specifier = "./" + specifier;
+    }
+
+    v8::Local<v8::Value> argv[] = { toV8String(isolate, specifier) };
+    v8::Local<v8::Value> exports;
+    if (!node::MakeCallback(isolate, scope.context->Global(), m_impl->require.Get(isolate),
+                            1, argv, {0, 0}).ToLocal(&exports)
+        || tryCatch.HasCaught()) {
+        m_lastError = tryCatch.HasCaught() ? describeException(isolate, scope.context, tryCatch)
+                                           : "require() failed";
+        CRAZY_LOG_ERROR("NodeRuntime: Failed to load {}: {}", path.c_str(), m_lastError.c_str());
+        return false;
+    }
+
+    if (exports->IsObject()) {
+        m_impl->exports.Reset(isolate, exports.As<v8::Object>());
+    } else {
+        m_impl->exports.Reset();
+    }
+    m_impl->functionCache.clear();
+    return true;
+}
+
+bool NodeRuntime::evaluate(const std::string& source, NodeValue* result) {
+    if (!m_impl->running) {
+        return false;
+    }
+
+    EnvironmentScope scope(*m_impl->setup);
+    v8::Isolate* isolate = m_impl->setup->isolate();
+
+    NodeValue value;
+    bool ok = false;
+    {
+        // Runs microtasks and process.nextTick callbacks when it closes
+        node::CallbackScope callbackScope(isolate, v8::Object::New(isolate), {0, 0});
+        v8::TryCatch tryCatch(isolate);
+
+        v8::Local<v8::Script> script;
+        v8::Local<v8::Value> completion;
+        if (v8::Script::Compile(scope.context, toV8String(isolate, source)).ToLocal(&script)
+            && script->Run(scope.context).ToLocal(&completion)) {
+            value = fromV8(isolate, completion);
+            ok = true;
+        } else {
+            m_lastError = tryCatch.HasCaught() ? describeException(isolate, scope.context, tryCatch)
+                                               : "evaluation failed";
+            CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+        }
+    }
+
+    if (ok && result) {
+        *result = std::move(value);
+    }
+    return ok;
+}
+
+bool NodeRuntime::call(const std::string& function, const std::vector<NodeValue>& args,
+                       NodeValue* result) {
+    if (!m_impl->running) {
+        return false;
+    }
+
+    EnvironmentScope scope(*m_impl->setup);
+    v8::Isolate* isolate = m_impl->setup->isolate();
+
+    v8::Local<v8::Object> receiver;
+    v8::Local<v8::Function> callee;
+    auto cached = m_impl->functionCache.find(function);
+    if (cached != m_impl->functionCache.end()) {
+        receiver = cached->second.receiver.Get(isolate);
+        callee = cached->second.function.Get(isolate);
+    } else {
+        if (!m_impl->resolve(isolate, scope.context, function, receiver, callee)) {
+            m_lastError = "Function not found: " + function;
+            CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+            return false;
+        }
+        Impl::CachedFunction& entry = m_impl->functionCache[function];
+        entry.receiver.Reset(isolate, receiver);
+        entry.function.Reset(isolate, callee);
+    }
+
+    std::vector<v8::Local<v8::Value>> argv;
+    argv.reserve(args.size());
+    for (const NodeValue& arg : args) {
+        argv.push_back(toV8(isolate, arg));
+    }
+
+    // MakeCallback() returns undefined rather than an empty handle when the
+    // callee throws outside of any callback scope, so check the TryCatch too
+    v8::TryCatch tryCatch(isolate);
+    v8::Local<v8::Value> returned;
+    if (!node::MakeCallback(isolate, receiver, callee, static_cast<int>(argv.size()),
+                            argv.data(), {0, 0}).ToLocal(&returned)
+        || tryCatch.HasCaught()) {
+        m_lastError = tryCatch.HasCaught() ? describeException(isolate, scope.context, tryCatch)
+                                           : "call failed: " + function;
+        CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+        return false;
+    }
+
+    if (result) {
+        *result = fromV8(isolate, returned);
+    }
+    return true;
+}
+
+void NodeRuntime::registerFunction(const std::string& name, NativeFunction function) {
+    auto it = m_impl->natives.find(name);
+    if (it != m_impl->natives.end()) {
+        // The JS function already points at this entry
+        *it->second = std::move(function);
+        return;
+    }
+
+    auto entry = std::make_unique<NativeFunction>(std::move(function));
+    NativeFunction* pointer = entry.get();
+    m_impl->natives.emplace(name, std::move(entry));
+
+    if (m_impl->running) {
+        EnvironmentScope scope(*m_impl->setup);
+        m_impl->installNative(m_impl->setup->isolate(), scope.context, name, invokeNative, pointer);
+    }
+}
+
+void NodeRuntime::registerAsyncFunction(const std::string& name, AsyncFunction function) {
+    auto it = m_impl->asyncNatives.find(name);
+    if (it != m_impl->asyncNatives.end()) {
+        it->second->function = std::make_shared<AsyncFunction>(std::move(function));
+        return;
+    }
+
+    auto entry = std::make_unique<Impl::AsyncEntry>();
+    entry->impl = m_impl.get();
+    entry->function = std::make_shared<AsyncFunction>(std::move(function));
+    Impl::AsyncEntry* pointer = entry.get();
+    m_impl->asyncNatives.emplace(name, std::move(entry));
+
+    if (m_impl->running) {
+        EnvironmentScope scope(*m_impl->setup);
+        m_impl->installNative(m_impl->setup->isolate(), scope.context, name, Impl::invokeAsync, pointer);
+    }
+}
+
+void NodeRuntime::setTaskPoolSettings(const TaskPoolSettings& settings) {
+    if (m_impl->taskPool) {
+        CRAZY_LOG_WARNING("NodeRuntime: Task pool already created, settings ignored");
+        return;
+    }
+    m_impl->taskPoolSettings = settings;
+}
+
+TaskPool& NodeRuntime::getTaskPool() {
+    return m_impl->getTaskPool();
+}
+
+bool NodeRuntime::shareMemory(const std::string& name, void* data, size_t size) {
+    if (!m_impl->running || !data) {
+        return false;
+    }
+
+    EnvironmentScope scope(*m_impl->setup);
+    v8::Isolate* isolate = m_impl->setup->isolate();
+    v8::Local<v8::Object> nativeObject = m_impl->nativeObject.Get(isolate);
+
+    v8::Local<v8::String> sharedKey = toV8String(isolate, "shared");
+    v8::Local<v8::Value> shared;
+    if (!nativeObject->Get(scope.context, sharedKey).ToLocal(&shared) || !shared->IsObject()) {
+        shared = v8::Object::New(isolate);
+        nativeObject->Set(scope.context, sharedKey, shared).Check();
+    }
+
+    // The memory belongs to the caller: the deleter does nothing
+    std::shared_ptr<v8::BackingStore> store = v8::SharedArrayBuffer::NewBackingStore(
+        data, size, [](void*, size_t, void*) {}, nullptr);
+    v8::Local<v8::SharedArrayBuffer> buffer = v8::SharedArrayBuffer::New(isolate, std::move(store));
+    return shared.As<v8::Object>()->Set(scope.context, toV8String(isolate, name), buffer).FromMaybe(false);
+}
+
+bool NodeRuntime::postCall(const std::string& function, std::vector<NodeValue> args) {
+    std::lock_guard<std::mutex> lock(m_impl->postMutex);
+    if (!m_impl->running) {
+        return false;
+    }
+    m_impl->postedCalls.emplace_back(function, std::move(args));
+    uv_async_send(&m_impl->postHandle);
+    return true;
+}
+
+bool NodeRuntime::runPendingEvents(double timeBudget) {
+    if (!m_impl->running) {
+        return false;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point deadline = Clock::now()
+        + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeBudget));
+
+    EnvironmentScope scope(*m_impl->setup);
+    uv_loop_t* loop = m_impl->setup->event_loop();
+    v8::Isolate* isolate = m_impl->setup->isolate();
+
+    // A zero backend timeout means timers are due or callbacks are queued
+    // for the next pass (e.g. I/O callbacks that started more work)
+    do {
+        uv_run(loop, UV_RUN_NOWAIT);
+        m_impl->platform->FlushForegroundTasks(isolate);
+    } while (uv_loop_alive(loop) && uv_backend_timeout(loop) == 0 && Clock::now() < deadline);
+
+    return uv_loop_alive(loop) && uv_backend_timeout(loop) == 0;
+}
+
+bool NodeRuntime::startEventWatcher(std::function<void()> wakeup) {
+    if (!m_impl->running || !wakeup) {
+        return false;
+    }
+    if (m_impl->watcher.thread.joinable()) {
+        return true;
+    }
+
+#ifdef _WIN32
+    CRAZY_LOG_WARNING("NodeRuntime: event watcher is not supported on this platform");
+    return false;
+#else
+    Impl::EventWatcher& watcher = m_impl->watcher;
+    watcher.backendFd = uv_backend_fd(m_impl->setup->event_loop());
+    if (watcher.backendFd < 0 || pipe(watcher.interruptFds) != 0) {
+        CRAZY_LOG_WARNING("NodeRuntime: libuv backend cannot be watched");
+        return false;
+    }
+
+    watcher.wakeup = std::move(wakeup);
+    watcher.armed = false;
+    watcher.stopping = false;
+    watcher.thread = std::thread([this] { m_impl->watchLoop(); });
+    return true;
+#endif
+}
+
+void NodeRuntime::stopEventWatcher() {
+#ifndef _WIN32
+    Impl::EventWatcher& watcher = m_impl->watcher;
+    if (!watcher.thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(watcher.mutex);
+        watcher.stopping = true;
+        watcher.armed = false;
+    }
+    watcher.condition.notify_one();
+    m_impl->interruptWatcher();
+    watcher.thread.join();
+
+    close(watcher.interruptFds[0]);
+    close(watcher.interruptFds[1]);
+    watcher.interruptFds[0] = watcher.interruptFds[1] = -1;
+    watcher.wakeup = nullptr;
+#endif
+}
+
+bool NodeRuntime::isEventWatcherRunning() const {
+    return m_impl->watcher.thread.joinable();
+}
+
+void NodeRuntime::armEventWatcher() {
+#ifndef _WIN32
+    Impl::EventWatcher& watcher = m_impl->watcher;
+    if (!watcher.thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(watcher.mutex);
+        // uv_backend_timeout() is 0 for a loop without active handles, which
+        // has nothing to wait for
+        uv_loop_t* loop = m_impl->setup->event_loop();
+        watcher.timeoutMs = uv_loop_alive(loop) ? uv_backend_timeout(loop) : -1;
+        watcher.armed = true;
+        ++watcher.generation;
+    }
+    watcher.condition.notify_one();
+    // Cut short a poll that may still use a stale timeout
+    m_impl->interruptWatcher();
+#endif
+}
+
+void NodeRuntime::disarmEventWatcher() {
+    Impl::EventWatcher& watcher = m_impl->watcher;
+    if (!watcher.thread.joinable()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(watcher.mutex);
+    watcher.armed = false;
+    ++watcher.generation;
+}
+
+void NodeRuntime::shutdown() {
+    if (!m_impl->running) {
+        return;
+    }
+    stopEventWatcher();
+    {
+        std::lock_guard<std::mutex> lock(m_impl->postMutex);
+        m_impl->running = false;
+        m_impl->postedCalls.clear();
+    }
+
+    // Async calls in flight are abandoned; running ones are asked to stop
+    // and waited for, since they post to the handle closed below
+    for (auto& entry : m_impl->pendingCalls) {
+        entry.second.cancelled->store(true, std::memory_order_relaxed);
+    }
+    if (m_impl->taskPool) {
+        m_impl->taskPool->shutdown();
+    }
+
+    {
+        EnvironmentScope scope(*m_impl->setup);
+        // The loop cannot be closed with open handles; this pass may also
+        // run other ready callbacks, hence the scope
+        uv_close(reinterpret_cast<uv_handle_t*>(&m_impl->postHandle), nullptr);
+        uv_run(m_impl->setup->event_loop(), UV_RUN_NOWAIT);
+        node::EmitProcessExit(m_impl->setup->env());
+    }
+
+    m_impl->pendingCalls.clear();
+    m_impl->completedCalls.clear();
+    m_impl->functionCache.clear();
+    m_impl->exports.Reset();
+    m_impl->require.Reset();
+    m_impl->nativeObject.Reset();
+    m_impl->snapshotExports.Reset();
+
+    node::Stop(m_impl->setup->env());
+    m_impl->setup.reset();
+#if CRAZY_NODE_SNAPSHOTS
+    m_impl->snapshot.reset();
+#endif
+    m_impl->disposeProcess();
+}
+
+#else // !NODE_EMBED_ENABLED
+
+struct NodeRuntime::Impl {
+    std::map<std::string, NativeFunction> natives;
+    std::map<std::string, AsyncFunction> asyncNatives;
+    TaskPoolSettings taskPoolSettings;
+    std::unique_ptr<TaskPool> taskPool;
+};
+
+NodeRuntime::NodeRuntime()
+    : m_impl(std::make_unique<Impl>())
+{
+}
+
+NodeRuntime::~NodeRuntime() = default;
+
+bool NodeRuntime::isAvailable() {
+    return false;
+}
+
+bool NodeRuntime::start(const std::vector<std::string>&) {
+    m_lastError = "Node.js embedding is not available (build with NODE_INCLUDE_DIR and NODE_LIBRARY)";
+    CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+    return false;
+}
+
+bool NodeRuntime::isRunning() const {
+    return false;
+}
+
+bool NodeRuntime::buildSnapshot(const std::string&, const std::string&, const std::vector<std::string>&) {
+    m_lastError = "Node.js embedding is not available (build with NODE_INCLUDE_DIR and NODE_LIBRARY)";
+    CRAZY_LOG_ERROR("NodeRuntime: {}", m_lastError.c_str());
+    return false;
+}
+
+void NodeRuntime::setStartupSnapshot(const std::string&) {
+}
+
+bool NodeRuntime::isSnapshotLoaded() const {
+    return false;
+}
+
+void NodeRuntime::setCodeCacheDirectory(const std::string&) {
+}
+
+bool NodeRuntime::loadScript(const std::string&) {
+    return false;
+}
+
+bool NodeRuntime::evaluate(const std::string&, NodeValue*) {
+    return false;
+}
+
+bool NodeRuntime::call(const std::string&, const std::vector<NodeValue>&, NodeValue*) {
+    return false;
+}
+
+void NodeRuntime::registerFunction(const std::string& name, NativeFunction function) {
+    m_impl->natives[name] = std::move(function);
+}
+
+void NodeRuntime::registerAsyncFunction(const std::string& name, AsyncFunction function) {
+    m_impl->asyncNatives[name] = std::move(function);
+}
+
+void NodeRuntime::setTaskPoolSettings(const TaskPoolSettings& settings) {
+    m_impl->taskPoolSettings = settings;
+}
+
+TaskPool& NodeRuntime::getTaskPool() {
+    if (!m_impl->taskPool) {
+        m_impl->taskPool = std::make_unique<TaskPool>(m_impl->taskPoolSettings);
+    }
+    return *m_impl->taskPool;
+}
+
+bool NodeRuntime::shareMemory(const std::string&, void*, size_t) {
+    return false;
+}
+
+bool NodeRuntime::postCall(const std::string&, std::vector<NodeValue>) {
+    return false;
+}
+
+bool NodeRuntime::runPendingEvents(double) {
+    return false;
+}
+
+bool NodeRuntime::startEventWatcher(std::function<void()>) {
+    return false;
+}
+
+void NodeRuntime::stopEventWatcher() {
+}
+
+bool NodeRuntime::isEventWatcherRunning() const {
+    return false;
+}
+
+void NodeRuntime::armEventWatcher() {
+}
+
+void NodeRuntime::disarmEventWatcher() {
+}
+
+void NodeRuntime::shutdown() {
+}
+
+#endif // NODE_EMBED_ENABLED
+
+NodeRuntime& NodeRuntime::instance() {
+    static NodeRuntime s_instance;
+    return s_instance;
+}
+
+const std::string& NodeRuntime::getLastError() const {
+    return m_lastError;
+}
+
+} // namespace crazy
@@ -0,0 +1,617 @@
+#include "crazy/NodeWorker.hpp"
+#include "crazy/Log.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace crazy {
+
+namespace {
+
+// Frames are a u32 payload length followed by the payload; all integers
+// little-endian. Requests: u32 id, u8 kind, u32 name length, name, u32
+// argument count, values. Responses: u32 id, u8 status, then the value
+// (success) or a u32-length error string.
+constexpr std::uint8_t kRequestCall = 1;
+constexpr std::uint8_t kRequestPing = 2;
+constexpr std::uint8_t kStatusOk = 0;
+
+constexpr std::uint8_t kValueUndefined = 0;
+constexpr std::uint8_t kValueNull = 1;
+constexpr std::uint8_t kValueFalse = 2;
+constexpr std::uint8_t kValueTrue = 3;
+constexpr std::uint8_t kValueNumber = 4;
+constexpr std::uint8_t kValueString = 5;
+
+// Largest frame accepted from the worker
+constexpr std::uint32_t kMaxFrameSize = 64u * 1024u * 1024u;
+
+void putU32(std::vector<unsigned char>& out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    }
+}
+
+void putBytes(std::vector<unsigned char>& out, const std::string& value) {
+    putU32(out, static_cast<std::uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+void putValue(std::vector<unsigned char>& out, const NodeValue& value) {
+    switch (value.getType()) {
+    case NodeValue::Type::Undefined:
+        out.push_back(kValueUndefined);
+        break;
+    case NodeValue::Type::Null:
+        out.push_back(kValueNull);
+        break;
+    case NodeValue::Type::Boolean:
+        out.push_back(value.asBoolean() ? kValueTrue : kValueFalse);
+        break;
+    case NodeValue::Type::Number: {
+        out.push_back(kValueNumber);
+        std::uint64_t bits;
+        double number = value.asNumber();
+        std::memcpy(&bits, &number, sizeof(bits));
+        for (int i = 0; i < 8; ++i) {
+            out.push_back(static_cast<unsigned char>(bits >> (8 * i)));
+        }
+        break;
+    }
+    case NodeValue::Type::String:
+        out.push_back(kValueString);
+        putBytes(out, value.asString());
+        break;
+    }
+}
+
+// Bounds-checked reader over one frame
+class FrameReader {
+public:
+    FrameReader(const unsigned char* data, std::size_t size)
+        : m_data(data)
+        , m_size(size)
+        , m_offset(0)
+    {
+    }
+
+    bool readU8(std::uint8_t& value) {
+        if (m_size - m_offset < 1) {
+            return false;
+        }
+        value = m_data[m_offset++];
+        return true;
+    }
+
+    bool readU32(std::uint32_t& value) {
+        if (m_size - m_offset < 4) {
+            return false;
+        }
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<std::uint32_t>(m_data[m_offset++]) << (8 * i);
+        }
+        return true;
+    }
+
+    bool readString(std::string& value) {
+        std::uint32_t length;
+        if (!readU32(length) || m_size - m_offset < length) {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char*>(m_data + m_offset), length);
+        m_offset += length;
+        return true;
+    }
+
+    bool readValue(NodeValue& value) {
+        std::uint8_t tag;
+        if (!readU8(tag)) {
+            return false;
+        }
+        switch (tag) {
+        case kValueUndefined:
+            value = NodeValue();
+            return true;
+        case kValueNull:
+            value = NodeValue::null();
+            return true;
+        case kValueFalse:
+        case kValueTrue:
+            value = NodeValue(tag == kValueTrue);
+            return true;
+        case kValueNumber: {
+            if (m_size - m_offset < 8) {
+                return false;
+            }
+            std::uint64_t bits = 0;
+            for (int i = 0; i < 8; ++i) {
+                bits |= static_cast<std::uint64_t>(m_data[m_offset++]) << (8 * i);
+            }
+            double number;
+            std::memcpy(&number, &bits, sizeof(number));
+            value = NodeValue(number);
+            return true;
+        }
+        case kValueString: {
+            std::string text;
+            if (!readString(text)) {
+                return false;
+            }
+            value = NodeValue(std::move(text));
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+private:
+    const unsigned char* m_data;
+    std::size_t m_size;
+    std::size_t m_offset;
+};
+
+} // namespace
+
+NodeWorker::NodeWorker()
+    : m_pid(-1)
+    , m_fd(-1)
+    , m_nextId(1)
+    , m_outputOffset(0)
+    , m_inputOffset(0)
+    , m_pingId(0)
+    , m_restarts(0)
+{
+}
+
+NodeWorker::~NodeWorker() {
+    stop();
+}
+
+bool NodeWorker::start(const NodeWorkerOptions& options) {
+    if (isRunning()) {
+        m_lastError = "Node worker is already running";
+        return false;
+    }
+    m_options = options;
+    m_restarts = 0;
+    return spawn();
+}
+
+bool NodeWorker::isRunning() const {
+    return m_fd >= 0;
+}
+
+std::uint32_t NodeWorker::callAsync(const std::string& function, const std::vector<NodeValue>& args,
+                                    Callback callback) {
+    if (!isRunning()) {
+        m_lastError = "Node worker is not running";
+        return 0;
+    }
+    return send(kRequestCall, function, args, std::move(callback));
+}
+
+bool NodeWorker::call(const std::string& function, const std::vector<NodeValue>& args,
+                      NodeValue* result, double timeoutSeconds) {
+    bool done = false;
+    bool succeeded = false;
+    std::uint32_t id = callAsync(function, args,
+        [&](bool ok, const NodeValue& value, const std::string& error) {
+            done = true;
+            succeeded = ok;
+            if (ok && result) {
+                *result = value;
+            } else if (!ok) {
+                m_lastError = error;
+            }
+        });
+    if (id == 0) {
+        return false;
+    }
+
+    const Clock::time_point start = Clock::now();
+    while (!done) {
+        double remaining = -1.0;
+        if (timeoutSeconds >= 0.0) {
+            remaining = timeoutSeconds - std::chrono::duration<double>(Clock::now() - start).count();
+            if (remaining <= 0.0) {
+                // A late response must not write through the dangling captures
+                m_pending[id] = nullptr;
+                m_lastError = "Node worker call timed out: " + function;
+                return false;
+            }
+        }
+        poll(remaining < 0.0 ? 0.1 : std::min(remaining, 0.1));
+        if (!done && !isRunning()) {
+            break;
+        }
+    }
+    return done && succeeded;
+}
+
+#ifndef _WIN32
+
+bool NodeWorker::spawn() {
+    int fds[2];
+#ifdef SOCK_CLOEXEC
+    const int type = SOCK_STREAM | SOCK_CLOEXEC;
+#else
+    const int type = SOCK_STREAM;
+#endif
+    if (socketpair(AF_UNIX, type, 0, fds) != 0) {
+        m_lastError = std::string("Failed to create socket pair: ") + std::strerror(errno);
+        CRAZY_LOG_ERROR("NodeWorker: {}", m_lastError);
+        return false;
+    }
+#ifndef SOCK_CLOEXEC
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+    // dup2() onto the same descriptor would keep close-on-exec set
+    if (fds[1] == 3) {
+        fcntl(fds[1], F_SETFD, 0);
+    }
+
+    std::vector<std::string> arguments;
+    arguments.push_back(m_options.nodeExecutable);
+    arguments.insert(arguments.end(), m_options.nodeArguments.begin(), m_options.nodeArguments.end());
+    arguments.push_back(m_options.workerScript);
+    if (!m_options.script.empty()) {
+        arguments.push_back(m_options.script);
+    }
+    std::vector<char*> argv;
+    for (std::string& argument : arguments) {
+        argv.push_back(&argument[0]);
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], 3);
+
+    pid_t pid = -1;
+    int error = posix_spawnp(&pid, m_options.nodeExecutable.c_str(), &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+
+    if (error != 0) {
+        close(fds[0]);
+        m_lastError = "Failed to start " + m_options.nodeExecutable + ": " + std::strerror(error);
+        CRAZY_LOG_ERROR("NodeWorker: {}", m_lastError);
+        return false;
+    }
+
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fds[0], SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+    m_pid = pid;
+    m_fd = fds[0];
+    m_output.clear();
+    m_outputOffset = 0;
+    m_input.clear();
+    m_inputOffset = 0;
+    m_pingId = 0;
+    m_lastPing = Clock::now();
+    m_lastReply = m_lastPing;
+    CRAZY_LOG_INFO("NodeWorker: Started {} (pid {})", m_options.workerScript, m_pid);
+    return true;
+}
+
+void NodeWorker::terminate() {
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    if (m_pid > 0) {
+        // The worker exits by itself when its socket closes; give it a moment
+        int status = 0;
+        pid_t result = 0;
+        for (int i = 0; i < 100 && (result = waitpid(m_pid, &status, WNOHANG)) == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        if (result == 0) {
+            kill(m_pid, SIGKILL);
+            waitpid(m_pid, &status, 0);
+        }
+        m_pid = -1;
+    }
+    m_output.clear();
+    m_outputOffset = 0;
+    m_input.clear();
+    m_inputOffset = 0;
+    m_pingId = 0;
+}
+
+std::uint32_t NodeWorker::send(std::uint8_t kind, const std::string& name, const std::vector<NodeValue>& args,
+                               Callback callback) {
+    std::uint32_t id = m_nextId++;
+    if (m_nextId == 0) {
+        m_nextId = 1;
+    }
+
+    // Length placeholder, patched below
+    const std::size_t start = m_output.size();
+    putU32(m_output, 0);
+    putU32(m_output, id);
+    m_output.push_back(kind);
+    putBytes(m_output, name);
+    putU32(m_output, static_cast<std::uint32_t>(args.size()));
+    for (const NodeValue& arg : args) {
+        putValue(m_output, arg);
+    }
+    const std::uint32_t length = static_cast<std::uint32_t>(m_output.size() - start - 4);
+    for (int i = 0; i < 4; ++i) {
+        m_output[start + i] = static_cast<unsigned char>(length >> (8 * i));
+    }
+
+    m_pending.emplace(id, std::move(callback));
+    flushOutput();
+    return id;
+}
+
+bool NodeWorker::flushOutput() {
+    while (m_fd >= 0 && m_outputOffset < m_output.size()) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        ssize_t written = ::send(m_fd, m_output.data() + m_outputOffset, m_output.size() - m_outputOffset, flags);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        m_outputOffset += static_cast<std::size_t>(written);
+    }
+    m_output.clear();
+    m_outputOffset = 0;
+    return true;
+}
+
+bool NodeWorker::readInput() {
+    unsigned char buffer[65536];
+    for (;;) {
+        ssize_t count = ::recv(m_fd, buffer, sizeof(buffer), 0);
+        if (count > 0) {
+            m_input.insert(m_input.end(), buffer, buffer + count);
+            continue;
+        }
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+std::size_t NodeWorker::poll(double timeoutSeconds) {
+    if (!isRunning()) {
+        return 0;
+    }
+    if (!flushOutput()) {
+        fail("Failed to write to the Node worker");
+        return 0;
+    }
+
+    pollfd descriptor;
+    descriptor.fd = m_fd;
+    descriptor.events = POLLIN;
+    if (m_outputOffset < m_output.size()) {
+        descriptor.events |= POLLOUT;
+    }
+    descriptor.revents = 0;
+    int timeout = timeoutSeconds > 0.0 ? static_cast<int>(std::ceil(timeoutSeconds * 1000.0)) : 0;
+    if (::poll(&descriptor, 1, timeout) < 0 && errno != EINTR) {
+        return 0;
+    }
+
+    if (descriptor.revents & POLLOUT) {
+        flushOutput();
+    }
+
+    std::size_t dispatched = 0;
+    if (descriptor.revents & (POLLIN | POLLHUP | POLLERR)) {
+        bool open = readInput();
+        dispatched = dispatchResponses();
+        if (!open) {
+            fail("Node worker exited");
+            return dispatched;
+        }
+    }
+
+    checkHealth();
+    return dispatched;
+}
+
+std::size_t NodeWorker::dispatchResponses() {
+    std::size_t dispatched = 0;
+    while (isRunning() && m_input.size() - m_inputOffset >= 4) {
+        FrameReader header(m_input.data() + m_inputOffset, 4);
+        std::uint32_t length = 0;
+        header.readU32(length);
+        if (length > kMaxFrameSize) {
+            fail("Invalid frame from the Node worker");
+            return dispatched;
+        }
+        if (m_input.size() - m_inputOffset - 4 < length) {
+            break;
+        }
+
+        FrameReader frame(m_input.data() + m_inputOffset + 4, length);
+        std::uint32_t id = 0;
+        std::uint8_t status = 0;
+        NodeValue value;
+        std::string error;
+        bool valid = frame.readU32(id) && frame.readU8(status)
+            && (status == kStatusOk ? frame.readValue(value) : frame.readString(error));
+
+        // Consumed before the callback runs: it may call back into the worker
+        m_inputOffset += 4 + length;
+        if (!valid) {
+            CRAZY_LOG_WARNING("NodeWorker: Dropped malformed response");
+            continue;
+        }
+
+        m_lastReply = Clock::now();
+        if (id == m_pingId) {
+            m_pingId = 0;
+        }
+        auto it = m_pending.find(id);
+        if (it == m_pending.end()) {
+            continue;
+        }
+        Callback callback = std::move(it->second);
+        m_pending.erase(it);
+        if (callback) {
+            callback(status == kStatusOk, value, error);
+        }
+        ++dispatched;
+    }
+
+    if (m_inputOffset == m_input.size()) {
+        m_input.clear();
+        m_inputOffset = 0;
+    } else if (m_inputOffset > 65536) {
+        m_input.erase(m_input.begin(), m_input.begin() + static_cast<std::ptrdiff_t>(m_inputOffset));
+        m_inputOffset = 0;
+    }
+    return dispatched;
+}
+
+void NodeWorker::checkHealth() {
+    if (m_options.healthCheckInterval <= 0.0 || !isRunning()) {
+        return;
+    }
+    const Clock::time_point now = Clock::now();
+    if (m_pingId != 0) {
+        if (std::chrono::duration<double>(now - m_lastPing).count() > m_options.healthCheckTimeout) {
+            fail("Node worker stopped responding");
+        }
+        return;
+    }
+    if (std::chrono::duration<double>(now - m_lastReply).count() >= m_options.healthCheckInterval
+        && std::chrono::duration<double>(now - m_lastPing).count() >= m_options.healthCheckInterval) {
+        m_lastPing = now;
+        m_pingId = send(kRequestPing, std::string(), {}, nullptr);
+    }
+}
+
+void NodeWorker::fail(const std::string& error) {
+    m_lastError = error;
+    CRAZY_LOG_WARNING("NodeWorker: {}", error);
+
+    // Shut down first so that callbacks see a consistent state
+    terminate();
+    std::unordered_map<std::uint32_t, Callback> pending;
+    pending.swap(m_pending);
+
+    if (m_options.healthCheckInterval > 0.0) {
+        if (m_restarts < m_options.maxRestarts) {
+            ++m_restarts;
+            CRAZY_LOG_INFO("NodeWorker: Restarting ({} of {})", m_restarts, m_options.maxRestarts);
+            spawn();
+        } else {
+            CRAZY_LOG_ERROR("NodeWorker: Giving up after {} restarts", m_restarts);
+        }
+    }
+
+    for (auto& entry : pending) {
+        if (entry.second) {
+            entry.second(false, NodeValue(), error);
+        }
+    }
+}
+
+void NodeWorker::stop() {
+    if (m_pid < 0 && m_fd < 0) {
+        return;
+    }
+    terminate();
+    std::unordered_map<std::uint32_t, Callback> pending;
+    pending.swap(m_pending);
+    for (auto& entry : pending) {
+        if (entry.second) {
+            entry.second(false, NodeValue(), "Node worker stopped");
+        }
+    }
+}
+
+#else // _WIN32
+
+bool NodeWorker::spawn() {
+    m_lastError = "NodeWorker is not supported on this platform";
+    CRAZY_LOG_ERROR("NodeWorker: {}", m_lastError);
+    return false;
+}
+
+void NodeWorker::terminate() {
+}
+
+std::uint32_t NodeWorker::send(std::uint8_t, const std::string&, const std::vector<NodeValue>&, Callback) {
+    return 0;
+}
+
+bool NodeWorker::flushOutput() {
+    return false;
+}
+
+bool NodeWorker::readInput() {
+    return false;
+}
+
+std::size_t NodeWorker::poll(double) {
+    return 0;
+}
+
+std::size_t NodeWorker::dispatchResponses() {
+    return 0;
+}
+
+void NodeWorker::checkHealth() {
+}
+
+void NodeWorker::fail(const std::string& error) {
+    m_lastError = error;
+}
+
+void NodeWorker::stop() {
+}
+
+#endif // _WIN32
+
+int NodeWorker::getFd() const {
+    return m_fd;
+}
+
+std::size_t NodeWorker::getPendingCount() const {
+    return m_pending.size();
+}
+
+int NodeWorker::getRestartCount() const {
+    return m_restarts;
+}
+
+const std::string& NodeWorker::getLastError() const {
+    return m_lastError;
+}
+
+} // namespace crazy
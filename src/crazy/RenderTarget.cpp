@@ -0,0 +1,177 @@
+#include "crazy/RenderTarget.hpp"
+#include "crazy/Log.hpp"
+#include "crazy/MemoryTracker.hpp"
+#include "GLFunctions.hpp"
+#include <algorithm>
+
+namespace crazy {
+
+namespace {
+
+int roundUpToBucket(int size) {
+    return (size + RenderTarget::kGrowthBucket - 1) / RenderTarget::kGrowthBucket * RenderTarget::kGrowthBucket;
+}
+
+} // namespace
+
+RenderTarget::RenderTarget(bool depthStencil)
+    : m_depthStencil(depthStencil)
+    , m_framebuffer(0)
+    , m_colorTexture(0)
+    , m_depthStencilBuffer(0)
+    , m_width(0)
+    , m_height(0)
+    , m_complete(false)
+    , m_memoryId(0)
+    , m_shrinkSince(-1.0)
+{
+}
+
+RenderTarget::~RenderTarget() {
+    release();
+}
+
+bool RenderTarget::resize(int width, int height) {
+    if (width <= 0 || height <= 0 || !gl::load()) {
+        return false;
+    }
+    if (m_framebuffer && width == m_width && height == m_height) {
+        return m_complete;
+    }
+    
+    if (!m_framebuffer) {
+        gl::GenFramebuffers(1, &m_framebuffer);
+        glGenTextures(1, &m_colorTexture);
+        if (m_depthStencil) {
+            gl::GenRenderbuffers(1, &m_depthStencilBuffer);
+        }
+    }
+    
+    GLint previousTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+    
+    glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previousTexture));
+    
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    
+    gl::BindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    gl::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+    if (m_depthStencil) {
+        gl::BindRenderbuffer(GL_RENDERBUFFER, m_depthStencilBuffer);
+        gl::RenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        gl::BindRenderbuffer(GL_RENDERBUFFER, 0);
+        gl::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                                    GL_RENDERBUFFER, m_depthStencilBuffer);
+    }
+    
+    m_complete = gl::CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    gl::BindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+    
+    if (!m_complete) {
+        CRAZY_LOG_ERROR("RenderTarget: framebuffer incomplete at {}x{}", width, height);
+    }
+    
+    // RGBA8 color plus, if present, a DEPTH24_STENCIL8 buffer
+    std::size_t bytes = MemoryTracker::estimateTextureSize(width, height, m_depthStencil ? 8 : 4);
+    MemoryTracker& memory = MemoryTracker::instance();
+    if (m_memoryId) {
+        memory.resize(m_memoryId, bytes);
+    } else {
+        m_memoryId = memory.track(MemoryCategory::FramebufferLayers, bytes, "RenderTarget");
+    }
+    
+    m_width = width;
+    m_height = height;
+    return m_complete;
+}
+
+bool RenderTarget::ensureSize(int width, int height, double shrinkDelay) {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    
+    // Too small: grow now, keeping the larger dimension of the old storage
+    if (!m_framebuffer || width > m_width || height > m_height) {
+        m_shrinkSince = -1.0;
+        return resize(std::max(roundUpToBucket(width), m_width),
+                      std::max(roundUpToBucket(height), m_height));
+    }
+    
+    // Much too large: shrink once the smaller size has persisted
+    const bool oversized = 2LL * width * height <= static_cast<long long>(m_width) * m_height;
+    if (!oversized) {
+        m_shrinkSince = -1.0;
+        return m_complete;
+    }
+    const double now = glfwGetTime();
+    if (m_shrinkSince < 0.0) {
+        m_shrinkSince = now;
+    } else if (now - m_shrinkSince >= shrinkDelay) {
+        m_shrinkSince = -1.0;
+        return resize(roundUpToBucket(width), roundUpToBucket(height));
+    }
+    return m_complete;
+}
+
+void RenderTarget::bind() {
+    if (m_framebuffer) {
+        gl::BindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    }
+}
+
+void RenderTarget::bindDefault() {
+    if (gl::isLoaded()) {
+        gl::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
+
+bool RenderTarget::isValid() const {
+    return m_complete;
+}
+
+int RenderTarget::getWidth() const {
+    return m_width;
+}
+
+int RenderTarget::getHeight() const {
+    return m_height;
+}
+
+GLuint RenderTarget::getFramebuffer() const {
+    return m_framebuffer;
+}
+
+GLuint RenderTarget::getColorTexture() const {
+    return m_colorTexture;
+}
+
+void RenderTarget::release() {
+    if (!m_framebuffer || !gl::isLoaded()) {
+        return;
+    }
+    
+    gl::DeleteFramebuffers(1, &m_framebuffer);
+    glDeleteTextures(1, &m_colorTexture);
+    if (m_depthStencilBuffer) {
+        gl::DeleteRenderbuffers(1, &m_depthStencilBuffer);
+    }
+    
+    m_framebuffer = 0;
+    m_colorTexture = 0;
+    m_depthStencilBuffer = 0;
+    MemoryTracker::instance().untrack(m_memoryId);
+    m_memoryId = 0;
+    m_width = 0;
+    m_height = 0;
+    m_complete = false;
+    m_shrinkSince = -1.0;
+}
+
+} // namespace crazy
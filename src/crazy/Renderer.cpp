@@ -1,13 +1,65 @@
 #include "crazy/Renderer.hpp"
+#include "crazy/Log.hpp"
+#include "GLFunctions.hpp"
+#include <algorithm>
 
 namespace crazy {
 
+namespace {
+
+const int kDefaultFramesInFlight = 2;
+const int kMaxFramesInFlight = 8;
+
+// Upper bound for a single glClientWaitSync call, in nanoseconds
+const GLuint64 kFenceTimeout = 100000000;
+
+} // namespace
+
 Renderer::Renderer()
     : m_clearColor{0.0f, 0.0f, 0.0f, 1.0f}
+    , m_bufferManager(std::make_unique<BufferManager>(4 * 1024 * 1024, 1024 * 1024, kDefaultFramesInFlight))
+    , m_frameFences(kDefaultFramesInFlight, nullptr)
+    , m_timerQueries(kDefaultFramesInFlight, 0)
+    , m_timerQueryPending(kDefaultFramesInFlight, false)
+    , m_timestampQueries(kDefaultFramesInFlight, 0)
+    , m_slotInputs(kDefaultFramesInFlight)
+    , m_gpuClockOffset(0.0)
+    , m_frameStartTime(0.0)
+    , m_drawCalls(0)
+    , m_stateChanges(0)
+    , m_maxFramesInFlight(kDefaultFramesInFlight)
+    , m_pendingFramesInFlight(kDefaultFramesInFlight)
 {
+    m_frameStats.maxFramesInFlight = m_maxFramesInFlight;
+    
+    // Resolve GL entry points for the current context, if any
+    gl::load();
 }
 
 Renderer::~Renderer() {
+    if (gl::isLoaded()) {
+        for (GLsync fence : m_frameFences) {
+            if (fence) {
+                gl::DeleteSync(fence);
+            }
+        }
+        for (GLuint query : m_timerQueries) {
+            if (query) {
+                gl::DeleteQueries(1, &query);
+            }
+        }
+        for (GLuint query : m_timestampQueries) {
+            if (query) {
+                gl::DeleteQueries(1, &query);
+            }
+        }
+    }
+}
+
+Renderer::SlotInput::SlotInput() {
+    for (double& time : inputTime) {
+        time = -1.0;
+    }
 }
 
 void Renderer::setClearColor(float r, float g, float b, float a) {
@@ -16,6 +68,7 @@ void Renderer::setClearColor(float r, float g, float b, float a) {
     m_clearColor[2] = b;
     m_clearColor[3] = a;
     glClearColor(r, g, b, a);
+    m_stateChanges++;
 }
 
 void Renderer::clear() {
@@ -39,19 +92,23 @@ void Renderer::setDepthTest(bool enabled) {
     } else {
         glDisable(GL_DEPTH_TEST);
     }
+    m_stateChanges++;
 }
 
 void Renderer::setBlending(bool enabled) {
     if (enabled) {
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        m_stateChanges += 2;
     } else {
         glDisable(GL_BLEND);
+        m_stateChanges++;
     }
 }
 
 void Renderer::setViewport(int x, int y, int width, int height) {
     glViewport(x, y, width, height);
+    m_stateChanges++;
 }
 
 const char* Renderer::getOpenGLVersion() {
@@ -66,4 +123,233 @@ const char* Renderer::getOpenGLRenderer() {
     return reinterpret_cast<const char*>(glGetString(GL_RENDERER));
 }
 
+void Renderer::beginFrame() {
+    if (m_pendingFramesInFlight != m_maxFramesInFlight) {
+        applyFramesInFlight();
+    }
+    
+    m_frameStats.frameSlot = static_cast<int>(m_frameStats.frameIndex % m_maxFramesInFlight);
+    m_frameStats.fenceWaitTime = 0.0;
+    
+    // Block until the GPU has finished the frame that last used this slot
+    GLsync& fence = m_frameFences[m_frameStats.frameSlot];
+    if (fence) {
+        waitForFence(fence);
+        gl::DeleteSync(fence);
+        fence = nullptr;
+    }
+    
+    m_frameStartTime = glfwGetTime();
+    m_drawCalls = 0;
+    m_stateChanges = 0;
+    
+    m_bufferManager->beginFrame(m_frameStats.frameSlot);
+    
+    // The slot's fence has passed, so its GPU timing is ready to collect
+    if (gl::isLoaded()) {
+        int slot = m_frameStats.frameSlot;
+        readTimerQuery(slot);
+        if (!m_timerQueries[slot]) {
+            gl::GenQueries(1, &m_timerQueries[slot]);
+        }
+        gl::BeginQuery(GL_TIME_ELAPSED, m_timerQueries[slot]);
+        m_timerQueryPending[slot] = true;
+    }
+    
+    // Likewise for the latency of the inputs it presented
+    readInputLatency(m_frameStats.frameSlot);
+}
+
+void Renderer::endFrame() {
+    m_bufferManager->endFrame();
+    
+    if (gl::isLoaded()) {
+        int slot = m_frameStats.frameSlot;
+        if (m_timerQueryPending[slot]) {
+            gl::EndQuery(GL_TIME_ELAPSED);
+        }
+        
+        // Mark the end of the frame's GPU work if it presents any input
+        SlotInput& input = m_slotInputs[slot];
+        if (input.hasInput && gl::QueryCounter && gl::GetInteger64v) {
+            GLint64 gpuNow = 0;
+            gl::GetInteger64v(GL_TIMESTAMP, &gpuNow);
+            m_gpuClockOffset = glfwGetTime() - static_cast<double>(gpuNow) * 1e-9;
+            if (!m_timestampQueries[slot]) {
+                gl::GenQueries(1, &m_timestampQueries[slot]);
+            }
+            gl::QueryCounter(m_timestampQueries[slot], GL_TIMESTAMP);
+            input.timestampPending = true;
+        }
+        
+        GLsync& fence = m_frameFences[m_frameStats.frameSlot];
+        if (fence) {
+            gl::DeleteSync(fence);
+        }
+        fence = gl::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    
+    m_frameStats.cpuFrameTime = glfwGetTime() - m_frameStartTime;
+    m_frameStats.drawCalls = m_drawCalls;
+    m_frameStats.stateChanges = m_stateChanges;
+    m_frameStats.frameIndex++;
+}
+
+void Renderer::setMaxFramesInFlight(int frames) {
+    m_pendingFramesInFlight = std::clamp(frames, 1, kMaxFramesInFlight);
+}
+
+int Renderer::getMaxFramesInFlight() const {
+    return m_maxFramesInFlight;
+}
+
+int Renderer::getFrameSlot() const {
+    return m_frameStats.frameSlot;
+}
+
+const FrameStats& Renderer::getFrameStats() const {
+    return m_frameStats;
+}
+
+void Renderer::recordDrawCalls(std::uint32_t count) {
+    m_drawCalls += count;
+}
+
+void Renderer::recordStateChanges(std::uint32_t count) {
+    m_stateChanges += count;
+}
+
+void Renderer::recordInput(InputKind kind, double timestamp) {
+    SlotInput& input = m_slotInputs[m_frameStats.frameSlot];
+    double& time = input.inputTime[static_cast<int>(kind)];
+    if (time < 0.0 || timestamp < time) {
+        time = timestamp;
+    }
+    input.hasInput = true;
+}
+
+void Renderer::framePresented() {
+    SlotInput& input = m_slotInputs[m_frameStats.frameSlot];
+    if (input.hasInput) {
+        input.swapTime = glfwGetTime();
+    }
+}
+
+void Renderer::resetInputLatency() {
+    for (LatencyHistogram& histogram : m_frameStats.inputLatencyHistogram) {
+        histogram.reset();
+    }
+}
+
+BufferManager& Renderer::getBufferManager() {
+    return *m_bufferManager;
+}
+
+void Renderer::waitForFence(GLsync fence) {
+    // Fast path: the GPU is already done with the slot
+    GLenum result = gl::ClientWaitSync(fence, 0, 0);
+    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+        return;
+    }
+    
+    double start = glfwGetTime();
+    
+    // Flush once so the fence is guaranteed to be submitted, then wait
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    do {
+        result = gl::ClientWaitSync(fence, flags, kFenceTimeout);
+        flags = 0;
+    } while (result == GL_TIMEOUT_EXPIRED);
+    
+    if (result == GL_WAIT_FAILED) {
+        CRAZY_LOG_ERROR("Renderer: glClientWaitSync failed");
+    }
+    
+    double waited = glfwGetTime() - start;
+    m_frameStats.fenceWaitTime += waited;
+    m_frameStats.totalFenceWaitTime += waited;
+    m_frameStats.fenceWaits++;
+}
+
+void Renderer::applyFramesInFlight() {
+    // Drain every outstanding frame so slots can be renumbered safely
+    for (GLsync& fence : m_frameFences) {
+        if (fence) {
+            waitForFence(fence);
+            gl::DeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    for (GLuint& query : m_timerQueries) {
+        if (query) {
+            gl::DeleteQueries(1, &query);
+            query = 0;
+        }
+    }
+    for (GLuint& query : m_timestampQueries) {
+        if (query) {
+            gl::DeleteQueries(1, &query);
+            query = 0;
+        }
+    }
+    
+    m_maxFramesInFlight = m_pendingFramesInFlight;
+    m_frameFences.assign(m_maxFramesInFlight, nullptr);
+    m_timerQueries.assign(m_maxFramesInFlight, 0);
+    m_timerQueryPending.assign(m_maxFramesInFlight, false);
+    m_timestampQueries.assign(m_maxFramesInFlight, 0);
+    m_slotInputs.assign(m_maxFramesInFlight, SlotInput());
+    m_frameStats.maxFramesInFlight = m_maxFramesInFlight;
+    m_bufferManager->setFrameCount(m_maxFramesInFlight);
+}
+
+void Renderer::readTimerQuery(int slot) {
+    if (!m_timerQueryPending[slot]) {
+        return;
+    }
+    
+    GLint available = 0;
+    gl::GetQueryObjectiv(m_timerQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+        GLuint64 elapsed = 0;
+        gl::GetQueryObjectui64v(m_timerQueries[slot], GL_QUERY_RESULT, &elapsed);
+        m_frameStats.gpuFrameTime = static_cast<double>(elapsed) * 1e-9;
+    }
+    m_timerQueryPending[slot] = false;
+}
+
+void Renderer::readInputLatency(int slot) {
+    SlotInput& input = m_slotInputs[slot];
+    if (!input.hasInput) {
+        return;
+    }
+    
+    // A frame that was never swapped (e.g. abandoned on shutdown) presented
+    // nothing, even if its GPU work finished
+    if (input.swapTime < 0.0) {
+        input = SlotInput();
+        return;
+    }
+    
+    double presented = input.swapTime;
+    if (input.timestampPending) {
+        GLint available = 0;
+        gl::GetQueryObjectiv(m_timestampQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 gpuTime = 0;
+            gl::GetQueryObjectui64v(m_timestampQueries[slot], GL_QUERY_RESULT, &gpuTime);
+            presented = std::max(presented, static_cast<double>(gpuTime) * 1e-9 + m_gpuClockOffset);
+        }
+    }
+    
+    for (int kind = 0; kind < static_cast<int>(InputKind::Count); ++kind) {
+        if (input.inputTime[kind] >= 0.0) {
+            const double latency = presented - input.inputTime[kind];
+            m_frameStats.inputLatency[kind] = latency;
+            m_frameStats.inputLatencyHistogram[kind].add(latency);
+        }
+    }
+    input = SlotInput();
+}
+
 } // namespace crazy
@@ -0,0 +1,332 @@
+#include "crazy/RingChannel.hpp"
+#include "crazy/Log.hpp"
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace crazy {
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+              "RingChannel needs 32-bit atomics without padding");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free,
+              "RingChannel needs lock-free 32-bit atomics to share memory");
+
+namespace {
+
+constexpr std::uint32_t kMagicOffset = 0;
+constexpr std::uint32_t kVersionOffset = 4;
+constexpr std::uint32_t kCapacityOffset = 8;
+constexpr std::uint32_t kWriteIndexOffset = 64;
+constexpr std::uint32_t kReadIndexOffset = 128;
+constexpr std::uint32_t kParkedOffset = 192;
+constexpr std::uint32_t kMinCapacity = 64;
+
+constexpr std::uint32_t recordSize(std::uint32_t payload) {
+    return (4 + payload + 7) & ~7u;
+}
+
+std::uint32_t roundUpToPowerOfTwo(std::uint32_t value) {
+    std::uint32_t result = kMinCapacity;
+    while (result < value && result < (1u << 31)) {
+        result <<= 1;
+    }
+    return result;
+}
+
+std::uint32_t load32(const unsigned char* address) {
+    std::uint32_t value;
+    std::memcpy(&value, address, sizeof(value));
+    return value;
+}
+
+void store32(unsigned char* address, std::uint32_t value) {
+    std::memcpy(address, &value, sizeof(value));
+}
+
+#ifdef __linux__
+// Shared (not FUTEX_PRIVATE) so that waiters in other processes are found
+long futex(std::atomic<std::uint32_t>* address, int op, std::uint32_t value, const timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(address), op, value, timeout, nullptr, 0);
+}
+#endif
+
+} // namespace
+
+std::size_t RingChannel::requiredSize(std::uint32_t capacity) {
+    return kHeaderSize + static_cast<std::size_t>(roundUpToPowerOfTwo(capacity));
+}
+
+RingChannel::RingChannel()
+    : m_base(nullptr)
+    , m_data(nullptr)
+    , m_capacity(0)
+    , m_mask(0)
+    , m_readCache(0)
+    , m_reservedEnd(0)
+    , m_reserved(false)
+    , m_dropped(0)
+    , m_writeCache(0)
+    , m_peekedEnd(0)
+    , m_peeked(false)
+{
+}
+
+RingChannel::RingChannel(void* memory, std::size_t size, bool initialize)
+    : RingChannel()
+{
+    if (!memory || size < requiredSize(kMinCapacity)
+        || reinterpret_cast<std::uintptr_t>(memory) % 8 != 0) {
+        CRAZY_LOG_ERROR("RingChannel: Region too small or misaligned ({} bytes)", size);
+        return;
+    }
+
+    unsigned char* base = static_cast<unsigned char*>(memory);
+    if (initialize) {
+        // Largest power of two that fits after the header
+        std::size_t available = size - kHeaderSize;
+        std::uint32_t capacity = kMinCapacity;
+        while (static_cast<std::size_t>(capacity) * 2 <= available && capacity < (1u << 30)) {
+            capacity <<= 1;
+        }
+
+        std::memset(base, 0, kHeaderSize);
+        store32(base + kMagicOffset, kMagic);
+        store32(base + kVersionOffset, kVersion);
+        store32(base + kCapacityOffset, capacity);
+    }
+
+    std::uint32_t capacity = load32(base + kCapacityOffset);
+    if (load32(base + kMagicOffset) != kMagic || load32(base + kVersionOffset) != kVersion
+        || capacity < kMinCapacity || (capacity & (capacity - 1)) != 0
+        || kHeaderSize + static_cast<std::size_t>(capacity) > size) {
+        CRAZY_LOG_ERROR("RingChannel: Region does not contain a valid ring");
+        return;
+    }
+
+    m_base = base;
+    m_data = base + kHeaderSize;
+    m_capacity = capacity;
+    m_mask = capacity - 1;
+    m_readCache = readIndex().load(std::memory_order_acquire);
+    m_writeCache = writeIndex().load(std::memory_order_acquire);
+}
+
+bool RingChannel::isValid() const {
+    return m_base != nullptr;
+}
+
+std::uint32_t RingChannel::getCapacity() const {
+    return m_capacity;
+}
+
+std::uint32_t RingChannel::getMaxMessageSize() const {
+    // Half the ring: a record this size fits even after skipping the tail
+    return m_capacity ? m_capacity / 2 - 4 : 0;
+}
+
+std::atomic<std::uint32_t>& RingChannel::writeIndex() const {
+    return *reinterpret_cast<std::atomic<std::uint32_t>*>(m_base + kWriteIndexOffset);
+}
+
+std::atomic<std::uint32_t>& RingChannel::readIndex() const {
+    return *reinterpret_cast<std::atomic<std::uint32_t>*>(m_base + kReadIndexOffset);
+}
+
+std::atomic<std::uint32_t>& RingChannel::parkedFlag() const {
+    return *reinterpret_cast<std::atomic<std::uint32_t>*>(m_base + kParkedOffset);
+}
+
+unsigned char* RingChannel::slot(std::uint32_t index) const {
+    return m_data + (index & m_mask);
+}
+
+void* RingChannel::reserve(std::uint32_t size) {
+    if (!m_base || size > getMaxMessageSize()) {
+        ++m_dropped;
+        return nullptr;
+    }
+
+    // Continue after messages reserved but not yet committed
+    const std::uint32_t record = recordSize(size);
+    const std::uint32_t write = m_reserved ? m_reservedEnd : writeIndex().load(std::memory_order_relaxed);
+
+    // Records never straddle the end of the data area
+    const std::uint32_t tail = m_capacity - (write & m_mask);
+    const std::uint32_t skip = record <= tail ? 0 : tail;
+
+    // The consumer's index is only re-read when the ring looks full, so its
+    // cache line is not pulled over on every message
+    if (skip + record > m_capacity - (write - m_readCache)) {
+        m_readCache = readIndex().load(std::memory_order_acquire);
+        if (skip + record > m_capacity - (write - m_readCache)) {
+            ++m_dropped;
+            return nullptr;
+        }
+    }
+
+    if (skip > 0) {
+        store32(slot(write), kWrapMarker);
+    }
+    const std::uint32_t start = write + skip;
+    store32(slot(start), size);
+
+    m_reservedEnd = start + record;
+    m_reserved = true;
+    return slot(start) + 4;
+}
+
+void RingChannel::commit() {
+    if (!m_reserved) {
+        return;
+    }
+    m_reserved = false;
+
+    // seq_cst pairs with park(): either the consumer sees the new index or
+    // we see its parked flag
+    writeIndex().store(m_reservedEnd, std::memory_order_seq_cst);
+    if (parkedFlag().load(std::memory_order_seq_cst) != 0
+        && parkedFlag().exchange(0, std::memory_order_seq_cst) != 0) {
+        if (m_wakeupCallback) {
+            m_wakeupCallback();
+        } else {
+            notify();
+        }
+    }
+}
+
+bool RingChannel::write(const void* data, std::uint32_t size) {
+    void* destination = reserve(size);
+    if (!destination) {
+        return false;
+    }
+    if (size > 0) {
+        std::memcpy(destination, data, size);
+    }
+    commit();
+    return true;
+}
+
+void RingChannel::setWakeupCallback(std::function<void()> callback) {
+    m_wakeupCallback = std::move(callback);
+}
+
+std::uint64_t RingChannel::getDroppedCount() const {
+    return m_dropped;
+}
+
+const void* RingChannel::peek(std::uint32_t& size) {
+    m_peeked = false;
+    if (!m_base) {
+        return nullptr;
+    }
+
+    std::uint32_t read = readIndex().load(std::memory_order_relaxed);
+    if (read == m_writeCache) {
+        m_writeCache = writeIndex().load(std::memory_order_acquire);
+        if (read == m_writeCache) {
+            return nullptr;
+        }
+    }
+
+    std::uint32_t length = load32(slot(read));
+    if (length == kWrapMarker) {
+        read += m_capacity - (read & m_mask);
+        length = load32(slot(read));
+    }
+
+    size = length;
+    m_peekedEnd = read + recordSize(length);
+    m_peeked = true;
+    return slot(read) + 4;
+}
+
+void RingChannel::release() {
+    if (!m_peeked) {
+        return;
+    }
+    m_peeked = false;
+    readIndex().store(m_peekedEnd, std::memory_order_release);
+}
+
+bool RingChannel::park() {
+    if (!m_base) {
+        return false;
+    }
+    parkedFlag().store(1, std::memory_order_seq_cst);
+    if (writeIndex().load(std::memory_order_seq_cst) != readIndex().load(std::memory_order_relaxed)) {
+        parkedFlag().store(0, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void RingChannel::unpark() {
+    if (m_base) {
+        parkedFlag().store(0, std::memory_order_relaxed);
+    }
+}
+
+bool RingChannel::wait(double timeoutSeconds) {
+    if (!m_base) {
+        return false;
+    }
+    if (!isEmpty()) {
+        return true;
+    }
+
+    const std::uint32_t observed = writeIndex().load(std::memory_order_seq_cst);
+    if (!park()) {
+        return true;
+    }
+
+#ifdef __linux__
+    // Returns at once if a commit changed the index after park()
+    if (timeoutSeconds < 0.0) {
+        futex(&writeIndex(), FUTEX_WAIT, observed, nullptr);
+    } else {
+        timespec timeout;
+        timeout.tv_sec = static_cast<time_t>(timeoutSeconds);
+        timeout.tv_nsec = static_cast<long>((timeoutSeconds - static_cast<double>(timeout.tv_sec)) * 1e9);
+        futex(&writeIndex(), FUTEX_WAIT, observed, &timeout);
+    }
+#else
+    // No portable address-based wait: poll at a coarse interval
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    while (writeIndex().load(std::memory_order_acquire) == observed) {
+        if (timeoutSeconds >= 0.0
+            && std::chrono::duration<double>(Clock::now() - start).count() >= timeoutSeconds) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+#endif
+
+    unpark();
+    return !isEmpty();
+}
+
+void RingChannel::notify() {
+#ifdef __linux__
+    if (m_base) {
+        futex(&writeIndex(), FUTEX_WAKE, INT_MAX, nullptr);
+    }
+#endif
+}
+
+bool RingChannel::isEmpty() const {
+    if (!m_base) {
+        return true;
+    }
+    return writeIndex().load(std::memory_order_acquire) == readIndex().load(std::memory_order_acquire);
+}
+
+} // namespace crazy
@@ -0,0 +1,176 @@
+#include "crazy/SharedMemory.hpp"
+#include "crazy/Log.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace crazy {
+
+namespace {
+
+#if !defined(_WIN32)
+// Anonymous file that can be shared through its descriptor
+int createSharedFd(const char* name) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+    int memfd = static_cast<int>(syscall(SYS_memfd_create, name, 1u /* MFD_CLOEXEC */));
+    if (memfd >= 0) {
+        return memfd;
+    }
+#endif
+    // shm_open fallback; the name is unlinked right away
+    char path[64];
+    std::snprintf(path, sizeof(path), "/%s-%d-%p", name, static_cast<int>(getpid()),
+                  static_cast<void*>(path));
+    int fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+        shm_unlink(path);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+}
+#endif
+
+} // namespace
+
+SharedMemory::SharedMemory()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_fd(-1)
+{
+}
+
+SharedMemory::SharedMemory(std::size_t size, const char* name)
+    : SharedMemory()
+{
+    if (size == 0) {
+        return;
+    }
+
+#ifdef _WIN32
+    (void)name;
+    m_data = _aligned_malloc(size, 4096);
+    if (!m_data) {
+        CRAZY_LOG_ERROR("SharedMemory: Failed to allocate {} bytes", size);
+        return;
+    }
+    std::memset(m_data, 0, size);
+    m_size = size;
+#else
+    int fd = createSharedFd(name ? name : "crazy");
+    if (fd < 0) {
+        CRAZY_LOG_ERROR("SharedMemory: Failed to create region: {}", std::strerror(errno));
+        return;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        CRAZY_LOG_ERROR("SharedMemory: Failed to size region to {} bytes: {}", size, std::strerror(errno));
+        close(fd);
+        return;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        CRAZY_LOG_ERROR("SharedMemory: Failed to map {} bytes: {}", size, std::strerror(errno));
+        close(fd);
+        return;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_fd = fd;
+#endif
+}
+
+SharedMemory::SharedMemory(int fd, std::size_t size)
+    : SharedMemory()
+{
+#ifdef _WIN32
+    (void)fd;
+    (void)size;
+    CRAZY_LOG_ERROR("SharedMemory: Mapping descriptors is not supported on this platform");
+#else
+    if (fd < 0 || size == 0) {
+        return;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        CRAZY_LOG_ERROR("SharedMemory: Failed to map descriptor {}: {}", fd, std::strerror(errno));
+        close(fd);
+        return;
+    }
+
+    m_data = data;
+    m_size = size;
+    m_fd = fd;
+#endif
+}
+
+SharedMemory::~SharedMemory() {
+    release();
+}
+
+SharedMemory::SharedMemory(SharedMemory&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+    , m_fd(std::exchange(other.m_fd, -1))
+{
+}
+
+SharedMemory& SharedMemory::operator=(SharedMemory&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_fd = std::exchange(other.m_fd, -1);
+    }
+    return *this;
+}
+
+bool SharedMemory::isValid() const {
+    return m_data != nullptr;
+}
+
+void* SharedMemory::getData() const {
+    return m_data;
+}
+
+std::size_t SharedMemory::getSize() const {
+    return m_size;
+}
+
+int SharedMemory::getFd() const {
+    return m_fd;
+}
+
+void SharedMemory::release() {
+    if (m_data) {
+#ifdef _WIN32
+        _aligned_free(m_data);
+#else
+        munmap(m_data, m_size);
+#endif
+    }
+#ifndef _WIN32
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_fd = -1;
+}
+
+} // namespace crazy
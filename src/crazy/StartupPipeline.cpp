@@ -0,0 +1,507 @@
+#include "crazy/StartupPipeline.hpp"
+#include "crazy/Log.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <unordered_map>
+
+namespace crazy {
+
+struct StartupPipeline::Stage {
+    StartupStage description;
+    std::vector<Stage*> dependencies;
+    bool required = false;                      // Needed for the first frame, directly or not
+    StartupStatus status = StartupStatus::Pending; // Guarded by m_mutex
+    JobHandle launch;                           // Hands a worker stage to the pool once its dependencies finished
+    JobHandle done;                             // Submitted once the stage finished; dependent launches wait for it
+};
+
+namespace {
+
+const char* statusName(StartupStatus status) {
+    switch (status) {
+        case StartupStatus::Pending: return "pending";
+        case StartupStatus::Running: return "running";
+        case StartupStatus::Done: return "done";
+        case StartupStatus::Failed: return "failed";
+        case StartupStatus::Skipped: return "skipped";
+    }
+    return "unknown";
+}
+
+// Seconds to milliseconds, rounded to a tenth for the log
+double milliseconds(double seconds) {
+    return std::round(seconds * 10000.0) / 10.0;
+}
+
+bool isFinished(StartupStatus status) {
+    return status == StartupStatus::Done || status == StartupStatus::Failed || status == StartupStatus::Skipped;
+}
+
+void writeJsonString(std::FILE* file, const std::string& text) {
+    std::fputc('"', file);
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', file);
+            std::fputc(c, file);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            std::fprintf(file, "\\u%04x", static_cast<unsigned>(c));
+        } else {
+            std::fputc(c, file);
+        }
+    }
+    std::fputc('"', file);
+}
+
+} // namespace
+
+StartupPipeline::StartupPipeline()
+    : m_origin(Clock::now())
+    , m_jobs(nullptr)
+    , m_mainThread(std::this_thread::get_id())
+    , m_started(false)
+    , m_reported(false)
+    , m_finished(0)
+    , m_running(0)
+    , m_stopping(false)
+    , m_firstFrame(0.0)
+{
+}
+
+StartupPipeline::~StartupPipeline() {
+    stop();
+}
+
+bool StartupPipeline::addStage(StartupStage stage) {
+    if (m_started) {
+        CRAZY_LOG_ERROR("Startup: Stage {} added after the pipeline started", stage.name.c_str());
+        return false;
+    }
+    for (const std::unique_ptr<Stage>& existing : m_stages) {
+        if (existing->description.name == stage.name) {
+            CRAZY_LOG_ERROR("Startup: Duplicate stage {}", stage.name.c_str());
+            return false;
+        }
+    }
+    m_stages.push_back(std::make_unique<Stage>());
+    m_stages.back()->description = std::move(stage);
+    return true;
+}
+
+void StartupPipeline::setTimelinePath(const std::string& path) {
+    m_timelinePath = path;
+}
+
+bool StartupPipeline::start(JobSystem& jobs) {
+    if (m_started) {
+        return true;
+    }
+    m_started = true;
+    m_jobs = &jobs;
+
+    std::unordered_map<std::string, Stage*> byName;
+    for (std::unique_ptr<Stage>& stage : m_stages) {
+        byName[stage->description.name] = stage.get();
+    }
+    bool valid = true;
+    for (std::unique_ptr<Stage>& stage : m_stages) {
+        for (const std::string& name : stage->description.dependencies) {
+            auto it = byName.find(name);
+            if (it == byName.end()) {
+                CRAZY_LOG_ERROR("Startup: Stage {} depends on unknown stage {}", stage->description.name.c_str(),
+                                name.c_str());
+                valid = false;
+            } else {
+                stage->dependencies.push_back(it->second);
+            }
+        }
+    }
+
+    // Depth-first search for cycles (0 unvisited, 1 on the path, 2 done)
+    std::unordered_map<const Stage*, int> marks;
+    std::function<bool(const Stage*)> acyclic = [&](const Stage* stage) {
+        int& mark = marks[stage];
+        if (mark != 0) {
+            return mark == 2;
+        }
+        mark = 1;
+        for (const Stage* dependency : stage->dependencies) {
+            if (!acyclic(dependency)) {
+                CRAZY_LOG_ERROR("Startup: Dependency cycle through stage {}", stage->description.name.c_str());
+                return false;
+            }
+        }
+        marks[stage] = 2;
+        return true;
+    };
+    for (const std::unique_ptr<Stage>& stage : m_stages) {
+        valid = valid && acyclic(stage.get());
+    }
+
+    if (!valid) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::unique_ptr<Stage>& stage : m_stages) {
+            stage->required = true;
+            stage->status = StartupStatus::Failed;
+        }
+        m_finished = m_stages.size();
+        return false;
+    }
+
+    // What the first frame waits for includes the dependencies of what it waits for
+    std::function<void(Stage*)> require = [&](Stage* stage) {
+        if (!stage->required) {
+            stage->required = true;
+            for (Stage* dependency : stage->dependencies) {
+                require(dependency);
+            }
+        }
+    };
+    for (std::unique_ptr<Stage>& stage : m_stages) {
+        if (stage->description.requiredForFirstFrame) {
+            require(stage.get());
+        }
+    }
+
+    // Worker stages block on I/O, which jobs must not, so they run on a
+    // pool with a thread per stage (up to the hardware threads). The job
+    // system only orders them: a worker stage's launch job waits for the
+    // empty done jobs of its dependencies, submitted as each one finishes.
+    std::size_t workerStages = 0;
+    for (std::unique_ptr<Stage>& stage : m_stages) {
+        Stage* raw = stage.get();
+        if (stage->description.affinity == StartupAffinity::Worker) {
+            stage->launch = jobs.create([this, raw] { launchStage(*raw); });
+            ++workerStages;
+        }
+    }
+    if (workerStages == 0) {
+        return true;
+    }
+    for (std::unique_ptr<Stage>& stage : m_stages) {
+        if (stage->description.affinity == StartupAffinity::Worker) {
+            for (Stage* dependency : stage->dependencies) {
+                if (!dependency->done.isValid()) {
+                    dependency->done = jobs.create([] {});
+                }
+                jobs.addDependency(stage->launch, dependency->done);
+            }
+        }
+    }
+
+    TaskPoolSettings poolSettings;
+    poolSettings.threadCount = static_cast<unsigned>(
+        std::min<std::size_t>(workerStages, std::max(2u, std::thread::hardware_concurrency())));
+    poolSettings.maxQueuedTasks = workerStages;
+    m_pool = std::make_unique<TaskPool>(poolSettings);
+
+    for (std::unique_ptr<Stage>& stage : m_stages) {
+        if (stage->description.affinity == StartupAffinity::Worker) {
+            jobs.submit(stage->launch);
+        }
+    }
+    return true;
+}
+
+void StartupPipeline::stop() {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_changed.wait(lock, [this] { return m_running == 0; });
+    }
+    if (m_pool) {
+        m_pool->shutdown();
+    }
+}
+
+bool StartupPipeline::runUntilReady() {
+    if (!m_started) {
+        return true;
+    }
+
+    while (true) {
+        runReadyMainStages(true, 0.0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        bool ready = true;
+        bool failed = false;
+        for (const std::unique_ptr<Stage>& stage : m_stages) {
+            if (stage->required) {
+                ready = ready && isFinished(stage->status);
+                failed = failed || stage->status == StartupStatus::Failed || stage->status == StartupStatus::Skipped;
+            }
+        }
+        if (ready) {
+            if (failed) {
+                CRAZY_LOG_ERROR("Startup: A stage required for the first frame did not succeed");
+                return false;
+            }
+            CRAZY_LOG_DEBUG("Startup: Ready for the first frame after {} ms", milliseconds(now()));
+            return true;
+        }
+        // Checked under the lock so a stage finishing now cannot be missed
+        if (!hasReadyMainStage(true)) {
+            m_changed.wait(lock);
+        }
+    }
+}
+
+bool StartupPipeline::pump(double timeBudget) {
+    if (!m_started) {
+        return false;
+    }
+    runReadyMainStages(false, now() + timeBudget);
+    finishIfComplete();
+    return !isComplete();
+}
+
+void StartupPipeline::markFirstFrame() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_firstFrame > 0.0) {
+            return;
+        }
+        m_firstFrame = now();
+    }
+    CRAZY_LOG_INFO("Startup: First frame after {} ms", milliseconds(m_firstFrame));
+    finishIfComplete();
+}
+
+void StartupPipeline::addSpan(const std::string& name, double start, double end) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    StartupTimelineEntry entry;
+    entry.name = name;
+    entry.start = start;
+    entry.end = end;
+    entry.thread = threadIndex();
+    entry.status = StartupStatus::Done;
+    m_spans.push_back(std::move(entry));
+}
+
+double StartupPipeline::now() const {
+    return std::chrono::duration<double>(Clock::now() - m_origin).count();
+}
+
+bool StartupPipeline::isComplete() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finished == m_stages.size();
+}
+
+StartupStatus StartupPipeline::getStatus(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const std::unique_ptr<Stage>& stage : m_stages) {
+        if (stage->description.name == name) {
+            return stage->status;
+        }
+    }
+    return StartupStatus::Pending;
+}
+
+double StartupPipeline::getTimeToFirstFrame() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_firstFrame;
+}
+
+std::vector<StartupTimelineEntry> StartupPipeline::getTimeline() const {
+    std::vector<StartupTimelineEntry> timeline;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        timeline = m_spans;
+    }
+    std::stable_sort(timeline.begin(), timeline.end(), [](const StartupTimelineEntry& a, const StartupTimelineEntry& b) {
+        return a.start < b.start;
+    });
+    return timeline;
+}
+
+bool StartupPipeline::writeTimeline(const std::string& path) const {
+    const std::vector<StartupTimelineEntry> timeline = getTimeline();
+    const double firstFrame = getTimeToFirstFrame();
+
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        CRAZY_LOG_ERROR("Startup: Cannot write timeline to {}", path.c_str());
+        return false;
+    }
+
+    // Chrome trace event format: complete events ("X") in microseconds
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    int threads = 0;
+    for (const StartupTimelineEntry& entry : timeline) {
+        threads = std::max(threads, entry.thread + 1);
+    }
+    std::fputs("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"main\"}},\n", file);
+    for (int thread = 1; thread < threads; ++thread) {
+        std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                           "\"args\":{\"name\":\"worker %d\"}},\n",
+                     thread, thread);
+    }
+    for (const StartupTimelineEntry& entry : timeline) {
+        std::fputs("{\"name\":", file);
+        writeJsonString(file, entry.name);
+        std::fprintf(file, ",\"cat\":\"startup\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.1f,\"dur\":%.1f,"
+                           "\"args\":{\"status\":\"%s\"}},\n",
+                     entry.thread, entry.start * 1e6, (entry.end - entry.start) * 1e6, statusName(entry.status));
+    }
+    std::fprintf(file, "{\"name\":\"first frame\",\"cat\":\"startup\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,"
+                       "\"tid\":0,\"ts\":%.1f}\n]}\n",
+                 firstFrame * 1e6);
+
+    const bool ok = std::fclose(file) == 0;
+    if (ok) {
+        CRAZY_LOG_INFO("Startup: Timeline written to {}", path.c_str());
+    }
+    return ok;
+}
+
+void StartupPipeline::launchStage(Stage& stage) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) {
+            return;
+        }
+        ++m_running;
+    }
+    // The queue holds every worker stage and the pool only shuts down in
+    // stop(), after this stage finished, so this cannot fail
+    if (!m_pool->submit([this, &stage] { runStage(stage); })) {
+        CRAZY_LOG_ERROR("Startup: Cannot queue stage {}", stage.description.name.c_str());
+        runStage(stage);
+    }
+}
+
+void StartupPipeline::runStage(Stage& stage) {
+    const std::string& name = stage.description.name;
+
+    StartupTimelineEntry entry;
+    entry.name = name;
+    bool runnable = true;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const Stage* dependency : stage.dependencies) {
+            runnable = runnable && dependency->status == StartupStatus::Done;
+        }
+        stage.status = runnable ? StartupStatus::Running : StartupStatus::Skipped;
+        entry.thread = threadIndex();
+    }
+
+    entry.start = now();
+    bool succeeded = true;
+    if (runnable && stage.description.run) {
+        try {
+            succeeded = stage.description.run();
+        } catch (const std::exception& e) {
+            CRAZY_LOG_ERROR("Startup: Stage {} threw: {}", name.c_str(), e.what());
+            succeeded = false;
+        } catch (...) {
+            CRAZY_LOG_ERROR("Startup: Stage {} threw an unknown exception", name.c_str());
+            succeeded = false;
+        }
+        if (!succeeded) {
+            CRAZY_LOG_ERROR("Startup: Stage {} failed", name.c_str());
+        }
+    } else if (!runnable) {
+        CRAZY_LOG_WARNING("Startup: Stage {} skipped, a dependency did not succeed", name.c_str());
+    }
+    entry.end = now();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stage.status = !runnable ? StartupStatus::Skipped : succeeded ? StartupStatus::Done : StartupStatus::Failed;
+        entry.status = stage.status;
+        m_spans.push_back(std::move(entry));
+    }
+    m_changed.notify_all();
+
+    // Lets the worker stages that depend on this one start. Counted as
+    // running until then, so stop() cannot let the job system go first.
+    if (stage.done.isValid()) {
+        m_jobs->submit(stage.done);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_finished;
+        if (stage.description.affinity == StartupAffinity::Worker) {
+            --m_running;
+        }
+    }
+    m_changed.notify_all();
+}
+
+bool StartupPipeline::isReady(const Stage& stage) const {
+    if (stage.status != StartupStatus::Pending) {
+        return false;
+    }
+    for (const Stage* dependency : stage.dependencies) {
+        if (!isFinished(dependency->status)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StartupPipeline::hasReadyMainStage(bool requiredOnly) const {
+    for (const std::unique_ptr<Stage>& stage : m_stages) {
+        if (stage->description.affinity == StartupAffinity::Main && (stage->required || !requiredOnly)
+            && isReady(*stage)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StartupPipeline::runReadyMainStages(bool requiredOnly, double deadline) {
+    bool ran = false;
+    for (std::unique_ptr<Stage>& stage : m_stages) {
+        if (stage->description.affinity != StartupAffinity::Main || (requiredOnly && !stage->required)) {
+            continue;
+        }
+        bool ready;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ready = isReady(*stage);
+        }
+        if (!ready) {
+            continue;
+        }
+        runStage(*stage);
+        ran = true;
+        if (deadline > 0.0 && now() >= deadline) {
+            break;
+        }
+    }
+    return ran;
+}
+
+int StartupPipeline::threadIndex() {
+    const std::thread::id id = std::this_thread::get_id();
+    if (id == m_mainThread) {
+        return 0;
+    }
+    auto it = std::find(m_threads.begin(), m_threads.end(), id);
+    if (it == m_threads.end()) {
+        m_threads.push_back(id);
+        return static_cast<int>(m_threads.size());
+    }
+    return static_cast<int>(it - m_threads.begin()) + 1;
+}
+
+void StartupPipeline::finishIfComplete() {
+    if (m_reported || getTimeToFirstFrame() <= 0.0 || !isComplete()) {
+        return;
+    }
+    m_reported = true;
+
+    for (const StartupTimelineEntry& entry : getTimeline()) {
+        CRAZY_LOG_DEBUG("Startup: {} at {} ms for {} ms ({}, thread {})", entry.name.c_str(),
+                        milliseconds(entry.start), milliseconds(entry.end - entry.start), statusName(entry.status),
+                        entry.thread);
+    }
+    if (!m_timelinePath.empty()) {
+        writeTimeline(m_timelinePath);
+    }
+}
+
+} // namespace crazy
@@ -0,0 +1,191 @@
+#include "crazy/TaskPool.hpp"
+#include "crazy/Log.hpp"
+#include <algorithm>
+#include <exception>
+
+namespace crazy {
+
+namespace {
+
+// Identifies the pool and deque of the current worker thread
+thread_local const TaskPool* t_pool = nullptr;
+thread_local std::size_t t_workerIndex = 0;
+
+} // namespace
+
+TaskPool::TaskPool(const TaskPoolSettings& settings)
+    : m_maxQueued(std::max<std::size_t>(settings.maxQueuedTasks, 1))
+    , m_queued(0)
+    , m_nextWorker(0)
+    , m_stopping(false)
+    , m_submitted(0)
+    , m_rejected(0)
+    , m_completed(0)
+    , m_stolen(0)
+    , m_discarded(0)
+{
+    unsigned count = settings.threadCount;
+    if (count == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        count = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    m_workers.reserve(count);
+    for (unsigned i = 0; i < count; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    // Started once every deque exists, since workers steal from all of them
+    for (std::size_t i = 0; i < m_workers.size(); ++i) {
+        m_workers[i]->thread = std::thread([this, i] { run(i); });
+    }
+    CRAZY_LOG_DEBUG("TaskPool: Started {} workers", count);
+}
+
+TaskPool::~TaskPool() {
+    shutdown();
+}
+
+bool TaskPool::submit(Task task) {
+    if (!task || m_stopping.load(std::memory_order_acquire)) {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Reserve a slot first so the bound holds under concurrent submits
+    std::size_t queued = m_queued.load(std::memory_order_relaxed);
+    do {
+        if (queued >= m_maxQueued) {
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!m_queued.compare_exchange_weak(queued, queued + 1, std::memory_order_acq_rel));
+
+    const std::size_t index = t_pool == this
+        ? t_workerIndex
+        : m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->tasks.push_back(std::move(task));
+    }
+    m_submitted.fetch_add(1, std::memory_order_relaxed);
+
+    // Taking the lock orders the wakeup after a worker's last check
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wakeup.notify_one();
+    return true;
+}
+
+void TaskPool::shutdown() {
+    if (isWorkerThread()) {
+        CRAZY_LOG_ERROR("TaskPool: shutdown() called from a task");
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping.store(true, std::memory_order_release);
+    }
+    m_wakeup.notify_all();
+
+    for (std::unique_ptr<Worker>& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    std::size_t discarded = 0;
+    for (std::unique_ptr<Worker>& worker : m_workers) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        discarded += worker->tasks.size();
+        worker->tasks.clear();
+    }
+    m_queued.fetch_sub(discarded, std::memory_order_relaxed);
+    m_discarded.fetch_add(discarded, std::memory_order_relaxed);
+}
+
+unsigned TaskPool::getThreadCount() const {
+    return static_cast<unsigned>(m_workers.size());
+}
+
+std::size_t TaskPool::getQueuedCount() const {
+    return m_queued.load(std::memory_order_relaxed);
+}
+
+bool TaskPool::isWorkerThread() const {
+    return t_pool == this;
+}
+
+TaskPoolStats TaskPool::getStats() const {
+    TaskPoolStats stats;
+    stats.submitted = m_submitted.load(std::memory_order_relaxed);
+    stats.rejected = m_rejected.load(std::memory_order_relaxed);
+    stats.completed = m_completed.load(std::memory_order_relaxed);
+    stats.stolen = m_stolen.load(std::memory_order_relaxed);
+    stats.discarded = m_discarded.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void TaskPool::run(std::size_t index) {
+    t_pool = this;
+    t_workerIndex = index;
+
+    while (!m_stopping.load(std::memory_order_acquire)) {
+        Task task;
+        if (take(index, task)) {
+            try {
+                task();
+            } catch (const std::exception& e) {
+                CRAZY_LOG_ERROR("TaskPool: Task threw: {}", e.what());
+            } catch (...) {
+                CRAZY_LOG_ERROR("TaskPool: Task threw an unknown exception");
+            }
+            m_completed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        if (m_queued.load(std::memory_order_acquire) > 0) {
+            // Reserved by submit() but not pushed yet
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+        m_wakeup.wait(lock, [this] {
+            return m_stopping.load(std::memory_order_acquire) || m_queued.load(std::memory_order_acquire) > 0;
+        });
+    }
+
+    t_pool = nullptr;
+}
+
+bool TaskPool::take(std::size_t index, Task& task) {
+    // Own tasks in order, then the most recent tasks of the others
+    {
+        Worker& own = *m_workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            m_queued.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    const std::size_t count = m_workers.size();
+    for (std::size_t offset = 1; offset < count; ++offset) {
+        Worker& victim = *m_workers[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            m_queued.fetch_sub(1, std::memory_order_acq_rel);
+            m_stolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace crazy
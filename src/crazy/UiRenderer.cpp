@@ -0,0 +1,768 @@
+#include "crazy/UiRenderer.hpp"
+#include "crazy/MemoryTracker.hpp"
+#include "crazy/Renderer.hpp"
+#include "crazy/UiTree.hpp"
+#include "GLShader.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace crazy {
+
+namespace {
+
+// One instance per rectangle; the quad corners come from gl_VertexID
+const char* const kRectVertexShader = R"(#version 330 core
+layout(location = 0) in vec4 aRect;
+layout(location = 1) in vec4 aColor;
+layout(location = 2) in float aRadius;
+uniform vec2 uViewport;
+out vec2 vLocal;
+out vec2 vHalfSize;
+out vec4 vColor;
+out float vRadius;
+void main() {
+    vec2 corner = vec2(gl_VertexID & 1, (gl_VertexID >> 1) & 1);
+    vHalfSize = aRect.zw * 0.5;
+    vLocal = (corner - 0.5) * aRect.zw;
+    vColor = aColor;
+    vRadius = min(aRadius, min(vHalfSize.x, vHalfSize.y));
+    vec2 position = (aRect.xy + corner * aRect.zw) / uViewport * 2.0 - 1.0;
+    gl_Position = vec4(position.x, -position.y, 0.0, 1.0);
+}
+)";
+
+// Rounded rectangle coverage from its signed distance, in pixels
+const char* const kRectFragmentShader = R"(#version 330 core
+in vec2 vLocal;
+in vec2 vHalfSize;
+in vec4 vColor;
+in float vRadius;
+out vec4 fragColor;
+void main() {
+    vec2 q = abs(vLocal) - vHalfSize + vRadius;
+    float distance = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - vRadius;
+    fragColor = vec4(vColor.rgb, vColor.a * clamp(0.5 - distance, 0.0, 1.0));
+}
+)";
+
+// One instance per tile, textured from the atlas
+const char* const kTileVertexShader = R"(#version 330 core
+layout(location = 0) in vec4 aRect;
+layout(location = 1) in vec4 aUV;
+layout(location = 2) in float aOpacity;
+uniform vec2 uViewport;
+out vec2 vUV;
+out float vOpacity;
+void main() {
+    vec2 corner = vec2(gl_VertexID & 1, (gl_VertexID >> 1) & 1);
+    vUV = mix(aUV.xy, aUV.zw, corner);
+    vOpacity = aOpacity;
+    vec2 position = (aRect.xy + corner * aRect.zw) / uViewport * 2.0 - 1.0;
+    gl_Position = vec4(position.x, -position.y, 0.0, 1.0);
+}
+)";
+
+// Tiles hold premultiplied colors
+const char* const kTileFragmentShader = R"(#version 330 core
+uniform sampler2D uAtlas;
+in vec2 vUV;
+in float vOpacity;
+out vec4 fragColor;
+void main() {
+    fragColor = texture(uAtlas, vUV) * vOpacity;
+}
+)";
+
+// Frames a scroll container may stay off screen before its content is dropped
+constexpr std::uint64_t kLayerLifetime = 120;
+
+// Tiles per scroll container beyond which its content is cut off
+constexpr std::size_t kMaxTilesPerLayer = std::size_t(1) << 22;
+
+// FNV-1a
+std::uint64_t hashBytes(std::uint64_t hash, const void* data, std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+UiRenderer::UiRenderer()
+    : m_program(0)
+    , m_vertexArray(0)
+    , m_viewportLocation(-1)
+    , m_tileProgram(0)
+    , m_tileVertexArray(0)
+    , m_tileViewportLocation(-1)
+    , m_tileAtlasLocation(-1)
+    , m_failed(false)
+    , m_instances(MemoryTracker::instance().getResource(MemoryCategory::DrawLists))
+    , m_tiles(m_scrollSettings.tileSize, m_scrollSettings.atlasTiles)
+    , m_jobs(nullptr)
+    , m_frame(0)
+    , m_refilling(false)
+{
+}
+
+UiRenderer::~UiRenderer() {
+    release();
+}
+
+void UiRenderer::render(const UiTree& tree, Renderer& renderer, int width, int height, float contentScale) {
+    m_instances.clear();
+    m_layerDraws.clear();
+    m_rasterQueue.clear();
+    m_tileInstances.clear();
+    m_scrollStats = UiScrollStats();
+    m_refilling = false;
+    if (width <= 0 || height <= 0 || m_failed) {
+        return;
+    }
+    ++m_frame;
+    m_tiles.beginFrame();
+    collect(tree.getRoot(), static_cast<float>(width), static_cast<float>(height), contentScale);
+
+    // Containers off screen for a while give up their content; their tiles age out of the cache
+    for (auto it = m_layers.begin(); it != m_layers.end();) {
+        it = m_frame - it->second.lastFrame > kLayerLifetime ? m_layers.erase(it) : std::next(it);
+    }
+
+    if ((m_instances.empty() && m_layerDraws.empty()) || !createPrograms()) {
+        m_instances.clear();
+        m_layerDraws.clear();
+        return;
+    }
+
+    // Save the state the pass touches
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    GLint blendSourceRgb = 0;
+    GLint blendDestinationRgb = 0;
+    GLint blendSourceAlpha = 0;
+    GLint blendDestinationAlpha = 0;
+    GLint program = 0;
+    GLint vertexArray = 0;
+    GLint arrayBuffer = 0;
+    GLint activeTexture = 0;
+    GLint texture = 0;
+    glGetIntegerv(GL_BLEND_SRC_RGB, &blendSourceRgb);
+    glGetIntegerv(GL_BLEND_DST_RGB, &blendDestinationRgb);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSourceAlpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDestinationAlpha);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBuffer);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    std::uint32_t stateChanges = 2;
+    std::uint32_t drawCalls = 0;
+
+    // Tiles first: they are composited by the draws below
+    if (!m_rasterQueue.empty()) {
+        stateChanges += rasterTiles(renderer);
+        drawCalls += m_scrollStats.tilesRasterised;
+    }
+    buildTileInstances();
+
+    StreamAllocation rects;
+    if (!m_instances.empty()) {
+        rects = renderer.getBufferManager().uploadStream(
+            m_instances.data(), m_instances.size() * sizeof(Instance), alignof(Instance));
+    }
+    StreamAllocation tiles;
+    if (!m_tileInstances.empty()) {
+        tiles = renderer.getBufferManager().uploadStream(
+            m_tileInstances.data(), m_tileInstances.size() * sizeof(TileInstance), alignof(TileInstance));
+    }
+
+    // Rectangles and tiles alternate in tree order; the streamed ranges
+    // move every frame, so the attributes are re-pointed per batch
+    enum class Pass { None, Rects, Tiles };
+    Pass pass = Pass::None;
+    std::uint32_t drawn = 0;
+    auto drawRects = [&](std::uint32_t end) {
+        if (end <= drawn || !rects.isValid()) {
+            drawn = std::max(drawn, end);
+            return;
+        }
+        if (pass != Pass::Rects) {
+            gl::UseProgram(m_program);
+            gl::Uniform2f(m_viewportLocation, static_cast<float>(width), static_cast<float>(height));
+            gl::BindVertexArray(m_vertexArray);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            stateChanges += 4;
+            pass = Pass::Rects;
+        }
+        pointInstances(rects.buffer, rects.offset + drawn * sizeof(Instance));
+        stateChanges += 4;
+        gl::DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(end - drawn));
+        drawCalls++;
+        drawn = end;
+    };
+    bool atlasBound = false;
+    for (const LayerDraw& draw : m_layerDraws) {
+        drawRects(draw.rectEnd);
+        if (draw.tileCount == 0 || !tiles.isValid()) {
+            continue;
+        }
+        if (pass != Pass::Tiles) {
+            gl::UseProgram(m_tileProgram);
+            gl::Uniform2f(m_tileViewportLocation, static_cast<float>(width), static_cast<float>(height));
+            gl::BindVertexArray(m_tileVertexArray);
+            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            stateChanges += 4;
+            if (!atlasBound) {
+                gl::ActiveTexture(GL_TEXTURE0);
+                glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+                glBindTexture(GL_TEXTURE_2D, m_tiles.getAtlas().getColorTexture());
+                gl::Uniform1i(m_tileAtlasLocation, 0);
+                stateChanges += 3;
+                atlasBound = true;
+            }
+            pass = Pass::Tiles;
+        }
+        pointTileInstances(tiles.buffer, tiles.offset + draw.tileFirst * sizeof(TileInstance));
+        stateChanges += 4;
+        gl::DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(draw.tileCount));
+        drawCalls++;
+    }
+    drawRects(static_cast<std::uint32_t>(m_instances.size()));
+    renderer.recordDrawCalls(drawCalls);
+
+    // Restore
+    if (atlasBound) {
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(texture));
+        gl::ActiveTexture(static_cast<GLenum>(activeTexture));
+        stateChanges += 2;
+    }
+    gl::BindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(arrayBuffer));
+    gl::BindVertexArray(static_cast<GLuint>(vertexArray));
+    gl::UseProgram(static_cast<GLuint>(program));
+    gl::BlendFuncSeparate(static_cast<GLenum>(blendSourceRgb), static_cast<GLenum>(blendDestinationRgb),
+                          static_cast<GLenum>(blendSourceAlpha), static_cast<GLenum>(blendDestinationAlpha));
+    if (!blend) glDisable(GL_BLEND);
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    // Restore: four bindings and the blend function, plus the capabilities that were changed
+    renderer.recordStateChanges(stateChanges + 4 + (blend ? 0 : 1) + (depthTest ? 1 : 0));
+}
+
+std::uint32_t UiRenderer::getQuadCount() const {
+    return static_cast<std::uint32_t>(m_instances.size());
+}
+
+void UiRenderer::setJobSystem(JobSystem* jobs) {
+    m_jobs = jobs;
+}
+
+void UiRenderer::setScrollSettings(const UiScrollSettings& settings) {
+    if (settings.tileSize != m_scrollSettings.tileSize) {
+        // Binned for the old tile size
+        m_layers.clear();
+    }
+    m_scrollSettings = settings;
+    m_tiles.configure(settings.tileSize, settings.atlasTiles);
+}
+
+const UiScrollSettings& UiRenderer::getScrollSettings() const {
+    return m_scrollSettings;
+}
+
+const UiScrollStats& UiRenderer::getScrollStats() const {
+    return m_scrollStats;
+}
+
+const UiTileCache& UiRenderer::getTileCache() const {
+    return m_tiles;
+}
+
+bool UiRenderer::isRefilling() const {
+    return m_refilling;
+}
+
+void UiRenderer::release() {
+    if (gl::isLoaded()) {
+        if (m_program) {
+            gl::DeleteProgram(m_program);
+            m_program = 0;
+        }
+        if (m_vertexArray) {
+            gl::DeleteVertexArrays(1, &m_vertexArray);
+            m_vertexArray = 0;
+        }
+        if (m_tileProgram) {
+            gl::DeleteProgram(m_tileProgram);
+            m_tileProgram = 0;
+        }
+        if (m_tileVertexArray) {
+            gl::DeleteVertexArrays(1, &m_tileVertexArray);
+            m_tileVertexArray = 0;
+        }
+    }
+    // Jobs still binning only hold their own content
+    m_layers.clear();
+    m_layerDraws.clear();
+    m_rasterQueue.clear();
+    m_tiles.release();
+    m_failed = false;
+}
+
+void UiRenderer::collect(const UiNode& node, float width, float height, float contentScale) {
+    if (!node.worldVisible || node.worldOpacity <= 0.0) {
+        return;
+    }
+
+    const std::uint32_t color = static_cast<std::uint32_t>(node.get(UiProperty::BackgroundColor));
+    const double alpha = (color & 0xFF) * node.worldOpacity;
+    if (!node.isText && alpha >= 0.5) {
+        const float scale = static_cast<float>(node.worldScale) * contentScale;
+        Instance instance;
+        instance.rect[0] = static_cast<float>(node.worldX) * contentScale;
+        instance.rect[1] = static_cast<float>(node.worldY) * contentScale;
+        instance.rect[2] = static_cast<float>(node.get(UiProperty::Width)) * scale;
+        instance.rect[3] = static_cast<float>(node.get(UiProperty::Height)) * scale;
+        const bool onScreen = instance.rect[2] > 0.0f && instance.rect[3] > 0.0f
+            && instance.rect[0] < width && instance.rect[1] < height
+            && instance.rect[0] + instance.rect[2] > 0.0f && instance.rect[1] + instance.rect[3] > 0.0f;
+        if (onScreen) {
+            instance.color[0] = static_cast<unsigned char>(color >> 24);
+            instance.color[1] = static_cast<unsigned char>(color >> 16);
+            instance.color[2] = static_cast<unsigned char>(color >> 8);
+            instance.color[3] = static_cast<unsigned char>(alpha + 0.5);
+            instance.radius = static_cast<float>(node.get(UiProperty::BorderRadius)) * scale;
+            m_instances.push_back(instance);
+        }
+    }
+
+    if (node.scrolls) {
+        addLayer(node, width, height, contentScale);
+        return;
+    }
+    for (const UiNode* child : node.children) {
+        collect(*child, width, height, contentScale);
+    }
+}
+
+void UiRenderer::addLayer(const UiNode& node, float width, float height, float contentScale) {
+    const float scale = static_cast<float>(node.worldScale) * contentScale;
+    const float left = static_cast<float>(node.worldX) * contentScale;
+    const float top = static_cast<float>(node.worldY) * contentScale;
+    const float clip[4] = {
+        std::max(left, 0.0f),
+        std::max(top, 0.0f),
+        std::min(left + static_cast<float>(node.get(UiProperty::Width)) * scale, width),
+        std::min(top + static_cast<float>(node.get(UiProperty::Height)) * scale, height)
+    };
+    if (scale <= 0.0f || clip[0] >= clip[2] || clip[1] >= clip[3]) {
+        return;
+    }
+
+    Layer& layer = m_layers[node.id];
+    layer.lastFrame = m_frame;
+    if (layer.job.isValid() && layer.job.isDone()) {
+        layer.content = std::move(layer.building);
+        layer.version = layer.buildingVersion;
+        layer.scale = layer.buildingScale;
+        layer.job = JobHandle();
+    }
+
+    // One build in flight per container; changes made meanwhile are picked up once it lands
+    const bool outdated = !layer.content || layer.version != node.contentVersion || layer.scale != scale;
+    if (outdated && !layer.job.isValid()) {
+        std::shared_ptr<TileContent> content = std::make_shared<TileContent>();
+        for (const UiNode* child : node.children) {
+            flatten(*child, node, contentScale, 0.0f, 0.0f, nullptr, content->instances);
+        }
+        m_scrollStats.contentBuilds++;
+        const int tileSize = m_tiles.getTileSize();
+        if (m_jobs) {
+            layer.building = content;
+            layer.buildingVersion = node.contentVersion;
+            layer.buildingScale = scale;
+            layer.job = m_jobs->schedule([content, tileSize]() {
+                bin(*content, tileSize);
+            });
+        } else {
+            bin(*content, tileSize);
+            layer.content = std::move(content);
+            layer.version = node.contentVersion;
+            layer.scale = scale;
+        }
+    }
+    m_refilling |= layer.job.isValid();
+    if (!layer.content) {
+        // First build still binning: the container shows its background
+        return;
+    }
+
+    const TileContent& content = *layer.content;
+    m_scrollStats.layers++;
+    if (content.columns == 0 || content.rows == 0) {
+        return;
+    }
+
+    // Content laid out at another scale is stretched until its rebuild lands;
+    // whole-pixel origins keep tiles sampled 1:1 otherwise
+    const float tileScale = scale / layer.scale;
+    const float tilePixels = static_cast<float>(m_tiles.getTileSize()) * tileScale;
+    LayerDraw draw;
+    draw.rectEnd = static_cast<std::uint32_t>(m_instances.size());
+    draw.node = node.id;
+    draw.content = layer.content;
+    std::copy(clip, clip + 4, draw.clip);
+    draw.originX = std::round(left - static_cast<float>(node.get(UiProperty::ScrollX)) * scale);
+    draw.originY = std::round(top - static_cast<float>(node.get(UiProperty::ScrollY)) * scale);
+    draw.tileScale = tileScale;
+    draw.opacity = static_cast<float>(node.worldOpacity);
+    draw.firstColumn = std::max(static_cast<int>(std::floor((clip[0] - draw.originX) / tilePixels)), 0);
+    draw.lastColumn = std::min(static_cast<int>(std::ceil((clip[2] - draw.originX) / tilePixels)) - 1,
+                               content.columns - 1);
+    draw.firstRow = std::max(static_cast<int>(std::floor((clip[1] - draw.originY) / tilePixels)), 0);
+    draw.lastRow = std::min(static_cast<int>(std::ceil((clip[3] - draw.originY) / tilePixels)) - 1,
+                            content.rows - 1);
+    if (draw.firstColumn > draw.lastColumn || draw.firstRow > draw.lastRow) {
+        return;
+    }
+    m_layerDraws.push_back(draw);
+
+    // Queue the visible and prefetch tiles that are missing or outdated
+    const int prefetch = std::max(m_scrollSettings.prefetchTiles, 0);
+    const int firstColumn = std::max(draw.firstColumn - prefetch, 0);
+    const int lastColumn = std::min(draw.lastColumn + prefetch, content.columns - 1);
+    const int firstRow = std::max(draw.firstRow - prefetch, 0);
+    const int lastRow = std::min(draw.lastRow + prefetch, content.rows - 1);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const std::size_t index = static_cast<std::size_t>(row) * content.columns + column;
+            if (content.offsets[index] == content.offsets[index + 1]) {
+                continue;
+            }
+            const UiTileKey key{node.id, column, row};
+            std::uint64_t hash = 0;
+            if (m_tiles.find(key, hash) < 0 || hash != content.hashes[index]) {
+                const bool visible = column >= draw.firstColumn && column <= draw.lastColumn
+                    && row >= draw.firstRow && row <= draw.lastRow;
+                m_rasterQueue.push_back({layer.content, key, visible});
+            }
+        }
+    }
+}
+
+void UiRenderer::flatten(const UiNode& node, const UiNode& container, float contentScale,
+                         float offsetX, float offsetY, const float* clip, std::vector<Instance>& out) const {
+    if (!node.worldVisible || node.worldOpacity <= 0.0) {
+        return;
+    }
+
+    const float scale = static_cast<float>(node.worldScale) * contentScale;
+    const float left = static_cast<float>(node.worldX - container.worldX) * contentScale + offsetX;
+    const float top = static_cast<float>(node.worldY - container.worldY) * contentScale + offsetY;
+    float bounds[4] = {
+        left,
+        top,
+        left + static_cast<float>(node.get(UiProperty::Width)) * scale,
+        top + static_cast<float>(node.get(UiProperty::Height)) * scale
+    };
+    if (clip) {
+        bounds[0] = std::max(bounds[0], clip[0]);
+        bounds[1] = std::max(bounds[1], clip[1]);
+        bounds[2] = std::min(bounds[2], clip[2]);
+        bounds[3] = std::min(bounds[3], clip[3]);
+    }
+
+    // Relative to the container, whose own opacity applies when compositing
+    const double opacity = node.worldOpacity / container.worldOpacity;
+    const std::uint32_t color = static_cast<std::uint32_t>(node.get(UiProperty::BackgroundColor));
+    const double alpha = (color & 0xFF) * opacity;
+    if (!node.isText && alpha >= 0.5 && bounds[0] < bounds[2] && bounds[1] < bounds[3]) {
+        Instance instance;
+        instance.rect[0] = bounds[0];
+        instance.rect[1] = bounds[1];
+        instance.rect[2] = bounds[2] - bounds[0];
+        instance.rect[3] = bounds[3] - bounds[1];
+        instance.color[0] = static_cast<unsigned char>(color >> 24);
+        instance.color[1] = static_cast<unsigned char>(color >> 16);
+        instance.color[2] = static_cast<unsigned char>(color >> 8);
+        instance.color[3] = static_cast<unsigned char>(std::min(alpha, 255.0) + 0.5);
+        instance.radius = static_cast<float>(node.get(UiProperty::BorderRadius)) * scale;
+        out.push_back(instance);
+    }
+
+    // Nested scroll containers are flattened with their offset and clip applied
+    if (node.scrolls) {
+        if (bounds[0] >= bounds[2] || bounds[1] >= bounds[3]) {
+            return;
+        }
+        offsetX -= static_cast<float>(node.get(UiProperty::ScrollX)) * scale;
+        offsetY -= static_cast<float>(node.get(UiProperty::ScrollY)) * scale;
+        clip = bounds;
+    }
+    for (const UiNode* child : node.children) {
+        flatten(*child, container, contentScale, offsetX, offsetY, clip, out);
+    }
+}
+
+void UiRenderer::bin(TileContent& content, int tileSize) {
+    const float size = static_cast<float>(tileSize);
+    float right = 0.0f;
+    float bottom = 0.0f;
+    for (const Instance& instance : content.instances) {
+        right = std::max(right, instance.rect[0] + instance.rect[2]);
+        bottom = std::max(bottom, instance.rect[1] + instance.rect[3]);
+    }
+    content.columns = static_cast<int>(std::ceil(right / size));
+    content.rows = static_cast<int>(std::ceil(bottom / size));
+    if (content.columns > 0 && static_cast<std::size_t>(content.columns) * content.rows > kMaxTilesPerLayer) {
+        content.rows = static_cast<int>(kMaxTilesPerLayer / content.columns);
+    }
+    const std::size_t tileCount = static_cast<std::size_t>(content.columns) * content.rows;
+
+    // Every rectangle goes to each tile it overlaps, in tree order
+    auto forEachTile = [&](const Instance& instance, auto&& function) {
+        const int firstColumn = std::max(static_cast<int>(std::floor(instance.rect[0] / size)), 0);
+        const int lastColumn = std::min(static_cast<int>(std::ceil((instance.rect[0] + instance.rect[2]) / size)) - 1,
+                                        content.columns - 1);
+        const int firstRow = std::max(static_cast<int>(std::floor(instance.rect[1] / size)), 0);
+        const int lastRow = std::min(static_cast<int>(std::ceil((instance.rect[1] + instance.rect[3]) / size)) - 1,
+                                     content.rows - 1);
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                function(static_cast<std::size_t>(row) * content.columns + column);
+            }
+        }
+    };
+    content.offsets.assign(tileCount + 1, 0);
+    for (const Instance& instance : content.instances) {
+        forEachTile(instance, [&](std::size_t tile) { content.offsets[tile + 1]++; });
+    }
+    for (std::size_t tile = 0; tile < tileCount; ++tile) {
+        content.offsets[tile + 1] += content.offsets[tile];
+    }
+    content.indices.resize(content.offsets[tileCount]);
+    std::vector<std::uint32_t> cursor(content.offsets.begin(), content.offsets.end() - 1);
+    for (std::size_t i = 0; i < content.instances.size(); ++i) {
+        forEachTile(content.instances[i], [&](std::size_t tile) {
+            content.indices[cursor[tile]++] = static_cast<std::uint32_t>(i);
+        });
+    }
+
+    content.hashes.assign(tileCount, 0);
+    for (std::size_t tile = 0; tile < tileCount; ++tile) {
+        std::uint64_t hash = 0xCBF29CE484222325ull;
+        for (std::uint32_t i = content.offsets[tile]; i < content.offsets[tile + 1]; ++i) {
+            hash = hashBytes(hash, &content.instances[content.indices[i]], sizeof(Instance));
+        }
+        content.hashes[tile] = hash;
+    }
+}
+
+bool UiRenderer::createPrograms() {
+    if (m_program && m_tileProgram) {
+        return true;
+    }
+    m_program = gl::createProgram(kRectVertexShader, kRectFragmentShader, "ui rectangles");
+    m_tileProgram = gl::createProgram(kTileVertexShader, kTileFragmentShader, "ui tiles");
+    if (!m_program || !m_tileProgram) {
+        // Don't retry every frame
+        m_failed = true;
+        return false;
+    }
+    m_viewportLocation = gl::GetUniformLocation(m_program, "uViewport");
+    m_tileViewportLocation = gl::GetUniformLocation(m_tileProgram, "uViewport");
+    m_tileAtlasLocation = gl::GetUniformLocation(m_tileProgram, "uAtlas");
+
+    // Per-instance attributes 0-2; their pointers are set per batch
+    GLint vertexArray = 0;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+    gl::GenVertexArrays(1, &m_vertexArray);
+    gl::GenVertexArrays(1, &m_tileVertexArray);
+    for (GLuint array : {m_vertexArray, m_tileVertexArray}) {
+        gl::BindVertexArray(array);
+        for (GLuint attribute = 0; attribute < 3; ++attribute) {
+            gl::EnableVertexAttribArray(attribute);
+            gl::VertexAttribDivisor(attribute, 1);
+        }
+    }
+    gl::BindVertexArray(static_cast<GLuint>(vertexArray));
+    return true;
+}
+
+void UiRenderer::pointInstances(GLuint buffer, std::size_t offset) {
+    const GLsizei stride = sizeof(Instance);
+    gl::BindBuffer(GL_ARRAY_BUFFER, buffer);
+    gl::VertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride,
+                            reinterpret_cast<const void*>(offset + offsetof(Instance, rect)));
+    gl::VertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                            reinterpret_cast<const void*>(offset + offsetof(Instance, color)));
+    gl::VertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride,
+                            reinterpret_cast<const void*>(offset + offsetof(Instance, radius)));
+}
+
+void UiRenderer::pointTileInstances(GLuint buffer, std::size_t offset) {
+    const GLsizei stride = sizeof(TileInstance);
+    gl::BindBuffer(GL_ARRAY_BUFFER, buffer);
+    gl::VertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride,
+                            reinterpret_cast<const void*>(offset + offsetof(TileInstance, rect)));
+    gl::VertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride,
+                            reinterpret_cast<const void*>(offset + offsetof(TileInstance, uv)));
+    gl::VertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride,
+                            reinterpret_cast<const void*>(offset + offsetof(TileInstance, opacity)));
+}
+
+std::uint32_t UiRenderer::rasterTiles(Renderer& renderer) {
+    // Visible tiles first; prefetch tiles get what is left of the budget
+    std::stable_partition(m_rasterQueue.begin(), m_rasterQueue.end(),
+                          [](const TileRaster& tile) { return tile.visible; });
+    const std::size_t budget = static_cast<std::size_t>(std::max(m_scrollSettings.maxRasterPerFrame, 1));
+    const std::size_t count = std::min(m_rasterQueue.size(), budget);
+    m_refilling |= m_rasterQueue.size() > budget;
+
+    // Rectangles of each tile, relative to the tile
+    const int tileSize = m_tiles.getTileSize();
+    m_rasterInstances.clear();
+    std::vector<std::uint32_t> firsts(count + 1);
+    for (std::size_t i = 0; i < count; ++i) {
+        const TileRaster& tile = m_rasterQueue[i];
+        const TileContent& content = *tile.content;
+        const std::size_t index = static_cast<std::size_t>(tile.key.row) * content.columns + tile.key.column;
+        firsts[i] = static_cast<std::uint32_t>(m_rasterInstances.size());
+        for (std::uint32_t j = content.offsets[index]; j < content.offsets[index + 1]; ++j) {
+            Instance instance = content.instances[content.indices[j]];
+            instance.rect[0] -= static_cast<float>(tile.key.column * tileSize);
+            instance.rect[1] -= static_cast<float>(tile.key.row * tileSize);
+            m_rasterInstances.push_back(instance);
+        }
+    }
+    firsts[count] = static_cast<std::uint32_t>(m_rasterInstances.size());
+    StreamAllocation instances = renderer.getBufferManager().uploadStream(
+        m_rasterInstances.data(), m_rasterInstances.size() * sizeof(Instance), alignof(Instance));
+    if (!instances.isValid()) {
+        m_refilling = true;
+        return 0;
+    }
+
+    GLint framebuffer = 0;
+    GLint viewport[4] = {};
+    GLint scissorBox[4] = {};
+    GLfloat clearColor[4] = {};
+    const GLboolean scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    // Tiles store premultiplied colors, so they composite like the rectangles would have
+    std::uint32_t stateChanges = 6;
+    glEnable(GL_SCISSOR_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    gl::BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    gl::UseProgram(m_program);
+    gl::Uniform2f(m_viewportLocation, static_cast<float>(tileSize), static_cast<float>(tileSize));
+    gl::BindVertexArray(m_vertexArray);
+
+    bool bound = false;
+    for (std::size_t i = 0; i < count; ++i) {
+        const TileRaster& tile = m_rasterQueue[i];
+        const TileContent& content = *tile.content;
+        const std::size_t index = static_cast<std::size_t>(tile.key.row) * content.columns + tile.key.column;
+        const int slot = m_tiles.allocate(tile.key, content.hashes[index]);
+        if (slot < 0) {
+            // Every slot holds a tile needed this frame: the atlas is too small for the viewport
+            m_refilling = true;
+            break;
+        }
+        if (!bound) {
+            m_tiles.getAtlas().bind();
+            stateChanges++;
+            bound = true;
+        }
+        int x = 0;
+        int y = 0;
+        m_tiles.getSlotOrigin(slot, x, y);
+        glViewport(x, y, tileSize, tileSize);
+        glScissor(x, y, tileSize, tileSize);
+        glClear(GL_COLOR_BUFFER_BIT);
+        pointInstances(instances.buffer, instances.offset + firsts[i] * sizeof(Instance));
+        gl::DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(firsts[i + 1] - firsts[i]));
+        stateChanges += 6;
+        m_scrollStats.tilesRasterised++;
+    }
+
+    // Restore
+    if (bound) {
+        gl::BindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        stateChanges += 2;
+    }
+    glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    if (!scissorTest) glDisable(GL_SCISSOR_TEST);
+    return stateChanges + 2 + (scissorTest ? 0 : 1);
+}
+
+void UiRenderer::buildTileInstances() {
+    const int tileSize = m_tiles.getTileSize();
+    const float atlasSize = static_cast<float>(m_tiles.getAtlasSize());
+    for (LayerDraw& draw : m_layerDraws) {
+        draw.tileFirst = static_cast<std::uint32_t>(m_tileInstances.size());
+        const TileContent& content = *draw.content;
+        const float tilePixels = static_cast<float>(tileSize) * draw.tileScale;
+        for (int row = draw.firstRow; row <= draw.lastRow; ++row) {
+            for (int column = draw.firstColumn; column <= draw.lastColumn; ++column) {
+                const std::size_t index = static_cast<std::size_t>(row) * content.columns + column;
+                if (content.offsets[index] == content.offsets[index + 1]) {
+                    continue;
+                }
+                m_scrollStats.tilesVisible++;
+                std::uint64_t hash = 0;
+                const int slot = m_tiles.peek({draw.node, column, row}, hash);
+                if (slot < 0) {
+                    m_scrollStats.tilesMissing++;
+                    m_refilling = true;
+                    continue;
+                }
+                if (hash != content.hashes[index]) {
+                    m_scrollStats.tilesStale++;
+                    m_refilling = true;
+                }
+
+                // The tile on screen, clipped to the container
+                const float x0 = draw.originX + static_cast<float>(column) * tilePixels;
+                const float y0 = draw.originY + static_cast<float>(row) * tilePixels;
+                const float left = std::max(x0, draw.clip[0]);
+                const float top = std::max(y0, draw.clip[1]);
+                const float right = std::min(x0 + tilePixels, draw.clip[2]);
+                const float bottom = std::min(y0 + tilePixels, draw.clip[3]);
+                if (left >= right || top >= bottom) {
+                    continue;
+                }
+
+                // Rows were rasterised top-down from the top of the slot
+                int slotX = 0;
+                int slotY = 0;
+                m_tiles.getSlotOrigin(slot, slotX, slotY);
+                const float slotTop = static_cast<float>(slotY + tileSize);
+                TileInstance instance;
+                instance.rect[0] = left;
+                instance.rect[1] = top;
+                instance.rect[2] = right - left;
+                instance.rect[3] = bottom - top;
+                instance.uv[0] = (static_cast<float>(slotX) + (left - x0) / draw.tileScale) / atlasSize;
+                instance.uv[1] = (slotTop - (top - y0) / draw.tileScale) / atlasSize;
+                instance.uv[2] = (static_cast<float>(slotX) + (right - x0) / draw.tileScale) / atlasSize;
+                instance.uv[3] = (slotTop - (bottom - y0) / draw.tileScale) / atlasSize;
+                instance.opacity = draw.opacity;
+                m_tileInstances.push_back(instance);
+                m_scrollStats.tilesDrawn++;
+            }
+        }
+        draw.tileCount = static_cast<std::uint32_t>(m_tileInstances.size()) - draw.tileFirst;
+    }
+}
+
+} // namespace crazy
@@ -0,0 +1,138 @@
+#include "crazy/UiTileCache.hpp"
+#include "crazy/Log.hpp"
+#include <algorithm>
+
+namespace crazy {
+
+UiTileCache::UiTileCache(int tileSize, int atlasTiles)
+    : m_tileSize(std::max(tileSize, 16))
+    , m_atlasTiles(std::max(atlasTiles, 1))
+    , m_atlas(false)
+    , m_frame(1)
+{
+    m_slots.resize(static_cast<std::size_t>(m_atlasTiles) * m_atlasTiles);
+    m_stats.capacity = m_slots.size();
+}
+
+void UiTileCache::configure(int tileSize, int atlasTiles) {
+    tileSize = std::max(tileSize, 16);
+    atlasTiles = std::max(atlasTiles, 1);
+    if (tileSize == m_tileSize && atlasTiles == m_atlasTiles) {
+        return;
+    }
+    m_tileSize = tileSize;
+    m_atlasTiles = atlasTiles;
+    m_slots.assign(static_cast<std::size_t>(m_atlasTiles) * m_atlasTiles, Slot());
+    m_index.clear();
+    m_stats.tiles = 0;
+    m_stats.capacity = m_slots.size();
+    // The atlas is resized by the next allocate()
+}
+
+void UiTileCache::beginFrame() {
+    ++m_frame;
+}
+
+int UiTileCache::find(const UiTileKey& key, std::uint64_t& hash) {
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        m_stats.misses++;
+        return -1;
+    }
+    Slot& slot = m_slots[it->second];
+    slot.lastUsed = m_frame;
+    hash = slot.hash;
+    m_stats.hits++;
+    return it->second;
+}
+
+int UiTileCache::peek(const UiTileKey& key, std::uint64_t& hash) const {
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        return -1;
+    }
+    hash = m_slots[it->second].hash;
+    return it->second;
+}
+
+int UiTileCache::allocate(const UiTileKey& key, std::uint64_t hash) {
+    const int size = m_tileSize * m_atlasTiles;
+    if (m_atlas.getWidth() != size || m_atlas.getHeight() != size) {
+        if (!m_atlas.resize(size, size)) {
+            CRAZY_LOG_ERROR("UiTileCache: cannot allocate a {}x{} tile atlas", size, size);
+            return -1;
+        }
+    }
+
+    int index = -1;
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        index = it->second;
+    } else {
+        // A free slot, else the least recently used one not needed this frame
+        for (std::size_t i = 0; i < m_slots.size(); ++i) {
+            const Slot& slot = m_slots[i];
+            if (!slot.occupied) {
+                index = static_cast<int>(i);
+                break;
+            }
+            if (slot.lastUsed != m_frame && (index < 0 || slot.lastUsed < m_slots[index].lastUsed)) {
+                index = static_cast<int>(i);
+            }
+        }
+        if (index < 0) {
+            return -1;
+        }
+        Slot& slot = m_slots[index];
+        if (slot.occupied) {
+            m_index.erase(slot.key);
+            m_stats.evictions++;
+        } else {
+            m_stats.tiles++;
+        }
+        slot.key = key;
+        slot.occupied = true;
+        m_index[key] = index;
+    }
+
+    Slot& slot = m_slots[index];
+    slot.hash = hash;
+    slot.lastUsed = m_frame;
+    return index;
+}
+
+void UiTileCache::clear() {
+    for (Slot& slot : m_slots) {
+        slot = Slot();
+    }
+    m_index.clear();
+    m_stats.tiles = 0;
+}
+
+void UiTileCache::getSlotOrigin(int slot, int& x, int& y) const {
+    x = slot % m_atlasTiles * m_tileSize;
+    y = slot / m_atlasTiles * m_tileSize;
+}
+
+RenderTarget& UiTileCache::getAtlas() {
+    return m_atlas;
+}
+
+int UiTileCache::getTileSize() const {
+    return m_tileSize;
+}
+
+int UiTileCache::getAtlasSize() const {
+    return m_tileSize * m_atlasTiles;
+}
+
+UiTileCacheStats UiTileCache::getStats() const {
+    return m_stats;
+}
+
+void UiTileCache::release() {
+    clear();
+    m_atlas.release();
+}
+
+} // namespace crazy
@@ -0,0 +1,652 @@
+#include "crazy/UiTree.hpp"
+#include "crazy/BridgeMessages.hpp"
+#include "crazy/CommandBatch.hpp"
+#include "crazy/Log.hpp"
+#include "crazy/MemoryTracker.hpp"
+#include "crazy/NodeRuntime.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace crazy {
+
+namespace {
+
+struct PropertyInfo {
+    const char* name;
+    UiProperty property;
+    double defaultValue;
+};
+
+// Indexed by UiProperty
+constexpr PropertyInfo kProperties[] = {
+    {"x", UiProperty::X, 0.0},
+    {"y", UiProperty::Y, 0.0},
+    {"width", UiProperty::Width, 0.0},
+    {"height", UiProperty::Height, 0.0},
+    {"opacity", UiProperty::Opacity, 1.0},
+    {"translateX", UiProperty::TranslateX, 0.0},
+    {"translateY", UiProperty::TranslateY, 0.0},
+    {"scale", UiProperty::Scale, 1.0},
+    {"borderRadius", UiProperty::BorderRadius, 0.0},
+    {"backgroundColor", UiProperty::BackgroundColor, 0.0},
+    {"color", UiProperty::Color, 0.0},
+    {"visible", UiProperty::Visible, 1.0},
+    {"scrollLeft", UiProperty::ScrollX, 0.0},
+    {"scrollTop", UiProperty::ScrollY, 0.0},
+};
+static_assert(sizeof(kProperties) / sizeof(kProperties[0]) == static_cast<std::size_t>(UiProperty::Count),
+              "kProperties must list every UiProperty");
+
+double defaultValue(UiProperty property) {
+    return kProperties[static_cast<int>(property)].defaultValue;
+}
+
+bool isColor(UiProperty property) {
+    return property == UiProperty::BackgroundColor || property == UiProperty::Color;
+}
+
+// Scroll offsets are applied on top of the world values, never baked into them
+bool isScroll(UiProperty property) {
+    return property == UiProperty::ScrollX || property == UiProperty::ScrollY;
+}
+
+double ease(UiEasing easing, double t) {
+    switch (easing) {
+        case UiEasing::EaseIn:
+            return t * t * t;
+        case UiEasing::EaseOut: {
+            double u = 1.0 - t;
+            return 1.0 - u * u * u;
+        }
+        case UiEasing::EaseInOut:
+            return t < 0.5 ? 4.0 * t * t * t : 1.0 - std::pow(-2.0 * t + 2.0, 3.0) / 2.0;
+        case UiEasing::Linear:
+        default:
+            return t;
+    }
+}
+
+// Packed 0xRRGGBBAA colors blend per channel
+double interpolate(UiProperty property, double from, double to, double t) {
+    if (!isColor(property)) {
+        return from + (to - from) * t;
+    }
+    std::uint32_t a = static_cast<std::uint32_t>(from);
+    std::uint32_t b = static_cast<std::uint32_t>(to);
+    std::uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        double ca = (a >> shift) & 0xFF;
+        double cb = (b >> shift) & 0xFF;
+        result |= static_cast<std::uint32_t>(std::lround(ca + (cb - ca) * t)) << shift;
+    }
+    return result;
+}
+
+std::uint32_t eventBit(UiEventKind kind) {
+    return 1u << static_cast<int>(kind);
+}
+
+} // namespace
+
+void* UiNode::operator new(std::size_t size) {
+    return MemoryTracker::instance().getResource(MemoryCategory::UiTree)->allocate(size, alignof(UiNode));
+}
+
+void UiNode::operator delete(void* p, std::size_t size) {
+    MemoryTracker::instance().getResource(MemoryCategory::UiTree)->deallocate(p, size, alignof(UiNode));
+}
+
+UiTree::UiTree(std::uint32_t eventCapacity)
+    : m_nodes(MemoryTracker::instance().getResource(MemoryCategory::UiTree))
+    , m_transitions(MemoryTracker::instance().getResource(MemoryCategory::UiTree))
+    , m_root(nullptr)
+    , m_revision(0)
+    , m_worldDirty(true)
+    , m_eventMemory(RingChannel::requiredSize(eventCapacity), "crazy-ui-events")
+    , m_events(m_eventMemory.getData(), m_eventMemory.getSize(), true)
+    , m_pointerX(0.0)
+    , m_pointerY(0.0)
+    , m_pressedNode(0)
+{
+    m_root = create(0, false, "root");
+}
+
+bool UiTree::attach(NodeRuntime& runtime, CommandBatch& commands) {
+    commands.setHandler([this](const void* data, std::uint32_t size) {
+        apply(data, size);
+    });
+    if (!m_events.isValid() || !runtime.shareMemory("uiEvents", m_eventMemory.getData(), m_eventMemory.getSize())) {
+        return false;
+    }
+    // Only called when JavaScript parked the ring after draining it
+    m_events.setWakeupCallback([&runtime]() {
+        runtime.postCall("crazy.dispatchUiEvents");
+    });
+    return true;
+}
+
+bool UiTree::apply(const void* data, std::uint32_t size) {
+    UiNode* node = nullptr;
+    switch (bridge::getMessageType(data, size)) {
+        case bridge::MessageType::CreateElement: {
+            bridge::CreateElement::Reader message(data, size);
+            if (!message.isValid() || !(node = create(message.id(), false, message.elementType()))) {
+                return false;
+            }
+            break;
+        }
+        case bridge::MessageType::CreateText: {
+            bridge::CreateText::Reader message(data, size);
+            if (!message.isValid() || !(node = create(message.id(), true, message.text()))) {
+                return false;
+            }
+            break;
+        }
+        case bridge::MessageType::AppendChild: {
+            bridge::AppendChild::Reader message(data, size);
+            UiNode* parent = message.isValid() ? lookup(message.parent()) : nullptr;
+            UiNode* child = message.isValid() ? lookup(message.child()) : nullptr;
+            if (!parent || !child || child == m_root) {
+                return false;
+            }
+            detach(child);
+            child->parent = parent;
+            parent->children.push_back(child);
+            markContent(parent);
+            break;
+        }
+        case bridge::MessageType::InsertBefore: {
+            bridge::InsertBefore::Reader message(data, size);
+            UiNode* parent = message.isValid() ? lookup(message.parent()) : nullptr;
+            UiNode* child = message.isValid() ? lookup(message.child()) : nullptr;
+            UiNode* before = message.isValid() ? lookup(message.before()) : nullptr;
+            if (!parent || !child || !before || child == m_root || before->parent != parent) {
+                return false;
+            }
+            detach(child);
+            child->parent = parent;
+            parent->children.insert(std::find(parent->children.begin(), parent->children.end(), before), child);
+            markContent(parent);
+            break;
+        }
+        case bridge::MessageType::RemoveChild: {
+            bridge::RemoveChild::Reader message(data, size);
+            UiNode* child = message.isValid() ? lookup(message.child()) : nullptr;
+            if (!child || !child->parent || child->parent->id != message.parent()) {
+                return false;
+            }
+            detach(child);
+            break;
+        }
+        case bridge::MessageType::DestroyNode: {
+            bridge::DestroyNode::Reader message(data, size);
+            node = message.isValid() ? lookup(message.id()) : nullptr;
+            if (!node || node == m_root) {
+                return false;
+            }
+            detach(node);
+            destroy(node);
+            break;
+        }
+        case bridge::MessageType::SetNumberProperty: {
+            bridge::SetNumberProperty::Reader message(data, size);
+            if (!message.isValid() || !(node = lookup(message.id()))) {
+                return false;
+            }
+            UiProperty property;
+            if (findProperty(message.property(), property)) {
+                setValue(node, property, message.value());
+                if (isScroll(property)) {
+                    markContent(node->parent);
+                    ++m_revision;
+                    return true;
+                }
+            } else {
+                node->numbers[std::string(message.property())] = message.value();
+            }
+            break;
+        }
+        case bridge::MessageType::SetStringProperty: {
+            bridge::SetStringProperty::Reader message(data, size);
+            if (!message.isValid() || !(node = lookup(message.id()))) {
+                return false;
+            }
+            node->strings[std::string(message.property())] = std::string(message.value());
+            break;
+        }
+        case bridge::MessageType::RemoveProperty: {
+            bridge::RemoveProperty::Reader message(data, size);
+            if (!message.isValid() || !(node = lookup(message.id()))) {
+                return false;
+            }
+            UiProperty property;
+            if (findProperty(message.property(), property)) {
+                // Removal never animates
+                m_animations.erase(std::remove_if(m_animations.begin(), m_animations.end(),
+                    [&](const Animation& animation) {
+                        return animation.node == node->id && animation.property == property;
+                    }), m_animations.end());
+                node->values[static_cast<int>(property)] = defaultValue(property);
+            } else {
+                std::string name(message.property());
+                node->numbers.erase(name);
+                node->strings.erase(name);
+            }
+            break;
+        }
+        case bridge::MessageType::SetText: {
+            bridge::SetText::Reader message(data, size);
+            if (!message.isValid() || !(node = lookup(message.id()))) {
+                return false;
+            }
+            node->text.assign(message.text());
+            break;
+        }
+        case bridge::MessageType::SetTransition: {
+            bridge::SetTransition::Reader message(data, size);
+            UiProperty property;
+            if (!message.isValid() || !lookup(message.id()) || !findProperty(message.property(), property)
+                || property == UiProperty::Visible) {
+                return false;
+            }
+            std::vector<Transition>& transitions = m_transitions[message.id()];
+            transitions.erase(std::remove_if(transitions.begin(), transitions.end(),
+                [&](const Transition& transition) { return transition.property == property; }),
+                transitions.end());
+            if (message.duration() > 0.0) {
+                UiEasing easing = message.easing() <= static_cast<std::uint8_t>(UiEasing::EaseInOut)
+                    ? static_cast<UiEasing>(message.easing()) : UiEasing::Linear;
+                transitions.push_back({property, easing, message.duration()});
+            }
+            return true;
+        }
+        case bridge::MessageType::SetEventMask: {
+            bridge::SetEventMask::Reader message(data, size);
+            if (!message.isValid() || !(node = lookup(message.id()))) {
+                return false;
+            }
+            node->eventMask = message.mask();
+            return true;
+        }
+        default:
+            return false;
+    }
+
+    if (node) {
+        markContent(node->parent);
+    }
+    ++m_revision;
+    m_worldDirty = true;
+    return true;
+}
+
+void UiTree::update(double deltaTime) {
+    if (!m_animations.empty()) {
+        bool worldChanged = false;
+        for (Animation& animation : m_animations) {
+            animation.elapsed += deltaTime;
+            UiNode* node = lookup(animation.node);
+            if (!node) {
+                animation.elapsed = animation.duration;
+                continue;
+            }
+            double t = std::min(animation.elapsed / animation.duration, 1.0);
+            node->values[static_cast<int>(animation.property)] = t >= 1.0
+                ? animation.to
+                : interpolate(animation.property, animation.from, animation.to, ease(animation.easing, t));
+            markContent(node->parent);
+            worldChanged |= !isScroll(animation.property);
+        }
+        m_animations.erase(std::remove_if(m_animations.begin(), m_animations.end(),
+            [](const Animation& animation) { return animation.elapsed >= animation.duration; }),
+            m_animations.end());
+        ++m_revision;
+        m_worldDirty |= worldChanged;
+    }
+
+    if (m_worldDirty) {
+        updateWorld(m_root, nullptr);
+        m_worldDirty = false;
+    }
+}
+
+bool UiTree::isAnimating() const {
+    return !m_animations.empty();
+}
+
+std::uint64_t UiTree::getRevision() const {
+    return m_revision;
+}
+
+const UiNode& UiTree::getRoot() const {
+    return *m_root;
+}
+
+const UiNode* UiTree::find(std::uint32_t id) const {
+    auto it = m_nodes.find(id);
+    return it != m_nodes.end() ? it->second.get() : nullptr;
+}
+
+std::size_t UiTree::getNodeCount() const {
+    return m_nodes.size();
+}
+
+const UiNode* UiTree::hitTest(double x, double y) const {
+    return hitTest(m_root, x, y);
+}
+
+bool UiTree::handleMouseMove(const MouseMoveEvent& event) {
+    m_pointerX = event.xpos;
+    m_pointerY = event.ypos;
+    if (m_worldDirty) {
+        update(0.0);
+    }
+
+    const UiNode* target = hitTest(m_pointerX, m_pointerY);
+    std::vector<std::uint32_t> path;
+    for (const UiNode* node = target; node && node != m_root; node = node->parent) {
+        path.push_back(node->id);
+    }
+
+    // Leave the innermost node first and enter the outermost first, as the DOM does
+    bool delivered = false;
+    for (std::uint32_t id : m_hoverPath) {
+        const UiNode* node = lookup(id);
+        if (node && std::find(path.begin(), path.end(), id) == path.end()
+            && (node->eventMask & eventBit(UiEventKind::PointerLeave))) {
+            delivered |= post(node, UiEventKind::PointerLeave, -1, 0);
+        }
+    }
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        const UiNode* node = lookup(*it);
+        if (std::find(m_hoverPath.begin(), m_hoverPath.end(), *it) == m_hoverPath.end()
+            && (node->eventMask & eventBit(UiEventKind::PointerEnter))) {
+            delivered |= post(node, UiEventKind::PointerEnter, -1, 0);
+        }
+    }
+    m_hoverPath.swap(path);
+
+    if (target && listens(target, UiEventKind::PointerMove)) {
+        delivered |= post(target, UiEventKind::PointerMove, -1, 0);
+    }
+    return delivered;
+}
+
+bool UiTree::handleMouseButton(const MouseButtonEvent& event, bool pressed) {
+    if (m_worldDirty) {
+        update(0.0);
+    }
+
+    const UiNode* target = hitTest(m_pointerX, m_pointerY);
+    bool delivered = false;
+    if (pressed) {
+        m_pressedNode = target ? target->id : 0;
+        if (target && listens(target, UiEventKind::PointerDown)) {
+            delivered |= post(target, UiEventKind::PointerDown, event.button, event.mods);
+        }
+        return delivered;
+    }
+
+    if (target && listens(target, UiEventKind::PointerUp)) {
+        delivered |= post(target, UiEventKind::PointerUp, event.button, event.mods);
+    }
+    if (target && target->id == m_pressedNode && listens(target, UiEventKind::Click)) {
+        delivered |= post(target, UiEventKind::Click, event.button, event.mods);
+    }
+    m_pressedNode = 0;
+    return delivered;
+}
+
+bool UiTree::handleScroll(const ScrollEvent& event) {
+    if (m_worldDirty) {
+        update(0.0);
+    }
+
+    const UiNode* target = hitTest(m_pointerX, m_pointerY);
+    for (const UiNode* candidate = target; candidate; candidate = candidate->parent) {
+        if (!candidate->scrolls) {
+            continue;
+        }
+        UiNode* node = lookup(candidate->id);
+        const double maxX = std::max(node->contentWidth - node->get(UiProperty::Width), 0.0);
+        const double maxY = std::max(node->contentHeight - node->get(UiProperty::Height), 0.0);
+        const double fromX = scrollTarget(node, UiProperty::ScrollX);
+        const double fromY = scrollTarget(node, UiProperty::ScrollY);
+        // Positive offsets scroll towards the start, like a wheel turned away from the user
+        const double toX = std::clamp(fromX - event.xoffset * kWheelStep, 0.0, maxX);
+        const double toY = std::clamp(fromY - event.yoffset * kWheelStep, 0.0, maxY);
+        if (toX == fromX && toY == fromY) {
+            continue;
+        }
+        if (toX != fromX) {
+            setValue(node, UiProperty::ScrollX, toX);
+        }
+        if (toY != fromY) {
+            setValue(node, UiProperty::ScrollY, toY);
+        }
+        markContent(node->parent);
+        ++m_revision;
+        return true;
+    }
+    return false;
+}
+
+bool UiTree::handleKey(const KeyEvent& event, int action) {
+    return m_events.isValid()
+        && bridge::KeyEvent::post(m_events, event.key, event.scancode, event.mods, static_cast<std::uint8_t>(action));
+}
+
+RingChannel& UiTree::getEventChannel() {
+    return m_events;
+}
+
+bool UiTree::findProperty(std::string_view name, UiProperty& property) {
+    for (const PropertyInfo& info : kProperties) {
+        if (name == info.name) {
+            property = info.property;
+            return true;
+        }
+    }
+    return false;
+}
+
+UiNode* UiTree::lookup(std::uint32_t id) {
+    auto it = m_nodes.find(id);
+    return it != m_nodes.end() ? it->second.get() : nullptr;
+}
+
+UiNode* UiTree::create(std::uint32_t id, bool isText, std::string_view typeOrText) {
+    std::unique_ptr<UiNode>& slot = m_nodes[id];
+    if (slot) {
+        CRAZY_LOG_DEBUG("UiTree: Node {} already exists", id);
+        return nullptr;
+    }
+    slot = std::make_unique<UiNode>();
+    slot->id = id;
+    slot->isText = isText;
+    slot->scrolls = !isText && typeOrText == "scroll";
+    (isText ? slot->text : slot->type).assign(typeOrText);
+    for (const PropertyInfo& info : kProperties) {
+        slot->values[static_cast<int>(info.property)] = info.defaultValue;
+    }
+    return slot.get();
+}
+
+void UiTree::detach(UiNode* node) {
+    if (!node->parent) {
+        return;
+    }
+    markContent(node->parent);
+    std::vector<UiNode*>& siblings = node->parent->children;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+    node->parent = nullptr;
+}
+
+void UiTree::destroy(UiNode* node) {
+    for (UiNode* child : node->children) {
+        child->parent = nullptr;
+        destroy(child);
+    }
+    // Running animations end at their next update()
+    m_transitions.erase(node->id);
+    m_nodes.erase(node->id);
+}
+
+void UiTree::setValue(UiNode* node, UiProperty property, double value) {
+    double& current = node->values[static_cast<int>(property)];
+    auto running = std::find_if(m_animations.begin(), m_animations.end(), [&](const Animation& animation) {
+        return animation.node == node->id && animation.property == property;
+    });
+
+    // Nodes not yet in a tree take their initial values without animating
+    const Transition* transition = nullptr;
+    auto transitions = m_transitions.find(node->id);
+    if (transitions != m_transitions.end() && node->parent) {
+        for (const Transition& candidate : transitions->second) {
+            if (candidate.property == property) {
+                transition = &candidate;
+            }
+        }
+    }
+
+    if (!transition || current == value) {
+        if (running != m_animations.end()) {
+            m_animations.erase(running);
+        }
+        current = value;
+        return;
+    }
+
+    // Retargeting starts from wherever the running animation got to
+    Animation animation{node->id, property, transition->easing, current, value, 0.0, transition->duration};
+    if (running != m_animations.end()) {
+        *running = animation;
+    } else {
+        m_animations.push_back(animation);
+    }
+}
+
+double UiTree::scrollTarget(const UiNode* node, UiProperty property) const {
+    // Wheel steps during a smooth scroll add up from where it is heading
+    for (const Animation& animation : m_animations) {
+        if (animation.node == node->id && animation.property == property) {
+            return animation.to;
+        }
+    }
+    return node->get(property);
+}
+
+void UiTree::markContent(UiNode* node) {
+    for (; node; node = node->parent) {
+        if (node->scrolls) {
+            ++node->contentVersion;
+        }
+    }
+}
+
+void UiTree::updateWorld(UiNode* node, const UiNode* parent) {
+    // p -> scale * p + offset, scaling around the node's center
+    const double scale = node->get(UiProperty::Scale);
+    const double offsetX = node->get(UiProperty::X) + node->get(UiProperty::TranslateX)
+        + node->get(UiProperty::Width) * 0.5 * (1.0 - scale);
+    const double offsetY = node->get(UiProperty::Y) + node->get(UiProperty::TranslateY)
+        + node->get(UiProperty::Height) * 0.5 * (1.0 - scale);
+    const bool visible = node->get(UiProperty::Visible) != 0.0;
+
+    if (parent) {
+        node->worldScale = parent->worldScale * scale;
+        node->worldX = parent->worldX + parent->worldScale * offsetX;
+        node->worldY = parent->worldY + parent->worldScale * offsetY;
+        node->worldOpacity = parent->worldOpacity * node->get(UiProperty::Opacity);
+        node->worldVisible = parent->worldVisible && visible;
+    } else {
+        node->worldScale = scale;
+        node->worldX = offsetX;
+        node->worldY = offsetY;
+        node->worldOpacity = node->get(UiProperty::Opacity);
+        node->worldVisible = visible;
+    }
+
+    for (UiNode* child : node->children) {
+        updateWorld(child, node);
+    }
+
+    if (node->scrolls) {
+        node->contentWidth = 0.0;
+        node->contentHeight = 0.0;
+        for (const UiNode* child : node->children) {
+            if (child->isText || child->get(UiProperty::Visible) == 0.0) {
+                continue;
+            }
+            const double childScale = child->get(UiProperty::Scale);
+            const double width = child->get(UiProperty::Width);
+            const double height = child->get(UiProperty::Height);
+            const double left = child->get(UiProperty::X) + child->get(UiProperty::TranslateX)
+                + width * 0.5 * (1.0 - childScale);
+            const double top = child->get(UiProperty::Y) + child->get(UiProperty::TranslateY)
+                + height * 0.5 * (1.0 - childScale);
+            node->contentWidth = std::max(node->contentWidth, left + width * childScale);
+            node->contentHeight = std::max(node->contentHeight, top + height * childScale);
+        }
+    }
+}
+
+const UiNode* UiTree::hitTest(const UiNode* node, double x, double y) const {
+    if (!node->worldVisible) {
+        return nullptr;
+    }
+    bool inside = false;
+    if (node->worldScale > 0.0) {
+        const double localX = (x - node->worldX) / node->worldScale;
+        const double localY = (y - node->worldY) / node->worldScale;
+        inside = localX >= 0.0 && localY >= 0.0
+            && localX < node->get(UiProperty::Width) && localY < node->get(UiProperty::Height);
+    }
+
+    // Scroll containers clip their content and shift it by the scroll offset
+    if (!node->scrolls || inside) {
+        const double contentX = node->scrolls ? x + node->get(UiProperty::ScrollX) * node->worldScale : x;
+        const double contentY = node->scrolls ? y + node->get(UiProperty::ScrollY) * node->worldScale : y;
+        for (auto it = node->children.rbegin(); it != node->children.rend(); ++it) {
+            if (const UiNode* hit = hitTest(*it, contentX, contentY)) {
+                return hit;
+            }
+        }
+    }
+    if (node->isText || node == m_root || !inside) {
+        return nullptr;
+    }
+    return node;
+}
+
+bool UiTree::listens(const UiNode* node, UiEventKind kind) const {
+    // Events bubble in JavaScript, so a listening ancestor counts
+    for (; node; node = node->parent) {
+        if (node->eventMask & eventBit(kind)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool UiTree::post(const UiNode* target, UiEventKind kind, int button, int mods) {
+    if (!m_events.isValid()) {
+        return false;
+    }
+    // The pointer in the unscrolled coordinates of the target's world values
+    double contentX = m_pointerX;
+    double contentY = m_pointerY;
+    for (const UiNode* ancestor = target->parent; ancestor; ancestor = ancestor->parent) {
+        if (ancestor->scrolls) {
+            contentX += ancestor->get(UiProperty::ScrollX) * ancestor->worldScale;
+            contentY += ancestor->get(UiProperty::ScrollY) * ancestor->worldScale;
+        }
+    }
+    const double scale = target->worldScale > 0.0 ? target->worldScale : 1.0;
+    return bridge::PointerEvent::post(m_events, target->id, button, mods, static_cast<std::uint8_t>(kind),
+                                      m_pointerX, m_pointerY,
+                                      (contentX - target->worldX) / scale,
+                                      (contentY - target->worldY) / scale);
+}
+
+} // namespace crazy
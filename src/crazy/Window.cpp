@@ -1,5 +1,5 @@
 #include "crazy/Window.hpp"
-#include <iostream>
+#include "crazy/Log.hpp"
 
 namespace crazy {
 
@@ -20,7 +20,7 @@ Window::Window(int width, int height, const std::string& title)
     // Create window
     m_window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
     if (!m_window) {
-        std::cerr << "Failed to create GLFW window: " << title << std::endl;
+        CRAZY_LOG_ERROR("Failed to create GLFW window: {}", title);
     }
 }
 
@@ -0,0 +1,405 @@
+// Frame-time regression harness: runs a scripted scene for a fixed number
+// of frames, reports the CPU/GPU frame-time distribution and the draw-call
+// and state-change counts, and compares them against a baseline file.
+//
+//   crazy_frame_benchmark --scene quads --frames 300 --baseline frame-baseline.txt
+//
+// Baseline format, one metric per line ('#' starts a comment):
+//
+//   version 1
+//   <scene>.<metric> <value> [tolerance]
+//
+// Times are in milliseconds. A metric fails when it exceeds
+// value * (1 + tolerance), plus --slack milliseconds for times; the
+// tolerance defaults to --tolerance. A metric missing from the baseline
+// fails unless --allow-missing is given, in which case it is reported as
+// a warning; --update-baseline writes the measured values, giving new time
+// entries a tolerance of their own (kTimeTolerance) for run-to-run noise.
+
+#include <crazy/Application.hpp>
+#include <crazy/BridgeMessages.hpp>
+#include <crazy/CommandBatch.hpp>
+#include <crazy/UiRenderer.hpp>
+#include <crazy/UiTree.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int kBaselineVersion = 1;
+const double kTimeTolerance = 0.5;
+const int kWidth = 1280;
+const int kHeight = 720;
+
+struct Options {
+    std::string scene;
+    int frames = 300;
+    int warmup = 30;
+    std::string baseline;
+    double tolerance = 0.25;
+    double slack = 0.25;
+    bool updateBaseline = false;
+    bool allowMissing = false;
+};
+
+/**
+ * @brief A scripted workload driving a UiTree through bridge messages
+ */
+class Scene {
+public:
+    explicit Scene(const std::string& name)
+        : m_name(name)
+        , m_nextId(1)
+        , m_frame(0)
+    {
+        m_commands.setHandler([this](const void* data, std::uint32_t size) {
+            m_tree.apply(data, size);
+        });
+    }
+
+    bool isKnown() const {
+        return m_name == "empty" || m_name == "quads" || m_name == "text" || m_name == "input";
+    }
+
+    crazy::CommandBatch& getCommands() { return m_commands; }
+
+    // Builds the tree; the commands are applied before the first render
+    void setup() {
+        if (m_name == "quads") {
+            // 2000 rounded rectangles in a grid
+            for (int i = 0; i < 2000; ++i) {
+                std::uint32_t id = box(0, (i % 50) * 25.0, (i / 50) * 17.0, 22.0, 14.0, 0x3080C0FFu + (i % 7) * 0x100000u);
+                send<crazy::bridge::SetNumberProperty>(id, 3.0, "borderRadius");
+                m_animated.push_back(id);
+            }
+        } else if (m_name == "text") {
+            // 150 rows, each a background with a label and a value
+            for (int i = 0; i < 150; ++i) {
+                std::uint32_t row = box(0, 10.0, i * 4.5, 600.0, 4.0, (i % 2) ? 0x202020FFu : 0x303030FFu);
+                text(row, "Row " + std::to_string(i));
+                m_animated.push_back(text(row, "0"));
+            }
+        } else if (m_name == "input") {
+            // 32x18 grid of buttons listening to every pointer event
+            for (int i = 0; i < 32 * 18; ++i) {
+                std::uint32_t id = box(0, (i % 32) * 40.0, (i / 32) * 40.0, 36.0, 36.0, 0x4060A0FFu);
+                send<crazy::bridge::SetEventMask>(id, 0xFFFFFFFFu);
+            }
+        }
+    }
+
+    // Per-frame script
+    void update(float deltaTime) {
+        ++m_frame;
+        if (m_name == "quads") {
+            // Move every tenth rectangle
+            for (std::size_t i = m_frame % 10; i < m_animated.size(); i += 10) {
+                send<crazy::bridge::SetNumberProperty>(m_animated[i], std::sin(m_frame * 0.1) * 5.0, "translateX");
+            }
+        } else if (m_name == "text") {
+            // Rewrite every value
+            for (std::size_t i = 0; i < m_animated.size(); ++i) {
+                send<crazy::bridge::SetText>(m_animated[i], std::to_string(m_frame * 31 + i));
+            }
+        } else if (m_name == "input") {
+            // A burst of pointer moves sweeping the grid, and a click
+            for (int i = 0; i < 64; ++i) {
+                double t = m_frame * 64 + i;
+                m_tree.handleMouseMove({std::fmod(t * 7.3, kWidth), std::fmod(t * 3.1, kHeight)});
+            }
+            m_tree.handleMouseButton({GLFW_MOUSE_BUTTON_LEFT, 0}, true);
+            m_tree.handleMouseButton({GLFW_MOUSE_BUTTON_LEFT, 0}, false);
+            m_tree.getEventChannel().drain([](const void*, std::uint32_t) {});
+        }
+        m_tree.update(deltaTime);
+    }
+
+    void render(crazy::Renderer& renderer, int width, int height) {
+        renderer.clear();
+        m_uiRenderer.render(m_tree, renderer, width, height);
+    }
+
+    void release() {
+        m_uiRenderer.release();
+    }
+
+private:
+    template <typename Message, typename... Args>
+    void send(const Args&... args) {
+        // The ring only fills up while building large scenes
+        if (!Message::post(m_commands.getChannel(), args...)) {
+            m_commands.apply();
+            Message::post(m_commands.getChannel(), args...);
+        }
+    }
+
+    std::uint32_t box(std::uint32_t parent, double x, double y, double width, double height, std::uint32_t color) {
+        std::uint32_t id = m_nextId++;
+        send<crazy::bridge::CreateElement>(id, std::string_view("view"));
+        send<crazy::bridge::SetNumberProperty>(id, x, "x");
+        send<crazy::bridge::SetNumberProperty>(id, y, "y");
+        send<crazy::bridge::SetNumberProperty>(id, width, "width");
+        send<crazy::bridge::SetNumberProperty>(id, height, "height");
+        send<crazy::bridge::SetNumberProperty>(id, static_cast<double>(color), "backgroundColor");
+        send<crazy::bridge::AppendChild>(parent, id);
+        return id;
+    }
+
+    std::uint32_t text(std::uint32_t parent, const std::string& content) {
+        std::uint32_t id = m_nextId++;
+        send<crazy::bridge::CreateText>(id, std::string_view(content));
+        send<crazy::bridge::AppendChild>(parent, id);
+        return id;
+    }
+
+    std::string m_name;
+    crazy::UiTree m_tree;
+    crazy::CommandBatch m_commands;
+    crazy::UiRenderer m_uiRenderer;
+    std::vector<std::uint32_t> m_animated;
+    std::uint32_t m_nextId;
+    int m_frame;
+};
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    std::size_t index = static_cast<std::size_t>(std::ceil(fraction * values.size()));
+    return values[std::min(values.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+struct Baseline {
+    struct Entry {
+        double value = 0.0;
+        double tolerance = -1.0;    // < 0: use the default
+    };
+    int version = 0;
+    std::map<std::string, Entry> entries;
+};
+
+bool loadBaseline(const std::string& path, Baseline& baseline) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key)) {
+            continue;
+        }
+        if (key == "version") {
+            fields >> baseline.version;
+            continue;
+        }
+        Baseline::Entry entry;
+        if (fields >> entry.value) {
+            if (!(fields >> entry.tolerance)) {
+                entry.tolerance = -1.0;
+            }
+            baseline.entries[key] = entry;
+        }
+    }
+    return true;
+}
+
+bool isTimeMetric(const std::string& metric) {
+    return metric.compare(0, 4, "cpu.") == 0 || metric.compare(0, 4, "gpu.") == 0;
+}
+
+// Replaces the lines of @p scene, keeping the other scenes and comments
+bool writeBaseline(const std::string& path, const std::string& scene,
+                   const std::vector<std::pair<std::string, double>>& metrics, const Baseline& previous) {
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            std::string key;
+            fields >> key;
+            if (key.compare(0, scene.size() + 1, scene + ".") != 0) {
+                lines.push_back(line);
+            }
+        }
+    }
+    if (std::none_of(lines.begin(), lines.end(), [](const std::string& l) { return l.compare(0, 8, "version ") == 0; })) {
+        lines.insert(lines.begin(), "version " + std::to_string(kBaselineVersion));
+    }
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    for (const std::string& line : lines) {
+        file << line << '\n';
+    }
+    for (const auto& metric : metrics) {
+        std::string key = scene + "." + metric.first;
+        file << key << ' ' << metric.second;
+        // Keep a tolerance tuned by hand; counts are exact, times get room for noise
+        auto it = previous.entries.find(key);
+        if (it != previous.entries.end() && it->second.tolerance >= 0.0) {
+            file << ' ' << it->second.tolerance;
+        } else {
+            file << ' ' << (isTimeMetric(metric.first) ? kTimeTolerance : 0.0);
+        }
+        file << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "--update-baseline") {
+            options.updateBaseline = true;
+            continue;
+        }
+        if (arg == "--allow-missing") {
+            options.allowMissing = true;
+            continue;
+        }
+        if (!value) {
+            return false;
+        }
+        ++i;
+        if (arg == "--scene") options.scene = value;
+        else if (arg == "--frames") options.frames = std::max(1, std::atoi(value));
+        else if (arg == "--warmup") options.warmup = std::max(0, std::atoi(value));
+        else if (arg == "--baseline") options.baseline = value;
+        else if (arg == "--tolerance") options.tolerance = std::atof(value);
+        else if (arg == "--slack") options.slack = std::atof(value);
+        else return false;
+    }
+    return !options.scene.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    using namespace crazy;
+
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+            "usage: %s --scene empty|quads|text|input [--frames N] [--warmup N]\n"
+            "          [--baseline FILE] [--tolerance F] [--slack MS] [--update-baseline] [--allow-missing]\n", argv[0]);
+        return 2;
+    }
+
+    Scene scene(options.scene);
+    if (!scene.isKnown()) {
+        std::fprintf(stderr, "unknown scene '%s'\n", options.scene.c_str());
+        return 2;
+    }
+
+    std::vector<double> cpuTimes;
+    std::vector<double> gpuTimes;
+    std::uint32_t maxDrawCalls = 0;
+    std::uint32_t maxStateChanges = 0;
+
+    Application app(kWidth, kHeight, "crazy frame benchmark");
+    app.setCommandBatch(&scene.getCommands());
+    app.setInitCallback([&]() {
+        // Measure the loop, not the display's refresh rate; under Xvfb the
+        // window never has focus, which would throttle it
+        app.getWindow().setVSync(false);
+        ThrottleSettings throttle;
+        throttle.enabled = false;
+        app.getFrameThrottle().setSettings(throttle);
+        scene.setup();
+    });
+    app.setUpdateCallback([&](float deltaTime) {
+        // Renderer::beginFrame() has run: the stats describe the previous frame
+        const FrameStats& stats = app.getRenderer().getFrameStats();
+        if (stats.frameIndex > static_cast<std::uint64_t>(options.warmup) + 1) {
+            cpuTimes.push_back(stats.cpuFrameTime * 1000.0);
+            gpuTimes.push_back(stats.gpuFrameTime * 1000.0);
+            maxDrawCalls = std::max(maxDrawCalls, stats.drawCalls);
+            maxStateChanges = std::max(maxStateChanges, stats.stateChanges);
+            if (cpuTimes.size() >= static_cast<std::size_t>(options.frames)) {
+                app.quit();
+            }
+        }
+        scene.update(deltaTime);
+    });
+    app.setRenderCallback([&]() {
+        scene.render(app.getRenderer(), app.getWindow().getWidth(), app.getWindow().getHeight());
+    });
+    app.setShutdownCallback([&]() {
+        scene.release();
+    });
+
+    if (app.run() != 0 || cpuTimes.size() < static_cast<std::size_t>(options.frames)) {
+        std::fprintf(stderr, "%s: run failed after %zu frames\n", options.scene.c_str(), cpuTimes.size());
+        return 1;
+    }
+
+    const std::vector<std::pair<std::string, double>> metrics = {
+        {"cpu.p50", percentile(cpuTimes, 0.50)},
+        {"cpu.p95", percentile(cpuTimes, 0.95)},
+        {"cpu.p99", percentile(cpuTimes, 0.99)},
+        {"gpu.p50", percentile(gpuTimes, 0.50)},
+        {"gpu.p95", percentile(gpuTimes, 0.95)},
+        {"drawCalls", static_cast<double>(maxDrawCalls)},
+        {"stateChanges", static_cast<double>(maxStateChanges)},
+    };
+
+    std::printf("%s: %d frames on %s\n", options.scene.c_str(), options.frames,
+                Renderer::getOpenGLRenderer() ? Renderer::getOpenGLRenderer() : "unknown renderer");
+
+    Baseline baseline;
+    if (!options.baseline.empty() && !loadBaseline(options.baseline, baseline) && !options.updateBaseline) {
+        std::fprintf(stderr, "cannot read baseline %s\n", options.baseline.c_str());
+        return 1;
+    }
+    if (!options.updateBaseline && baseline.version != kBaselineVersion && !options.baseline.empty()) {
+        std::fprintf(stderr, "baseline %s has version %d, expected %d\n",
+                     options.baseline.c_str(), baseline.version, kBaselineVersion);
+        return 1;
+    }
+
+    int failures = 0;
+    for (const auto& metric : metrics) {
+        const std::string key = options.scene + "." + metric.first;
+        auto it = baseline.entries.find(key);
+        if (it == baseline.entries.end()) {
+            const bool failed = !options.updateBaseline && !options.allowMissing;
+            failures += failed ? 1 : 0;
+            std::printf("  %-24s %10.3f   (no baseline)   %s\n", key.c_str(), metric.second,
+                        options.updateBaseline ? "added" : failed ? "FAIL; run the update_frame_baseline target"
+                                                                  : "WARNING: unchecked, run the update_frame_baseline target");
+            continue;
+        }
+        const bool isTime = isTimeMetric(metric.first);
+        const double tolerance = it->second.tolerance >= 0.0 ? it->second.tolerance : options.tolerance;
+        const double limit = it->second.value * (1.0 + tolerance) + (isTime ? options.slack : 0.0);
+        const bool failed = metric.second > limit;
+        failures += failed ? 1 : 0;
+        std::printf("  %-24s %10.3f   baseline %10.3f   limit %10.3f   %s\n", key.c_str(), metric.second,
+                    it->second.value, limit, failed ? "FAIL" : "ok");
+    }
+
+    if (options.updateBaseline) {
+        if (options.baseline.empty() || !writeBaseline(options.baseline, options.scene, metrics, baseline)) {
+            std::fprintf(stderr, "cannot write baseline %s\n", options.baseline.c_str());
+            return 1;
+        }
+        std::printf("updated %s\n", options.baseline.c_str());
+        return 0;
+    }
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,337 @@
+#!/usr/bin/env node
+'use strict';
+
+// Packs a directory of assets into one file for crazy::AssetPack.
+//
+//   node tools/asset-pack/pack.js <input-dir> <output> [--compress] [--keep-png]
+//
+// Every regular file under <input-dir> becomes an entry named by its path
+// relative to the directory, with '/' separators. PNG images are decoded
+// to RGBA8 textures (unless --keep-png), so the application can upload
+// them without an image decoder. With --compress, entries are stored as
+// LZ4 blocks when that saves at least an eighth of their size.
+//
+// File layout (little-endian, sections aligned to 64 bytes):
+//
+//   header  magic "CRZPACK1", u32 version, u32 entry count, u64 index
+//           offset, u64 names offset, u64 names size, u64 file size
+//   index   32-byte entries sorted by name (byte-wise): u64 data offset,
+//           u32 stored size, u32 size, u32 name offset, u32 name length,
+//           u16 kind (0 raw, 1 texture), u8 compression (0 none, 1 LZ4),
+//           u8 reserved, u32 reserved
+//   names   entry names, concatenated without terminators
+//   data    payloads; a texture payload is u32 width, u32 height,
+//           u32 format (1 RGBA8), u32 row stride, then rows top to bottom
+//
+// Keep in sync with src/crazy/AssetPack.cpp.
+
+const fs = require('fs');
+const path = require('path');
+const zlib = require('zlib');
+
+const MAGIC = 'CRZPACK1';
+const VERSION = 1;
+const HEADER_SIZE = 64;
+const ENTRY_SIZE = 32;
+const ALIGNMENT = 64;
+
+const KIND_RAW = 0;
+const KIND_TEXTURE = 1;
+const COMPRESSION_NONE = 0;
+const COMPRESSION_LZ4 = 1;
+const TEXTURE_RGBA8 = 1;
+
+function fail(message) {
+  console.error(`asset-pack: ${message}`);
+  process.exit(1);
+}
+
+function align(offset) {
+  return Math.ceil(offset / ALIGNMENT) * ALIGNMENT;
+}
+
+function listFiles(directory, prefix = '') {
+  const files = [];
+  for (const entry of fs.readdirSync(directory, { withFileTypes: true })) {
+    const relative = prefix + entry.name;
+    const absolute = path.join(directory, entry.name);
+    if (entry.isDirectory()) {
+      files.push(...listFiles(absolute, relative + '/'));
+    } else if (entry.isFile()) {
+      files.push({ name: relative, path: absolute });
+    }
+  }
+  return files;
+}
+
+// PNG -> RGBA8. Supports the non-interlaced 8-bit images asset pipelines
+// produce (grey, grey+alpha, RGB, RGBA, palette); anything else is an error.
+
+function paeth(a, b, c) {
+  const p = a + b - c;
+  const pa = Math.abs(p - a);
+  const pb = Math.abs(p - b);
+  const pc = Math.abs(p - c);
+  if (pa <= pb && pa <= pc) {
+    return a;
+  }
+  return pb <= pc ? b : c;
+}
+
+function decodePng(data, name) {
+  if (data.length < 8 || data.readUInt32BE(0) !== 0x89504e47 || data.readUInt32BE(4) !== 0x0d0a1a0a) {
+    fail(`${name}: not a PNG file`);
+  }
+
+  let header = null;
+  let palette = null;
+  let transparency = null;
+  const idat = [];
+  for (let offset = 8; offset + 8 <= data.length;) {
+    const length = data.readUInt32BE(offset);
+    const type = data.toString('latin1', offset + 4, offset + 8);
+    const chunk = data.subarray(offset + 8, offset + 8 + length);
+    offset += 12 + length;
+    if (type === 'IHDR') {
+      header = {
+        width: chunk.readUInt32BE(0),
+        height: chunk.readUInt32BE(4),
+        bitDepth: chunk[8],
+        colorType: chunk[9],
+        interlace: chunk[12],
+      };
+    } else if (type === 'PLTE') {
+      palette = chunk;
+    } else if (type === 'tRNS') {
+      transparency = chunk;
+    } else if (type === 'IDAT') {
+      idat.push(chunk);
+    } else if (type === 'IEND') {
+      break;
+    }
+  }
+
+  if (!header) {
+    fail(`${name}: missing IHDR`);
+  }
+  const channels = { 0: 1, 2: 3, 3: 1, 4: 2, 6: 4 }[header.colorType];
+  if (!channels || header.bitDepth !== 8 || header.interlace !== 0) {
+    fail(`${name}: only non-interlaced 8-bit PNGs are supported (use --keep-png to store it as is)`);
+  }
+  if (header.colorType === 3 && !palette) {
+    fail(`${name}: missing PLTE`);
+  }
+
+  const { width, height } = header;
+  const stride = width * channels;
+  const raw = zlib.inflateSync(Buffer.concat(idat));
+  if (raw.length < (stride + 1) * height) {
+    fail(`${name}: truncated image data`);
+  }
+
+  // Undo the per-row filters in place
+  const rows = Buffer.alloc(stride * height);
+  for (let y = 0; y < height; ++y) {
+    const filter = raw[y * (stride + 1)];
+    const source = y * (stride + 1) + 1;
+    const row = y * stride;
+    for (let x = 0; x < stride; ++x) {
+      const left = x >= channels ? rows[row + x - channels] : 0;
+      const up = y > 0 ? rows[row - stride + x] : 0;
+      const upLeft = x >= channels && y > 0 ? rows[row - stride + x - channels] : 0;
+      let predictor;
+      switch (filter) {
+        case 0: predictor = 0; break;
+        case 1: predictor = left; break;
+        case 2: predictor = up; break;
+        case 3: predictor = (left + up) >> 1; break;
+        case 4: predictor = paeth(left, up, upLeft); break;
+        default: fail(`${name}: invalid filter ${filter}`);
+      }
+      rows[row + x] = (raw[source + x] + predictor) & 0xff;
+    }
+  }
+
+  const pixels = Buffer.alloc(width * height * 4);
+  for (let i = 0; i < width * height; ++i) {
+    const s = i * channels;
+    const d = i * 4;
+    switch (header.colorType) {
+      case 0:
+        pixels.fill(rows[s], d, d + 3);
+        pixels[d + 3] = 255;
+        break;
+      case 2:
+        rows.copy(pixels, d, s, s + 3);
+        pixels[d + 3] = 255;
+        break;
+      case 3: {
+        const index = rows[s];
+        palette.copy(pixels, d, index * 3, index * 3 + 3);
+        pixels[d + 3] = transparency && index < transparency.length ? transparency[index] : 255;
+        break;
+      }
+      case 4:
+        pixels.fill(rows[s], d, d + 3);
+        pixels[d + 3] = rows[s + 1];
+        break;
+      default:
+        rows.copy(pixels, d, s, s + 4);
+    }
+  }
+
+  const texture = Buffer.alloc(16 + pixels.length);
+  texture.writeUInt32LE(width, 0);
+  texture.writeUInt32LE(height, 4);
+  texture.writeUInt32LE(TEXTURE_RGBA8, 8);
+  texture.writeUInt32LE(width * 4, 12);
+  pixels.copy(texture, 16);
+  return texture;
+}
+
+// LZ4 block compressor (greedy, single hash probe). The format rules: the
+// last 5 bytes are literals and the last match starts at least 12 bytes
+// before the end.
+
+function writeLength(out, op, length) {
+  while (length >= 255) {
+    out[op++] = 255;
+    length -= 255;
+  }
+  out[op++] = length;
+  return op;
+}
+
+function writeSequence(out, op, input, anchor, literals, offset, matchLength) {
+  const extra = matchLength - 4;
+  out[op++] = (Math.min(literals, 15) << 4) | (matchLength ? Math.min(extra, 15) : 0);
+  if (literals >= 15) {
+    op = writeLength(out, op, literals - 15);
+  }
+  input.copy(out, op, anchor, anchor + literals);
+  op += literals;
+  if (matchLength) {
+    out[op++] = offset & 0xff;
+    out[op++] = offset >> 8;
+    if (extra >= 15) {
+      op = writeLength(out, op, extra - 15);
+    }
+  }
+  return op;
+}
+
+function compressLz4(input) {
+  const HASH_BITS = 16;
+  const table = new Int32Array(1 << HASH_BITS).fill(-1);
+  const out = Buffer.alloc(input.length + Math.ceil(input.length / 255) + 16);
+  const matchStartLimit = input.length - 12;
+  const matchEndLimit = input.length - 5;
+
+  let op = 0;
+  let anchor = 0;
+  let ip = 0;
+  while (ip < matchStartLimit) {
+    const sequence = input.readUInt32LE(ip);
+    const hash = Math.imul(sequence, 2654435761) >>> (32 - HASH_BITS);
+    const candidate = table[hash];
+    table[hash] = ip;
+    if (candidate < 0 || ip - candidate > 65535 || input.readUInt32LE(candidate) !== sequence) {
+      ++ip;
+      continue;
+    }
+    let length = 4;
+    while (ip + length < matchEndLimit && input[candidate + length] === input[ip + length]) {
+      ++length;
+    }
+    op = writeSequence(out, op, input, anchor, ip - anchor, ip - candidate, length);
+    ip += length;
+    anchor = ip;
+  }
+  op = writeSequence(out, op, input, anchor, input.length - anchor, 0, 0);
+  return out.subarray(0, op);
+}
+
+function main() {
+  const args = process.argv.slice(2);
+  const positional = args.filter((arg) => !arg.startsWith('--'));
+  const compress = args.includes('--compress');
+  const keepPng = args.includes('--keep-png');
+  if (positional.length !== 2) {
+    fail('usage: pack.js <input-dir> <output> [--compress] [--keep-png]');
+  }
+  const [inputDir, outputPath] = positional.map((arg) => path.resolve(arg));
+  if (!fs.statSync(inputDir, { throwIfNoEntry: false })?.isDirectory()) {
+    fail(`${inputDir} is not a directory`);
+  }
+
+  const entries = listFiles(inputDir).map((file) => {
+    let data = fs.readFileSync(file.path);
+    let kind = KIND_RAW;
+    if (!keepPng && file.name.toLowerCase().endsWith('.png')) {
+      data = decodePng(data, file.name);
+      kind = KIND_TEXTURE;
+    }
+    let stored = data;
+    let compression = COMPRESSION_NONE;
+    if (compress && data.length >= 64) {
+      const packed = compressLz4(data);
+      if (packed.length <= data.length - data.length / 8) {
+        stored = packed;
+        compression = COMPRESSION_LZ4;
+      }
+    }
+    if (data.length > 0xffffffff) {
+      fail(`${file.name}: entries are limited to 4 GiB`);
+    }
+    return { name: Buffer.from(file.name, 'utf8'), data, stored, kind, compression };
+  });
+  entries.sort((a, b) => Buffer.compare(a.name, b.name));
+
+  const indexOffset = HEADER_SIZE;
+  const namesOffset = align(indexOffset + entries.length * ENTRY_SIZE);
+  const namesSize = entries.reduce((total, entry) => total + entry.name.length, 0);
+  let offset = align(namesOffset + namesSize);
+  for (const entry of entries) {
+    entry.dataOffset = offset;
+    offset = align(offset + entry.stored.length);
+  }
+  const fileSize = offset;
+
+  const output = Buffer.alloc(fileSize);
+  output.write(MAGIC, 0, 'latin1');
+  output.writeUInt32LE(VERSION, 8);
+  output.writeUInt32LE(entries.length, 12);
+  output.writeBigUInt64LE(BigInt(indexOffset), 16);
+  output.writeBigUInt64LE(BigInt(namesOffset), 24);
+  output.writeBigUInt64LE(BigInt(namesSize), 32);
+  output.writeBigUInt64LE(BigInt(fileSize), 40);
+
+  let nameOffset = 0;
+  entries.forEach((entry, i) => {
+    const at = indexOffset + i * ENTRY_SIZE;
+    output.writeBigUInt64LE(BigInt(entry.dataOffset), at);
+    output.writeUInt32LE(entry.stored.length, at + 8);
+    output.writeUInt32LE(entry.data.length, at + 12);
+    output.writeUInt32LE(nameOffset, at + 16);
+    output.writeUInt32LE(entry.name.length, at + 20);
+    output.writeUInt16LE(entry.kind, at + 24);
+    output[at + 26] = entry.compression;
+    entry.name.copy(output, namesOffset + nameOffset);
+    nameOffset += entry.name.length;
+    entry.stored.copy(output, entry.dataOffset);
+  });
+
+  // Replace the pack atomically so a running application never maps a
+  // half-written file
+  fs.mkdirSync(path.dirname(outputPath), { recursive: true });
+  const temporary = `${outputPath}.tmp`;
+  fs.writeFileSync(temporary, output);
+  fs.renameSync(temporary, outputPath);
+
+  const stored = entries.reduce((total, entry) => total + entry.stored.length, 0);
+  const original = entries.reduce((total, entry) => total + entry.data.length, 0);
+  console.log(`asset-pack: ${entries.length} entries, ${original} bytes -> ${stored} bytes stored, `
+    + `${fileSize} bytes written to ${path.relative(process.cwd(), outputPath)}`);
+}
+
+main();
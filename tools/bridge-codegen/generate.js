@@ -0,0 +1,467 @@
+#!/usr/bin/env node
+'use strict';
+
+// Generates the C++ and JavaScript codecs for the bridge message schema.
+//
+//   node tools/bridge-codegen/generate.js [schema] [header] [module]
+//
+// Defaults: schema/bridge-messages.json -> include/crazy/BridgeMessages.hpp
+// and frontend/src/bridge/messages.js. The build runs this through the
+// `bridge_messages` target; the outputs are committed so that building the
+// library does not need Node.js.
+//
+// Wire format of a message (little-endian):
+//
+//   offset 0   u16 message type id
+//   fixed fields in schema order, each aligned to its own size
+//   string fields store their UTF-8 byte length (u32) in the fixed part;
+//   the bytes follow the fixed part, in field order, without terminators
+//
+// Every offset is a compile-time constant, so reading a field is a single
+// load at a known offset of the message as it sits in the ring buffer.
+
+const fs = require('fs');
+const path = require('path');
+
+const root = path.resolve(__dirname, '..', '..');
+const schemaPath = path.resolve(process.argv[2] || path.join(root, 'schema', 'bridge-messages.json'));
+const headerPath = path.resolve(process.argv[3] || path.join(root, 'include', 'crazy', 'BridgeMessages.hpp'));
+const modulePath = path.resolve(process.argv[4] || path.join(root, 'frontend', 'src', 'bridge', 'messages.js'));
+
+const TYPES = {
+  i8: { size: 1, cpp: 'std::int8_t', js: 'Int8' },
+  u8: { size: 1, cpp: 'std::uint8_t', js: 'Uint8' },
+  i16: { size: 2, cpp: 'std::int16_t', js: 'Int16' },
+  u16: { size: 2, cpp: 'std::uint16_t', js: 'Uint16' },
+  i32: { size: 4, cpp: 'std::int32_t', js: 'Int32' },
+  u32: { size: 4, cpp: 'std::uint32_t', js: 'Uint32' },
+  f32: { size: 4, cpp: 'float', js: 'Float32' },
+  f64: { size: 8, cpp: 'double', js: 'Float64' },
+  string: { size: 4, cpp: 'std::string_view', js: 'Uint32' },
+};
+
+// Names used by the generated code itself
+const RESERVED = new Set(['type', 'size', 'encode', 'post', 'isValid', 'fixedSize', 'Reader']);
+
+function fail(message) {
+  console.error(`bridge-codegen: ${path.relative(root, schemaPath)}: ${message}`);
+  process.exit(1);
+}
+
+function capitalize(name) {
+  return name[0].toUpperCase() + name.slice(1);
+}
+
+function layout(message) {
+  let offset = 2;
+  const fields = message.fields.map((field) => {
+    const type = TYPES[field.type];
+    if (!type) {
+      fail(`${message.name}.${field.name}: unknown type '${field.type}'`);
+    }
+    if (!/^[a-z][A-Za-z0-9]*$/.test(field.name) || RESERVED.has(field.name)) {
+      fail(`${message.name}.${field.name}: invalid field name`);
+    }
+    offset = (offset + type.size - 1) & ~(type.size - 1);
+    const result = { ...field, ...type, offset, isString: field.type === 'string' };
+    offset += type.size;
+    return result;
+  });
+  return { ...message, fields, fixedSize: offset, strings: fields.filter((f) => f.isString) };
+}
+
+function loadSchema() {
+  const schema = JSON.parse(fs.readFileSync(schemaPath, 'utf8'));
+  const ids = new Set();
+  const names = new Set();
+  for (const message of schema.messages) {
+    if (!/^[A-Z][A-Za-z0-9]*$/.test(message.name) || names.has(message.name)) {
+      fail(`invalid or duplicate message name '${message.name}'`);
+    }
+    if (!(message.id > 0 && message.id < 0x10000) || ids.has(message.id)) {
+      fail(`${message.name}: invalid or duplicate id ${message.id}`);
+    }
+    names.add(message.name);
+    ids.add(message.id);
+  }
+  return { ...schema, messages: schema.messages.map(layout) };
+}
+
+// C++
+
+function cppStringOffset(message, field) {
+  const previous = message.strings.slice(0, message.strings.indexOf(field));
+  return ['kFixedSize', ...previous.map((f) => `${f.name}Length()`)].join(' + ');
+}
+
+function cppMessage(message) {
+  const params = message.fields.map((f) => `${f.cpp} ${f.name}`).join(', ');
+  const args = message.fields.map((f) => f.name).join(', ');
+  const sizeParams = message.strings.map((f) => `std::string_view ${f.name}`).join(', ');
+  const sizeArgs = message.strings.map((f) => f.name).join(', ');
+  const sizeExpr = ['kFixedSize', ...message.strings.map((f) => `static_cast<std::uint32_t>(${f.name}.size())`)].join('\n            + ');
+  const out = [];
+
+  out.push(`/**`);
+  out.push(` * @brief ${message.doc || message.name}`);
+  out.push(` */`);
+  out.push(`struct ${message.name} {`);
+  out.push(`    static constexpr MessageType kType = MessageType::${message.name};`);
+  for (const f of message.fields) {
+    const suffix = f.isString ? 'LengthOffset' : 'Offset';
+    out.push(`    static constexpr std::uint32_t k${capitalize(f.name)}${suffix} = ${f.offset};`);
+  }
+  out.push(`    static constexpr std::uint32_t kFixedSize = ${message.fixedSize};`);
+  out.push(``);
+  out.push(`    /**`);
+  out.push(`     * @brief Get the encoded size of a message`);
+  out.push(`     */`);
+  out.push(`    static constexpr std::uint32_t size(${sizeParams}) {`);
+  out.push(`        return ${sizeExpr};`);
+  out.push(`    }`);
+  out.push(``);
+  out.push(`    /**`);
+  out.push(`     * @brief Encode a message into @p out, which holds at least size() bytes`);
+  out.push(`     */`);
+  out.push(`    static void encode(void* out, ${params}) {`);
+  out.push(`        unsigned char* data = static_cast<unsigned char*>(out);`);
+  out.push(`        detail::store(data, static_cast<std::uint16_t>(kType));`);
+  for (const f of message.fields) {
+    if (f.isString) {
+      out.push(`        detail::store(data + k${capitalize(f.name)}LengthOffset, static_cast<std::uint32_t>(${f.name}.size()));`);
+    } else {
+      out.push(`        detail::store(data + k${capitalize(f.name)}Offset, ${f.name});`);
+    }
+  }
+  if (message.strings.length > 0) {
+    out.push(`        unsigned char* tail = data + kFixedSize;`);
+    for (const f of message.strings) {
+      out.push(`        tail = detail::storeString(tail, ${f.name});`);
+    }
+  }
+  out.push(`    }`);
+  out.push(``);
+  out.push(`    /**`);
+  out.push(`     * @brief Encode a message directly into a ring`);
+  out.push(`     *`);
+  out.push(`     * @return true if the message was written, false if the ring is full`);
+  out.push(`     */`);
+  out.push(`    static bool post(RingChannel& ring, ${params}) {`);
+  out.push(`        void* out = ring.reserve(size(${sizeArgs}));`);
+  out.push(`        if (!out) {`);
+  out.push(`            return false;`);
+  out.push(`        }`);
+  out.push(`        encode(out, ${args});`);
+  out.push(`        ring.commit();`);
+  out.push(`        return true;`);
+  out.push(`    }`);
+  out.push(``);
+  out.push(`    /**`);
+  out.push(`     * @brief Read an encoded message in place`);
+  out.push(`     */`);
+  out.push(`    class Reader {`);
+  out.push(`    public:`);
+  out.push(`        Reader(const void* data, std::uint32_t size)`);
+  out.push(`            : m_data(static_cast<const unsigned char*>(data))`);
+  out.push(`            , m_size(size)`);
+  out.push(`        {`);
+  out.push(`        }`);
+  out.push(``);
+  out.push(`        /**`);
+  out.push(`         * @brief Check the type and that every field lies within the message`);
+  out.push(`         */`);
+  out.push(`        bool isValid() const {`);
+  const checks = ['m_size >= kFixedSize', 'detail::load<std::uint16_t>(m_data) == static_cast<std::uint16_t>(kType)'];
+  if (message.strings.length > 0) {
+    const lengths = message.strings.map((f) => `static_cast<std::uint64_t>(${f.name}Length())`);
+    checks.push(`${['static_cast<std::uint64_t>(kFixedSize)', ...lengths].join(' + ')} <= m_size`);
+  }
+  out.push(`            return ${checks.join('\n                && ')};`);
+  out.push(`        }`);
+  for (const f of message.fields) {
+    out.push(``);
+    if (f.isString) {
+      out.push(`        std::uint32_t ${f.name}Length() const {`);
+      out.push(`            return detail::load<std::uint32_t>(m_data + k${capitalize(f.name)}LengthOffset);`);
+      out.push(`        }`);
+      out.push(``);
+      out.push(`        std::string_view ${f.name}() const {`);
+      out.push(`            return std::string_view(reinterpret_cast<const char*>(m_data + ${cppStringOffset(message, f)}), ${f.name}Length());`);
+      out.push(`        }`);
+    } else {
+      out.push(`        ${f.cpp} ${f.name}() const {`);
+      out.push(`            return detail::load<${f.cpp}>(m_data + k${capitalize(f.name)}Offset);`);
+      out.push(`        }`);
+    }
+  }
+  out.push(``);
+  out.push(`    private:`);
+  out.push(`        const unsigned char* m_data;`);
+  out.push(`        std::uint32_t m_size;`);
+  out.push(`    };`);
+  out.push(`};`);
+  return out.join('\n');
+}
+
+function generateHeader(schema) {
+  const namespaces = schema.namespace.split('::');
+  const enumerators = schema.messages.map((m) => `    ${m.name} = ${m.id},`).join('\n');
+  return `// Generated by tools/bridge-codegen/generate.js from schema/bridge-messages.json.
+// Do not edit: change the schema and rebuild the bridge_messages target.
+#ifndef CRAZY_BRIDGE_MESSAGES_HPP
+#define CRAZY_BRIDGE_MESSAGES_HPP
+
+#include "crazy/RingChannel.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+${namespaces.map((n) => `namespace ${n} {`).join('\n')}
+
+/**
+ * @brief Version of the message schema; both ends must agree on it
+ */
+constexpr std::uint32_t kSchemaVersion = ${schema.version};
+
+/**
+ * @brief Type id stored in the first two bytes of every message
+ */
+enum class MessageType : std::uint16_t {
+    Invalid = 0,
+${enumerators}
+};
+
+namespace detail {
+
+// Messages follow a 4-byte length prefix in the ring, so fields are not
+// necessarily aligned in memory; memcpy compiles to a plain load/store.
+template <typename T>
+inline T load(const unsigned char* address) {
+    T value;
+    std::memcpy(&value, address, sizeof(T));
+    return value;
+}
+
+template <typename T>
+inline void store(unsigned char* address, T value) {
+    std::memcpy(address, &value, sizeof(T));
+}
+
+inline unsigned char* storeString(unsigned char* address, std::string_view value) {
+    if (!value.empty()) {
+        std::memcpy(address, value.data(), value.size());
+    }
+    return address + value.size();
+}
+
+} // namespace detail
+
+/**
+ * @brief Get the type of an encoded message
+ *
+ * @return MessageType::Invalid if the message is too short to have one
+ */
+inline MessageType getMessageType(const void* data, std::uint32_t size) {
+    if (size < 2) {
+        return MessageType::Invalid;
+    }
+    return static_cast<MessageType>(detail::load<std::uint16_t>(static_cast<const unsigned char*>(data)));
+}
+
+${schema.messages.map(cppMessage).join('\n\n')}
+
+${namespaces.slice().reverse().map((n) => `} // namespace ${n}`).join('\n')}
+
+#endif // CRAZY_BRIDGE_MESSAGES_HPP
+`;
+}
+
+// JavaScript
+
+function jsMessage(message) {
+  const params = message.fields.map((f) => f.name).join(', ');
+  const sizeParams = message.strings.map((f) => f.name).join(', ');
+  const out = [];
+  out.push(`/** ${message.doc || message.name} */`);
+  out.push(`const ${message.name} = Object.freeze({`);
+  out.push(`  type: ${message.id},`);
+  out.push(`  fixedSize: ${message.fixedSize},`);
+  out.push(``);
+  out.push(`  /** Encoded size of a message */`);
+  if (message.strings.length > 0) {
+    out.push(`  size(${sizeParams}) {`);
+    out.push(`    return ${[message.fixedSize, ...message.strings.map((f) => `utf8Length(${f.name})`)].join(' + ')};`);
+    out.push(`  },`);
+  } else {
+    out.push(`  size() {`);
+    out.push(`    return ${message.fixedSize};`);
+    out.push(`  },`);
+  }
+  out.push(``);
+  out.push(`  /** Encode at \`offset\` in \`view\`; returns the encoded size */`);
+  out.push(`  encode(view, offset, ${params}) {`);
+  out.push(`    view.setUint16(offset, ${message.id}, true);`);
+  if (message.strings.length > 0) {
+    out.push(`    let tail = offset + ${message.fixedSize};`);
+  }
+  for (const f of message.fields) {
+    if (f.isString) {
+      out.push(`    const ${f.name}Length = encodeUtf8(view, tail, ${f.name});`);
+      out.push(`    view.setUint32(offset + ${f.offset}, ${f.name}Length, true);`);
+      out.push(`    tail += ${f.name}Length;`);
+    } else if (f.size === 1) {
+      out.push(`    view.set${f.js}(offset + ${f.offset}, ${f.name});`);
+    } else {
+      out.push(`    view.set${f.js}(offset + ${f.offset}, ${f.name}, true);`);
+    }
+  }
+  out.push(message.strings.length > 0 ? `    return tail - offset;` : `    return ${message.fixedSize};`);
+  out.push(`  },`);
+  out.push(``);
+  out.push(`  /** Encode directly into a RingChannel; returns false if it is full */`);
+  out.push(`  post(ring, ${params}) {`);
+  out.push(`    const offset = ring.reserve(this.size(${sizeParams}));`);
+  out.push(`    if (offset < 0) {`);
+  out.push(`      return false;`);
+  out.push(`    }`);
+  out.push(`    this.encode(ring.view, offset, ${params});`);
+  out.push(`    ring.commit();`);
+  out.push(`    return true;`);
+  out.push(`  },`);
+  out.push(``);
+  out.push(`  /** Check the type and that every field lies within \`size\` bytes */`);
+  out.push(`  isValid(view, offset, size) {`);
+  const checks = [`size >= ${message.fixedSize}`, `view.getUint16(offset, true) === ${message.id}`];
+  if (message.strings.length > 0) {
+    checks.push(`${[message.fixedSize, ...message.strings.map((f) => `view.getUint32(offset + ${f.offset}, true)`)].join(' + ')} <= size`);
+  }
+  out.push(`    return ${checks.join(' &&\n      ')};`);
+  out.push(`  },`);
+  for (const f of message.fields) {
+    out.push(``);
+    if (f.isString) {
+      const previous = message.strings.slice(0, message.strings.indexOf(f));
+      const start = [`offset + ${message.fixedSize}`, ...previous.map((p) => `view.getUint32(offset + ${p.offset}, true)`)].join(' + ');
+      out.push(`  ${f.name}Length(view, offset) {`);
+      out.push(`    return view.getUint32(offset + ${f.offset}, true);`);
+      out.push(`  },`);
+      out.push(``);
+      out.push(`  ${f.name}(view, offset) {`);
+      out.push(`    return decodeUtf8(view, ${start}, view.getUint32(offset + ${f.offset}, true));`);
+      out.push(`  },`);
+    } else if (f.size === 1) {
+      out.push(`  ${f.name}(view, offset) {`);
+      out.push(`    return view.get${f.js}(offset + ${f.offset});`);
+      out.push(`  },`);
+    } else {
+      out.push(`  ${f.name}(view, offset) {`);
+      out.push(`    return view.get${f.js}(offset + ${f.offset}, true);`);
+      out.push(`  },`);
+    }
+  }
+  out.push(`});`);
+  return out.join('\n');
+}
+
+function generateModule(schema) {
+  const types = schema.messages.map((m) => `  ${m.name}: ${m.id},`).join('\n');
+  const names = schema.messages.map((m) => m.name);
+  return `'use strict';
+
+// Generated by tools/bridge-codegen/generate.js from schema/bridge-messages.json.
+// Do not edit: change the schema and rebuild the bridge_messages target.
+//
+// Accessors take the DataView of the buffer holding the message and the
+// byte offset of the message, as returned by RingChannel.peek()/reserve(),
+// and read or write the field at its fixed offset.
+
+const SCHEMA_VERSION = ${schema.version};
+
+const MessageType = Object.freeze({
+  Invalid: 0,
+${types}
+});
+
+const encoder = new TextEncoder();
+
+// Messages are almost always written through the same view (a ring's)
+let lastView = null;
+let lastBytes = null;
+
+function bytesOf(view) {
+  if (view !== lastView) {
+    lastBytes = new Uint8Array(view.buffer, view.byteOffset, view.byteLength);
+    lastView = view;
+  }
+  return lastBytes;
+}
+
+/** Number of bytes \`text\` takes in UTF-8 */
+function utf8Length(text) {
+  let length = 0;
+  for (let i = 0; i < text.length; i++) {
+    const c = text.charCodeAt(i);
+    if (c < 0x80) {
+      length += 1;
+    } else if (c < 0x800) {
+      length += 2;
+    } else if ((c & 0xfc00) === 0xd800 && i + 1 < text.length && (text.charCodeAt(i + 1) & 0xfc00) === 0xdc00) {
+      length += 4;
+      i++;
+    } else {
+      length += 3;
+    }
+  }
+  return length;
+}
+
+function encodeUtf8(view, offset, text) {
+  const bytes = bytesOf(view);
+  let i = 0;
+  // Short ASCII strings (element types, property names) are the common case
+  for (; i < text.length; i++) {
+    const c = text.charCodeAt(i);
+    if (c >= 0x80) {
+      break;
+    }
+    bytes[offset + i] = c;
+  }
+  if (i === text.length) {
+    return i;
+  }
+  return i + encoder.encodeInto(text.slice(i), bytes.subarray(offset + i)).written;
+}
+
+function decodeUtf8(view, offset, length) {
+  return Buffer.from(view.buffer, view.byteOffset + offset, length).toString('utf8');
+}
+
+/** Type of the message at \`offset\`, or MessageType.Invalid if \`size\` is too small */
+function getMessageType(view, offset, size) {
+  return size < 2 ? MessageType.Invalid : view.getUint16(offset, true);
+}
+
+${schema.messages.map(jsMessage).join('\n\n')}
+
+module.exports = {
+  SCHEMA_VERSION,
+  MessageType,
+  getMessageType,
+  utf8Length,
+${names.map((n) => `  ${n},`).join('\n')}
+};
+`;
+}
+
+function writeIfChanged(file, content) {
+  if (fs.existsSync(file) && fs.readFileSync(file, 'utf8') === content) {
+    return;
+  }
+  fs.mkdirSync(path.dirname(file), { recursive: true });
+  fs.writeFileSync(file, content);
+  console.log(`bridge-codegen: wrote ${path.relative(root, file)}`);
+}
+
+const schema = loadSchema();
+writeIfChanged(headerPath, generateHeader(schema));
+writeIfChanged(modulePath, generateModule(schema));